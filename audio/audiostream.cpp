@@ -24,6 +24,10 @@
 #include "common/mutex.h"
 #include "common/textconsole.h"
 #include "common/queue.h"
+#include "common/ringbuffer.h"
+#include "common/singleton.h"
+#include "common/system.h"
+#include "common/threadpool.h"
 #include "common/util.h"
 
 #include "audio/audiostream.h"
@@ -468,6 +472,196 @@ AudioStream *makeLimitingAudioStream(AudioStream *parentStream, const Timestamp
 	return new LimitingAudioStream(parentStream, length, disposeAfterUse);
 }
 
+// The worker threads shared by all prefetching streams. The pool is created
+// with the first such stream and stopped with the last one.
+class PrefetchThreadPool : public Common::Singleton<PrefetchThreadPool> {
+public:
+	PrefetchThreadPool() : _users(0), _pool(nullptr) {}
+
+	Common::ThreadPool *acquire() {
+		Common::StackLock lock(_mutex);
+		if (_users++ == 0)
+			_pool = new Common::ThreadPool(kPrefetchThreads);
+		return _pool;
+	}
+
+	void release() {
+		Common::StackLock lock(_mutex);
+		assert(_users > 0);
+		if (--_users == 0) {
+			delete _pool;
+			_pool = nullptr;
+		}
+	}
+
+private:
+	enum {
+		kPrefetchThreads = 2
+	};
+
+	Common::Mutex _mutex;
+	uint _users;
+	Common::ThreadPool *_pool;
+};
+
+} // End of namespace Audio
+
+namespace Common {
+DECLARE_SINGLETON(Audio::PrefetchThreadPool);
+}
+
+namespace Audio {
+
+class PrefetchingAudioStreamImpl : public PrefetchingAudioStream {
+public:
+	PrefetchingAudioStreamImpl(AudioStream *parentStream, uint lookaheadMillis, DisposeAfterUse::Flag disposeAfterUse);
+	~PrefetchingAudioStreamImpl();
+
+	int readBuffer(int16 *buffer, const int numSamples) override;
+	bool isStereo() const override { return _stereo; }
+	int getRate() const override { return _rate; }
+
+	bool endOfData() const override {
+		// The ring buffer has to be checked last: the worker sets
+		// _parentEnded after writing the last samples
+		return _parentEnded.load(std::memory_order_acquire) && _samples.empty();
+	}
+
+	uint32 getUnderrunCount() const override { return _underrunCount.load(std::memory_order_relaxed); }
+	uint32 getUnderrunSamples() const override { return _underrunSamples.load(std::memory_order_relaxed); }
+	uint getBufferedSamples() const override { return _samples.size(); }
+
+private:
+	enum {
+		/** Number of samples read from the parent stream at once */
+		kDecodeChunkSize = 2048
+	};
+
+	/**
+	 * Tops up the ring buffer and returns. The reader submits it again
+	 * once half of the buffer has been consumed.
+	 */
+	class DecodeTask : public Common::Task {
+	public:
+		explicit DecodeTask(PrefetchingAudioStreamImpl *stream) : _stream(stream) {}
+		void run() override { _stream->decode(); }
+
+	private:
+		PrefetchingAudioStreamImpl *_stream;
+	};
+
+	/** Decode into the ring buffer until it is full. Called on a worker thread. */
+	void decode();
+
+	/**
+	 * Submit the decode task again if the ring buffer needs to be refilled.
+	 * This is called from the mixer callback, so it only locks when the
+	 * task has to be submitted.
+	 */
+	void requestDecode();
+
+	AudioStream *_parentStream;
+	const DisposeAfterUse::Flag _disposeAfterUse;
+	const bool _stereo;
+	const int _rate;
+
+	Common::RingBuffer<int16> _samples;
+	/** Only used by the worker */
+	int16 _decodeBuffer[kDecodeChunkSize];
+
+	std::atomic<bool> _parentEnded;
+	std::atomic<bool> _quit;
+	std::atomic<uint32> _underrunCount;
+	std::atomic<uint32> _underrunSamples;
+
+	Common::ThreadPool *_pool;
+	DecodeTask _task;
+	/** Set from submitting the task until decode() returns */
+	std::atomic<bool> _decoding;
+};
+
+PrefetchingAudioStreamImpl::PrefetchingAudioStreamImpl(AudioStream *parentStream, uint lookaheadMillis, DisposeAfterUse::Flag disposeAfterUse)
+	: _parentStream(parentStream), _disposeAfterUse(disposeAfterUse),
+	  _stereo(parentStream->isStereo()), _rate(parentStream->getRate()),
+	  _samples(MAX<uint>(_rate * (_stereo ? 2 : 1) * lookaheadMillis / 1000, kDecodeChunkSize * 2)),
+	  _parentEnded(false), _quit(false), _underrunCount(0), _underrunSamples(0),
+	  _pool(PrefetchThreadPool::instance().acquire()), _task(this), _decoding(true) {
+	// Fill the whole buffer. Without threads, this decodes right away.
+	_pool->submit(&_task);
+}
+
+PrefetchingAudioStreamImpl::~PrefetchingAudioStreamImpl() {
+	_quit.store(true, std::memory_order_relaxed);
+	_task.wait();
+	PrefetchThreadPool::instance().release();
+
+	if (_disposeAfterUse == DisposeAfterUse::YES)
+		delete _parentStream;
+}
+
+void PrefetchingAudioStreamImpl::decode() {
+	const uint channels = _stereo ? 2 : 1;
+
+	while (!_quit.load(std::memory_order_relaxed)) {
+		const uint space = _samples.capacity() - _samples.size();
+		const uint toRead = MIN<uint>(space, kDecodeChunkSize) / channels * channels;
+		if (toRead == 0)
+			break;
+
+		const int samplesRead = _parentStream->readBuffer(_decodeBuffer, toRead);
+		if (samplesRead > 0)
+			_samples.write(_decodeBuffer, samplesRead);
+
+		// Done with data, at least for now
+		if (samplesRead < (int)toRead) {
+			if (_parentStream->endOfStream())
+				_parentEnded.store(true, std::memory_order_release);
+			break;
+		}
+	}
+
+	// If the reader consumed samples since the last check, it submits the
+	// task again on its next read
+	_decoding.store(false, std::memory_order_release);
+}
+
+void PrefetchingAudioStreamImpl::requestDecode() {
+	if (_decoding.load(std::memory_order_acquire) || _parentEnded.load(std::memory_order_acquire) ||
+	    _samples.size() > _samples.capacity() / 2)
+		return;
+
+	// decode() returned, but the task may not be marked as done yet. Rather
+	// than waiting for it, which could run other queued tasks on the mixer
+	// thread, try again on the next read.
+	if (!_task.isDone())
+		return;
+
+	_decoding.store(true, std::memory_order_relaxed);
+	_pool->submit(&_task);
+}
+
+int PrefetchingAudioStreamImpl::readBuffer(int16 *buffer, const int numSamples) {
+	int samplesRead = _samples.read(buffer, numSamples);
+	requestDecode();
+
+	// Without threads, the buffer has been refilled already
+	while (samplesRead < numSamples && !_pool->isAsync() && !_samples.empty()) {
+		samplesRead += _samples.read(buffer + samplesRead, numSamples - samplesRead);
+		requestDecode();
+	}
+
+	if (samplesRead < numSamples && !_parentEnded.load(std::memory_order_acquire)) {
+		_underrunCount.fetch_add(1, std::memory_order_relaxed);
+		_underrunSamples.fetch_add(numSamples - samplesRead, std::memory_order_relaxed);
+	}
+
+	return samplesRead;
+}
+
+PrefetchingAudioStream *makePrefetchingAudioStream(AudioStream *parentStream, uint lookaheadMillis, DisposeAfterUse::Flag disposeAfterUse) {
+	return new PrefetchingAudioStreamImpl(parentStream, lookaheadMillis, disposeAfterUse);
+}
+
 /**
  * An AudioStream that plays nothing and immediately returns that
  * the endOfStream() has been reached
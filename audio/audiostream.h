@@ -436,6 +436,39 @@ Timestamp convertTimeToStreamPos(const Timestamp &where, int rate, bool isStereo
  */
 AudioStream *makeLimitingAudioStream(AudioStream *parentStream, const Timestamp &length, DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::YES);
 
+/**
+ * An AudioStream wrapper that decodes its parent stream ahead of time on a
+ * thread pool shared by all such streams, so that reading from it only has
+ * to copy the samples.
+ *
+ * The parent stream must not be accessed by anyone else once wrapped.
+ * If the backend does not support threads, the parent is decoded ahead
+ * from the reading thread instead.
+ */
+class PrefetchingAudioStream : public AudioStream {
+public:
+	/**
+	 * Return how many reads could not be completely served from the
+	 * decoded samples since the stream was created.
+	 */
+	virtual uint32 getUnderrunCount() const = 0;
+
+	/** Return the total number of samples missing in those reads. */
+	virtual uint32 getUnderrunSamples() const = 0;
+
+	/** Return the number of samples currently decoded ahead. */
+	virtual uint getBufferedSamples() const = 0;
+};
+
+/**
+ * Factory function for a PrefetchingAudioStream.
+ *
+ * @param parentStream     The stream to decode ahead.
+ * @param lookaheadMillis  How much audio to keep decoded ahead, in milliseconds.
+ * @param disposeAfterUse  Whether the parent stream object should be destroyed on destruction of the returned stream.
+ */
+PrefetchingAudioStream *makePrefetchingAudioStream(AudioStream *parentStream, uint lookaheadMillis = 500, DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::YES);
+
 /**
  * An AudioStream designed to work in terms of packets.
  *
@@ -26,6 +26,7 @@
 
 #include "audio/mixer_intern.h"
 #include "audio/rate.h"
+#include "audio/rate_intern.h"
 #include "audio/audiostream.h"
 #include "audio/timestamp.h"
 
@@ -42,20 +43,27 @@ namespace Audio {
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	/**
+	 * Create a channel. The effective volumes are only computed once the
+	 * mixer calls notifyGlobalVolChange(), as the sound type settings
+	 * belong to the mixer callback.
+	 */
+	Channel(MixerImpl *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, byte volume, int8 balance);
 	~Channel();
 
 	/**
 	 * Mixes the channel's samples into the given buffer.
 	 *
-	 * @param data buffer where to mix the data
-	 * @param len  number of sample *pairs*. So a value of 10
-	 *             in stereo and 16-bit samples means that the
-	 *             buffer contains twice 10 sample, each 16 bits,
-	 *             for a total of 40 bytes.
+	 * @param data           buffer where to mix the data
+	 * @param len            number of sample *pairs*. So a value of 10
+	 *                       in stereo and 16-bit samples means that the
+	 *                       buffer contains twice 10 sample, each 16 bits,
+	 *                       for a total of 40 bytes.
+	 * @param bytesPerSample size of each sample in the buffer
+	 * @param mixMode        how the samples are added to the buffer
 	 * @return number of sample pairs processed (which can still be silence!)
 	 */
-	int mix(byte *data, uint len);
+	int mix(byte *data, uint len, uint bytesPerSample, MixMode mixMode);
 
 	/**
 	 * Queries whether the channel is still playing or not.
@@ -175,9 +183,14 @@ public:
 	void notifyGlobalVolChange() { updateChannelVolumes(); }
 
 	/**
-	 * Queries how long the channel has been playing.
+	 * Queries the number of sample pairs mixed before the last call to mix().
+	 */
+	uint32 getSamplesConsumed() const { return _samplesConsumed; }
+
+	/**
+	 * Queries when mix() was last called, 0 if it never was.
 	 */
-	Timestamp getElapsedTime() const;
+	uint32 getMixerTimeStamp() const { return _mixerTimeStamp; }
 
 	/**
 	 * Replaces the channel's stream with a version that loops indefinitely.
@@ -216,13 +229,11 @@ private:
 	void updateChannelVolumes();
 	st_volume_t _volL, _volR;
 
-	Mixer *_mixer;
+	MixerImpl *_mixer;
 
 	uint32 _samplesConsumed;
 	uint32 _samplesDecoded;
 	uint32 _mixerTimeStamp;
-	uint32 _pauseStartTime;
-	uint32 _pauseTime;
 
 	RateConverter *_converter;
 	Common::DisposablePtr<AudioStream> _stream;
@@ -233,24 +244,52 @@ private:
 #pragma mark -
 
 MixerImpl::MixerImpl(uint sampleRate, bool stereo, uint outBufSize, uint outBytesPerSample, bool clamp)
-	: _mutex(), _sampleRate(sampleRate), _stereo(stereo), _outBufSize(outBufSize), _outBytesPerSample(outBytesPerSample), _clamp(clamp)
-	, _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _mutex(), _streamLockWanted(false), _mixingUnlocked(false), _sampleRate(sampleRate), _stereo(stereo), _outBufSize(outBufSize), _outBytesPerSample(outBytesPerSample), _clamp(clamp)
+	, _mixerReady(false), _handleSeed(0), _soundTypeSettings(), _mixSoundTypeSettings(), _commands(NUM_COMMANDS)
+	, _channelsBusy(false), _mixCount(0) {
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	// The bus is signed and only used when the backend wants clamped output
+#ifdef OUTPUT_UNSIGNED_AUDIO
+	_useBus = false;
+#else
+	_useBus = clamp;
+#endif
+	_busKernels = getRateMixKernels();
+	if (_useBus && outBufSize)
+		_bus.resize(outBufSize * (stereo ? 2 : 1));
+
+	for (int i = 0; i != NUM_CHANNELS; i++) {
 		_channels[i] = nullptr;
+		_liveHandles[i].store(0xffffffff, std::memory_order_relaxed);
+	}
 }
 
 MixerImpl::~MixerImpl() {
+	// Take over the channels which were never mixed
+	processCommands();
+
 	for (int i = 0; i != NUM_CHANNELS; i++)
 		delete _channels[i];
 }
 
-void MixerImpl::setReady(bool ready) {
-	Common::StackLock lock(_mutex);
+Common::Mutex &MixerImpl::mutex() {
+	// From now on, the mixer callback holds the mutex while it reads the
+	// streams. Let the one reading them without it finish first. A stream
+	// asking for the mutex from the callback would wait for itself, hence
+	// the bound.
+	if (!_streamLockWanted.load(std::memory_order_relaxed)) {
+		_streamLockWanted.store(true);
+		for (int i = 0; i < 100 && _mixingUnlocked.load(); i++)
+			g_system->delayMillis(1);
+	}
+
+	return _mutex;
+}
 
-	_mixerReady = ready;
+void MixerImpl::setReady(bool ready) {
+	_mixerReady.store(ready, std::memory_order_release);
 }
 
 uint MixerImpl::getOutputRate() const {
@@ -273,10 +312,14 @@ bool MixerImpl::getClamping() const {
 	return _clamp;
 }
 
-void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
+void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan, DisposeAfterUse::Flag autofreeStream) {
+	Common::StackLock lock(_commandMutex);
+
+	// A stopped sound may still have its channel until the next mix, but
+	// its slot can be reused: the new channel is queued after the stop
 	int index = -1;
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] == nullptr) {
+		if (_liveHandles[i].load(std::memory_order_acquire) == 0xffffffff) {
 			index = i;
 			break;
 		}
@@ -287,8 +330,6 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 		return;
 	}
 
-	_channels[index] = chan;
-
 	SoundHandle chanHandle;
 	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
 
@@ -296,6 +337,164 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 	_handleSeed++;
 	if (handle)
 		*handle = chanHandle;
+
+	ChannelParams &params = _channelParams[index];
+	params = ChannelParams();
+	params.type = chan->getType();
+	params.id = chan->getId();
+	params.permanent = chan->isPermanent();
+	params.streamOwned = (autofreeStream == DisposeAfterUse::YES);
+	params.volume = chan->getVolume();
+	params.balance = chan->getBalance();
+	params.faderL = chan->getFaderL();
+	params.faderR = chan->getFaderR();
+	params.rate = chan->getRate();
+	params.streamRate = params.rate;
+	_liveHandles[index].store(chanHandle._val, std::memory_order_release);
+
+	if (!postCommand(Command::kPlay, chanHandle._val, 0, chan)) {
+		_liveHandles[index].store(0xffffffff, std::memory_order_release);
+		delete chan;
+	}
+}
+
+void MixerImpl::deleteChannel(int index) {
+	// The slot may have been given to a new sound already
+	uint32 handle = _channels[index]->getHandle()._val;
+	_liveHandles[index].compare_exchange_strong(handle, 0xffffffff, std::memory_order_acq_rel);
+	delete _channels[index];
+	_channels[index] = nullptr;
+}
+
+bool MixerImpl::isLiveHandle(SoundHandle handle) const {
+	// The default handle would match the empty slots otherwise
+	if (handle._val == 0xffffffff)
+		return false;
+
+	const int index = handle._val % NUM_CHANNELS;
+	return _liveHandles[index].load(std::memory_order_acquire) == handle._val;
+}
+
+bool MixerImpl::postCommand(Command::Type type, uint32 target, int32 value, Channel *channel) {
+	Command cmd;
+	cmd.type = type;
+	cmd.target = target;
+	cmd.value = value;
+	cmd.channel = channel;
+
+	// The queue is only full when nobody has been mixing for a while (e.g. the
+	// audio device is paused), in which case applying it ourselves is cheap.
+	// _commandMutex stays locked, so that the commands stay in order.
+	for (int i = 0; !_commands.push(cmd); i++) {
+		if (!_channelsBusy.exchange(true, std::memory_order_acquire)) {
+			processCommands();
+			_channelsBusy.store(false, std::memory_order_release);
+			continue;
+		}
+
+		// The mixer callback drains the queue meanwhile, unless we are
+		// called from it
+		if (i == 100) {
+			warning("MixerImpl::postCommand: command queue overflow");
+			return false;
+		}
+		g_system->delayMillis(1);
+	}
+
+	return true;
+}
+
+void MixerImpl::processCommands() {
+	Command cmd;
+	while (_commands.pop(cmd)) {
+		if (cmd.type == Command::kSetSoundTypeVolume || cmd.type == Command::kSetSoundTypeMute) {
+			if (cmd.type == Command::kSetSoundTypeVolume)
+				_mixSoundTypeSettings[cmd.target].volume = cmd.value;
+			else
+				_mixSoundTypeSettings[cmd.target].mute = (cmd.value != 0);
+
+			for (int i = 0; i != NUM_CHANNELS; ++i) {
+				if (_channels[i] && _channels[i]->getType() == (SoundType)cmd.target)
+					_channels[i]->notifyGlobalVolChange();
+			}
+			continue;
+		}
+
+		const int index = cmd.target % NUM_CHANNELS;
+		if (cmd.type == Command::kPlay) {
+			// Any previous channel of the slot was stopped by an earlier command
+			assert(!_channels[index]);
+			_channels[index] = cmd.channel;
+			cmd.channel->notifyGlobalVolChange();
+			publishMixClock(index);
+			continue;
+		}
+
+		// Ignore changes for sounds that terminated in the meantime
+		Channel *chan = _channels[index];
+		if (!chan || chan->getHandle()._val != cmd.target)
+			continue;
+
+		switch (cmd.type) {
+		case Command::kStop:
+			deleteChannel(index);
+			break;
+		case Command::kPause:
+			chan->pause(cmd.value != 0);
+			break;
+		case Command::kLoop:
+			chan->loop();
+			break;
+		case Command::kSetVolume:
+			chan->setVolume(cmd.value);
+			break;
+		case Command::kSetBalance:
+			chan->setBalance(cmd.value);
+			break;
+		case Command::kSetFaderL:
+			chan->setFaderL(cmd.value);
+			break;
+		case Command::kSetFaderR:
+			chan->setFaderR(cmd.value);
+			break;
+		case Command::kSetRate:
+			chan->setRate(cmd.value);
+			break;
+		case Command::kResetRate:
+			chan->resetRate();
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void MixerImpl::publishMixClock(int index) {
+	MixClock &clock = _mixClocks[index];
+	const Channel *chan = _channels[index];
+	const uint32 sequence = clock.sequence.load(std::memory_order_relaxed);
+
+	clock.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	clock.handle.store(chan->getHandle()._val, std::memory_order_relaxed);
+	clock.samplesConsumed.store(chan->getSamplesConsumed(), std::memory_order_relaxed);
+	clock.timeStamp.store(chan->getMixerTimeStamp(), std::memory_order_relaxed);
+	clock.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void MixerImpl::waitForMixing() {
+	// Make our commands visible before looking at the mixer callback
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	// A mix which started later applies them before reading any stream.
+	// Called from the mixer callback, this would wait for itself, hence
+	// the bound.
+	const uint32 count = _mixCount.load(std::memory_order_acquire);
+	if (!(count & 1))
+		return;
+
+	for (int i = 0; i < 100 && _mixCount.load(std::memory_order_acquire) == count; i++)
+		g_system->delayMillis(1);
 }
 
 void MixerImpl::playStream(
@@ -306,75 +505,130 @@ void MixerImpl::playStream(
 			DisposeAfterUse::Flag autofreeStream,
 			bool permanent,
 			bool reverseStereo) {
-	Common::StackLock lock(_mutex);
-
 	if (stream == nullptr) {
 		warning("stream is 0");
 		return;
 	}
 
-
-	assert(_mixerReady);
+	assert(_mixerReady.load(std::memory_order_acquire));
 
 	// Prevent duplicate sounds
-	if (id != -1) {
-		for (int i = 0; i != NUM_CHANNELS; i++)
-			if (_channels[i] != nullptr && _channels[i]->getId() == id) {
-				// Delete the stream if were asked to auto-dispose it.
-				// Note: This could cause trouble if the client code does not
-				// yet expect the stream to be gone. The primary example to
-				// keep in mind here is QueuingAudioStream.
-				// Thus, as a quick rule of thumb, you should never, ever,
-				// try to play QueuingAudioStreams with a sound id.
-				if (autofreeStream == DisposeAfterUse::YES)
-					delete stream;
-				return;
-			}
+	if (id != -1 && isSoundIDActive(id)) {
+		// Delete the stream if were asked to auto-dispose it.
+		// Note: This could cause trouble if the client code does not
+		// yet expect the stream to be gone. The primary example to
+		// keep in mind here is QueuingAudioStream.
+		// Thus, as a quick rule of thumb, you should never, ever,
+		// try to play QueuingAudioStreams with a sound id.
+		if (autofreeStream == DisposeAfterUse::YES)
+			delete stream;
+		return;
 	}
 
 #ifdef AUDIO_REVERSE_STEREO
 	reverseStereo = !reverseStereo;
 #endif
 
-	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
-	chan->setVolume(volume);
-	chan->setBalance(balance);
-	insertChannel(handle, chan);
+	// Create the channel. The mixer callback takes it over from the queue.
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent, volume, balance);
+	insertChannel(handle, chan, autofreeStream);
 }
 
 int MixerImpl::mixCallback(byte *samples, uint len) {
 	assert(samples);
 
-	Common::StackLock lock(_mutex);
+	// The engine applies the queue itself while it is full
+	if (_channelsBusy.exchange(true, std::memory_order_acquire)) {
+		memset(samples, 0, len);
+		return 0;
+	}
+
+	_mixCount.fetch_add(1);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
 
 	// Since the mixer callback has been called, the mixer must be ready...
-	_mixerReady = true;
+	_mixerReady.store(true, std::memory_order_release);
+
+	processCommands();
+
+	// Engines which asked for mutex() expect it to be held while the
+	// streams are read, see mutex()
+	_mixingUnlocked.store(true);
+	const bool lockStreams = _streamLockWanted.load();
+	if (lockStreams) {
+		_mixingUnlocked.store(false);
+		_mutex.lock();
+	}
+
+	const int res = mixChannels(samples, len);
+
+	if (lockStreams)
+		_mutex.unlock();
+	else
+		_mixingUnlocked.store(false);
+
+	_mixCount.fetch_add(1, std::memory_order_release);
+	_channelsBusy.store(false, std::memory_order_release);
+	return res;
+}
 
+int MixerImpl::mixChannels(byte *samples, uint len) {
 	// we store samples of size defined by the backend
 	const uint bytesPerFrame = _outBytesPerSample * (_stereo ? 2 : 1);
 	assert(len % bytesPerFrame == 0);
 	const uint numFrames = len / bytesPerFrame;
+	const uint numSamples = numFrames * (_stereo ? 2 : 1);
+
+	// Clamped 16-bit output is mixed into the 32-bit bus first, so that the
+	// channels are summed without clamping and the result is only saturated
+	// once. Other formats are mixed directly into the output buffer.
+	byte *mixBuffer = samples;
+	uint mixBytesPerSample = _outBytesPerSample;
+	MixMode mixMode = _clamp ? MIX_CLAMPED_ADD : MIX_ADD;
+	const bool useBus = _useBus && _outBytesPerSample == sizeof(int16);
+	if (useBus) {
+		if (_bus.size() < numSamples)
+			_bus.resize(numSamples);
+		mixBuffer = (byte *)_bus.data();
+		mixBytesPerSample = sizeof(int32);
+		mixMode = MIX_ADD;
+	}
 
 	// mix all channels, zeroing the buffer lazily on first non-silent channel
 	bool zeroed = false;
 	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		// The streams may stop or start sounds from their callbacks.
+		// Apply these before the next stream is read.
+		if (!_commands.empty())
+			processCommands();
+
 		if (_channels[i]) {
 			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = nullptr;
+				deleteChannel(i);
 			} else if (!_channels[i]->isPaused()) {
 				if (!_channels[i]->isSilent() && !zeroed) {
-					memset(samples, 0, len);
+					memset(mixBuffer, 0, numSamples * mixBytesPerSample);
 					zeroed = true;
 				}
-				tmp = _channels[i]->mix(samples, numFrames);
+				tmp = _channels[i]->mix(mixBuffer, numFrames, mixBytesPerSample, mixMode);
+				publishMixClock(i);
 
 				if (tmp > res)
 					res = tmp;
 			}
 		}
+	}
+
+	if (useBus && zeroed) {
+		if (_busKernels) {
+			_busKernels->saturate((int16 *)samples, _bus.data(), numSamples);
+		} else {
+			int16 *out = (int16 *)samples;
+			for (uint i = 0; i < numSamples; i++)
+				out[i] = rateSaturateScalar(_bus[i]);
+		}
+	}
 
 	if (!zeroed) {
 		if (_clamp) {
@@ -387,151 +641,186 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	return res;
 }
 
+void MixerImpl::stopSlot(int index, bool &mustWait) {
+	const ChannelParams &params = _channelParams[index];
+	const uint32 handle = _liveHandles[index].load(std::memory_order_acquire);
+
+	_liveHandles[index].store(0xffffffff, std::memory_order_release);
+	postCommand(Command::kStop, handle, 0);
+
+	// The caller may delete the streams it owns once we return
+	if (!params.streamOwned)
+		mustWait = true;
+}
+
 void MixerImpl::stopAll() {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != nullptr && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = nullptr;
+	bool mustWait = false;
+	{
+		Common::StackLock lock(_commandMutex);
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_liveHandles[i].load(std::memory_order_acquire) != 0xffffffff && !_channelParams[i].permanent)
+				stopSlot(i, mustWait);
 		}
 	}
+
+	if (mustWait)
+		waitForMixing();
 }
 
 void MixerImpl::stopID(int id) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != nullptr && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = nullptr;
+	bool mustWait = false;
+	{
+		Common::StackLock lock(_commandMutex);
+		for (int i = 0; i != NUM_CHANNELS; i++) {
+			if (_liveHandles[i].load(std::memory_order_acquire) != 0xffffffff && _channelParams[i].id == id)
+				stopSlot(i, mustWait);
 		}
 	}
+
+	if (mustWait)
+		waitForMixing();
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	bool mustWait = false;
+	{
+		Common::StackLock lock(_commandMutex);
 
-	// Simply ignore stop requests for handles of sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+		// Simply ignore stop requests for handles of sounds that already terminated
+		if (!isLiveHandle(handle))
+			return;
 
-	delete _channels[index];
-	_channels[index] = nullptr;
+		stopSlot(handle._val % NUM_CHANNELS, mustWait);
+	}
+
+	if (mustWait)
+		waitForMixing();
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
-	_soundTypeSettings[type].mute = mute;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	Common::StackLock lock(_commandMutex);
+	_soundTypeSettings[type].mute = mute;
+	postCommand(Command::kSetSoundTypeMute, type, mute);
 }
 
 bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
+
+	Common::StackLock lock(_commandMutex);
 	return _soundTypeSettings[type].mute;
 }
 
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	// Simply ignore changes for sounds that already terminated
+	if (!isLiveHandle(handle))
 		return;
 
-	_channels[index]->setVolume(volume);
+	_channelParams[handle._val % NUM_CHANNELS].volume = volume;
+	postCommand(Command::kSetVolume, handle._val, volume);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) const {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_commandMutex);
+
+	if (!isLiveHandle(handle))
 		return 0;
 
-	return _channels[index]->getVolume();
+	return _channelParams[handle._val % NUM_CHANNELS].volume;
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	// Simply ignore changes for sounds that already terminated
+	if (!isLiveHandle(handle))
 		return;
 
-	_channels[index]->setBalance(balance);
+	_channelParams[handle._val % NUM_CHANNELS].balance = balance;
+	postCommand(Command::kSetBalance, handle._val, balance);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) const {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_commandMutex);
+
+	if (!isLiveHandle(handle))
 		return 0;
 
-	return _channels[index]->getBalance();
+	return _channelParams[handle._val % NUM_CHANNELS].balance;
 }
 
 void MixerImpl::setChannelFaderL(SoundHandle handle, uint8 faderL) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	// Simply ignore changes for sounds that already terminated
+	if (!isLiveHandle(handle))
 		return;
 
-	_channels[index]->setFaderL(faderL);
+	_channelParams[handle._val % NUM_CHANNELS].faderL = faderL;
+	postCommand(Command::kSetFaderL, handle._val, faderL);
 }
 
 uint8 MixerImpl::getChannelFaderL(SoundHandle handle) const {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_commandMutex);
+
+	if (!isLiveHandle(handle))
 		return 0;
 
-	return _channels[index]->getFaderL();
+	return _channelParams[handle._val % NUM_CHANNELS].faderL;
 }
 
 void MixerImpl::setChannelFaderR(SoundHandle handle, uint8 faderR) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	// Simply ignore changes for sounds that already terminated
+	if (!isLiveHandle(handle))
 		return;
 
-	_channels[index]->setFaderR(faderR);
+	_channelParams[handle._val % NUM_CHANNELS].faderR = faderR;
+	postCommand(Command::kSetFaderR, handle._val, faderR);
 }
 
 uint8 MixerImpl::getChannelFaderR(SoundHandle handle) const {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_commandMutex);
+
+	if (!isLiveHandle(handle))
 		return 0;
 
-	return _channels[index]->getFaderR();
+	return _channelParams[handle._val % NUM_CHANNELS].faderR;
 }
 
 void MixerImpl::setChannelRate(SoundHandle handle, uint32 rate) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	// Simply ignore changes for sounds that already terminated
+	if (!isLiveHandle(handle))
 		return;
 
-	_channels[index]->setRate(rate);
+	_channelParams[handle._val % NUM_CHANNELS].rate = rate;
+	postCommand(Command::kSetRate, handle._val, rate);
 }
 
 uint32 MixerImpl::getChannelRate(SoundHandle handle) const {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_commandMutex);
+
+	if (!isLiveHandle(handle))
 		return 0;
 
-	return _channels[index]->getRate();
+	return _channelParams[handle._val % NUM_CHANNELS].rate;
 }
 
 void MixerImpl::resetChannelRate(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	if (!isLiveHandle(handle))
 		return;
 
-	_channels[index]->resetRate();
+	ChannelParams &params = _channelParams[handle._val % NUM_CHANNELS];
+	params.rate = params.streamRate;
+	postCommand(Command::kResetRate, handle._val, 0);
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) const {
@@ -539,91 +828,143 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) const {
 }
 
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) const {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
+
+	Audio::Timestamp ts(0, _sampleRate);
+	if (!isLiveHandle(handle))
+		return ts;
 
+	// Read the position last published by the mixer callback
 	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return Timestamp(0, _sampleRate);
+	const MixClock &clock = _mixClocks[index];
+	uint32 sequence, clockHandle, samplesConsumed, mixerTimeStamp;
+	do {
+		sequence = clock.sequence.load(std::memory_order_acquire);
+		clockHandle = clock.handle.load(std::memory_order_relaxed);
+		samplesConsumed = clock.samplesConsumed.load(std::memory_order_relaxed);
+		mixerTimeStamp = clock.timeStamp.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((sequence & 1) || clock.sequence.load(std::memory_order_relaxed) != sequence);
+
+	// Not mixed yet
+	if (clockHandle != handle._val || mixerTimeStamp == 0)
+		return ts;
+
+	const ChannelParams &params = _channelParams[index];
+	uint32 delta;
+	if (params.pauseLevel) {
+		delta = params.pauseStartTime - mixerTimeStamp;
+	} else {
+		// Only a pause which ended after the last mix delays the sound
+		const uint32 pauseTime = (int32)(params.pauseEndTime - mixerTimeStamp) >= 0 ? params.pauseTime : 0;
+		delta = g_system->getMillis(true) - mixerTimeStamp - pauseTime;
+	}
+
+	// Convert the number of samples into a time duration.
+
+	ts = ts.addFrames(samplesConsumed);
+	ts = ts.addMsecs(delta);
+
+	// In theory it would seem like a good idea to limit the approximation
+	// so that it never exceeds the theoretical upper bound set by
+	// the samples decoded. Meanwhile, back in the real world, doing so makes
+	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
+	// isn't invoked at the regular intervals that I first imagined.
 
-	return _channels[index]->getElapsedTime();
+	return ts;
 }
 
 void MixerImpl::loopChannel(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	if (!isLiveHandle(handle))
 		return;
 
-	_channels[index]->loop();
+	postCommand(Command::kLoop, handle._val, 0);
+}
+
+void MixerImpl::pauseSlot(int index, bool paused) {
+	ChannelParams &params = _channelParams[index];
+
+	if (paused) {
+		params.pauseLevel++;
+
+		if (params.pauseLevel == 1)
+			params.pauseStartTime = g_system->getMillis(true);
+	} else if (params.pauseLevel > 0) {
+		params.pauseLevel--;
+
+		if (!params.pauseLevel) {
+			params.pauseEndTime = g_system->getMillis(true);
+			params.pauseTime = params.pauseEndTime - params.pauseStartTime;
+			params.pauseStartTime = 0;
+		}
+	}
+
+	postCommand(Command::kPause, _liveHandles[index].load(std::memory_order_relaxed), paused);
 }
 
 void MixerImpl::pauseAll(bool paused) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != nullptr) {
-			_channels[i]->pause(paused);
-		}
+		if (_liveHandles[i].load(std::memory_order_acquire) != 0xffffffff)
+			pauseSlot(i, paused);
 	}
 }
 
 void MixerImpl::pauseID(int id, bool paused) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != nullptr && _channels[i]->getId() == id) {
-			_channels[i]->pause(paused);
+		if (_liveHandles[i].load(std::memory_order_acquire) != 0xffffffff && _channelParams[i].id == id) {
+			pauseSlot(i, paused);
 			return;
 		}
 	}
 }
 
 void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 
 	// Simply ignore (un)pause requests for sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	if (!isLiveHandle(handle))
 		return;
 
-	_channels[index]->pause(paused);
+	pauseSlot(handle._val % NUM_CHANNELS, paused);
 }
 
 bool MixerImpl::isSoundIDActive(int id) const {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getId() == id)
+		if (_liveHandles[i].load(std::memory_order_acquire) != 0xffffffff && _channelParams[i].id == id)
 			return true;
 	return false;
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) const {
-	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
-		return _channels[index]->getId();
+	Common::StackLock lock(_commandMutex);
+	if (isLiveHandle(handle))
+		return _channelParams[handle._val % NUM_CHANNELS].id;
 	return 0;
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) const {
-	Common::StackLock lock(_mutex);
-
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.updateSubsystems();
 #endif
 
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	// Polled by engines every frame, so avoid contending with the other engine threads
+	return isLiveHandle(handle);
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) const {
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getType() == type)
+		if (_liveHandles[i].load(std::memory_order_acquire) != 0xffffffff && _channelParams[i].type == type)
 			return true;
 	return false;
 }
@@ -637,18 +978,15 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 	// TODO: Maybe we should do logarithmic (not linear) volume
 	// scaling? See also Player_V2::setMasterVolume
 
-	Common::StackLock lock(_mutex);
+	Common::StackLock lock(_commandMutex);
 	_soundTypeSettings[type].volume = volume;
-
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	postCommand(Command::kSetSoundTypeVolume, type, volume);
 }
 
 int MixerImpl::getVolumeForSoundType(SoundType type) const {
 	assert(0 <= (int)type && (int)type < ARRAYSIZE(_soundTypeSettings));
 
+	Common::StackLock lock(_commandMutex);
 	return _soundTypeSettings[type].volume;
 }
 
@@ -657,17 +995,17 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark --- Channel implementations ---
 #pragma mark -
 
-Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-				 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
-	: _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
-	  _balance(0), _faderL(255), _faderR(255), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
-	  _pauseStartTime(0), _pauseTime(0), _converter(nullptr), _volL(0), _volR(0),
+Channel::Channel(MixerImpl *mixer, Mixer::SoundType type, AudioStream *stream,
+				 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent, byte volume, int8 balance)
+	: _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(volume),
+	  _balance(balance), _faderL(255), _faderR(255), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
+	  _converter(nullptr), _volL(0), _volR(0),
 	  _stream(stream, autofreeStream) {
 	assert(mixer);
 	assert(stream);
 
 	// Get a rate converter instance
-	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), mixer->getOutputStereo(), reverseStereo);
+	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), mixer->getOutputStereo(), reverseStereo, getConfiguredRateConverterQuality());
 }
 
 Channel::~Channel() {
@@ -737,8 +1075,8 @@ void Channel::updateChannelVolumes() {
 	// volume is in the range 0 - kMaxMixerVolume.
 	// Hence, the vol_l/vol_r values will be in that range, too
 
-	if (!_mixer->isSoundTypeMuted(_type)) {
-		int vol = _mixer->getVolumeForSoundType(_type) * _volume;
+	if (!_mixer->isMixSoundTypeMuted(_type)) {
+		int vol = _mixer->getMixVolumeForSoundType(_type) * _volume;
 
 		if (_balance == 0) {
 			_volL = vol / Mixer::kMaxChannelVolume;
@@ -758,49 +1096,11 @@ void Channel::updateChannelVolumes() {
 }
 
 void Channel::pause(bool paused) {
-	//assert((paused && _pauseLevel >= 0) || (!paused && _pauseLevel));
-
-	if (paused) {
+	// The pause times are tracked by the mixer, see MixerImpl::pauseSlot()
+	if (paused)
 		_pauseLevel++;
-
-		if (_pauseLevel == 1)
-			_pauseStartTime = g_system->getMillis(true);
-	} else if (_pauseLevel > 0) {
+	else if (_pauseLevel > 0)
 		_pauseLevel--;
-
-		if (!_pauseLevel) {
-			_pauseTime = (g_system->getMillis(true) - _pauseStartTime);
-			_pauseStartTime = 0;
-		}
-	}
-}
-
-Timestamp Channel::getElapsedTime() const {
-	const uint32 rate = _mixer->getOutputRate();
-	uint32 delta = 0;
-
-	Audio::Timestamp ts(0, rate);
-
-	if (_mixerTimeStamp == 0)
-		return ts;
-
-	if (isPaused())
-		delta = _pauseStartTime - _mixerTimeStamp;
-	else
-		delta = g_system->getMillis(true) - _mixerTimeStamp - _pauseTime;
-
-	// Convert the number of samples into a time duration.
-
-	ts = ts.addFrames(_samplesConsumed);
-	ts = ts.addMsecs(delta);
-
-	// In theory it would seem like a good idea to limit the approximation
-	// so that it never exceeds the theoretical upper bound set by
-	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
-	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
-	// isn't invoked at the regular intervals that I first imagined.
-
-	return ts;
 }
 
 void Channel::loop() {
@@ -812,7 +1112,7 @@ void Channel::loop() {
 	}
 }
 
-int Channel::mix(byte *data, uint len) {
+int Channel::mix(byte *data, uint len, uint bytesPerSample, MixMode mixMode) {
 	assert(_stream);
 	assert(_converter);
 
@@ -820,15 +1120,14 @@ int Channel::mix(byte *data, uint len) {
 	if (!_stream->endOfData() || _converter->needsDraining()) {
 		_samplesConsumed = _samplesDecoded;
 		_mixerTimeStamp = g_system->getMillis(true);
-		_pauseTime = 0;
 		res = _converter->convert(
 			*_stream,
 			data,
-			_mixer->getOutputBytesPerSample(),
+			bytesPerSample,
 			len,
 			_volL,
 			_volR,
-			_mixer->getClamping() ? MIX_CLAMPED_ADD : MIX_ADD);
+			mixMode);
 		_samplesDecoded += res;
 	}
 
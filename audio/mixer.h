@@ -105,6 +105,11 @@ public:
 
 	/**
 	 * Return the mixer's internal mutex so that audio players can use it.
+	 *
+	 * Once this has been called, the mixer holds it while pulling data from
+	 * the audio streams. The other functions of the mixer do not take it:
+	 * starting, stopping and changing sounds is queued and applied by the
+	 * next mixer callback.
 	 */
 	virtual Common::Mutex &mutex() = 0;
 
@@ -23,11 +23,15 @@
 #define AUDIO_MIXER_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/mutex.h"
+#include "common/ringbuffer.h"
 #include "audio/mixer.h"
 
 namespace Audio {
 
+struct RateMixKernels;
+
 /**
  * @defgroup audio_mixer_intern Mixer implementation
  * @ingroup audio
@@ -49,6 +53,19 @@ namespace Audio {
  * 4) Change the mixer into ready mode via setReady(true).
  * 5) Start audio processing (e.g. by resuming the audio thread, if applicable).
  *
+ * The channels are owned by mixCallback(). Starting, stopping, pausing and
+ * changing sounds posts commands to a lock-free queue, which mixCallback()
+ * drains, and the getters answer from a copy of the channel parameters
+ * kept on the engine side. None of them take the mixer mutex.
+ *
+ * Engines use mutex() to guard their own stream state against the mixer
+ * callback, so once mutex() has been asked for, mixCallback() holds it
+ * while it reads the streams. Until then, mixing takes no lock at all.
+ *
+ * Once stopHandle() returns, the stream of the sound is not read anymore,
+ * so that the caller can delete it. If the mixer owns the stream, it is
+ * deleted by mixCallback().
+ *
  * In the future, we might make it possible for backends to provide
  * (partial) alternative implementations of the mixer, e.g. to make
  * better use of native sound mixing support on low-end devices.
@@ -58,17 +75,29 @@ namespace Audio {
 class MixerImpl : public Mixer {
 private:
 	enum {
-		NUM_CHANNELS = 32
+		NUM_CHANNELS = 32,
+		NUM_COMMANDS = 256
 	};
 
+	/** Returned by mutex(). Held by mixCallback() while mixing once _streamLockWanted is set. */
 	Common::Mutex _mutex;
+	std::atomic<bool> _streamLockWanted;
+	/** Set while mixCallback() reads the streams without holding _mutex */
+	std::atomic<bool> _mixingUnlocked;
 
 	const uint _sampleRate;
 	const bool _stereo;
 	uint _outBufSize;
 	const uint _outBytesPerSample;
 	const bool _clamp;
-	bool _mixerReady;
+	std::atomic<bool> _mixerReady;
+
+	/** Whether clamped 16-bit output is mixed into _bus first. */
+	bool _useBus;
+	/** Mix bus, holding the sum of all channels before it is saturated to the output format. */
+	Common::Array<int32> _bus;
+	/** SIMD kernels for converting the bus, if supported by the CPU. */
+	const RateMixKernels *_busKernels;
 	uint32 _handleSeed;
 
 	struct SoundTypeSettings {
@@ -78,18 +107,119 @@ private:
 		int volume;
 	};
 
+	/**
+	 * Change posted by the engine, to be applied by the consumer of the
+	 * queue, usually the mixer callback.
+	 */
+	struct Command {
+		enum Type {
+			kPlay,
+			kStop,
+			kPause,
+			kLoop,
+			kSetVolume,
+			kSetBalance,
+			kSetFaderL,
+			kSetFaderR,
+			kSetRate,
+			kResetRate,
+			kSetSoundTypeVolume,
+			kSetSoundTypeMute
+		};
+
+		Type type;
+		uint32 target; ///< Handle value, or sound type for the kSetSoundType* commands
+		int32 value;
+		Channel *channel; ///< New channel, for kPlay
+	};
+
+	/**
+	 * Engine side copy of the channel parameters, so that the getters reflect
+	 * the queued changes without having to lock _mutex.
+	 */
+	struct ChannelParams {
+		ChannelParams() : type(kPlainSoundType), id(-1), permanent(false), streamOwned(true),
+			volume(0), balance(0), faderL(0), faderR(0), rate(0), streamRate(0),
+			pauseLevel(0), pauseStartTime(0), pauseEndTime(0), pauseTime(0) {}
+
+		SoundType type;
+		int id;
+		bool permanent;
+		/** Whether the stream is deleted along with the channel */
+		bool streamOwned;
+
+		byte volume;
+		int8 balance;
+		uint8 faderL;
+		uint8 faderR;
+		uint32 rate;
+		uint32 streamRate;
+
+		int pauseLevel;
+		uint32 pauseStartTime;
+		/** When the last pause ended, and how long it lasted */
+		uint32 pauseEndTime;
+		uint32 pauseTime;
+	};
+
+	/**
+	 * Playback position of a channel, published by the mixer callback for
+	 * getElapsedTime(). The sequence number is odd while it is updated.
+	 */
+	struct MixClock {
+		MixClock() : sequence(0), handle(0xffffffff), samplesConsumed(0), timeStamp(0) {}
+
+		std::atomic<uint32> sequence;
+		std::atomic<uint32> handle;
+		std::atomic<uint32> samplesConsumed;
+		std::atomic<uint32> timeStamp;
+	};
+
+	/** Engine side settings, returned by the getters. Protected by _commandMutex. */
 	SoundTypeSettings _soundTypeSettings[4];
+	/** Settings used for mixing. Only used by the consumer of the queue. */
+	SoundTypeSettings _mixSoundTypeSettings[4];
+	/** Only used by the consumer of the queue. */
 	Channel *_channels[NUM_CHANNELS];
 
+	/**
+	 * Serializes the engine threads posting commands, and protects the
+	 * engine side state. Never taken by the mixer callback.
+	 */
+	Common::Mutex _commandMutex;
+	Common::RingBuffer<Command> _commands;
+	ChannelParams _channelParams[NUM_CHANNELS];
+	/** Handle value of the channel in each slot, or 0xffffffff for an empty slot. */
+	std::atomic<uint32> _liveHandles[NUM_CHANNELS];
+	MixClock _mixClocks[NUM_CHANNELS];
+
+	/**
+	 * Set by the consumer of the queue. This is the mixer callback, unless
+	 * the queue is full, in which case the engine applies it itself.
+	 */
+	std::atomic<bool> _channelsBusy;
+	/** Incremented before and after each mix, so that it is odd while mixing */
+	std::atomic<uint32> _mixCount;
+
+	bool postCommand(Command::Type type, uint32 target, int32 value, Channel *channel = nullptr);
+	void processCommands();
+	void deleteChannel(int index);
+	bool isLiveHandle(SoundHandle handle) const;
+	void stopSlot(int index, bool &mustWait);
+	void pauseSlot(int index, bool paused);
+	void waitForMixing();
+	int mixChannels(byte *samples, uint len);
+	void publishMixClock(int index);
+
 
 public:
 
 	MixerImpl(uint sampleRate, bool stereo = true, uint outBufSize = 0, uint outBytesPerSample = 2, bool clamp = true);
 	~MixerImpl();
 
-	bool isReady() const override { Common::StackLock lock(_mutex); return _mixerReady; }
+	bool isReady() const override { return _mixerReady.load(std::memory_order_acquire); }
 
-	Common::Mutex &mutex() override { return _mutex; }
+	Common::Mutex &mutex() override;
 
 	void playStream(
 		SoundType type,
@@ -145,9 +275,16 @@ public:
 	bool getClamping() const override;
 
 protected:
-	void insertChannel(SoundHandle *handle, Channel *chan);
+	void insertChannel(SoundHandle *handle, Channel *chan, DisposeAfterUse::Flag autofreeStream);
 
 public:
+	/**
+	 * Volume and mute state of a sound type as currently used for mixing.
+	 * Must only be called by the consumer of the command queue.
+	 */
+	int getMixVolumeForSoundType(SoundType type) const { return _mixSoundTypeSettings[type].volume; }
+	bool isMixSoundTypeMuted(SoundType type) const { return _mixSoundTypeSettings[type].mute; }
+
 	/**
 	 * Adjust the output buffer size
 	 */
@@ -27,6 +27,7 @@ MODULE_OBJS := \
 	musicplugin.o \
 	null.o \
 	rate.o \
+	rate_sinc.o \
 	sid.o \
 	ym2149.o \
 	timestamp.o \
@@ -167,5 +168,18 @@ MODULE_OBJS += \
 	soundfont/vab/vab.o
 endif
 
+ifdef SCUMMVM_NEON
+MODULE_OBJS += \
+	rate_neon.o
+endif
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	rate_sse2.o
+endif
+ifdef SCUMMVM_AVX2
+MODULE_OBJS += \
+	rate_avx2.o
+endif
+
 # Include common rules
 include $(srcdir)/rules.mk
@@ -31,9 +31,11 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_intern.h"
 #include "audio/mixer.h"
 #include "common/config-manager.h"
 #include "common/debug.h"
+#include "common/system.h"
 #include "common/util.h"
 
 namespace Audio {
@@ -49,6 +51,31 @@ enum {
 	FRAC_HALF_LOW = (1L << (FRAC_BITS_LOW-1))
 };
 
+const RateMixKernels *getRateMixKernels() {
+	const RateMixKernels *kernels = nullptr;
+
+	// The kernels only implement signed output
+#ifndef OUTPUT_UNSIGNED_AUDIO
+	if (!g_system)
+		return nullptr;
+
+#ifdef SCUMMVM_NEON
+	if (g_system->hasFeature(OSystem::kFeatureCpuNEON))
+		kernels = &g_rateMixKernelsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+	if (g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+		kernels = &g_rateMixKernelsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+	if (g_system->hasFeature(OSystem::kFeatureCpuAVX2))
+		kernels = &g_rateMixKernelsAVX2;
+#endif
+#endif
+
+	return kernels;
+}
+
 template<bool inStereo, bool outStereo, bool reverseStereo>
 class RateConverter_Impl : public RateConverter {
 private:
@@ -80,6 +107,42 @@ private:
 	/** Current sample(s) in the input stream (left/right channel) */
 	int16 _inCurL, _inCurR;
 
+	/** SIMD kernels for mixing into 16-bit stereo output, if supported by the CPU */
+	const RateMixKernels *_mixKernels;
+
+	enum {
+		/** Size in samples of the blocks of resampled input handed to the kernels */
+		kMixBlockSize = 512
+	};
+
+	/**
+	 * Whether the block kernels can be used. They only handle stereo output
+	 * with both channels audible, and don't clamp 32-bit output; the
+	 * remaining cases are rare.
+	 */
+	template<st_volume_t volL, st_volume_t volR, typename st_sample_t, MixMode mixMode>
+	bool canMixBlocks() const {
+		return outStereo && (sizeof(st_sample_t) == sizeof(int16) || mixMode == MIX_ADD) && volL != 0 && volR != 0 && _mixKernels;
+	}
+
+	void mixBlock(int16 *out, const int16 *in, uint frames, st_volume_t volL, st_volume_t volR, bool clamp) const {
+		if (!inStereo)
+			_mixKernels->mixMono(out, in, frames, volL, volR, clamp);
+		else if (reverseStereo)
+			_mixKernels->mixStereoReversed(out, in, frames, volL, volR, clamp);
+		else
+			_mixKernels->mixStereo(out, in, frames, volL, volR, clamp);
+	}
+
+	void mixBlock(int32 *out, const int16 *in, uint frames, st_volume_t volL, st_volume_t volR, bool clamp) const {
+		if (!inStereo)
+			_mixKernels->mixMono32(out, in, frames, volL, volR, clamp);
+		else if (reverseStereo)
+			_mixKernels->mixStereoReversed32(out, in, frames, volL, volR, clamp);
+		else
+			_mixKernels->mixStereo32(out, in, frames, volL, volR, clamp);
+	}
+
 	template<st_volume_t volL, st_volume_t volR, typename st_sample_t, MixMode mixMode>
 	int commonConvert(AudioStream &input, st_sample_t *outBuffer, st_size_t numSamples, st_volume_t volL_val, st_volume_t volR_val, int outputSamples);
 
@@ -154,7 +217,36 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::commonConvert(AudioS
 			(int)(outEnd - outBuffer) / (outStereo ? 2 : 1) / outputSamples);
 		_bufferSize -= count * (inStereo ? 2 : 1);
 
-		if (volL | volR) {
+		if (canMixBlocks<volL, volR, st_sample_t, mixMode>() && outputSamples * (inStereo ? 2 : 1) <= kMixBlockSize) {
+			const bool clamp = (mixMode == MIX_CLAMPED_ADD);
+
+			if (outputSamples == 1) {
+				mixBlock(outBuffer, _bufferPos, count, volL_val, volR_val, clamp);
+				_bufferPos += count * (inStereo ? 2 : 1);
+				outBuffer += count * 2;
+			} else {
+				// Duplicate the input frames into a temporary block first
+				int16 block[kMixBlockSize];
+				const int blockFrames = kMixBlockSize / (inStereo ? 2 : 1) / outputSamples * outputSamples;
+				int16 *blockPos = block;
+
+				for (int i = 0; i < count; ++i) {
+					for (int j = 0; j < outputSamples; ++j) {
+						*blockPos++ = _bufferPos[0];
+						if (inStereo)
+							*blockPos++ = _bufferPos[1];
+					}
+					_bufferPos += (inStereo ? 2 : 1);
+
+					const int frames = (blockPos - block) / (inStereo ? 2 : 1);
+					if (frames == blockFrames || i == count - 1) {
+						mixBlock(outBuffer, block, frames, volL_val, volR_val, clamp);
+						outBuffer += frames * 2;
+						blockPos = block;
+					}
+				}
+			}
+		} else if (volL | volR) {
 			// Mix the data into the output buffer
 			for (int i = 0; i < count; ++i) {
 				int16 inL, inR;
@@ -396,6 +488,31 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::interpolateConvert(A
 			_outPosFrac -= FRAC_ONE_LOW;
 		}
 
+		if (canMixBlocks<volL, volR, st_sample_t, mixMode>()) {
+			// Same as below, but the interpolated frames are collected in
+			// a temporary block which is then mixed in one go
+			int16 block[kMixBlockSize];
+			const int blockFrames = kMixBlockSize / (inStereo ? 2 : 1);
+			int frames = 0;
+
+			while (_outPosFrac < (frac_t)FRAC_ONE_LOW && outBuffer + frames * 2 < outEnd && frames < blockFrames) {
+				const int16 inL = (int16)(_inLastL + (((_inCurL - _inLastL) * _outPosFrac + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
+				if (inStereo) {
+					block[frames * 2] = inL;
+					block[frames * 2 + 1] = (int16)(_inLastR + (((_inCurR - _inLastR) * _outPosFrac + FRAC_HALF_LOW) >> FRAC_BITS_LOW));
+				} else {
+					block[frames] = inL;
+				}
+				frames++;
+
+				_outPosFrac += outPos_inc;
+			}
+
+			mixBlock(outBuffer, block, frames, volL_val, volR_val, mixMode == MIX_CLAMPED_ADD);
+			outBuffer += frames * 2;
+			continue;
+		}
+
 		// Loop as long as the _outPos trails behind, and as long as there is
 		// still space in the output buffer.
 		while (_outPosFrac < (frac_t)FRAC_ONE_LOW && outBuffer < outEnd) {
@@ -469,7 +586,8 @@ RateConverter_Impl<inStereo, outStereo, reverseStereo>::RateConverter_Impl(st_ra
 	_inCurL(0),
 	_inCurR(0),
 	_bufferSize(0),
-	_bufferPos(nullptr) {}
+	_bufferPos(nullptr),
+	_mixKernels(getRateMixKernels()) {}
 
 template<bool inStereo, bool outStereo, bool reverseStereo>
 template<typename st_sample_t, MixMode mixMode>
@@ -540,7 +658,22 @@ int RateConverter_Impl<inStereo, outStereo, reverseStereo>::convert(AudioStream
 	}
 }
 
-RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo) {
+RateConverterQuality getConfiguredRateConverterQuality() {
+	const Common::String quality = ConfMan.get("resampler_quality");
+
+	if (quality.equalsIgnoreCase("medium"))
+		return kRateConverterSincMedium;
+	else if (quality.equalsIgnoreCase("high"))
+		return kRateConverterSincHigh;
+	else
+		return kRateConverterLinear;
+}
+
+RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality) {
+	// Streams which already play at the output rate only need to be copied
+	if (quality != kRateConverterLinear && inRate != outRate)
+		return makeSincRateConverter(inRate, outRate, inStereo, outStereo, reverseStereo, quality);
+
 	if (inStereo) {
 		if (outStereo) {
 			if (reverseStereo)
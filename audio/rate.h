@@ -124,7 +124,23 @@ public:
 	virtual bool needsDraining() const = 0;
 };
 
-RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo);
+/**
+ * Resampling algorithm used by the rate converters, from the cheapest to the
+ * one with the least aliasing.
+ */
+enum RateConverterQuality {
+	kRateConverterLinear,		///< Linear interpolation, nearest sample copy for integer ratios
+	kRateConverterSincMedium,	///< Windowed sinc filter, 16 taps
+	kRateConverterSincHigh		///< Windowed sinc filter, 32 taps
+};
+
+/**
+ * Return the quality selected with the "resampler_quality" config key, which
+ * may be "low", "medium" or "high".
+ */
+RateConverterQuality getConfiguredRateConverterQuality();
+
+RateConverter *makeRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality = kRateConverterLinear);
 
 /** @} */
 } // End of namespace Audio
@@ -0,0 +1,159 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/rate_intern.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Audio {
+
+/**
+ * Scale 16 samples by the per-lane volumes in vol (32-bit lanes, alternating
+ * left/right), dividing by 256 with rounding towards zero.
+ *
+ * The unpacks work within 128-bit lanes, so lo holds samples 0-3 and 8-11,
+ * and hi holds samples 4-7 and 12-15.
+ */
+static FORCEINLINE void avx2_scale(__m256i in, __m256i vol, __m256i &lo, __m256i &hi) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i bias = _mm256_set1_epi32(255);
+
+	lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(in, zero), vol);
+	hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(in, zero), vol);
+	lo = _mm256_srai_epi32(_mm256_add_epi32(lo, _mm256_and_si256(_mm256_srai_epi32(lo, 31), bias)), 8);
+	hi = _mm256_srai_epi32(_mm256_add_epi32(hi, _mm256_and_si256(_mm256_srai_epi32(hi, 31), bias)), 8);
+}
+
+static FORCEINLINE void avx2_accumulate(int16 *out, __m256i in, __m256i vol, bool clamp) {
+	__m256i lo, hi;
+	avx2_scale(in, vol, lo, hi);
+	// The pack works within lanes too, which restores the sample order
+	const __m256i val = _mm256_packs_epi32(lo, hi);
+
+	__m256i dst = _mm256_loadu_si256((const __m256i *)out);
+	dst = clamp ? _mm256_adds_epi16(dst, val) : _mm256_add_epi16(dst, val);
+	_mm256_storeu_si256((__m256i *)out, dst);
+}
+
+static FORCEINLINE void avx2_accumulate(int32 *out, __m256i in, __m256i vol, bool clamp) {
+	__m256i lo, hi;
+	avx2_scale(in, vol, lo, hi);
+	const __m256i first = _mm256_permute2x128_si256(lo, hi, 0x20);
+	const __m256i second = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+	_mm256_storeu_si256((__m256i *)out, _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)out), first));
+	_mm256_storeu_si256((__m256i *)(out + 8), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(out + 8)), second));
+}
+
+template<bool reverse, typename T>
+static void mixStereoAVX2(T *out, const int16 *in, uint frames, int volL, int volR, bool clamp) {
+	// Swapping the input pairs turns the reversed case into the regular one
+	const __m256i vol = reverse ? _mm256_set_epi32(volL, volR, volL, volR, volL, volR, volL, volR)
+	                            : _mm256_set_epi32(volR, volL, volR, volL, volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8) {
+		__m256i src = _mm256_loadu_si256((const __m256i *)(in + i * 2));
+		if (reverse)
+			src = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+		avx2_accumulate(out + i * 2, src, vol, clamp);
+	}
+
+	for (; i < frames; i++) {
+		rateMixSampleScalar(out[i * 2 + (reverse ? 1 : 0)], in[i * 2], volL, clamp);
+		rateMixSampleScalar(out[i * 2 + (reverse ? 0 : 1)], in[i * 2 + 1], volR, clamp);
+	}
+}
+
+template<typename T>
+static void mixMonoAVX2(T *out, const int16 *in, uint frames, int volL, int volR, bool clamp) {
+	const __m256i vol = _mm256_set_epi32(volR, volL, volR, volL, volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 16 <= frames; i += 16) {
+		const __m256i src = _mm256_loadu_si256((const __m256i *)(in + i));
+		// Bring samples 0-7 to the low lane and 8-15 to the high lane
+		// before duplicating them within the lanes
+		const __m256i perm = _mm256_permute4x64_epi64(src, _MM_SHUFFLE(3, 1, 2, 0));
+		avx2_accumulate(out + i * 2, _mm256_unpacklo_epi16(perm, perm), vol, clamp);
+		avx2_accumulate(out + i * 2 + 16, _mm256_unpackhi_epi16(perm, perm), vol, clamp);
+	}
+
+	for (; i < frames; i++) {
+		rateMixSampleScalar(out[i * 2], in[i], volL, clamp);
+		rateMixSampleScalar(out[i * 2 + 1], in[i], volR, clamp);
+	}
+}
+
+static int32 filterAVX2(const int16 *samples, const int16 *coeffs, uint taps) {
+	__m256i sum = _mm256_setzero_si256();
+	for (uint i = 0; i < taps; i += 16) {
+		const __m256i src = _mm256_loadu_si256((const __m256i *)(samples + i));
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(src, _mm256_loadu_si256((const __m256i *)(coeffs + i))));
+	}
+
+	__m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum128);
+}
+
+static void saturateAVX2(int16 *out, const int32 *in, uint samples) {
+	uint i = 0;
+	for (; i + 16 <= samples; i += 16) {
+		const __m256i lo = _mm256_loadu_si256((const __m256i *)(in + i));
+		const __m256i hi = _mm256_loadu_si256((const __m256i *)(in + i + 8));
+		// The pack interleaves the lanes of its inputs
+		const __m256i packed = _mm256_packs_epi32(lo, hi);
+		_mm256_storeu_si256((__m256i *)(out + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+
+	for (; i < samples; i++)
+		out[i] = rateSaturateScalar(in[i]);
+}
+
+const RateMixKernels g_rateMixKernelsAVX2 = {
+	mixStereoAVX2<false, int16>,
+	mixStereoAVX2<true, int16>,
+	mixMonoAVX2<int16>,
+	mixStereoAVX2<false, int32>,
+	mixStereoAVX2<true, int32>,
+	mixMonoAVX2<int32>,
+	filterAVX2,
+	saturateAVX2
+};
+
+} // End of namespace Audio
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
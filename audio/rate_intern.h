@@ -0,0 +1,111 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef AUDIO_RATE_INTERN_H
+#define AUDIO_RATE_INTERN_H
+
+#include "common/scummsys.h"
+
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * Block kernels used by the rate converters to scale 16-bit frames by the
+ * channel volumes and add them to a 16-bit or 32-bit stereo output buffer.
+ *
+ * They must give exactly the same results as the per-sample code in
+ * RateConverter_Impl, i.e. out += (in * vol) / Mixer::kMaxMixerVolume,
+ * with saturation if clamping is requested. The 32-bit variants are used
+ * for the mixer bus and never clamp.
+ *
+ * The filter kernel is the inner loop of the windowed sinc converter and
+ * must match rateFilterScalar(). The saturate kernel converts the mixer bus
+ * to the final output and must match rateSaturateScalar().
+ */
+struct RateMixKernels {
+	/** Stereo input: left goes to out[0], right to out[1]. */
+	void (*mixStereo)(int16 *out, const int16 *in, uint frames, int volL, int volR, bool clamp);
+	/** Stereo input with reversed output: left goes to out[1], right to out[0]. */
+	void (*mixStereoReversed)(int16 *out, const int16 *in, uint frames, int volL, int volR, bool clamp);
+	/** Mono input, duplicated to both output channels. */
+	void (*mixMono)(int16 *out, const int16 *in, uint frames, int volL, int volR, bool clamp);
+	/** 32-bit versions of the above, @p clamp is ignored. */
+	void (*mixStereo32)(int32 *out, const int16 *in, uint frames, int volL, int volR, bool clamp);
+	void (*mixStereoReversed32)(int32 *out, const int16 *in, uint frames, int volL, int volR, bool clamp);
+	void (*mixMono32)(int32 *out, const int16 *in, uint frames, int volL, int volR, bool clamp);
+	/** Dot product of @p taps samples with one filter phase; @p taps is a multiple of 16. */
+	int32 (*filter)(const int16 *samples, const int16 *coeffs, uint taps);
+	/** Saturate 32-bit samples to 16 bits. */
+	void (*saturate)(int16 *out, const int32 *in, uint samples);
+};
+
+/**
+ * Return the fastest kernels supported by the CPU, or nullptr if none of
+ * them is better than the scalar code.
+ */
+const RateMixKernels *getRateMixKernels();
+
+#ifdef SCUMMVM_NEON
+extern const RateMixKernels g_rateMixKernelsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+extern const RateMixKernels g_rateMixKernelsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+extern const RateMixKernels g_rateMixKernelsAVX2;
+#endif
+
+/** Scalar version of the kernels, used for the remaining frames of a block. */
+inline void rateMixSampleScalar(int16 &out, int in, int vol, bool clamp) {
+	// Division, not shift: the scalar converters round towards zero
+	const int val = (in * vol) / 256;
+	if (clamp) {
+		const int sum = out + val;
+		out = (int16)(sum > 32767 ? 32767 : (sum < -32768 ? -32768 : sum));
+	} else {
+		out = (int16)(out + val);
+	}
+}
+
+inline void rateMixSampleScalar(int32 &out, int in, int vol, bool clamp) {
+	out += (in * vol) / 256;
+}
+
+/** Scalar version of the saturate kernel. */
+inline int16 rateSaturateScalar(int32 in) {
+	return (int16)(in > 32767 ? 32767 : (in < -32768 ? -32768 : in));
+}
+
+/** Scalar version of the filter kernel. */
+inline int32 rateFilterScalar(const int16 *samples, const int16 *coeffs, uint taps) {
+	int32 sum = 0;
+	for (uint i = 0; i < taps; i++)
+		sum += samples[i] * coeffs[i];
+	return sum;
+}
+
+/** Create the windowed sinc converter used for the higher quality settings. */
+RateConverter *makeSincRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality);
+
+} // End of namespace Audio
+
+#endif
@@ -0,0 +1,154 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "audio/rate_intern.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Audio {
+
+/** Divide by 256, rounding towards zero like the scalar code. */
+static FORCEINLINE int32x4_t neon_div256(int32x4_t val) {
+	const uint32x4_t bias = vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(val, 31)), 24);
+	return vshrq_n_s32(vaddq_s32(val, vreinterpretq_s32_u32(bias)), 8);
+}
+
+static FORCEINLINE void neon_accumulate(int16 *out, int16x8_t in, int16x4_t vol, bool clamp) {
+	const int32x4_t lo = neon_div256(vmull_s16(vget_low_s16(in), vol));
+	const int32x4_t hi = neon_div256(vmull_s16(vget_high_s16(in), vol));
+	const int16x8_t val = vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi));
+
+	int16x8_t dst = vld1q_s16(out);
+	dst = clamp ? vqaddq_s16(dst, val) : vaddq_s16(dst, val);
+	vst1q_s16(out, dst);
+}
+
+static FORCEINLINE void neon_accumulate(int32 *out, int16x8_t in, int16x4_t vol, bool clamp) {
+	const int32x4_t lo = neon_div256(vmull_s16(vget_low_s16(in), vol));
+	const int32x4_t hi = neon_div256(vmull_s16(vget_high_s16(in), vol));
+
+	vst1q_s32(out, vaddq_s32(vld1q_s32(out), lo));
+	vst1q_s32(out + 4, vaddq_s32(vld1q_s32(out + 4), hi));
+}
+
+template<bool reverse, typename T>
+static void mixStereoNEON(T *out, const int16 *in, uint frames, int volL, int volR, bool clamp) {
+	// Swapping the input pairs turns the reversed case into the regular one
+	const int16 volPattern[4] = {
+		(int16)(reverse ? volR : volL), (int16)(reverse ? volL : volR),
+		(int16)(reverse ? volR : volL), (int16)(reverse ? volL : volR)
+	};
+	const int16x4_t vol = vld1_s16(volPattern);
+
+	uint i = 0;
+	for (; i + 4 <= frames; i += 4) {
+		int16x8_t src = vld1q_s16(in + i * 2);
+		if (reverse)
+			src = vrev32q_s16(src);
+		neon_accumulate(out + i * 2, src, vol, clamp);
+	}
+
+	for (; i < frames; i++) {
+		rateMixSampleScalar(out[i * 2 + (reverse ? 1 : 0)], in[i * 2], volL, clamp);
+		rateMixSampleScalar(out[i * 2 + (reverse ? 0 : 1)], in[i * 2 + 1], volR, clamp);
+	}
+}
+
+template<typename T>
+static void mixMonoNEON(T *out, const int16 *in, uint frames, int volL, int volR, bool clamp) {
+	const int16 volPattern[4] = { (int16)volL, (int16)volR, (int16)volL, (int16)volR };
+	const int16x4_t vol = vld1_s16(volPattern);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8) {
+		const int16x8_t src = vld1q_s16(in + i);
+		const int16x8x2_t dup = vzipq_s16(src, src);
+		neon_accumulate(out + i * 2, dup.val[0], vol, clamp);
+		neon_accumulate(out + i * 2 + 8, dup.val[1], vol, clamp);
+	}
+
+	for (; i < frames; i++) {
+		rateMixSampleScalar(out[i * 2], in[i], volL, clamp);
+		rateMixSampleScalar(out[i * 2 + 1], in[i], volR, clamp);
+	}
+}
+
+static int32 filterNEON(const int16 *samples, const int16 *coeffs, uint taps) {
+	int32x4_t sum = vdupq_n_s32(0);
+	for (uint i = 0; i < taps; i += 8) {
+		const int16x8_t src = vld1q_s16(samples + i);
+		const int16x8_t coeff = vld1q_s16(coeffs + i);
+		sum = vmlal_s16(sum, vget_low_s16(src), vget_low_s16(coeff));
+		sum = vmlal_s16(sum, vget_high_s16(src), vget_high_s16(coeff));
+	}
+
+	const int32x2_t half = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+	return vget_lane_s32(vpadd_s32(half, half), 0);
+}
+
+static void saturateNEON(int16 *out, const int32 *in, uint samples) {
+	uint i = 0;
+	for (; i + 8 <= samples; i += 8)
+		vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vld1q_s32(in + i)), vqmovn_s32(vld1q_s32(in + i + 4))));
+
+	for (; i < samples; i++)
+		out[i] = rateSaturateScalar(in[i]);
+}
+
+const RateMixKernels g_rateMixKernelsNEON = {
+	mixStereoNEON<false, int16>,
+	mixStereoNEON<true, int16>,
+	mixMonoNEON<int16>,
+	mixStereoNEON<false, int32>,
+	mixStereoNEON<true, int32>,
+	mixMonoNEON<int32>,
+	filterNEON,
+	saturateNEON
+};
+
+} // End of namespace Audio
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
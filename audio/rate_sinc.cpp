@@ -0,0 +1,381 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Polyphase windowed sinc resampler.
+ *
+ * The filter bank holds one set of Kaiser windowed sinc coefficients for
+ * each of a fixed number of fractional positions between two input frames.
+ * Every output frame picks the nearest phase and computes one dot product
+ * per channel over the surrounding input frames, so the cost only depends
+ * on the number of taps and not on the conversion ratio.
+ */
+
+#include "audio/audiostream.h"
+#include "audio/rate.h"
+#include "audio/rate_intern.h"
+#include "audio/mixer.h"
+#include "common/array.h"
+#include "common/util.h"
+
+namespace Audio {
+
+namespace {
+
+struct SincFilterSpec {
+	/** Number of input frames used for each output frame, a multiple of 16 */
+	uint taps;
+	/** Number of fractional positions in the filter bank */
+	uint phases;
+	/** Kaiser window shape, higher values trade a wider transition band for less ripple */
+	double beta;
+	/** Cutoff frequency relative to the Nyquist frequency of the slower rate */
+	double cutoff;
+};
+
+const SincFilterSpec kSincFilterSpecs[] = {
+	{ 16, 128, 6.0, 0.85 },	// kRateConverterSincMedium
+	{ 32, 256, 8.5, 0.92 }	// kRateConverterSincHigh
+};
+
+enum {
+	/** The filter coefficients are Q1.14 fixed point numbers */
+	kCoeffBits = 14,
+	kMaxTaps = 32,
+	/** Size in samples of the blocks of resampled frames handed to the mix kernels */
+	kMixBlockSize = 512,
+	/** Number of frames read from the stream at once */
+	kReadFrames = 256
+};
+
+/** Zeroth order modified Bessel function of the first kind, for the Kaiser window. */
+double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+/** Scale and add resampled frames to the output buffer, like RateConverter_Impl does. */
+template<typename st_sample_t, MixMode mixMode>
+void mixFrames(st_sample_t *out, const int16 *in, uint frames, bool inStereo, bool outStereo, bool reverseStereo, st_volume_t volL, st_volume_t volR) {
+	for (uint i = 0; i < frames; i++) {
+		const int inL = *in++;
+		const int inR = inStereo ? *in++ : inL;
+		const st_sample_t outL = (inL * (int)volL) / Audio::Mixer::kMaxMixerVolume;
+		const st_sample_t outR = (inR * (int)volR) / Audio::Mixer::kMaxMixerVolume;
+
+		if (outStereo) {
+			processSample<mixMode>(out[reverseStereo    ], outL);
+			processSample<mixMode>(out[reverseStereo ^ 1], outR);
+			out += 2;
+		} else {
+			processSample<mixMode>(out[0], (outL + outR) / 2);
+			out++;
+		}
+	}
+}
+
+class SincRateConverter : public RateConverter {
+public:
+	SincRateConverter(st_rate_t inputRate, st_rate_t outputRate, bool inStereo, bool outStereo, bool reverseStereo, const SincFilterSpec &spec);
+
+	int convert(AudioStream &input, byte *outBuffer, uint outBytesPerSample, st_size_t numSamples, st_volume_t vol_l, st_volume_t vol_r, MixMode mixMode) override;
+
+	void setInputRate(st_rate_t inputRate) override { _inRate = inputRate; }
+	void setOutputRate(st_rate_t outputRate) override { _outRate = outputRate; }
+
+	st_rate_t getInputRate() const override { return _inRate; }
+	st_rate_t getOutputRate() const override { return _outRate; }
+
+	bool needsDraining() const override { return _pos + _spec.taps / 2 - 1 < _dataEnd; }
+
+private:
+	/** Rebuild the filter bank and the phase scale after a rate change. */
+	void updateFilter();
+
+	/**
+	 * Make sure there are enough input frames for the next output frame.
+	 * Once the stream has run out of data, the history is padded with
+	 * silence so that the last frames can be drained.
+	 *
+	 * @return False if no output frame can be produced yet.
+	 */
+	bool fillHistory(AudioStream &input);
+
+	template<typename st_sample_t, MixMode mixMode>
+	void mixBlock(byte *outBuffer, const int16 *block, uint frames, st_volume_t volL, st_volume_t volR) const {
+		mixFrames<st_sample_t, mixMode>((st_sample_t *)outBuffer, block, frames, _inStereo, _outStereo, _reverseStereo, volL, volR);
+	}
+
+	const SincFilterSpec &_spec;
+	const bool _inStereo, _outStereo, _reverseStereo;
+
+	/** Input and output rates */
+	st_rate_t _inRate, _outRate;
+
+	/** Rates the filter bank and _phaseScale were computed for */
+	st_rate_t _filterInRate, _filterOutRate;
+
+	/** Filter coefficients, _spec.phases + 1 rows of _spec.taps values */
+	Common::Array<int16> _bank;
+
+	/** Maps _phaseAcc to a filter bank row, as a 32.32 fixed point factor */
+	uint64 _phaseScale;
+
+	/** Deinterleaved input frames, the next output frame starts at _pos */
+	int16 _history[2][kMaxTaps + kReadFrames];
+
+	/** Position of the first tap of the next output frame in _history */
+	uint _pos;
+
+	/** Number of frames in _history */
+	uint _fill;
+
+	/** End of the frames read from the stream, the silence used for draining follows */
+	uint _dataEnd;
+
+	/** Fractional position between input frames, in units of 1 / _outRate */
+	uint32 _phaseAcc;
+
+	/** Interleaved buffer for reading from the stream */
+	int16 _readBuffer[kReadFrames * 2];
+
+	/** SIMD kernels for filtering and mixing, if supported by the CPU */
+	const RateMixKernels *_mixKernels;
+	int32 (*_filter)(const int16 *samples, const int16 *coeffs, uint taps);
+};
+
+SincRateConverter::SincRateConverter(st_rate_t inputRate, st_rate_t outputRate, bool inStereo, bool outStereo, bool reverseStereo, const SincFilterSpec &spec) :
+	_spec(spec),
+	_inStereo(inStereo),
+	_outStereo(outStereo),
+	_reverseStereo(inStereo && outStereo && reverseStereo),
+	_inRate(inputRate),
+	_outRate(outputRate),
+	_filterInRate(0),
+	_filterOutRate(0),
+	_phaseScale(0),
+	_pos(0),
+	_fill(spec.taps / 2 - 1),
+	_dataEnd(spec.taps / 2 - 1),
+	_phaseAcc(0),
+	_mixKernels(getRateMixKernels()) {
+	assert(spec.taps % 16 == 0 && spec.taps <= kMaxTaps);
+
+	// Start with silence so that the first output frame is centered on the
+	// first input frame
+	memset(_history, 0, sizeof(_history));
+
+	_filter = _mixKernels ? _mixKernels->filter : rateFilterScalar;
+	updateFilter();
+}
+
+void SincRateConverter::updateFilter() {
+	if (_filterInRate == _inRate && _filterOutRate == _outRate)
+		return;
+
+	// Keep the fractional position when the output rate changes
+	if (_filterOutRate != 0 && _filterOutRate != _outRate)
+		_phaseAcc = (uint32)((uint64)_phaseAcc * _outRate / _filterOutRate);
+
+	_phaseScale = ((uint64)_spec.phases << 32) / _outRate;
+
+	// The bank only depends on the ratio when downsampling
+	const bool rebuild = _bank.empty() || _inRate > _outRate || _filterInRate > _filterOutRate;
+	_filterInRate = _inRate;
+	_filterOutRate = _outRate;
+	if (!rebuild)
+		return;
+
+	const uint taps = _spec.taps;
+	const uint phases = _spec.phases;
+	const double cutoff = _spec.cutoff * (_inRate > _outRate ? (double)_outRate / _inRate : 1.0);
+	const double half = taps / 2;
+	const double windowScale = 1.0 / besselI0(_spec.beta);
+
+	_bank.resize((phases + 1) * taps);
+
+	for (uint phase = 0; phase <= phases; phase++) {
+		int16 *coeffs = &_bank[phase * taps];
+		double values[kMaxTaps];
+		double total = 0.0;
+
+		for (uint tap = 0; tap < taps; tap++) {
+			// Distance between the tap and the output position
+			const double x = (double)tap - (half - 1) - (double)phase / phases;
+			const double r = x / half;
+			const double window = (r <= -1.0 || r >= 1.0) ? 0.0 : besselI0(_spec.beta * sqrt(1.0 - r * r)) * windowScale;
+			const double t = M_PI * cutoff * x;
+			values[tap] = (x == 0.0 ? 1.0 : sin(t) / t) * window;
+			total += values[tap];
+		}
+
+		// Normalize each phase to unity gain, and give the rounding error to
+		// the largest tap so that constant input stays constant
+		int sum = 0;
+		uint largest = 0;
+		for (uint tap = 0; tap < taps; tap++) {
+			const double value = values[tap] / total * (1 << kCoeffBits);
+			coeffs[tap] = (int16)(value < 0 ? value - 0.5 : value + 0.5);
+			sum += coeffs[tap];
+			if (ABS(coeffs[tap]) > ABS(coeffs[largest]))
+				largest = tap;
+		}
+		coeffs[largest] += (1 << kCoeffBits) - sum;
+	}
+}
+
+bool SincRateConverter::fillHistory(AudioStream &input) {
+	const uint taps = _spec.taps;
+
+	while (_pos + taps > _fill) {
+		// Move the frames still needed to the start of the history. When
+		// downsampling, _pos may also point past the frames read so far.
+		if (_pos > 0) {
+			const uint shift = MIN(_pos, _fill);
+			const uint keep = _fill - shift;
+			memmove(_history[0], _history[0] + shift, keep * sizeof(int16));
+			if (_inStereo)
+				memmove(_history[1], _history[1] + shift, keep * sizeof(int16));
+			_dataEnd -= MIN(_dataEnd, shift);
+			_fill = keep;
+			_pos -= shift;
+		}
+
+		const uint channels = _inStereo ? 2 : 1;
+		const uint space = ARRAYSIZE(_history[0]) - _fill;
+		const int read = input.readBuffer(_readBuffer, MIN<uint>(space, kReadFrames) * channels);
+
+		if (read > 0) {
+			const uint frames = read / channels;
+			if (_inStereo) {
+				for (uint i = 0; i < frames; i++) {
+					_history[0][_fill + i] = _readBuffer[i * 2];
+					_history[1][_fill + i] = _readBuffer[i * 2 + 1];
+				}
+			} else {
+				memcpy(_history[0] + _fill, _readBuffer, frames * sizeof(int16));
+			}
+			_fill += frames;
+			_dataEnd = _fill;
+		} else if (input.endOfData() && _fill < _dataEnd + taps / 2) {
+			// Pad with silence until the last frame reaches the filter center
+			const uint pad = _dataEnd + taps / 2 - _fill;
+			memset(_history[0] + _fill, 0, pad * sizeof(int16));
+			memset(_history[1] + _fill, 0, pad * sizeof(int16));
+			_fill += pad;
+		} else {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int SincRateConverter::convert(AudioStream &input, byte *outBuffer, uint outBytesPerSample, st_size_t numSamples, st_volume_t volL, st_volume_t volR, MixMode mixMode) {
+	assert(input.isStereo() == _inStereo);
+
+	updateFilter();
+
+	const uint taps = _spec.taps;
+	const uint channels = _inStereo ? 2 : 1;
+	const uint outStride = (_outStereo ? 2 : 1) * outBytesPerSample;
+	const bool useKernels = _mixKernels && _outStereo && (outBytesPerSample == sizeof(int16) || mixMode == MIX_ADD);
+
+	int16 block[kMixBlockSize];
+	st_size_t done = 0;
+
+	while (done < numSamples) {
+		const uint blockFrames = MIN<st_size_t>(kMixBlockSize / channels, numSamples - done);
+		uint frames = 0;
+
+		for (; frames < blockFrames; frames++) {
+			if (_pos + taps > _fill && !fillHistory(input))
+				break;
+
+			const uint phase = (uint)(((uint64)_phaseAcc * _phaseScale + (1U << 31)) >> 32);
+			const int16 *coeffs = &_bank[phase * taps];
+			for (uint c = 0; c < channels; c++) {
+				const int32 sum = (_filter(_history[c] + _pos, coeffs, taps) + (1 << (kCoeffBits - 1))) >> kCoeffBits;
+				block[frames * channels + c] = (int16)CLIP<int32>(sum, -32768, 32767);
+			}
+
+			_phaseAcc += _inRate;
+			while (_phaseAcc >= _outRate) {
+				_phaseAcc -= _outRate;
+				_pos++;
+			}
+		}
+
+		if (frames == 0)
+			break;
+
+		byte *out = outBuffer + done * outStride;
+		if (volL == 0 && volR == 0) {
+			// Nothing to add
+		} else if (useKernels && outBytesPerSample == sizeof(int32)) {
+			if (!_inStereo)
+				_mixKernels->mixMono32((int32 *)out, block, frames, volL, volR, false);
+			else if (_reverseStereo)
+				_mixKernels->mixStereoReversed32((int32 *)out, block, frames, volL, volR, false);
+			else
+				_mixKernels->mixStereo32((int32 *)out, block, frames, volL, volR, false);
+		} else if (useKernels) {
+			const bool clamp = (mixMode == MIX_CLAMPED_ADD);
+			if (!_inStereo)
+				_mixKernels->mixMono((int16 *)out, block, frames, volL, volR, clamp);
+			else if (_reverseStereo)
+				_mixKernels->mixStereoReversed((int16 *)out, block, frames, volL, volR, clamp);
+			else
+				_mixKernels->mixStereo((int16 *)out, block, frames, volL, volR, clamp);
+		} else if (outBytesPerSample == sizeof(int32)) {
+			if (mixMode == MIX_ADD)
+				mixBlock<int32, MIX_ADD>(out, block, frames, volL, volR);
+			else
+				mixBlock<int32, MIX_CLAMPED_ADD>(out, block, frames, volL, volR);
+		} else {
+			if (mixMode == MIX_ADD)
+				mixBlock<int16, MIX_ADD>(out, block, frames, volL, volR);
+			else
+				mixBlock<int16, MIX_CLAMPED_ADD>(out, block, frames, volL, volR);
+		}
+
+		done += frames;
+		if (frames < blockFrames)
+			break;
+	}
+
+	return done;
+}
+
+} // End of anonymous namespace
+
+RateConverter *makeSincRateConverter(st_rate_t inRate, st_rate_t outRate, bool inStereo, bool outStereo, bool reverseStereo, RateConverterQuality quality) {
+	assert(quality == kRateConverterSincMedium || quality == kRateConverterSincHigh);
+	return new SincRateConverter(inRate, outRate, inStereo, outStereo, reverseStereo, kSincFilterSpecs[quality - kRateConverterSincMedium]);
+}
+
+} // End of namespace Audio
@@ -0,0 +1,154 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "audio/rate_intern.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Audio {
+
+/**
+ * Scale 8 samples by the per-lane volumes in vol (32-bit lanes, alternating
+ * left/right), dividing by 256 with rounding towards zero.
+ */
+static FORCEINLINE void sse2_scale(__m128i in, __m128i vol, __m128i &lo, __m128i &hi) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi32(255);
+
+	lo = _mm_madd_epi16(_mm_unpacklo_epi16(in, zero), vol);
+	hi = _mm_madd_epi16(_mm_unpackhi_epi16(in, zero), vol);
+	lo = _mm_srai_epi32(_mm_add_epi32(lo, _mm_and_si128(_mm_srai_epi32(lo, 31), bias)), 8);
+	hi = _mm_srai_epi32(_mm_add_epi32(hi, _mm_and_si128(_mm_srai_epi32(hi, 31), bias)), 8);
+}
+
+static FORCEINLINE void sse2_accumulate(int16 *out, __m128i in, __m128i vol, bool clamp) {
+	__m128i lo, hi;
+	sse2_scale(in, vol, lo, hi);
+	const __m128i val = _mm_packs_epi32(lo, hi);
+
+	__m128i dst = _mm_loadu_si128((const __m128i *)out);
+	dst = clamp ? _mm_adds_epi16(dst, val) : _mm_add_epi16(dst, val);
+	_mm_storeu_si128((__m128i *)out, dst);
+}
+
+static FORCEINLINE void sse2_accumulate(int32 *out, __m128i in, __m128i vol, bool clamp) {
+	__m128i lo, hi;
+	sse2_scale(in, vol, lo, hi);
+
+	_mm_storeu_si128((__m128i *)out, _mm_add_epi32(_mm_loadu_si128((const __m128i *)out), lo));
+	_mm_storeu_si128((__m128i *)(out + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(out + 4)), hi));
+}
+
+template<bool reverse, typename T>
+static void mixStereoSSE2(T *out, const int16 *in, uint frames, int volL, int volR, bool clamp) {
+	// Swapping the input pairs turns the reversed case into the regular one
+	const __m128i vol = reverse ? _mm_set_epi32(volL, volR, volL, volR) : _mm_set_epi32(volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 4 <= frames; i += 4) {
+		__m128i src = _mm_loadu_si128((const __m128i *)(in + i * 2));
+		if (reverse)
+			src = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+		sse2_accumulate(out + i * 2, src, vol, clamp);
+	}
+
+	for (; i < frames; i++) {
+		rateMixSampleScalar(out[i * 2 + (reverse ? 1 : 0)], in[i * 2], volL, clamp);
+		rateMixSampleScalar(out[i * 2 + (reverse ? 0 : 1)], in[i * 2 + 1], volR, clamp);
+	}
+}
+
+template<typename T>
+static void mixMonoSSE2(T *out, const int16 *in, uint frames, int volL, int volR, bool clamp) {
+	const __m128i vol = _mm_set_epi32(volR, volL, volR, volL);
+
+	uint i = 0;
+	for (; i + 8 <= frames; i += 8) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)(in + i));
+		sse2_accumulate(out + i * 2, _mm_unpacklo_epi16(src, src), vol, clamp);
+		sse2_accumulate(out + i * 2 + 8, _mm_unpackhi_epi16(src, src), vol, clamp);
+	}
+
+	for (; i < frames; i++) {
+		rateMixSampleScalar(out[i * 2], in[i], volL, clamp);
+		rateMixSampleScalar(out[i * 2 + 1], in[i], volR, clamp);
+	}
+}
+
+static int32 filterSSE2(const int16 *samples, const int16 *coeffs, uint taps) {
+	__m128i sum = _mm_setzero_si128();
+	for (uint i = 0; i < taps; i += 8) {
+		const __m128i src = _mm_loadu_si128((const __m128i *)(samples + i));
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(src, _mm_loadu_si128((const __m128i *)(coeffs + i))));
+	}
+
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum);
+}
+
+static void saturateSSE2(int16 *out, const int32 *in, uint samples) {
+	uint i = 0;
+	for (; i + 8 <= samples; i += 8) {
+		const __m128i lo = _mm_loadu_si128((const __m128i *)(in + i));
+		const __m128i hi = _mm_loadu_si128((const __m128i *)(in + i + 4));
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(lo, hi));
+	}
+
+	for (; i < samples; i++)
+		out[i] = rateSaturateScalar(in[i]);
+}
+
+const RateMixKernels g_rateMixKernelsSSE2 = {
+	mixStereoSSE2<false, int16>,
+	mixStereoSSE2<true, int16>,
+	mixMonoSSE2<int16>,
+	mixStereoSSE2<false, int32>,
+	mixStereoSSE2<true, int32>,
+	mixMonoSSE2<int32>,
+	filterSSE2,
+	saturateSSE2
+};
+
+} // End of namespace Audio
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
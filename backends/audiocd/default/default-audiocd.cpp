@@ -128,8 +128,9 @@ bool DefaultAudioCDManager::play(int track, int numLoops, int startFrame, int du
 			repetitions. Finally, -1 means infinitely many
 			*/
 			_emulating = true;
-			_mixer->playStream(soundType, &_handle,
-			                        Audio::makeLoopingAudioStream(stream, start, end, (numLoops < 1) ? numLoops + 1 : numLoops), -1, _cd.volume, _cd.balance);
+			// The tracks are compressed, so decode them ahead of the mixer
+			Audio::AudioStream *looping = Audio::makeLoopingAudioStream(stream, start, end, (numLoops < 1) ? numLoops + 1 : numLoops);
+			_mixer->playStream(soundType, &_handle, Audio::makePrefetchingAudioStream(looping), -1, _cd.volume, _cd.balance);
 			return true;
 		}
 	}
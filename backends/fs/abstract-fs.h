@@ -172,6 +172,13 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size and the last modification time of the file referred
+	 * by this node. The default implementation returns false.
+	 *
+	 * @return bool true if both values could be retrieved, false otherwise.
+	 */
+	virtual bool getFileStats(int64 &size, int64 &modificationTime) const;
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -33,6 +33,7 @@
 
 #include "backends/fs/posix/posix-fs.h"
 #include "backends/fs/posix/posix-iostream.h"
+#include "backends/fs/posix/posix-mappedstream.h"
 #include "common/algorithm.h"
 
 #include <sys/param.h>
@@ -67,6 +68,16 @@ bool POSIXFilesystemNode::isWritable() const {
 	return access(_path.c_str(), W_OK) == 0;
 }
 
+bool POSIXFilesystemNode::getFileStats(int64 &size, int64 &modificationTime) const {
+	struct stat st;
+	if (stat(_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+		return false;
+
+	size = st.st_size;
+	modificationTime = st.st_mtime;
+	return true;
+}
+
 void POSIXFilesystemNode::setFlags() {
 	struct stat st;
 
@@ -276,6 +287,11 @@ AbstractFSNode *POSIXFilesystemNode::getParent() const {
 }
 
 Common::SeekableReadStream *POSIXFilesystemNode::createReadStream() {
+	// Large files which we do not write are mapped into memory when possible
+	Common::SeekableReadStream *stream = PosixMappedStream::makeFromPath(getPath());
+	if (stream)
+		return stream;
+
 	return PosixIoStream::makeFromPath(getPath(), StdioStream::WriteMode_Read);
 }
 
@@ -0,0 +1,125 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "backends/fs/posix/posix-mappedstream.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/vfs.h>
+#define POSIX_HAS_MMAP
+#elif defined(MACOSX) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+#include <sys/mman.h>
+#include <sys/mount.h>
+#define POSIX_HAS_MMAP
+#endif
+#endif
+
+enum {
+	// Below this size, reading the file is cheaper than setting up
+	// and tearing down a mapping
+	kMinMappedSize = 64 * 1024,
+
+	// Larger files are read through stdio on 32-bit builds, so that a few
+	// of them can not take up a large part of the address space. 64-bit
+	// builds map anything a MemoryReadStream can hold.
+	kMaxMappedSize32 = 64 * 1024 * 1024
+};
+
+#ifdef POSIX_HAS_MMAP
+/**
+ * Return true if the file is stored on a local disk. A failed read of a
+ * mapped file, e.g. on a network share, raises SIGBUS instead of a
+ * stream error.
+ */
+static bool isOnLocalFilesystem(int fd) {
+	struct statfs fs;
+	if (fstatfs(fd, &fs) == -1)
+		return false;
+
+#if defined(__linux__)
+	switch ((uint32)fs.f_type) {
+	case 0x6969:		// NFS
+	case 0x517B:		// SMB
+	case 0xFF534D42:	// CIFS
+	case 0xFE534D42:	// SMB2
+	case 0x65735546:	// FUSE
+	case 0x01021997:	// 9P
+	case 0x73757245:	// Coda
+	case 0x5346414F:	// AFS
+	case 0x00C36400:	// Ceph
+		return false;
+	default:
+		return true;
+	}
+#else
+	return (fs.f_flags & MNT_LOCAL) != 0;
+#endif
+}
+#endif
+
+PosixMappedStream *PosixMappedStream::makeFromPath(const Common::String &path) {
+#ifdef POSIX_HAS_MMAP
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return nullptr;
+
+	// Truncating a mapped file raises SIGBUS when the mapping is read, so
+	// only map files which we can not write, like installed game data, or
+	// which nobody is meant to write. Saves and other files we write use
+	// the stdio stream.
+	const uint32 maxSize = sizeof(void *) >= 8 ? 0xFFFFFFFFU : (uint32)kMaxMappedSize32;
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+	    (access(path.c_str(), W_OK) == 0 && (st.st_mode & (S_IWUSR | S_IWGRP | S_IWOTH))) ||
+	    st.st_size < kMinMappedSize || (uint64)st.st_size > maxSize || !isOnLocalFilesystem(fd)) {
+		close(fd);
+		return nullptr;
+	}
+
+	void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+	// The mapping stays valid once the file is closed
+	close(fd);
+
+	if (mapping == MAP_FAILED)
+		return nullptr;
+
+	return new PosixMappedStream(mapping, st.st_size);
+#else
+	return nullptr;
+#endif
+}
+
+PosixMappedStream::PosixMappedStream(void *mapping, uint32 size) :
+		Common::MemoryReadStream((const byte *)mapping, size), _mapping(mapping) {
+}
+
+PosixMappedStream::~PosixMappedStream() {
+#ifdef POSIX_HAS_MMAP
+	munmap(_mapping, size());
+#endif
+}
@@ -0,0 +1,55 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_POSIXMAPPEDSTREAM_H
+#define BACKENDS_FS_POSIX_POSIXMAPPEDSTREAM_H
+
+#include "common/memstream.h"
+#include "common/str.h"
+
+/**
+ * A read-only file stream backed by a memory mapping of the whole file.
+ *
+ * Reads and seeks are served from the page cache without any system call,
+ * and the pages are shared with everything else mapping or reading the file.
+ *
+ * Only files on local disks which the process can not write, or which have
+ * no write permission at all, are mapped. 32-bit builds only map files of
+ * at most 64 MiB.
+ */
+class PosixMappedStream final : public Common::MemoryReadStream {
+public:
+	/**
+	 * Map the file at @p path. Returns nullptr when the file is not
+	 * suitable for mapping (see above), or can not be mapped, in which case
+	 * the caller should fall back to a regular stream.
+	 */
+	static PosixMappedStream *makeFromPath(const Common::String &path);
+
+	~PosixMappedStream() override;
+
+private:
+	PosixMappedStream(void *mapping, uint32 size);
+
+	void *_mapping;
+};
+
+#endif
@@ -31,6 +31,10 @@
 #include "backends/platform/sdl/win32/win32_wrapper.h"
 #endif
 
+#if defined(POSIX)
+#include <unistd.h>	// for fsync()
+#endif
+
 // Include this after windows.h so we don't get a warning for redefining ARRAYSIZE
 #include "backends/fs/stdiostream.h"
 #include "common/textconsole.h"
@@ -53,18 +57,28 @@ StdioStream::StdioStream(void *handle) : _handle(handle), _path(nullptr) {
 }
 
 StdioStream::~StdioStream() {
-	fclose((FILE *)_handle);
-
 	if (!_path) {
+		fclose((FILE *)_handle);
 		return;
 	}
 
-	// _path is set: recreate the temporary file name and rename the file to
-	// its real name
+	// _path is set: make sure that the data reached the disk, so that a
+	// crash never leaves a truncated file in place of the real one
+	bool failed = fflush((FILE *)_handle) != 0 || ferror((FILE *)_handle) != 0;
+#if defined(POSIX)
+	failed = fsync(fileno((FILE *)_handle)) != 0 || failed;
+#endif
+	failed = fclose((FILE *)_handle) != 0 || failed;
+
+	// Recreate the temporary file name and rename the file to its real
+	// name, unless writing failed, which keeps the previous file intact
 	Common::String tmpPath(*_path);
 	tmpPath += ".tmp";
 
-	if (!moveFile(tmpPath, *_path)) {
+	if (failed) {
+		warning("Couldn't save file %s", _path->c_str());
+		(void)remove(tmpPath.c_str());
+	} else if (!moveFile(tmpPath, *_path)) {
 		warning("Couldn't save file %s", _path->c_str());
 	}
 
@@ -31,6 +31,7 @@
 #include "common/util.h"
 #include "common/file.h"
 #include "common/frac.h"
+#include "common/threadpool.h"
 #ifdef USE_RGB_COLOR
 #include "common/list.h"
 #endif
@@ -117,6 +118,12 @@ static SDL_Surface *createSurface(int width, int height, SDL_Surface *surface) {
 #endif
 }
 
+enum {
+	// Number of worker threads scaling the screen in bands with the
+	// expensive scalers. The calling thread scales one band as well.
+	kScalerThreads = 3
+};
+
 static const OSystem::GraphicsMode s_supportedGraphicsModes[] = {
 	{"surfacesdl", _s("SDL Surface"), GFX_SURFACESDL},
 	{nullptr, nullptr, 0}
@@ -191,7 +198,7 @@ SurfaceSdlGraphicsManager::SurfaceSdlGraphicsManager(SdlEventSource *sdlEventSou
 	_enableFocusRectDebugCode(false), _enableFocusRect(false), _focusRect(),
 #endif
 	_transactionMode(kTransactionNone),
-	_scalerPlugins(ScalerMan.getPlugins()), _scalerPlugin(nullptr), _scaler(nullptr),
+	_scalerPlugins(ScalerMan.getPlugins()), _scalerPlugin(nullptr), _scaler(nullptr), _scalerPool(nullptr),
 	_needRestoreAfterOverlay(false), _isInOverlayPalette(false), _isDoubleBuf(false), _prevForceRedraw(false), _numPrevDirtyRects(0),
 	_prevCursorNeedsRedraw(false),
 	_mouseKeyColor(0), _disableMouseKeyColor(false) {
@@ -244,6 +251,7 @@ SurfaceSdlGraphicsManager::~SurfaceSdlGraphicsManager() {
 	unloadGFXMode();
 	delete _scaler;
 	delete _mouseScaler;
+	delete _scalerPool;
 	if (_mouseOrigSurface) {
 		destroySurface(_mouseOrigSurface);
 		if (_mouseOrigSurface == _mouseSurface) {
@@ -717,6 +725,19 @@ void SurfaceSdlGraphicsManager::setGraphicsModeIntern() {
 	}
 
 	_scaler->setFactor(_videoMode.scaleFactor);
+	if (_scalerPlugin->isThreadSafe() && _scalerPlugin->isExpensive() && _videoMode.scaleFactor > 1) {
+		if (!_scalerPool)
+			_scalerPool = new Common::ThreadPool(kScalerThreads);
+
+		// Without threads, scaling in bands would only add overhead
+		_scaler->setThreadPool(_scalerPool->isAsync() ? _scalerPool : nullptr);
+	} else {
+		// Cheap scalers are faster on this thread alone, so do not keep
+		// idle workers around for them
+		_scaler->setThreadPool(nullptr);
+		delete _scalerPool;
+		_scalerPool = nullptr;
+	}
 	_extraPixels = _scalerPlugin->extraPixels();
 	_useOldSrc = _scalerPlugin->useOldSource();
 	if (_useOldSrc) {
@@ -34,6 +34,10 @@
 
 #include "backends/platform/sdl/sdl-sys.h"
 
+namespace Common {
+class ThreadPool;
+}
+
 #ifndef RELEASE_BUILD
 // Define this to allow for focus rectangle debugging
 #define USE_SDL_DEBUG_FOCUSRECT
@@ -335,6 +339,8 @@ protected:
 	const PluginList &_scalerPlugins;
 	ScalerPluginObject *_scalerPlugin;
 	Scaler *_scaler, *_mouseScaler;
+	/** Worker threads for scalers which support scaling in bands */
+	Common::ThreadPool *_scalerPool;
 	uint _maxExtraPixels;
 	uint _extraPixels;
 
@@ -28,7 +28,7 @@
 #include <android/log.h>
 #include <oboe/Oboe.h>
 
-#include "backends/mixer/android/ringbuffer.h"
+#include "common/ringbuffer.h"
 
 #include "backends/mixer/android/android-mixer.h"
 #include "backends/platform/android/android.h"
@@ -60,7 +60,7 @@ private:
 
 	size_t _chunkSize;
 
-	RingBuffer<frame_t> *_buffer;
+	Common::RingBuffer<frame_t> *_buffer;
 	std::shared_ptr<oboe::AudioStream> _stream_ptr;
 	oboe::LatencyTuner *_latency;
 
@@ -187,11 +187,11 @@ void AndroidMixerManagerImpl::initStream() {
 
 	if (!_buffer) {
 		LOGD("Setting up ring buffer with capacity: %zu", bufferCapacity);
-		_buffer = new RingBuffer<frame_t>(bufferCapacity);
+		_buffer = new Common::RingBuffer<frame_t>(bufferCapacity);
 	} else if (_chunkSize != chunkSize) {
 		LOGD("Reconfiguring ring buffer with capacity: %zu", bufferCapacity);
-		RingBuffer<frame_t> *old_buffer = _buffer;
-		_buffer = new RingBuffer<frame_t>(bufferCapacity, std::move(*old_buffer));
+		Common::RingBuffer<frame_t> *old_buffer = _buffer;
+		_buffer = new Common::RingBuffer<frame_t>(bufferCapacity, std::move(*old_buffer));
 		delete old_buffer;
 	}
 
@@ -228,7 +228,7 @@ oboe::DataCallbackResult AndroidMixerManagerImpl::onAudioReady(oboe::AudioStream
 
 	while (numFrames > 0) {
 		size_t n = numFrames;
-		frame_t *inputData = _buffer->try_consume(&n);
+		frame_t *inputData = _buffer->tryConsume(&n);
 		if (!inputData) {
 			break;
 		}
@@ -383,7 +383,7 @@ void *AndroidMixerManagerImpl::audioThreadFunc(void *arg) {
 		// end Android P/Q workaround for AAudio not detection disconnections
 
 		size_t req = chunkSize;
-		frame_t *outputData = this_->_buffer->try_produce(&req);
+		frame_t *outputData = this_->_buffer->tryProduce(&req);
 		if (!outputData) {
 			// buffer is full: either we have to wait for a new slot or to restart the stream
 			if (started) {
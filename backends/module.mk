@@ -218,6 +218,7 @@ MODULE_OBJS += \
 	mixer/sdl/sdl-mixer.o \
 	mixer/null/null-mixer.o \
 	mutex/sdl/sdl-mutex.o \
+	thread/sdl/sdl-thread.o \
 	timer/sdl/sdl-timer.o
 
 ifndef USE_SDL3
@@ -280,6 +281,7 @@ MODULE_OBJS += \
 	fs/posix/posix-fs.o \
 	fs/posix/posix-fs-factory.o \
 	fs/posix/posix-iostream.o \
+	fs/posix/posix-mappedstream.o \
 	fs/posix-drives/posix-drives-fs.o \
 	fs/posix-drives/posix-drives-fs-factory.o \
 	fs/chroot/chroot-fs-factory.o \
@@ -357,6 +359,7 @@ MODULE_OBJS += \
 	graphics/android/android-graphics.o \
 	mixer/android/android-mixer.o \
 	mutex/pthread/pthread-mutex.o \
+	thread/pthread/pthread-thread.o \
 	networking/basic/android/jni.o \
 	networking/basic/android/socket.o \
 	networking/basic/android/url.o
@@ -408,6 +411,7 @@ MODULE_OBJS += \
 	fs/posix/posix-fs.o \
 	fs/posix/posix-fs-factory.o \
 	fs/posix/posix-iostream.o \
+	fs/posix/posix-mappedstream.o \
 	fs/ps3/ps3-fs-factory.o \
 	events/ps3sdl/ps3sdl-events.o
 endif
@@ -449,6 +453,7 @@ MODULE_OBJS += \
 	fs/posix/posix-fs.o \
 	fs/posix/posix-fs-factory.o \
 	fs/posix/posix-iostream.o \
+	fs/posix/posix-mappedstream.o \
 	fs/posix-drives/posix-drives-fs.o \
 	fs/posix-drives/posix-drives-fs-factory.o \
 	fs/devoptab/devoptab-fs-factory.o \
@@ -460,6 +465,7 @@ ifdef IPHONE
 MODULE_OBJS += \
 	midi/coremidi.o \
 	mutex/pthread/pthread-mutex.o \
+	thread/pthread/pthread-thread.o \
 	graphics/ios/ios-graphics.o \
 	graphics/ios/renderbuffer.o
 
@@ -519,6 +525,7 @@ ifeq ($(BACKEND),psp2)
 MODULE_OBJS += \
 	fs/posix/posix-fs.o \
 	fs/posix/posix-iostream.o \
+	fs/posix/posix-mappedstream.o \
 	fs/posix-drives/posix-drives-fs.o \
 	fs/posix-drives/posix-drives-fs-factory.o \
 	plugins/psp2/psp2-provider.o \
@@ -70,6 +70,7 @@
 #include "backends/events/default/default-events.h"
 #include "backends/mixer/mixer.h"
 #include "backends/mutex/pthread/pthread-mutex.h"
+#include "backends/thread/pthread/pthread-thread.h"
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
 
@@ -773,6 +774,43 @@ Common::MutexInternal *OSystem_Android::createMutex() {
 	return createPthreadMutexInternal();
 }
 
+namespace {
+
+struct JNIThreadStart {
+	Common::ThreadProc proc;
+	void *data;
+};
+
+// Every thread which may end up in Java (e.g. through SAF file nodes)
+// must be attached to the JVM, as the timer thread is
+void jniThreadProc(void *arg) {
+	JNIThreadStart *start = (JNIThreadStart *)arg;
+	const Common::ThreadProc proc = start->proc;
+	void *data = start->data;
+	delete start;
+
+	JNI::attachThread();
+	proc(data);
+	JNI::detachThread();
+}
+
+} // End of anonymous namespace
+
+Common::ThreadInternal *OSystem_Android::createThread(void (*proc)(void *data), void *data) {
+	JNIThreadStart *start = new JNIThreadStart;
+	start->proc = proc;
+	start->data = data;
+
+	Common::ThreadInternal *thread = createPthreadThreadInternal(jniThreadProc, start);
+	if (!thread)
+		delete start;
+	return thread;
+}
+
+Common::SemaphoreInternal *OSystem_Android::createSemaphore(uint initialCount) {
+	return createPthreadSemaphoreInternal(initialCount);
+}
+
 void OSystem_Android::quit() {
 	ENTER();
 
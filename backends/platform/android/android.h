@@ -245,6 +245,8 @@ public:
 	uint32 getMillis(bool skipRecord = false) override;
 	void delayMillis(uint msecs) override;
 	Common::MutexInternal *createMutex() override;
+	Common::ThreadInternal *createThread(void (*proc)(void *data), void *data) override;
+	Common::SemaphoreInternal *createSemaphore(uint initialCount) override;
 
 	void quit() override;
 
@@ -52,6 +52,7 @@
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
 #include "backends/mutex/pthread/pthread-mutex.h"
+#include "backends/thread/pthread/pthread-thread.h"
 #include "backends/fs/chroot/chroot-fs-factory.h"
 #include "backends/fs/posix/posix-fs.h"
 #include "backends/text-to-speech/avfaudio/avfaudio-text-to-speech.h"
@@ -368,6 +369,14 @@ Common::MutexInternal *OSystem_iOS7::createMutex() {
 	return createPthreadMutexInternal();
 }
 
+Common::ThreadInternal *OSystem_iOS7::createThread(void (*proc)(void *data), void *data) {
+	return createPthreadThreadInternal(proc, data);
+}
+
+Common::SemaphoreInternal *OSystem_iOS7::createSemaphore(uint initialCount) {
+	return createPthreadSemaphoreInternal(initialCount);
+}
+
 void OSystem_iOS7::quit() {
 }
 
@@ -50,7 +50,12 @@ typedef void (*sighandler_t)(int);
 #include "common/events.h"
 
 #include "backends/modular-backend.h"
+#include "backends/graphics/null/null-graphics.h"
 #include "backends/mutex/null/null-mutex.h"
+#if defined(POSIX) && defined(NULL_DRIVER_USE_FOR_TEST)
+#include "backends/mutex/pthread/pthread-mutex.h"
+#include "backends/thread/pthread/pthread-thread.h"
+#endif
 #include "base/main.h"
 
 #ifndef NULL_DRIVER_USE_FOR_TEST
@@ -58,7 +63,6 @@ typedef void (*sighandler_t)(int);
 #include "backends/timer/default/default-timer.h"
 #include "backends/events/default/default-events.h"
 #include "backends/mixer/null/null-mixer.h"
-#include "backends/graphics/null/null-graphics.h"
 #include "gui/debugger.h"
 #endif
 
@@ -87,6 +91,11 @@ public:
 	virtual bool pollEvent(Common::Event &event);
 
 	virtual Common::MutexInternal *createMutex();
+#if defined(POSIX) && defined(NULL_DRIVER_USE_FOR_TEST)
+	// Real threads, so that the tests cover the threaded code paths
+	virtual Common::ThreadInternal *createThread(void (*proc)(void *data), void *data);
+	virtual Common::SemaphoreInternal *createSemaphore(uint initialCount);
+#endif
 	virtual uint32 getMillis(bool skipRecord = false);
 	virtual void delayMillis(uint msecs);
 	virtual void getTimeAndDate(TimeDate &td, bool skipRecord = false) const;
@@ -144,6 +153,9 @@ void OSystem_NULL::initBackend() {
 	_startTime = GetTickCount();
 #endif
 
+	// Also used by the tests, so that hasFeature() and friends work
+	_graphicsManager = new NullGraphicsManager();
+
 #ifndef NULL_DRIVER_USE_FOR_TEST
 #ifdef POSIX
 	last_handler = signal(SIGINT, intHandler);
@@ -152,12 +164,15 @@ void OSystem_NULL::initBackend() {
 	_timerManager = new DefaultTimerManager();
 	_eventManager = new DefaultEventManager(this);
 	_savefileManager = new DefaultSaveFileManager();
-	_graphicsManager = new NullGraphicsManager();
 	_mixerManager = new NullMixerManager();
 	// Setup and start mixer
 	_mixerManager->init();
 
 	BaseBackend::initBackend();
+#else
+	// The tests run real threads, so the mutexes which are only created
+	// once the backend is initialized, like the String one, are needed
+	setBackendInitialized();
 #endif
 }
 
@@ -189,9 +204,23 @@ bool OSystem_NULL::pollEvent(Common::Event &event) {
 }
 
 Common::MutexInternal *OSystem_NULL::createMutex() {
+#if defined(POSIX) && defined(NULL_DRIVER_USE_FOR_TEST)
+	return createPthreadMutexInternal();
+#else
 	return new NullMutexInternal();
+#endif
+}
+
+#if defined(POSIX) && defined(NULL_DRIVER_USE_FOR_TEST)
+Common::ThreadInternal *OSystem_NULL::createThread(void (*proc)(void *data), void *data) {
+	return createPthreadThreadInternal(proc, data);
 }
 
+Common::SemaphoreInternal *OSystem_NULL::createSemaphore(uint initialCount) {
+	return createPthreadSemaphoreInternal(initialCount);
+}
+#endif
+
 uint32 OSystem_NULL::getMillis(bool skipRecord) {
 #ifdef POSIX
 	timeval curTime;
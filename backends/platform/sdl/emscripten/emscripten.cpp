@@ -211,6 +211,11 @@ Common::MutexInternal *OSystem_Emscripten::createMutex() {
 	return new NullMutexInternal();
 }
 
+Common::ThreadInternal *OSystem_Emscripten::createThread(void (*proc)(void *data), void *data) {
+	// Mutexes are dummies here, so thread pools must stay synchronous
+	return nullptr;
+}
+
 void OSystem_Emscripten::addSysArchivesToSearchSet(Common::SearchSet &s, int priority) {
 	// Add the global DATA_PATH (and some sub-folders) to the directory search list 
 	// Note: gui-icons folder is added in GuiManager::initIconsSet 
@@ -46,6 +46,7 @@
 #include "backends/events/default/default-events.h"
 #include "backends/keymapper/hardware-input.h"
 #include "backends/mutex/sdl/sdl-mutex.h"
+#include "backends/thread/sdl/sdl-thread.h"
 #include "backends/timer/sdl/sdl-timer.h"
 #include "backends/graphics/surfacesdl/surfacesdl-graphics.h"
 #ifdef USE_OPENGL
@@ -876,6 +877,14 @@ Common::MutexInternal *OSystem_SDL::createMutex() {
 	return createSdlMutexInternal();
 }
 
+Common::ThreadInternal *OSystem_SDL::createThread(void (*proc)(void *data), void *data) {
+	return createSdlThreadInternal(proc, data);
+}
+
+Common::SemaphoreInternal *OSystem_SDL::createSemaphore(uint initialCount) {
+	return createSdlSemaphoreInternal(initialCount);
+}
+
 uint32 OSystem_SDL::getMillis(bool skipRecord) {
 	uint32 millis = SDL_GetTicks();
 
@@ -89,6 +89,8 @@ public:
 	void setWindowCaption(const Common::U32String &caption) override;
 	void addSysArchivesToSearchSet(Common::SearchSet &s, int priority = 0) override;
 	Common::MutexInternal *createMutex() override;
+	Common::ThreadInternal *createThread(void (*proc)(void *data), void *data) override;
+	Common::SemaphoreInternal *createSemaphore(uint initialCount) override;
 	uint32 getMillis(bool skipRecord = false) override;
 	void delayMillis(uint msecs) override;
 	void getTimeAndDate(TimeDate &td, bool skipRecord = false) const override;
@@ -36,6 +36,8 @@
 #include "common/fs.h"
 #include "common/archive.h"
 #include "common/config-manager.h"
+#include "common/memstream.h"
+#include "common/threadpool.h"
 #include "common/compression/deflate.h"
 
 #include <errno.h>	// for removeSavefile()
@@ -44,13 +46,52 @@
 const char *const DefaultSaveFileManager::TIMESTAMPS_FILENAME = "timestamps";
 #endif
 
-DefaultSaveFileManager::DefaultSaveFileManager() {
+const char *const DefaultSaveFileManager::METADATA_INDEX_SUFFIX = ".svmindex";
+
+/**
+ * Compresses and writes an asynchronous save on the save worker thread.
+ */
+class AsyncSaveTask : public Common::Task {
+public:
+	typedef Common::SaveFileManager::AsyncSave AsyncSave;
+	typedef bool (*WriteProc)(const AsyncSave &save, Common::WriteStream *stream);
+	typedef void (*FinishProc)(AsyncSave *save, bool success);
+
+	AsyncSaveTask(AsyncSave *save, Common::WriteStream *stream, WriteProc write, FinishProc finish)
+		: _name(save->name), _save(save), _stream(stream), _write(write), _finish(finish) {}
+
+	void run() override {
+		_finish(_save, _write(*_save, _stream));
+		_save = nullptr;
+		_stream = nullptr;
+	}
+
+	const Common::String &getName() const { return _name; }
+
+private:
+	Common::String _name;
+	AsyncSave *_save;
+	Common::WriteStream *_stream;
+	WriteProc _write;
+	FinishProc _finish;
+};
+
+DefaultSaveFileManager::DefaultSaveFileManager() : _savePool(nullptr), _cloudSyncPending(false), _metadataIndexDirty(false), _metadataIndexOnDisk(false) {
 }
 
-DefaultSaveFileManager::DefaultSaveFileManager(const Common::Path &defaultSavepath) {
+DefaultSaveFileManager::DefaultSaveFileManager(const Common::Path &defaultSavepath) : _savePool(nullptr), _cloudSyncPending(false), _metadataIndexDirty(false), _metadataIndexOnDisk(false) {
 	ConfMan.registerDefault("savepath", defaultSavepath);
 }
 
+DefaultSaveFileManager::~DefaultSaveFileManager() {
+	// The cloud manager may be gone already. The saves of the engines are
+	// synced when they quit, see runGame().
+	_cloudSyncPending = false;
+	waitForPendingSaves();
+	delete _savePool;
+	flushSaveMetadata();
+}
+
 
 void DefaultSaveFileManager::checkPath(const Common::FSNode &dir) {
 	clearError();
@@ -69,9 +110,15 @@ void DefaultSaveFileManager::updateSavefilesList(Common::StringArray &lockedFile
 
 	//remember the locked files list because some of these files don't exist yet
 	_lockedFiles = lockedFiles;
+
+	//the locked files are being downloaded, so their metadata is outdated
+	for (const auto &lockedFile : lockedFiles)
+		invalidateSaveMetadata(lockedFile);
 }
 
 Common::StringArray DefaultSaveFileManager::listSavefiles(const Common::String &pattern) {
+	reapFinishedSaves();
+
 	// Assure the savefile name cache is up-to-date.
 	assureCached(getSavePath());
 	if (getError().getCode() != Common::kNoError)
@@ -84,6 +131,8 @@ Common::StringArray DefaultSaveFileManager::listSavefiles(const Common::String &
 
 	Common::StringArray results;
 	for (const auto &file : _saveFileCache) {
+		if (file._key.hasSuffixIgnoreCase(METADATA_INDEX_SUFFIX))
+			continue;
 		if (!locked.contains(file._key) && file._key.matchString(pattern, true)) {
 			results.push_back(file._key);
 		}
@@ -92,6 +141,8 @@ Common::StringArray DefaultSaveFileManager::listSavefiles(const Common::String &
 }
 
 Common::InSaveFile *DefaultSaveFileManager::openRawFile(const Common::String &filename) {
+	waitForPendingSaves(filename);
+
 	// Assure the savefile name cache is up-to-date.
 	assureCached(getSavePath());
 	if (getError().getCode() != Common::kNoError)
@@ -108,6 +159,8 @@ Common::InSaveFile *DefaultSaveFileManager::openRawFile(const Common::String &fi
 }
 
 Common::InSaveFile *DefaultSaveFileManager::openForLoading(const Common::String &filename) {
+	waitForPendingSaves(filename);
+
 	// Assure the savefile name cache is up-to-date.
 	assureCached(getSavePath());
 	if (getError().getCode() != Common::kNoError)
@@ -132,6 +185,15 @@ Common::InSaveFile *DefaultSaveFileManager::openForLoading(const Common::String
 }
 
 Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String &filename, bool compress) {
+	waitForPendingSaves(filename);
+
+	Common::SeekableWriteStream *const sf = createSaveStream(filename);
+	if (!sf)
+		return nullptr;
+	return new Common::OutSaveFile(compress ? Common::wrapCompressedWriteStream(sf) : sf);
+}
+
+Common::SeekableWriteStream *DefaultSaveFileManager::createSaveStream(const Common::String &filename, bool atomic) {
 	// Assure the savefile name cache is up-to-date.
 	const Common::Path savePathName = getSavePath();
 	assureCached(savePathName);
@@ -151,6 +213,8 @@ Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String
 	saveTimestamps(timestamps);
 #endif
 
+	invalidateSaveMetadata(filename);
+
 	// Obtain node.
 	SaveFileCache::const_iterator file = _saveFileCache.find(filename);
 	Common::FSNode fileNode;
@@ -164,18 +228,243 @@ Common::OutSaveFile *DefaultSaveFileManager::openForSaving(const Common::String
 	}
 
 	// Open the file for saving.
-	Common::SeekableWriteStream *const sf = fileNode.createWriteStream(false);
+	Common::SeekableWriteStream *const sf = fileNode.createWriteStream(atomic);
 	if (!sf)
 		return nullptr;
-	Common::OutSaveFile *const result = new Common::OutSaveFile(compress ? Common::wrapCompressedWriteStream(sf) : sf);
 
 	// Add file to cache now that it exists.
 	_saveFileCache[filename] = Common::FSNode(fileNode.getPath());
 
-	return result;
+	return sf;
+}
+
+void DefaultSaveFileManager::commitAsyncSave(AsyncSave *save) {
+	// Two streams writing the same file at once would mix their data
+	waitForPendingSaves(save->name);
+
+	// The data goes to a temporary file which replaces the save file once
+	// complete, so that the previous save survives a crash while writing
+	Common::SeekableWriteStream *sf = createSaveStream(save->name, true);
+	if (!sf) {
+		finishAsyncSave(save, false);
+		return;
+	}
+
+	if (!_savePool)
+		_savePool = new Common::ThreadPool(1);
+
+	AsyncSaveTask *task = new AsyncSaveTask(save, sf, &writeAsyncSave, &finishAsyncSave);
+	_pendingSaves.push_back(task);
+	_savePool->submit(task);
+
+#ifdef USE_CLOUD
+	// Sync once the file is written rather than when its OutSaveFile is
+	// deleted, so that a partial file never gets uploaded
+	_cloudSyncPending = true;
+#endif
+}
+
+void DefaultSaveFileManager::waitForPendingSaves() {
+	waitForPendingSaves(Common::String());
+}
+
+void DefaultSaveFileManager::waitForPendingSaves(const Common::String &filename) {
+	// Saves complete in order, so wait up to the last one matching
+	uint count = 0;
+	uint index = 0;
+	for (const auto &task : _pendingSaves) {
+		index++;
+		if (filename.empty() || task->getName().equalsIgnoreCase(filename))
+			count = index;
+	}
+
+	for (; count > 0; count--) {
+		AsyncSaveTask *task = _pendingSaves.front();
+		task->wait();
+		_pendingSaves.pop_front();
+		delete task;
+	}
+
+	reapFinishedSaves();
+}
+
+void DefaultSaveFileManager::reapFinishedSaves() {
+	while (!_pendingSaves.empty() && _pendingSaves.front()->isDone()) {
+		delete _pendingSaves.front();
+		_pendingSaves.pop_front();
+	}
+
+#ifdef USE_CLOUD
+	if (_cloudSyncPending && _pendingSaves.empty()) {
+		_cloudSyncPending = false;
+		CloudMan.syncSaves();
+	}
+#endif
+}
+
+Common::String DefaultSaveFileManager::getMetadataIndexName(const Common::String &filename) {
+	const char *ext = strrchr(filename.c_str(), '.');
+	const uint prefixLength = ext ? ext - filename.c_str() : filename.size();
+	return Common::String(filename.c_str(), prefixLength) + METADATA_INDEX_SUFFIX;
+}
+
+bool DefaultSaveFileManager::loadMetadataIndex(const Common::String &indexName) {
+	const Common::Path savePath = getSavePath();
+	if (indexName.equalsIgnoreCase(_metadataIndexName) && savePath == _metadataIndexPath)
+		return true;
+
+	flushSaveMetadata();
+	_metadataIndex.clear();
+	_metadataIndexName.clear();
+	_metadataIndexOnDisk = false;
+
+	// Assure the savefile name cache is up-to-date.
+	assureCached(savePath);
+	if (getError().getCode() != Common::kNoError)
+		return false;
+
+	_metadataIndexName = indexName;
+	_metadataIndexPath = savePath;
+
+	SaveFileCache::const_iterator file = _saveFileCache.find(indexName);
+	if (file == _saveFileCache.end())
+		return true;
+	_metadataIndexOnDisk = true;
+
+	Common::ScopedPtr<Common::SeekableReadStream> in(file->_value.createReadStream());
+	if (!in || in->readUint32BE() != MKTAG('S', 'V', 'M', 'I') || in->readUint32LE() != 2)
+		return true;
+
+	const uint32 count = in->readUint32LE();
+	bool corrupt = false;
+	for (uint32 i = 0; i < count && !corrupt; i++) {
+		const Common::String name = in->readPascalString();
+		const int64 fileSize = in->readSint64LE();
+		const int64 modificationTime = in->readSint64LE();
+		const uint32 size = in->readUint32LE();
+		corrupt = in->eos() || in->err() || size > in->size() - in->pos();
+		if (corrupt)
+			break;
+
+		MetadataEntry &entry = _metadataIndex[name];
+		entry.fileSize = fileSize;
+		entry.modificationTime = modificationTime;
+		entry.data.resize(size);
+		in->read(entry.data.data(), size);
+	}
+
+	if (corrupt || in->eos() || in->err()) {
+		warning("DefaultSaveFileManager: Ignoring corrupt metadata index '%s'", indexName.c_str());
+		_metadataIndex.clear();
+	}
+	return true;
+}
+
+void DefaultSaveFileManager::invalidateSaveMetadata(const Common::String &filename) {
+	const Common::String indexName = getMetadataIndexName(filename);
+	const bool isCurrent = indexName.equalsIgnoreCase(_metadataIndexName) && getSavePath() == _metadataIndexPath;
+	if (!isCurrent && !_saveFileCache.contains(indexName))
+		return;
+
+	if (!loadMetadataIndex(indexName) || !_metadataIndex.contains(filename))
+		return;
+
+	_metadataIndex.erase(filename);
+	_metadataIndexDirty = true;
+
+	// The index is only rewritten by the next flushSaveMetadata(), but the
+	// save file is about to change. Delete the index from the disk in the
+	// meantime, so that its outdated entry is never used if we don't get
+	// the chance to write it, which is cheaper than rewriting it now.
+	if (_metadataIndexOnDisk) {
+		const Common::FSNode indexNode = Common::FSNode(_metadataIndexPath).getChild(_metadataIndexName);
+		if (removeFile(indexNode) == Common::kNoError) {
+			_saveFileCache.erase(_metadataIndexName);
+			_metadataIndexOnDisk = false;
+		} else {
+			// Fall back to writing it right away
+			flushSaveMetadata();
+		}
+	}
+}
+
+Common::SeekableReadStream *DefaultSaveFileManager::openSaveMetadata(const Common::String &filename) {
+	if (!loadMetadataIndex(getMetadataIndexName(filename)))
+		return nullptr;
+
+	MetadataIndex::iterator entry = _metadataIndex.find(filename);
+	if (entry == _metadataIndex.end())
+		return nullptr;
+
+	// Drop the entries of save files which were changed behind our back,
+	// e.g. copied over by the user
+	int64 fileSize, modificationTime;
+	getSaveFileStats(filename, fileSize, modificationTime);
+	if (fileSize != entry->_value.fileSize || modificationTime != entry->_value.modificationTime) {
+		_metadataIndex.erase(entry);
+		_metadataIndexDirty = true;
+		return nullptr;
+	}
+
+	return new Common::MemoryReadStream(entry->_value.data.data(), entry->_value.data.size());
+}
+
+void DefaultSaveFileManager::storeSaveMetadata(const Common::String &filename, const byte *data, uint32 size) {
+	// Names are stored with a single length byte
+	if (filename.size() > 255)
+		return;
+
+	if (!loadMetadataIndex(getMetadataIndexName(filename)))
+		return;
+
+	MetadataEntry &entry = _metadataIndex[filename];
+	getSaveFileStats(filename, entry.fileSize, entry.modificationTime);
+	entry.data = Common::Array<byte>(data, size);
+	_metadataIndexDirty = true;
+}
+
+void DefaultSaveFileManager::getSaveFileStats(const Common::String &filename, int64 &size, int64 &modificationTime) {
+	SaveFileCache::const_iterator file = _saveFileCache.find(filename);
+	if (file == _saveFileCache.end() || !file->_value.getFileStats(size, modificationTime))
+		size = modificationTime = -1;
+}
+
+void DefaultSaveFileManager::flushSaveMetadata() {
+	if (!_metadataIndexDirty)
+		return;
+	_metadataIndexDirty = false;
+
+	// This is not a save file, so it is written directly: it must not be
+	// synced to the cloud.
+	const Common::FSNode indexNode = Common::FSNode(_metadataIndexPath).getChild(_metadataIndexName);
+	Common::ScopedPtr<Common::SeekableWriteStream> out(indexNode.createWriteStream(false));
+	if (!out) {
+		warning("DefaultSaveFileManager: Failed to write metadata index '%s'", _metadataIndexName.c_str());
+		return;
+	}
+	_saveFileCache[_metadataIndexName] = Common::FSNode(indexNode.getPath());
+
+	out->writeUint32BE(MKTAG('S', 'V', 'M', 'I'));
+	out->writeUint32LE(2);
+	out->writeUint32LE(_metadataIndex.size());
+	for (const auto &entry : _metadataIndex) {
+		out->writeByte(entry._key.size());
+		out->writeString(entry._key);
+		out->writeSint64LE(entry._value.fileSize);
+		out->writeSint64LE(entry._value.modificationTime);
+		out->writeUint32LE(entry._value.data.size());
+		out->write(entry._value.data.data(), entry._value.data.size());
+	}
+
+	out->finalize();
+	if (out->err())
+		warning("DefaultSaveFileManager: Failed to write metadata index '%s'", _metadataIndexName.c_str());
+	_metadataIndexOnDisk = true;
 }
 
 bool DefaultSaveFileManager::removeSavefile(const Common::String &filename) {
+	waitForPendingSaves(filename);
+
 	// Assure the savefile name cache is up-to-date.
 	assureCached(getSavePath());
 	if (getError().getCode() != Common::kNoError)
@@ -191,6 +480,8 @@ bool DefaultSaveFileManager::removeSavefile(const Common::String &filename) {
 	}
 #endif
 
+	invalidateSaveMetadata(filename);
+
 	// Obtain node if exists.
 	SaveFileCache::const_iterator file = _saveFileCache.find(filename);
 	if (file == _saveFileCache.end()) {
@@ -222,6 +513,8 @@ Common::ErrorCode DefaultSaveFileManager::removeFile(const Common::FSNode &fileN
 }
 
 bool DefaultSaveFileManager::exists(const Common::String &filename) {
+	reapFinishedSaves();
+
 	// Assure the savefile name cache is up-to-date.
 	assureCached(getSavePath());
 	if (getError().getCode() != Common::kNoError)
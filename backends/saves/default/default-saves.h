@@ -27,6 +27,13 @@
 #include "common/str.h"
 #include "common/fs.h"
 #include "common/hash-str.h"
+#include "common/list.h"
+
+namespace Common {
+class ThreadPool;
+}
+
+class AsyncSaveTask;
 
 /**
  * Provides a default savefile manager implementation for common platforms.
@@ -35,6 +42,7 @@ class DefaultSaveFileManager : public Common::SaveFileManager {
 public:
 	DefaultSaveFileManager();
 	DefaultSaveFileManager(const Common::Path &defaultSavepath);
+	~DefaultSaveFileManager() override;
 
 	void updateSavefilesList(Common::StringArray &lockedFiles) override;
 	Common::StringArray listSavefiles(const Common::String &pattern) override;
@@ -43,6 +51,10 @@ public:
 	Common::OutSaveFile *openForSaving(const Common::String &filename, bool compress = true) override;
 	bool removeSavefile(const Common::String &filename) override;
 	bool exists(const Common::String &filename) override;
+	void waitForPendingSaves() override;
+	Common::SeekableReadStream *openSaveMetadata(const Common::String &filename) override;
+	void storeSaveMetadata(const Common::String &filename, const byte *data, uint32 size) override;
+	void flushSaveMetadata() override;
 
 #ifdef USE_CLOUD
 
@@ -82,6 +94,84 @@ protected:
 	 */
 	void assureCached(const Common::Path &savePathName);
 
+	/**
+	 * Create the save file, register it in the cache and return a stream
+	 * writing to it, or nullptr if an error occurred. If @p atomic is true,
+	 * the data is written to a temporary file which replaces the save file
+	 * once the stream is deleted.
+	 */
+	Common::SeekableWriteStream *createSaveStream(const Common::String &filename, bool atomic = false);
+
+	/**
+	 * Compress and write the save file on a worker thread.
+	 */
+	void commitAsyncSave(AsyncSave *save) override;
+
+	/**
+	 * Block until the pending asynchronous saves are written. If
+	 * @p filename is not empty, only wait if one of them writes that
+	 * save file.
+	 */
+	void waitForPendingSaves(const Common::String &filename);
+
+	/**
+	 * Forget the asynchronous saves which are written, without blocking.
+	 * Once all are, the saves are synced with the cloud.
+	 */
+	void reapFinishedSaves();
+
+	/**
+	 * Suffix of the files holding the metadata of the save files sharing
+	 * the same name up to the extension, typically those of one target.
+	 */
+	static const char *const METADATA_INDEX_SUFFIX;
+
+	/**
+	 * Return the name of the index file holding the metadata of a save file.
+	 */
+	static Common::String getMetadataIndexName(const Common::String &filename);
+
+	/**
+	 * Make the given index current, loading it from the save path if
+	 * it is not yet. Returns false if the save path can't be used.
+	 */
+	bool loadMetadataIndex(const Common::String &indexName);
+
+	/**
+	 * Drop the stored metadata of a save file, which is about to change.
+	 */
+	void invalidateSaveMetadata(const Common::String &filename);
+
+	/**
+	 * Metadata of a save file, along with the size and modification time
+	 * the save file had when it was stored, or -1 if they are unknown.
+	 */
+	struct MetadataEntry {
+		int64 fileSize;
+		int64 modificationTime;
+		Common::Array<byte> data;
+
+		MetadataEntry() : fileSize(-1), modificationTime(-1) {}
+	};
+
+	/**
+	 * Retrieve the size and modification time of a save file, or -1 if
+	 * they are unknown.
+	 */
+	void getSaveFileStats(const Common::String &filename, int64 &size, int64 &modificationTime);
+
+	typedef Common::HashMap<Common::String, MetadataEntry, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> MetadataIndex;
+
+	/**
+	 * Metadata of the save files of the current index, whether it changed
+	 * since it was last written, and whether the index file exists.
+	 */
+	Common::Path _metadataIndexPath;
+	Common::String _metadataIndexName;
+	MetadataIndex _metadataIndex;
+	bool _metadataIndexDirty;
+	bool _metadataIndexOnDisk;
+
 	typedef Common::HashMap<Common::String, Common::FSNode, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> SaveFileCache;
 
 	/**
@@ -104,6 +194,23 @@ private:
 	 * The currently cached directory.
 	 */
 	Common::Path _cachedDirectory;
+
+	/**
+	 * Worker thread writing asynchronous saves, created on first use.
+	 * A single thread keeps the saves in order.
+	 */
+	Common::ThreadPool *_savePool;
+
+	/**
+	 * Asynchronous saves not reaped yet, in submission order.
+	 */
+	Common::List<AsyncSaveTask *> _pendingSaves;
+
+	/**
+	 * Whether asynchronous saves were written since the saves were last
+	 * synced with the cloud.
+	 */
+	bool _cloudSyncPending;
 };
 
 #endif
@@ -20,20 +20,23 @@
  */
 
 #include "common/util.h"
+#include "common/memstream.h"
 #include "common/savefile.h"
 #include "common/str.h"
+#include "common/compression/deflate.h"
 #ifdef USE_CLOUD
 #include "backends/cloud/cloudmanager.h"
 #endif
 
 namespace Common {
 
-OutSaveFile::OutSaveFile(WriteStream *w): _wrapped(w) {}
+OutSaveFile::OutSaveFile(WriteStream *w, bool syncOnClose): _wrapped(w), _syncOnClose(syncOnClose) {}
 
 OutSaveFile::~OutSaveFile() {
 	delete _wrapped;
 #ifdef USE_CLOUD
-	CloudMan.syncSaves();
+	if (_syncOnClose)
+		CloudMan.syncSaves();
 #endif
 }
 
@@ -79,6 +82,88 @@ int64 OutSaveFile::size() const {
 	}
 }
 
+/**
+ * Keeps the data of a save file opened with openForSavingAsync() in
+ * memory, and hands it to the save file manager once finalized.
+ */
+class AsyncSaveStream : public SeekableWriteStream {
+public:
+	AsyncSaveStream(SaveFileManager *manager, SaveFileManager::AsyncSave *save)
+		: _manager(manager), _save(save), _buffer(DisposeAfterUse::NO) {}
+
+	~AsyncSaveStream() override {
+		finalize();
+	}
+
+	bool err() const override { return _buffer.err(); }
+	void clearErr() override { _buffer.clearErr(); }
+
+	void finalize() override {
+		if (!_save)
+			return;
+
+		_save->data = _buffer.getData();
+		_save->size = _buffer.size();
+		_manager->commitAsyncSave(_save);
+		_save = nullptr;
+	}
+
+	uint32 write(const void *dataPtr, uint32 dataSize) override {
+		if (!_save)
+			return 0;
+		return _buffer.write(dataPtr, dataSize);
+	}
+
+	int64 pos() const override { return _buffer.pos(); }
+	bool seek(int64 offset, int whence = SEEK_SET) override { return _buffer.seek(offset, whence); }
+	int64 size() const override { return _buffer.size(); }
+
+private:
+	SaveFileManager *_manager;
+	SaveFileManager::AsyncSave *_save;
+	MemoryWriteStreamDynamic _buffer;
+};
+
+OutSaveFile *SaveFileManager::openForSavingAsync(const String &name, bool compress, int compressionLevel, AsyncSaveCallback *callback) {
+	AsyncSave *save = new AsyncSave();
+	save->name = name;
+	save->compress = compress;
+	save->compressionLevel = compressionLevel;
+	save->callback = callback;
+	// The save file may not be written yet when this is deleted, so it is
+	// up to commitAsyncSave() to sync it
+	return new OutSaveFile(new AsyncSaveStream(this, save), false);
+}
+
+void SaveFileManager::commitAsyncSave(AsyncSave *save) {
+	OutSaveFile *file = openForSaving(save->name, false);
+	finishAsyncSave(save, file && writeAsyncSave(*save, file));
+}
+
+bool SaveFileManager::writeAsyncSave(const AsyncSave &save, WriteStream *stream) {
+	if (save.compress)
+		stream = wrapCompressedWriteStream(stream, save.compressionLevel);
+
+	bool success = stream->write(save.data, save.size) == save.size;
+	stream->finalize();
+	success = success && !stream->err();
+	delete stream;
+	return success;
+}
+
+void SaveFileManager::finishAsyncSave(AsyncSave *save, bool success) {
+	if (!success)
+		warning("Failed to write save file '%s'", save->name.c_str());
+
+	if (save->callback) {
+		AsyncSaveResult result;
+		result.name = save->name;
+		result.success = success;
+		(*save->callback)(result);
+	}
+	delete save;
+}
+
 bool SaveFileManager::copySavefile(const String &oldFilename, const String &newFilename, bool compress) {
 	InSaveFile *inFile = nullptr;
 	OutSaveFile *outFile = nullptr;
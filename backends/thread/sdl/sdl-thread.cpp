@@ -0,0 +1,123 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/thread/sdl/sdl-thread.h"
+#include "backends/platform/sdl/sdl-sys.h"
+
+#include "common/textconsole.h"
+
+/**
+ * SDL thread implementation
+ */
+class SdlThreadInternal final : public Common::ThreadInternal {
+public:
+	SdlThreadInternal(Common::ThreadProc proc, void *data) : _proc(proc), _data(data), _thread(nullptr) {}
+
+	bool start();
+	bool join() override;
+
+private:
+	static int SDLCALL threadFunc(void *arg);
+
+	Common::ThreadProc _proc;
+	void *_data;
+	SDL_Thread *_thread;
+};
+
+int SDLCALL SdlThreadInternal::threadFunc(void *arg) {
+	SdlThreadInternal *self = (SdlThreadInternal *)arg;
+	self->_proc(self->_data);
+	return 0;
+}
+
+bool SdlThreadInternal::start() {
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	_thread = SDL_CreateThread(threadFunc, "ScummVM worker", this);
+#else
+	_thread = SDL_CreateThread(threadFunc, this);
+#endif
+	if (!_thread) {
+		warning("SDL_CreateThread() failed: %s", SDL_GetError());
+		return false;
+	}
+	return true;
+}
+
+bool SdlThreadInternal::join() {
+	if (!_thread)
+		return false;
+
+	SDL_WaitThread(_thread, nullptr);
+	_thread = nullptr;
+	return true;
+}
+
+/**
+ * SDL semaphore implementation
+ */
+class SdlSemaphoreInternal final : public Common::SemaphoreInternal {
+public:
+	SdlSemaphoreInternal(uint initialCount) { _sem = SDL_CreateSemaphore(initialCount); }
+	~SdlSemaphoreInternal() override { SDL_DestroySemaphore(_sem); }
+
+	bool wait() override {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+		SDL_WaitSemaphore(_sem);
+		return true;
+#else
+		return (SDL_SemWait(_sem) == 0);
+#endif
+	}
+	bool post() override {
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+		SDL_SignalSemaphore(_sem);
+		return true;
+#else
+		return (SDL_SemPost(_sem) == 0);
+#endif
+	}
+
+private:
+#if SDL_VERSION_ATLEAST(3, 0, 0)
+	SDL_Semaphore *_sem;
+#else
+	SDL_sem *_sem;
+#endif
+};
+
+Common::ThreadInternal *createSdlThreadInternal(Common::ThreadProc proc, void *data) {
+	SdlThreadInternal *thread = new SdlThreadInternal(proc, data);
+	if (!thread->start()) {
+		delete thread;
+		return nullptr;
+	}
+	return thread;
+}
+
+Common::SemaphoreInternal *createSdlSemaphoreInternal(uint initialCount) {
+	return new SdlSemaphoreInternal(initialCount);
+}
+
+#endif
@@ -25,79 +25,168 @@
 #include "common/system.h"
 
 
-void insertPrioQueue(TimerSlot *head, TimerSlot *newSlot) {
-	// The head points to a fake anchor TimerSlot; this common
-	// trick allows us to get rid of many special cases.
-
-	const uint32 nextFireTime = newSlot->nextFireTime;
-	TimerSlot *slot = head;
-	newSlot->next = nullptr;
-
-	// Insert the new slot into the sorted list of already scheduled
-	// timers in such a way that the list stays sorted...
-	while (true) {
-		assert(slot);
-		if (slot->next == nullptr || nextFireTime < slot->next->nextFireTime) {
-			newSlot->next = slot->next;
-			slot->next = newSlot;
-			return;
-		}
-		slot = slot->next;
-	}
+void TimerListNode::detach() {
+	prev->next = next;
+	next->prev = prev;
+	prev = next = this;
+}
+
+void TimerListNode::append(TimerListNode *node) {
+	node->prev = prev;
+	node->next = this;
+	prev->next = node;
+	prev = node;
+}
+
+void TimerListNode::spliceTo(TimerListNode *list) {
+	if (empty())
+		return;
+
+	// Move all nodes to the end of the other list
+	next->prev = list->prev;
+	prev->next = list;
+	list->prev->next = next;
+	list->prev = prev;
+	prev = next = this;
 }
 
 
 DefaultTimerManager::DefaultTimerManager() :
 	_timerCallbackNext(0),
-	_head(nullptr) {
-
-	_head = new TimerSlot();
+	_wheelTime(0) {
 }
 
 DefaultTimerManager::~DefaultTimerManager() {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
-	while (slot) {
-		TimerSlot *next = slot->next;
-		delete slot;
-		slot = next;
+	for (auto &slot : _slots)
+		delete slot._value;
+	_slots.clear();
+}
+
+void DefaultTimerManager::scheduleSlot(TimerSlot *slot) {
+	const uint32 fireTime = slot->nextFireTime;
+	const int32 delta = (int32)(fireTime - _wheelTime);
+
+	if (delta < 0) {
+		// Already due, for instance because its interval is below one
+		// millisecond: run it with the current tick
+		_expired.append(slot);
+		return;
+	}
+
+	if (delta < kRootSize) {
+		_root[fireTime & (kRootSize - 1)].append(slot);
+		return;
+	}
+
+	for (int level = 0; level < kNumLevels; level++) {
+		const int shift = kRootBits + level * kLevelBits;
+		if (level == kNumLevels - 1 || (uint32)delta < (1u << (shift + kLevelBits))) {
+			_levels[level][(fireTime >> shift) & (kLevelSize - 1)].append(slot);
+			return;
+		}
+	}
+}
+
+bool DefaultTimerManager::cascade(int level) {
+	const int shift = kRootBits + level * kLevelBits;
+	const uint32 index = (_wheelTime >> shift) & (kLevelSize - 1);
+
+	// The timers of this bucket are due before the level wraps around again,
+	// so they all go to lower levels
+	TimerListNode list;
+	_levels[level][index].spliceTo(&list);
+	while (!list.empty()) {
+		TimerSlot *slot = (TimerSlot *)list.next;
+		slot->detach();
+		scheduleSlot(slot);
+	}
+
+	// The next level needs to cascade too when this one wraps around
+	return index == 0;
+}
+
+void DefaultTimerManager::fireSlot(TimerSlot *slot, uint32 curTime) {
+	// Update the statistics
+	const uint32 lateness = curTime - slot->nextFireTime;
+	slot->fireCount++;
+	if ((uint64)lateness * 1000 > slot->interval)
+		slot->lateCount++;
+	slot->maxLateness = MAX(slot->maxLateness, lateness);
+
+	// Update the fire time and reschedule the TimerSlot. The fire time is
+	// advanced by the interval instead of being based on the current time,
+	// so that late calls don't make the timer drift.
+	assert(slot->interval > 0);
+	slot->nextFireTime += (slot->interval / 1000);
+	slot->nextFireTimeMicro += (slot->interval % 1000);
+	if (slot->nextFireTimeMicro >= 1000) {
+		slot->nextFireTime += slot->nextFireTimeMicro / 1000;
+		slot->nextFireTimeMicro %= 1000;
+	}
+
+	// If the timer fell too far behind, for instance because the system was
+	// suspended, skip the missed calls instead of making them all at once.
+	const int32 behind = (int32)(curTime - slot->nextFireTime);
+	if (behind > (int32)kMaxCatchUpTime) {
+		const uint64 skipped = (uint64)behind * 1000 / slot->interval;
+		const uint64 skippedTime = skipped * slot->interval + slot->nextFireTimeMicro;
+		slot->nextFireTime += (uint32)(skippedTime / 1000);
+		slot->nextFireTimeMicro = (uint32)(skippedTime % 1000);
+		slot->skipCount += (uint32)skipped;
 	}
-	_head = nullptr;
+
+	scheduleSlot(slot);
+
+	// Invoke the timer callback
+	assert(slot->callback);
+	slot->callback(slot->refCon);
 }
 
 void DefaultTimerManager::handler() {
-	Common::StackLock lock(_mutex);
+	runTimers(g_system->getMillis(true));
+}
 
-	uint32 curTime = g_system->getMillis(true);
+void DefaultTimerManager::runTimers(uint32 curTime) {
+	Common::StackLock lock(_mutex);
 
-	// On slow systems this could still be run after destructor
-	if (!_head)
-		return;
+	// Run every tick before the current time. A TimerSlot is scheduled to
+	// fire when its fire time is before the current time.
+	while ((int32)(curTime - _wheelTime) > 0) {
+		// On slow systems this could still be run after destructor
+		if (_slots.empty()) {
+			_wheelTime = curTime;
+			break;
+		}
 
-	// Repeat as long as there is a TimerSlot that is scheduled to fire.
-	TimerSlot *slot = _head->next;
-	while (slot && slot->nextFireTime < curTime) {
-		// Remove the slot from the priority queue
-		_head->next = slot->next;
-
-		// Update the fire time and reinsert the TimerSlot into the priority
-		// queue.
-		assert(slot->interval > 0);
-		slot->nextFireTime += (slot->interval / 1000);
-		slot->nextFireTimeMicro += (slot->interval % 1000);
-		if (slot->nextFireTimeMicro > 1000) {
-			slot->nextFireTime += slot->nextFireTimeMicro / 1000;
-			slot->nextFireTimeMicro %= 1000;
+		const uint32 index = _wheelTime & (kRootSize - 1);
+		if (index == 0) {
+			for (int level = 0; level < kNumLevels && cascade(level); level++)
+				;
 		}
-		insertPrioQueue(_head, slot);
 
-		// Invoke the timer callback
-		assert(slot->callback);
-		slot->callback(slot->refCon);
+		// Jump over the empty buckets, up to the current time or to the next
+		// wrap around, which may need a cascade
+		const uint32 end = index + MIN<uint32>(curTime - _wheelTime, kRootSize - index);
+		uint32 next = index;
+		while (next < end && _root[next].empty())
+			next++;
 
-		// Look at the next scheduled timer
-		slot = _head->next;
+		_wheelTime += next - index;
+		if (next == end)
+			continue;
+
+		_root[next].spliceTo(&_expired);
+		_wheelTime++;
+
+		// The callbacks may remove any timer, including the ones left in
+		// the list, so it is only walked through its head
+		while (!_expired.empty()) {
+			TimerSlot *slot = (TimerSlot *)_expired.next;
+			slot->detach();
+			fireSlot(slot, curTime);
+		}
 	}
 }
 
@@ -115,29 +204,31 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 	assert(interval > 0);
 	Common::StackLock lock(_mutex);
 
-	if (_callbacks.contains(id)) {
-		if (_callbacks[id] != callback) {
-			error("Different callbacks are referred by same name (%s)", id.c_str());
-		}
+	TimerSlotMap::const_iterator existing = _callbacks.find(id);
+	if (existing != _callbacks.end() && existing->_value != callback) {
+		error("Different callbacks are referred by same name (%s)", id.c_str());
 	}
 
-	for (const auto &curCallback : _callbacks) {
-		if (curCallback._value == callback) {
-			error("Same callback added twice (old name: %s, new name: %s)", curCallback._key.c_str(), id.c_str());
-		}
+	TimerProcMap::const_iterator installed = _slots.find(callback);
+	if (installed != _slots.end()) {
+		error("Same callback added twice (old name: %s, new name: %s)", installed->_value->id.c_str(), id.c_str());
 	}
 	_callbacks[id] = callback;
 
+	const uint32 curTime = g_system->getMillis();
+	if (_slots.empty())
+		_wheelTime = curTime;
+
 	TimerSlot *slot = new TimerSlot;
 	slot->callback = callback;
 	slot->refCon = refCon;
 	slot->id = id;
 	slot->interval = interval;
-	slot->nextFireTime = g_system->getMillis() + interval / 1000;
+	slot->nextFireTime = curTime + interval / 1000;
 	slot->nextFireTimeMicro = interval % 1000;
-	slot->next = nullptr;
 
-	insertPrioQueue(_head, slot);
+	_slots[callback] = slot;
+	scheduleSlot(slot);
 
 	return true;
 }
@@ -145,19 +236,14 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 	Common::StackLock lock(_mutex);
 
-	TimerSlot *slot = _head;
+	TimerProcMap::iterator installed = _slots.find(callback);
+	if (installed == _slots.end())
+		return;
 
-	while (slot->next) {
-		if (slot->next->callback == callback) {
-			TimerSlot *next = slot->next->next;
-			delete slot->next;
-			slot->next = next;
-		} else {
-			slot = slot->next;
-		}
-	}
+	TimerSlot *slot = installed->_value;
+	_slots.erase(installed);
 
-	// We need to remove all names referencing the timer proc here.
+	// We need to remove the name referencing the timer proc here.
 	//
 	// Else we run into troubles, when the client code removes and readds timer
 	// callbacks.
@@ -169,8 +255,25 @@ void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 	// name and causing installTimerProc to error out.
 	// A good test case is running a SCUMM with ALSA output and then a KYRA
 	// game for example.
-	for (TimerSlotMap::iterator i = _callbacks.begin(), end = _callbacks.end(); i != end; ++i) {
-		if (i->_value == callback)
-			_callbacks.erase(i);
-	}
+	_callbacks.erase(slot->id);
+
+	// This also takes it out of the expired list, if it is removed by
+	// another timer callback
+	slot->detach();
+	delete slot;
+}
+
+bool DefaultTimerManager::getTimerStats(TimerProc proc, TimerStats &stats) {
+	Common::StackLock lock(_mutex);
+
+	TimerProcMap::const_iterator installed = _slots.find(proc);
+	if (installed == _slots.end())
+		return false;
+
+	const TimerSlot *slot = installed->_value;
+	stats.fireCount = slot->fireCount;
+	stats.lateCount = slot->lateCount;
+	stats.skipCount = slot->skipCount;
+	stats.maxLateness = slot->maxLateness;
+	return true;
 }
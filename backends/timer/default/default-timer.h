@@ -28,7 +28,23 @@
 #include "common/mutex.h"
 
 
-struct TimerSlot {
+/**
+ * Links of the intrusive, circular lists holding the timers of a bucket of
+ * the timing wheel. An unlinked node points to itself.
+ */
+struct TimerListNode {
+	TimerListNode *prev;
+	TimerListNode *next;
+
+	TimerListNode() : prev(this), next(this) {}
+
+	bool empty() const { return next == this; }
+	void detach();
+	void append(TimerListNode *node);
+	void spliceTo(TimerListNode *list);
+};
+
+struct TimerSlot : public TimerListNode {
 	Common::TimerManager::TimerProc callback;
 	void *refCon;
 	Common::String id;
@@ -37,24 +53,83 @@ struct TimerSlot {
 	uint32 nextFireTime;	// in milliseconds
 	uint32 nextFireTimeMicro;	// microseconds part of nextFire
 
-	TimerSlot *next;
+	uint32 fireCount;	// number of calls to the callback
+	uint32 lateCount;	// number of calls made more than an interval late
+	uint32 skipCount;	// number of calls skipped to catch up
+	uint32 maxLateness;	// in milliseconds
 
-	TimerSlot() : callback(nullptr), refCon(nullptr), interval(0), nextFireTime(0), nextFireTimeMicro(0), next(nullptr) {}
+	TimerSlot() : callback(nullptr), refCon(nullptr), interval(0), nextFireTime(0), nextFireTimeMicro(0),
+		fireCount(0), lateCount(0), skipCount(0), maxLateness(0) {}
 };
 
-void insertPrioQueue(TimerSlot *head, TimerSlot *newSlot);
-
 class DefaultTimerManager : public Common::TimerManager {
+public:
+	/**
+	 * Statistics about the calls made to a timer callback, to track down
+	 * the timers which can't keep up.
+	 */
+	struct TimerStats {
+		uint32 fireCount;	///< Number of calls to the callback.
+		uint32 lateCount;	///< Number of calls made more than an interval after they were due.
+		uint32 skipCount;	///< Number of calls skipped because the timer fell too far behind.
+		uint32 maxLateness;	///< Largest delay of a call, in milliseconds.
+	};
+
+	/**
+	 * Number of milliseconds a timer may fall behind before the missed calls
+	 * are skipped, instead of being made in a burst to catch up.
+	 */
+	static const uint32 kMaxCatchUpTime = 500;
+
 private:
 	typedef Common::HashMap<Common::String, TimerProc, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> TimerSlotMap;
 
+	struct TimerProc_Hash {
+		uint operator()(TimerProc proc) const { return (uint)(uintptr)proc; }
+	};
+
+	typedef Common::HashMap<TimerProc, TimerSlot *, TimerProc_Hash> TimerProcMap;
+
 	TimerSlotMap _callbacks;
 
 	uint32 _timerCallbackNext;
 
+	/**
+	 * The timers are kept in a hierarchical timing wheel, with a resolution
+	 * of one millisecond. The first level has a bucket for each of the next
+	 * 256 milliseconds, and each following level has 64 buckets, each one
+	 * spanning the whole previous level. The buckets of a level are moved to
+	 * the previous level when it wraps around.
+	 */
+	enum {
+		kRootBits = 8,
+		kLevelBits = 6,
+		kRootSize = 1 << kRootBits,
+		kLevelSize = 1 << kLevelBits,
+		kNumLevels = 4
+	};
+
+	TimerListNode _root[kRootSize];
+	TimerListNode _levels[kNumLevels][kLevelSize];
+
+	/** Timers due at the tick being run. */
+	TimerListNode _expired;
+
+	/** Next tick of the wheel to run, in milliseconds. */
+	uint32 _wheelTime;
+
+	void scheduleSlot(TimerSlot *slot);
+	bool cascade(int level);
+	void fireSlot(TimerSlot *slot, uint32 curTime);
+
 protected:
 	Common::Mutex _mutex;
-	TimerSlot *_head;
+	TimerProcMap _slots;
+
+	/**
+	 * Run the timers due before the given time, in milliseconds.
+	 */
+	void runTimers(uint32 curTime);
 
 public:
 	DefaultTimerManager();
@@ -72,6 +147,13 @@ public:
 	 * Should be called from pollEvents() on backends without threads.
 	 */
 	void checkTimers(uint32 interval = 10);
+
+	/**
+	 * Get the statistics of an installed timer callback.
+	 *
+	 * @return False if the callback is not installed.
+	 */
+	bool getTimerStats(TimerProc proc, TimerStats &stats);
 };
 
 #endif
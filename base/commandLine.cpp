@@ -330,6 +330,8 @@ void registerDefaults() {
 	ConfMan.registerDefault("speech_mute", false);
 	ConfMan.registerDefault("mute", false);
 
+	ConfMan.registerDefault("resampler_quality", "low");
+
 	ConfMan.registerDefault("multi_midi", false);
 	ConfMan.registerDefault("native_mt32", false);
 	ConfMan.registerDefault("dump_midi", false);
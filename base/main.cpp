@@ -30,6 +30,7 @@
 // FIXME: Avoid using printf
 #define FORBIDDEN_SYMBOL_EXCEPTION_printf
 
+#include "engines/advancedDetector.h"
 #include "engines/engine.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
@@ -340,6 +341,10 @@ static Common::Error runGame(const Plugin *enginePlugin, OSystem &system, const
 	// Free up memory
 	metaEngine.deleteInstance(engine, game, meDescriptor);
 
+	// Finish the saves the engine left to be written in the background,
+	// which also syncs them with the cloud while it is still available
+	system.getSavefileManager()->waitForPendingSaves();
+
 	// Reset the file/directory mappings
 	SearchMan.clear();
 
@@ -940,6 +945,7 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	//I think it's important to destroy it after ConnectionManager
 	Cloud::CloudManager::destroy();
 #endif
+	ADCacheMan.savePersistentCache(true);
 	PluginManager::destroy();
 	GUI::GuiManager::destroy();
 	Common::ConfigManager::destroy();
@@ -22,11 +22,14 @@
 #include "common/archive.h"
 #include "common/file.h"
 #include "common/fs.h"
+#include "common/hash-ptr.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/memstream.h"
+#include "common/mutex.h"
 #include "common/punycode.h"
 #include "common/debug.h"
+#include "common/singleton.h"
 
 namespace Common {
 
@@ -254,6 +257,197 @@ void Archive::prepareMaps() const {
 	}
 }
 
+// Holds a mutex for its lifetime, creating it first if needed. Like the
+// string memory pool, archives may be used before g_system is ready, when
+// there are no threads yet, so the mutex is only created once the backend is.
+class LazyStackLock {
+public:
+	explicit LazyStackLock(Mutex *&mutex) {
+		if (!mutex && g_system && g_system->backendInitialized())
+			mutex = new Mutex();
+		_mutex = mutex;
+		if (_mutex)
+			_mutex->lock();
+	}
+
+	~LazyStackLock() {
+		if (_mutex)
+			_mutex->unlock();
+	}
+
+private:
+	Mutex *_mutex;
+};
+
+// Ports can override the budget of the shared archive contents cache
+// by defining ARCHIVE_CACHE_BUDGET.
+#ifndef ARCHIVE_CACHE_BUDGET
+#if defined(__N64__) || defined(__DS__) || defined(__3DS__) || defined(__DC__) || defined(__PSP__)
+#define ARCHIVE_CACHE_BUDGET (256 * 1024)
+#else
+#define ARCHIVE_CACHE_BUDGET (8 * 1024 * 1024)
+#endif
+#endif
+
+// Least recently used cache holding the strong references to the small
+// members of all memcaching archives. The archives themselves only keep
+// weak references, which expire once a member is evicted and no stream
+// uses it anymore. Each archive must only be used by one thread at a time,
+// but different archives may be read from different threads, so the cache
+// they share is guarded by a mutex. Since the reference counts of SharedPtr
+// are not atomic, any reference to cached contents is also only taken or
+// dropped while holding it.
+class ArchiveContentsCache : public Singleton<ArchiveContentsCache> {
+public:
+	// Holds the cache mutex for its lifetime
+	class CacheLock : public LazyStackLock {
+	public:
+		explicit CacheLock(const ArchiveContentsCache &cache) : LazyStackLock(cache._mutex) {}
+	};
+
+	void countHit() {
+		CacheLock lock(*this);
+		_stats.hits++;
+	}
+
+	void countMiss() {
+		CacheLock lock(*this);
+		_stats.misses++;
+	}
+
+	// Mark the contents as most recently used, adding them if needed
+	void use(const MemcachingCaseInsensitiveArchive *owner, const SharedPtr<byte> &contents, uint32 size) {
+		CacheLock lock(*this);
+		IndexMap::iterator it = _index.find(contents.get());
+		if (it != _index.end()) {
+			_lru.push_front(*it->_value);
+			_lru.erase(it->_value);
+			it->_value = _lru.begin();
+			return;
+		}
+
+		if (size > _stats.budget)
+			return;
+
+		Node node;
+		node.owner = owner;
+		node.contents = contents;
+		node.size = size;
+		_lru.push_front(node);
+		_index[contents.get()] = _lru.begin();
+		_stats.usedBytes += size;
+		evict();
+	}
+
+	// Drop all contents of an archive being destroyed
+	void purge(const MemcachingCaseInsensitiveArchive *owner) {
+		CacheLock lock(*this);
+		NodeList::iterator it = _lru.begin();
+		while (it != _lru.end()) {
+			if (it->owner == owner) {
+				_index.erase(it->contents.get());
+				_stats.usedBytes -= it->size;
+				it = _lru.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	void setBudget(uint32 budget) {
+		CacheLock lock(*this);
+		_stats.budget = budget;
+		evict();
+	}
+
+	ArchiveCacheStats getStats() const {
+		CacheLock lock(*this);
+		return _stats;
+	}
+
+	void resetStats() {
+		CacheLock lock(*this);
+		_stats.hits = 0;
+		_stats.misses = 0;
+		_stats.evictions = 0;
+	}
+
+private:
+	friend class Singleton<SingletonBaseType>;
+
+	ArchiveContentsCache() : _mutex(nullptr) {
+		_stats.hits = 0;
+		_stats.misses = 0;
+		_stats.evictions = 0;
+		_stats.usedBytes = 0;
+		_stats.budget = ARCHIVE_CACHE_BUDGET;
+	}
+
+	~ArchiveContentsCache() {
+		delete _mutex;
+	}
+
+	struct Node {
+		const MemcachingCaseInsensitiveArchive *owner;
+		SharedPtr<byte> contents;
+		uint32 size;
+	};
+
+	typedef List<Node> NodeList;
+	typedef HashMap<const byte *, NodeList::iterator> IndexMap;
+
+	void evict() {
+		while (_stats.usedBytes > _stats.budget) {
+			Node &node = _lru.back();
+			_index.erase(node.contents.get());
+			_stats.usedBytes -= node.size;
+			_stats.evictions++;
+			_lru.pop_back();
+		}
+	}
+
+	// Most recently used first
+	NodeList _lru;
+	IndexMap _index;
+	ArchiveCacheStats _stats;
+	mutable Mutex *_mutex;
+};
+
+DECLARE_SINGLETON(ArchiveContentsCache);
+
+// Memory stream over cached contents, which drops its reference under the
+// cache lock since the cache may evict the same contents from another thread
+class CachedContentsReadStream : public MemoryReadStream {
+public:
+	CachedContentsReadStream(const SharedPtr<byte> &contents, uint32 size) :
+		MemoryReadStream(contents.get(), size), _contents(contents) {}
+
+	~CachedContentsReadStream() override {
+		ArchiveContentsCache::CacheLock lock(ArchiveContentsCache::instance());
+		_contents.reset();
+	}
+
+private:
+	SharedPtr<byte> _contents;
+};
+
+MemcachingCaseInsensitiveArchive::~MemcachingCaseInsensitiveArchive() {
+	if (ArchiveContentsCache::hasInstance())
+		ArchiveContentsCache::instance().purge(this);
+}
+
+void MemcachingCaseInsensitiveArchive::setCacheBudget(uint32 budget) {
+	ArchiveContentsCache::instance().setBudget(budget);
+}
+
+ArchiveCacheStats MemcachingCaseInsensitiveArchive::getCacheStats() {
+	return ArchiveContentsCache::instance().getStats();
+}
+
+void MemcachingCaseInsensitiveArchive::resetCacheStats() {
+	ArchiveContentsCache::instance().resetStats();
+}
+
 SeekableReadStream *MemcachingCaseInsensitiveArchive::createReadStreamForMember(const Path &path) const {
 	return createReadStreamForMemberImpl(path, false, Common::AltStreamType::Invalid);
 }
@@ -273,6 +467,8 @@ SeekableReadStream *MemcachingCaseInsensitiveArchive::createReadStreamForMemberI
 	cacheKey.path = translatePath(path);
 	cacheKey.altStreamType = isAltStream ? altStreamType : AltStreamType::Invalid;
 
+	ArchiveContentsCache &contentsCache = ArchiveContentsCache::instance();
+
 	bool isNew = false;
 	if (!_cache.contains(cacheKey)) {
 		SharedArchiveContents readResult = isAltStream ? readContentsForPathAltStream(cacheKey.path, altStreamType) : readContentsForPath(cacheKey.path);
@@ -286,12 +482,23 @@ SeekableReadStream *MemcachingCaseInsensitiveArchive::createReadStreamForMemberI
 
 	// Errors and missing files. Just return nullptr,
 	// no need to create stream.
-	if (entry->isFileMissing())
+	if (entry->isFileMissing()) {
+		if (isNew)
+			contentsCache.countMiss();
+		else
+			contentsCache.countHit();
 		return nullptr;
+	}
 
 	// Check whether the entry is still valid as WeakPtr might have expired.
-	if (!entry->makeStrong()) {
-		// If it's expired, recreate the entry.
+	bool isValid;
+	{
+		ArchiveContentsCache::CacheLock lock(contentsCache);
+		isValid = entry->makeStrong();
+	}
+	if (!isValid) {
+		// If it's expired, recreate the entry. The new contents are not
+		// shared with the cache yet, so this needs no lock.
 		SharedArchiveContents readResult = isAltStream ? readContentsForPathAltStream(cacheKey.path, altStreamType) : readContentsForPath(cacheKey.path);
 		if (readResult._bypass)
 			return readResult._bypass;
@@ -300,19 +507,27 @@ SeekableReadStream *MemcachingCaseInsensitiveArchive::createReadStreamForMemberI
 		isNew = true;
 	}
 
+	if (isNew)
+		contentsCache.countMiss();
+	else
+		contentsCache.countHit();
+
 	// It's possible that recreation failed in case of e.g. network
 	// share going offline.
 	if (entry->isFileMissing())
 		return nullptr;
 
+	ArchiveContentsCache::CacheLock lock(contentsCache);
+
 	// Now we have a valid contents reference. Make stream for it.
-	Common::MemoryReadStream *memStream = new Common::MemoryReadStream(entry->getContents(), entry->getSize());
+	Common::MemoryReadStream *memStream = new CachedContentsReadStream(entry->getContents(), entry->getSize());
 
-	// If the entry was just created and it's too big for strong caching,
-	// mark the copy in cache as weak
-	if (isNew && entry->getSize() > _maxStronglyCachedSize) {
-		entry->makeWeak();
-	}
+	// Small enough entries are kept alive by the shared contents cache.
+	// The copy in our own cache only holds a weak reference, so the
+	// contents are freed once evicted and no longer used by any stream.
+	if (entry->getSize() <= _maxStronglyCachedSize && entry->getContents())
+		contentsCache.use(this, entry->getContents(), entry->getSize());
+	entry->makeWeak();
 
 	return memStream;
 }
@@ -368,6 +583,12 @@ void SearchSet::add(const String &name, Archive *archive, int priority, bool aut
 	if (_ignoreClashes || (find(name) == _list.end())) {
 		Node node(priority, name, archive, autoFree);
 		insert(node);
+
+		// Files found through a nested search set depend on its archives
+		SearchSet *set = dynamic_cast<SearchSet *>(archive);
+		if (set)
+			set->_parents.push_back(this);
+		invalidateIndex();
 	} else {
 		if (autoFree)
 			delete archive;
@@ -455,9 +676,11 @@ void SearchSet::addSubDirectoriesMatching(const FSNode &directory, String origPa
 void SearchSet::remove(const String &name) {
 	ArchiveNodeList::iterator it = find(name);
 	if (it != _list.end()) {
+		unlinkNested(it->_arc);
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		invalidateIndex();
 	}
 }
 
@@ -476,11 +699,13 @@ Archive *SearchSet::getArchive(const String &name) const {
 
 void SearchSet::clear() {
 	for (auto &archive : _list) {
+		unlinkNested(archive._arc);
 		if (archive._autoFree)
 			delete archive._arc;
 	}
 
 	_list.clear();
+	invalidateIndex();
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -497,18 +722,68 @@ void SearchSet::setPriority(const String &name, int priority) {
 	_list.erase(it);
 	node._priority = priority;
 	insert(node);
+	invalidateIndex();
 }
 
-bool SearchSet::hasFile(const Path &path) const {
-	if (path.empty())
-		return false;
+SearchSet::~SearchSet() {
+	clear();
+	delete _lookupIndexMutex;
+}
 
+void SearchSet::unlinkNested(Archive *archive) {
+	SearchSet *set = dynamic_cast<SearchSet *>(archive);
+	if (set)
+		set->_parents.remove(this);
+}
+
+void SearchSet::invalidateIndex() {
+	{
+		LazyStackLock lock(_lookupIndexMutex);
+		_lookupIndex.clear();
+		_lookupIndexGeneration++;
+	}
+
+	// The search sets containing this one found files through it
+	for (auto &parent : _parents)
+		parent->invalidateIndex();
+}
+
+Archive *SearchSet::lookupArchive(const Path &path) const {
+	// The index is only accessed under the lock, while the archives are
+	// asked without holding it, so that file system accesses do not
+	// serialize lookups from different threads
+	uint32 generation;
+	{
+		LazyStackLock lock(_lookupIndexMutex);
+		LookupIndex::const_iterator entry = _lookupIndex.find(path);
+		if (entry != _lookupIndex.end())
+			return entry->_value;
+		generation = _lookupIndexGeneration;
+	}
+
+	Archive *found = nullptr;
 	for (const auto &archive : _list) {
-		if (archive._arc->hasFile(path))
-			return true;
+		if (archive._arc->hasFile(path)) {
+			found = archive._arc;
+			break;
+		}
 	}
 
-	return false;
+	// Misses are remembered too, unless the set changed in the meantime
+	LazyStackLock lock(_lookupIndexMutex);
+	if (generation == _lookupIndexGeneration) {
+		if (_lookupIndex.size() >= kMaxLookupIndexSize)
+			_lookupIndex.clear();
+		_lookupIndex[path] = found;
+	}
+	return found;
+}
+
+bool SearchSet::hasFile(const Path &path) const {
+	if (path.empty())
+		return false;
+
+	return lookupArchive(path) != nullptr;
 }
 
 bool SearchSet::isPathDirectory(const Path &path) const {
@@ -583,16 +858,14 @@ const ArchiveMemberPtr SearchSet::getMember(const Path &path, Archive **containe
 	if (path.empty())
 		return ArchiveMemberPtr();
 
-	for (const auto &archive : _list) {
-		if (archive._arc->hasFile(path)) {
-			if (container) {
-				*container = archive._arc;
-			}
-			return archive._arc->getMember(path);
-		}
-	}
+	Archive *archive = lookupArchive(path);
+	if (!archive)
+		return ArchiveMemberPtr();
 
-	return ArchiveMemberPtr();
+	if (container) {
+		*container = archive;
+	}
+	return archive->getMember(path);
 }
 
 const ArchiveMemberPtr SearchSet::getMember(const Path &path) const {
@@ -603,13 +876,16 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const Path &path) const
 	if (path.empty())
 		return nullptr;
 
-	for (const auto &archive : _list) {
-		SeekableReadStream *stream = archive._arc->createReadStreamForMember(path);
-		if (stream)
-			return stream;
-	}
+	Archive *found = lookupArchive(path);
+	if (!found)
+		return nullptr;
 
-	return nullptr;
+	SeekableReadStream *foundStream = found->createReadStreamForMember(path);
+	if (foundStream)
+		return foundStream;
+
+	// The member could not be opened, try the archives which come next
+	return createReadStreamForMemberNext(path, found);
 }
 
 SeekableReadStream *SearchSet::createReadStreamForMemberAltStream(const Path &path, AltStreamType altStreamType) const {
@@ -45,6 +45,7 @@ namespace Common {
 
 class ArchiveMember;
 class FSNode;
+class Mutex;
 class SeekableReadStream;
 
 enum class AltStreamType {
@@ -281,12 +282,31 @@ private:
 	friend class MemcachingCaseInsensitiveArchive;
 };
 
+/**
+ * Statistics of the contents cache shared by all MemcachingCaseInsensitiveArchive instances.
+ */
+struct ArchiveCacheStats {
+	uint64 hits;      /*!< Reads served from contents already in memory. */
+	uint64 misses;    /*!< Reads that had to load the member from the archive. */
+	uint64 evictions; /*!< Members dropped from the cache to stay within the budget. */
+	uint32 usedBytes; /*!< Bytes of member contents currently held by the cache. */
+	uint32 budget;    /*!< Maximum number of bytes held by the cache. */
+};
+
 /**
  * An archive that caches the resulting contents.
+ *
+ * Members up to the archive's strong caching size are kept in a least
+ * recently used cache shared by all memcaching archives. Once the total
+ * size of the cached members exceeds the cache budget, the least recently
+ * used ones are dropped. Larger members are only kept in memory while
+ * streams to them are still alive.
  */
 class MemcachingCaseInsensitiveArchive : public Archive {
 public:
 	MemcachingCaseInsensitiveArchive(uint32 maxStronglyCachedSize = 512) : _maxStronglyCachedSize(maxStronglyCachedSize) {}
+	~MemcachingCaseInsensitiveArchive() override;
+
 	SeekableReadStream *createReadStreamForMember(const Path &path) const override;
 	SeekableReadStream *createReadStreamForMemberAltStream(const Path &path, Common::AltStreamType altStreamType) const override;
 
@@ -297,6 +317,19 @@ public:
 	virtual SharedArchiveContents readContentsForPath(const Path &translatedPath) const = 0;
 	virtual SharedArchiveContents readContentsForPathAltStream(const Path &translatedPath, AltStreamType altStreamType) const;
 
+	/**
+	 * Set the maximum number of bytes of member contents kept in memory by
+	 * all memcaching archives together. Members are evicted immediately if
+	 * the cache is above the new budget.
+	 */
+	static void setCacheBudget(uint32 budget);
+
+	/** Return the statistics of the shared contents cache. */
+	static ArchiveCacheStats getCacheStats();
+
+	/** Reset the hit, miss and eviction counters of the shared contents cache. */
+	static void resetCacheStats();
+
 private:
 	struct CacheKey {
 		CacheKey();
@@ -347,9 +380,24 @@ class SearchSet : public Archive {
 
 	bool _ignoreClashes;
 
+	// Archive containing each looked up path, or nullptr for paths found in
+	// no archive. It is forgotten whenever this set or one nested in it
+	// changes, and once it reaches its maximum size.
+	typedef HashMap<Path, Archive *, Path::Hash, Path::EqualTo> LookupIndex;
+	enum { kMaxLookupIndexSize = 4096 };
+	mutable LookupIndex _lookupIndex;
+	mutable uint32 _lookupIndexGeneration; //!< Bumped whenever the index is forgotten.
+	mutable Mutex *_lookupIndexMutex;
+
+	List<SearchSet *> _parents; //!< Search sets containing this one, whose index depends on it.
+
+	void unlinkNested(Archive *archive); //!< Forget that an archive being removed may be a nested search set.
+
+	Archive *lookupArchive(const Path &path) const; //!< Find the first archive having a file, using the lookup index.
+
 public:
-	SearchSet() : _ignoreClashes(false) { }
-	virtual ~SearchSet() { clear(); }
+	SearchSet() : _ignoreClashes(false), _lookupIndexGeneration(0), _lookupIndexMutex(nullptr) { }
+	virtual ~SearchSet();
 
 	char getPathSeparator() const override { return '/'; }
 
@@ -443,6 +491,19 @@ public:
 	 */
 	void setPriority(const String& name, int priority);
 
+	/**
+	 * Forget which archives contain which files.
+	 *
+	 * Search sets remember the archive where each looked up file was found
+	 * first, and the files which were not found at all, so that they do not
+	 * need to query every archive again. This is forgotten automatically when
+	 * archives are added to, removed from or reordered in the set, or in a
+	 * search set nested in it. Call this when files are added to or removed
+	 * from an archive of the set, as archives like FSDirectory only read
+	 * their contents once anyway.
+	 */
+	void invalidateIndex();
+
 	bool hasFile(const Path &path) const override;
 	bool isPathDirectory(const Path &path) const override;
 	int listMatchingMembers(ArchiveMemberList &list, const Path &pattern, bool matchPathComponents = false) const override;
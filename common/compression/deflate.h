@@ -177,8 +177,11 @@ SeekableReadStream *wrapClickteamReadStream(SeekableReadStream *toBeWrapped,
  *
  * It is safe to call this with a NULL parameter (in this case, NULL is
  * returned).
+ *
+ * @param level  The zlib compression level, from 1 (fastest) to 9 (smallest),
+ *               or -1 for the default trade-off.
  */
-WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped);
+WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped, int level = -1);
 
 /** @} */
 
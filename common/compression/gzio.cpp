@@ -1388,7 +1388,7 @@ SeekableReadStream* wrapDeflateReadStream(Common::SeekableReadStream *parent, Di
 	return gzio;
 }
 
-WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
+WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped, int level) {
 	// Not supported, return stream itself to write uncompressed data
 	return toBeWrapped;
 }
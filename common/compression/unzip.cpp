@@ -95,6 +95,8 @@ typedef Byte Bytef;
 #include "common/compression/deflate.h"
 #include "common/compression/unzip.h"
 #include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/substream.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -237,6 +239,14 @@ Common::SharedArchiveContents unzOpenCurrentFile(unzFile file
   If there is no error, the return value is UNZ_OK.
 */
 
+Common::SeekableReadStream *unzOpenCurrentFileStream(unzFile file);
+/*
+  Open a stream reading the current file directly from the zipfile, without
+  reading it into memory first. Stored files are read as a substream of the
+  zipfile, deflated ones are decompressed on the fly. The CRC is not checked.
+  Return nullptr if the file can't be streamed.
+*/
+
 int unzCloseCurrentFile(unzFile file);
 /*
   Close the file in zip opened with unzOpenCurrentFile
@@ -284,6 +294,11 @@ int unzGetLocalExtrafield(unzFile file, voidp buf, unsigned len);
 #define UNZ_MAXFILENAMEINZIP (256)
 #endif
 
+/* members of at least this size are streamed instead of read into memory */
+#ifndef UNZ_STREAMTHRESHOLD
+#define UNZ_STREAMTHRESHOLD (64 * 1024)
+#endif
+
 #define SIZECENTRALDIRITEM (0x2e)
 #define SIZEZIPLOCALHEADER (0x1e)
 
@@ -325,6 +340,7 @@ typedef Common::HashMap<Common::Path, cached_file_in_zip, Common::Path::IgnoreCa
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _streamRef; /* owns _stream, shared with streamed members */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -459,6 +475,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 	int err = UNZ_OK;
 
 	us->_stream = stream;
+	us->_streamRef = Common::SharedPtr<Common::SeekableReadStream>(stream);
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos == 0)
@@ -489,7 +506,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 		err = UNZ_ERRNO;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return nullptr;
 	}
@@ -516,7 +532,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream, bool flattenTree) {
 		err = UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return nullptr;
 	}
@@ -606,7 +621,6 @@ int unzClose(unzFile file) {
 		return UNZ_PARAMERROR;
 	s = (unz_s *)file;
 
-	delete s->_stream;
 	delete s;
 	return UNZ_OK;
 }
@@ -1024,6 +1038,71 @@ Common::SharedArchiveContents unzOpenCurrentFile (unzFile file
 	return Common::SharedArchiveContents(uncompressedBuffer, s->cur_file_info.uncompressed_size);
 }
 
+/*
+  A substream of the zipfile which keeps the zipfile stream alive, so that
+  it can outlive the archive it was opened from.
+*/
+class ZipMemberReadStream : public Common::SafeSeekableSubReadStream {
+public:
+	ZipMemberReadStream(const Common::SharedPtr<Common::SeekableReadStream> &parentStream, uint32 begin, uint32 end) :
+		Common::SafeSeekableSubReadStream(parentStream.get(), begin, end, DisposeAfterUse::NO), _parentRef(parentStream) {}
+
+private:
+	Common::SharedPtr<Common::SeekableReadStream> _parentRef;
+};
+
+/*
+  A member of a zipfile held in memory, like a memory mapped file, which reads
+  the memory directly instead of seeking the zipfile stream for every read.
+*/
+class ZipMemoryMemberReadStream : public Common::MemoryReadStream {
+public:
+	ZipMemoryMemberReadStream(const Common::SharedPtr<Common::SeekableReadStream> &parentStream, const byte *data, uint32 size) :
+		Common::MemoryReadStream(data, size), _parentRef(parentStream) {}
+
+private:
+	Common::SharedPtr<Common::SeekableReadStream> _parentRef;
+};
+
+static Common::SeekableReadStream *createZipMemberReadStream(const Common::SharedPtr<Common::SeekableReadStream> &parentStream, uint32 begin, uint32 end) {
+	const Common::MemoryReadStream *memoryStream = dynamic_cast<const Common::MemoryReadStream *>(parentStream.get());
+	if (memoryStream && begin <= end && end <= memoryStream->size())
+		return new ZipMemoryMemberReadStream(parentStream, memoryStream->getData() + begin, end - begin);
+
+	return new ZipMemberReadStream(parentStream, begin, end);
+}
+
+Common::SeekableReadStream *unzOpenCurrentFileStream(unzFile file) {
+	uInt iSizeVar;
+	unz_s *s;
+	uLong offset_local_extrafield;  /* offset of the local extra field */
+	uInt  size_local_extrafield;    /* size of the local extra field */
+
+	if (file == nullptr)
+		return nullptr;
+	s = (unz_s *)file;
+	if (!s->current_file_ok)
+		return nullptr;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s, &iSizeVar,
+				&offset_local_extrafield, &size_local_extrafield) != UNZ_OK)
+		return nullptr;
+
+	uint32 begin = s->cur_file_info_internal.offset_curfile + s->byte_before_the_zipfile + SIZEZIPLOCALHEADER + iSizeVar;
+	Common::SeekableReadStream *compressedStream = createZipMemberReadStream(s->_streamRef, begin, begin + s->cur_file_info.compressed_size);
+
+	switch (s->cur_file_info.compression_method) {
+	case 0: // Store
+		return compressedStream;
+	case Z_DEFLATED:
+		return Common::wrapDeflateReadStream(compressedStream, DisposeAfterUse::YES, s->cur_file_info.uncompressed_size);
+	default:
+		warning("Unknown compression algoritthm %d", (int)s->cur_file_info.compression_method);
+		delete compressedStream;
+		return nullptr;
+	}
+}
+
 
 namespace Common {
 
@@ -1114,6 +1193,14 @@ const ArchiveMemberPtr ZipArchive::getMember(const Path &path) const {
 Common::SharedArchiveContents ZipArchive::readContentsForPath(const Common::Path &path) const {
 	if (unzLocateFile(_zipFile, path, 2) != UNZ_OK)
 		return Common::SharedArchiveContents();
+
+	// Stream large members, such as videos, instead of holding them in memory
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	if (archive->cur_file_info.uncompressed_size >= UNZ_STREAMTHRESHOLD) {
+		Common::SeekableReadStream *stream = unzOpenCurrentFileStream(_zipFile);
+		if (stream)
+			return Common::SharedArchiveContents::bypass(stream);
+	}
 #ifndef USE_ZLIB
 	return unzOpenCurrentFile(_zipFile, _crc);
 #else
@@ -33,6 +33,7 @@
 
 #include "common/compression/deflate.h"
 
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
@@ -89,15 +90,37 @@ bool inflateZlibHeaderless(byte *dst, uint *dstLen, const byte *src, uint srcLen
 static bool _shownBackwardSeekingWarning = false;
 #endif
 
+// inflateGetDictionary() was added in zlib 1.2.7.1
+#if ZLIB_VERNUM >= 0x1271
+#define ZLIB_HAS_GETDICTIONARY
+#endif
+
 /**
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other SeekableReadStream and will then provide on-the-fly decompression support.
  * Assumes the compressed data to be in gzip format.
+ *
+ * For headerless deflate data, the stream records a checkpoint at deflate
+ * block boundaries every CHECKPOINT_SPACING bytes of output. A checkpoint
+ * holds the input position and the last 32 KiB of output, which is all
+ * inflate needs to resume from there. Seeks then only decompress from the
+ * nearest checkpoint instead of from the start of the data.
  */
 class GZipReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,		// 1 << MAX_WBITS
+		WINDOWSIZE = 32768,
+		CHECKPOINT_SPACING = 1024 * 1024,
+		MAX_CHECKPOINTS = 64
+	};
+
+	struct Checkpoint {
+		uint32 outPos;
+		uint64 inPos;
+		int bits;
+		uint windowSize;
+		SharedPtr<byte> window;
 	};
 
 	byte	_buf[BUFSIZE];
@@ -110,6 +133,74 @@ protected:
 	uint32 _origSize;
 	bool _eos;
 
+	// Checkpoints are only used for headerless streams
+	bool _useCheckpoints;
+	uint32 _checkpointSpacing;
+	uint64 _inBase;
+	Array<Checkpoint> _checkpoints;
+
+	void initCheckpoints() {
+#ifdef ZLIB_HAS_GETDICTIONARY
+		_useCheckpoints = true;
+		_checkpointSpacing = MAX<uint32>(CHECKPOINT_SPACING, _origSize / MAX_CHECKPOINTS);
+#else
+		_useCheckpoints = false;
+		_checkpointSpacing = 0;
+#endif
+		_inBase = 0;
+	}
+
+	// Record a checkpoint if inflate stopped at a block boundary far enough
+	// from the previous one.
+	void recordCheckpoint(uint32 outPos) {
+#ifdef ZLIB_HAS_GETDICTIONARY
+		// Bit 7 is set at the end of a block, bit 6 if it was the last one
+		if ((_stream.data_type & 0xC0) != 0x80)
+			return;
+
+		uint32 nextPos = _checkpoints.empty() ? _checkpointSpacing : _checkpoints.back().outPos + _checkpointSpacing;
+		if (outPos < nextPos)
+			return;
+
+		Checkpoint checkpoint;
+		checkpoint.outPos = outPos;
+		checkpoint.inPos = _inBase + _stream.total_in;
+		checkpoint.bits = _stream.data_type & 7;
+		checkpoint.window = SharedPtr<byte>(new byte[WINDOWSIZE], ArrayDeleter<byte>());
+		checkpoint.windowSize = WINDOWSIZE;
+		if (inflateGetDictionary(&_stream, checkpoint.window.get(), &checkpoint.windowSize) != Z_OK)
+			return;
+
+		_checkpoints.push_back(checkpoint);
+#endif
+	}
+
+	// Restart decompression at the given checkpoint
+	bool restoreCheckpoint(const Checkpoint &checkpoint) {
+		_zlibErr = inflateReset(&_stream);
+		if (_zlibErr != Z_OK)
+			return false;
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+
+		// The checkpoint may start in the middle of a byte
+		_wrapped->seek(_parentPos + checkpoint.inPos - (checkpoint.bits ? 1 : 0), SEEK_SET);
+		if (checkpoint.bits) {
+			int value = _wrapped->readByte();
+			_zlibErr = inflatePrime(&_stream, checkpoint.bits, value >> (8 - checkpoint.bits));
+			if (_zlibErr != Z_OK)
+				return false;
+		}
+
+		_zlibErr = inflateSetDictionary(&_stream, checkpoint.window.get(), checkpoint.windowSize);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_inBase = checkpoint.inPos;
+		_pos = checkpoint.outPos;
+		return true;
+	}
+
 public:
 
 	GZipReadStream(SeekableReadStream *w, DisposeAfterUse::Flag disposeParent, uint32 knownSize) : _wrapped(w, disposeParent), _stream() {
@@ -139,6 +230,10 @@ public:
 		// the compressed file. This feature was added in zlib 1.2.0.4,
 		// released 10 August 2003.
 		// Note: This is *crucial* for savegame compatibility, do *not* remove!
+		_useCheckpoints = false;
+		_checkpointSpacing = 0;
+		_inBase = 0;
+
 		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
 		if (_zlibErr != Z_OK)
 			return;
@@ -158,6 +253,7 @@ public:
 		_origSize = knownSize;
 		_pos = 0;
 		_eos = false;
+		initCheckpoints();
 
 		_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
 		if (_zlibErr != Z_OK)
@@ -196,7 +292,13 @@ public:
 				_stream.next_in = _buf;
 				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
 			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+			if (_useCheckpoints) {
+				_zlibErr = inflate(&_stream, Z_BLOCK);
+				if (_zlibErr == Z_OK)
+					recordCheckpoint(_pos + dataSize - _stream.avail_out);
+			} else {
+				_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+			}
 		}
 
 		// Update the position counter
@@ -236,7 +338,16 @@ public:
 
 		assert(newPos >= 0);
 
-		if ((uint32)newPos < _pos) {
+		// Resume from the closest checkpoint before the target, if that
+		// is closer than the current position
+		const Checkpoint *checkpoint = nullptr;
+		for (uint i = 0; i < _checkpoints.size() && _checkpoints[i].outPos <= (uint32)newPos; i++)
+			checkpoint = &_checkpoints[i];
+
+		if (checkpoint && ((uint32)newPos < _pos || checkpoint->outPos > _pos)) {
+			if (!restoreCheckpoint(*checkpoint))
+				return false;
+		} else if ((uint32)newPos < _pos) {
 			// To search backward, we have to restart the whole decompression
 			// from the start of the file. A rather wasteful operation, best
 			// to avoid it. :/
@@ -252,6 +363,7 @@ public:
 #endif
 
 			_pos = 0;
+			_inBase = 0;
 			_wrapped->seek(_parentPos, SEEK_SET);
 			_zlibErr = inflateReset(&_stream);
 			if (_zlibErr != Z_OK)
@@ -308,7 +420,7 @@ protected:
 	}
 
 public:
-	GZipWriteStream(WriteStream *w) : _wrapped(w), _stream(), _pos(0) {
+	GZipWriteStream(WriteStream *w, int level) : _wrapped(w), _stream(), _pos(0) {
 		assert(w != nullptr);
 
 		// Adding 16 to windowBits indicates to zlib that it is supposed to
@@ -316,7 +428,7 @@ public:
 		// released 10 August 2003.
 		// Note: This is *crucial* for savegame compatibility, do *not* remove!
 		_zlibErr = deflateInit2(&_stream,
-		                 Z_DEFAULT_COMPRESSION,
+		                 level,
 		                 Z_DEFLATED,
 		                 MAX_WBITS + 16,
 		                 8,
@@ -422,10 +534,10 @@ SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, Dispo
 	return new GZipReadStream(toBeWrapped, disposeParent, knownSize, dict, dictLen);
 }
 
-WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
+WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped, int level) {
 	if (!toBeWrapped)
 		return nullptr;
-	return new GZipWriteStream(toBeWrapped);
+	return new GZipWriteStream(toBeWrapped, level);
 }
 
 } // End of namespace Common
@@ -0,0 +1,749 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+// The hash map implementation in this file follows the design of the
+// "Swiss tables" of Abseil: one control byte per slot, probed a group of
+// slots at a time.
+
+#ifndef COMMON_FLAT_HASHMAP_H
+#define COMMON_FLAT_HASHMAP_H
+
+#include "common/endian.h"
+#include "common/func.h"
+#include "common/hashmap.h"
+#include "common/intrinsics.h"
+#include "common/util.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLATHASHMAP_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * @defgroup common_flat_hashmap Flat hash table (FlatHashMap)
+ * @ingroup common
+ *
+ * @brief API for operations on an open addressing hash table.
+ *
+ * @{
+ */
+
+namespace FlatHashMapImpl {
+
+/**
+ * Control byte values. Full slots store the low 7 bits of the hash of
+ * their key instead, so the high bit tells free slots apart.
+ */
+enum {
+	kCtrlEmpty = -128,
+	kCtrlDeleted = -2
+};
+
+/** Index of the lowest bit set in a non-zero mask. */
+inline uint lowestBit(uint32 mask) {
+	return intLog2(mask & (0 - mask));
+}
+
+#ifdef FLATHASHMAP_USE_SSE2
+
+/**
+ * A group of control bytes, compared all at once with SSE2.
+ * Each match function returns a mask with bit i set for slot i.
+ */
+struct Group {
+	enum {
+		kWidth = 16
+	};
+
+	explicit Group(const int8 *ctrl) : _ctrl(_mm_loadu_si128((const __m128i *)ctrl)) {}
+
+	uint32 match(int8 h2) const {
+		return (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl));
+	}
+
+	uint32 matchEmpty() const {
+		return (uint32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(kCtrlEmpty), _ctrl));
+	}
+
+	uint32 matchEmptyOrDeleted() const {
+		return (uint32)_mm_movemask_epi8(_ctrl);
+	}
+
+private:
+	__m128i _ctrl;
+};
+
+#else
+
+/**
+ * A group of control bytes, compared all at once in a 64-bit integer.
+ * Each match function returns a mask with bit i set for slot i.
+ *
+ * match() may report a slot holding a different hash right after a slot
+ * which really matches. Such slots are always full, and the key comparison
+ * weeds them out.
+ */
+struct Group {
+	enum {
+		kWidth = 8
+	};
+
+	explicit Group(const int8 *ctrl) : _ctrl(READ_LE_UINT64(ctrl)) {}
+
+	uint32 match(int8 h2) const {
+		const uint64 x = _ctrl ^ (kLsbs * (uint8)h2);
+		return compact((x - kLsbs) & ~x & kMsbs);
+	}
+
+	uint32 matchEmpty() const {
+		// Empty is the only value with the high bit set and bit 1 clear
+		return compact(_ctrl & ~(_ctrl << 6) & kMsbs);
+	}
+
+	uint32 matchEmptyOrDeleted() const {
+		return compact(_ctrl & kMsbs);
+	}
+
+private:
+	static const uint64 kLsbs = 0x0101010101010101ULL;
+	static const uint64 kMsbs = 0x8080808080808080ULL;
+
+	// Gather the high bit of each byte into the low byte
+	static uint32 compact(uint64 bits) {
+		return (uint32)(((bits >> 7) * 0x0102040810204080ULL) >> 56);
+	}
+
+	uint64 _ctrl;
+};
+
+#endif
+
+/** Control bytes of maps without storage, so that lookups need no special case. */
+inline const int8 *emptyGroup() {
+	static const int8 group[Group::kWidth] = {
+		kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty,
+#ifdef FLATHASHMAP_USE_SSE2
+		kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty, kCtrlEmpty
+#endif
+	};
+	return group;
+}
+
+/** Spread the bits of a hash, since many of our hash functions are trivial. */
+inline uint32 mixHash(uint32 hash) {
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6B;
+	hash ^= hash >> 13;
+	hash *= 0xC2B2AE35;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+} // End of namespace FlatHashMapImpl
+
+/**
+ * FlatHashMap<Key,Val> maps objects of type Key to objects of type Val, like
+ * HashMap, and mostly has the same interface.
+ *
+ * The nodes are stored in a single array instead of being allocated one by
+ * one, and a separate array holds one control byte per node with 7 bits of
+ * the hash of its key. Lookups compare a whole group of control bytes at
+ * once, using SSE2 when available, so they rarely touch nodes with other
+ * keys. This makes lookups considerably faster, especially for misses.
+ *
+ * Unlike with HashMap, inserting elements invalidates iterators and
+ * references to other elements when the storage grows.
+ *
+ * The lookup functions also accept other types than Key, as long as the hash
+ * and equality functors accept them, and hash them the same way as the
+ * equivalent Key. For instance, a map using IgnoreCase_Hash and
+ * IgnoreCase_EqualTo can be searched with a const char * without
+ * constructing a String.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+	struct Node {
+		const Key _key;
+		Val _value;
+		explicit Node(const Key &key) : _key(key), _value() {}
+	};
+
+private:
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> FHM_t;
+	typedef FlatHashMapImpl::Group Group;
+
+	enum {
+		FLATHASHMAP_MIN_CAPACITY = 16,
+
+		// The storage grows once this fraction of the slots is used,
+		// including deleted slots.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 7,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	static const size_type NONE_FOUND = (size_type)-1;
+
+	/** Default value, returned by the const getVal. */
+	Val _defaultVal;
+
+	int8 *_ctrl;		///< Control bytes, followed by a copy of the first group for wrapping loads.
+	Node *_slots;		///< Node storage, or nullptr if nothing was allocated yet.
+	size_type _mask;	///< Capacity minus one, or 0 without storage.
+	size_type _size;
+	size_type _growthLeft;	///< Number of empty slots which can still be used before growing.
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	size_type capacity() const { return _slots ? _mask + 1 : 0; }
+
+	static size_type maxLoad(size_type capacity) {
+		return capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR / FLATHASHMAP_LOADFACTOR_DENOMINATOR;
+	}
+
+	void setCtrl(size_type idx, int8 value) {
+		_ctrl[idx] = value;
+		if (idx < Group::kWidth)
+			_ctrl[_mask + 1 + idx] = value;
+	}
+
+	template<class K2>
+	size_type lookup(const K2 &key, uint32 hash) const {
+		const int8 h2 = hash & 0x7F;
+		size_type pos = (hash >> 7) & _mask;
+		for (size_type step = Group::kWidth; ; step += Group::kWidth) {
+			const Group group(_ctrl + pos);
+			for (uint32 match = group.match(h2); match; match &= match - 1) {
+				const size_type idx = (pos + FlatHashMapImpl::lowestBit(match)) & _mask;
+				if (_equal(_slots[idx]._key, key))
+					return idx;
+			}
+			if (group.matchEmpty())
+				return NONE_FOUND;
+
+			pos = (pos + step) & _mask;
+		}
+	}
+
+	template<class K2>
+	size_type lookup(const K2 &key) const {
+		return lookup(key, FlatHashMapImpl::mixHash(_hash(key)));
+	}
+
+	/** Find the first free slot on the probe sequence of a hash. */
+	size_type findFreeSlot(uint32 hash) const {
+		size_type pos = (hash >> 7) & _mask;
+		for (size_type step = Group::kWidth; ; step += Group::kWidth) {
+			const uint32 match = Group(_ctrl + pos).matchEmptyOrDeleted();
+			if (match)
+				return (pos + FlatHashMapImpl::lowestBit(match)) & _mask;
+
+			pos = (pos + step) & _mask;
+		}
+	}
+
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void allocStorage(size_type capacity);
+	void freeStorage();
+	void rehash(size_type newCapacity);
+	void assign(const FHM_t &map);
+	void eraseAt(size_type idx);
+
+	/**
+	 * Simple FlatHashMap iterator implementation.
+	 */
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != nullptr);
+			assert(_idx < _hashmap->capacity());
+			assert(_hashmap->_ctrl[_idx] >= 0);
+			return &_hashmap->_slots[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(nullptr) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			const size_type end = _hashmap->capacity();
+			do {
+				_idx++;
+			} while (_idx < end && _hashmap->_ctrl[_idx] < 0);
+			if (_idx >= end)
+				_idx = NONE_FOUND;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const FHM_t &map);
+	~FlatHashMap();
+
+	FHM_t &operator=(const FHM_t &map) {
+		if (this == &map)
+			return *this;
+
+		freeStorage();
+		assign(map);
+		return *this;
+	}
+
+	template<class K2>
+	bool contains(const K2 &key) const {
+		return lookup(key) != NONE_FOUND;
+	}
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getOrCreateVal(const Key &key);
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getValOrDefault(const Key &key) const;
+
+	/**
+	 * Get a value from the hashmap. If the key is not present, then return @p defaultVal.
+	 */
+	template<class K2>
+	const Val &getValOrDefault(const K2 &key, const Val &defaultVal) const {
+		const size_type ctr = lookup(key);
+		if (ctr != NONE_FOUND)
+			return _slots[ctr]._value;
+		else
+			return defaultVal;
+	}
+
+	template<class K2>
+	bool tryGetVal(const K2 &key, Val &out) const {
+		const size_type ctr = lookup(key);
+		if (ctr != NONE_FOUND) {
+			out = _slots[ctr]._value;
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	void setVal(const Key &key, const Val &val);
+
+	/** Make room for @p count elements without growing the storage again. */
+	void reserve(size_type count);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr < capacity(); ++ctr) {
+			if (_ctrl[ctr] >= 0)
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator	end() {
+		return iterator(NONE_FOUND, this);
+	}
+
+	const_iterator	begin() const {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr < capacity(); ++ctr) {
+			if (_ctrl[ctr] >= 0)
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator	end() const {
+		return const_iterator(NONE_FOUND, this);
+	}
+
+	template<class K2>
+	iterator	find(const K2 &key) {
+		return iterator(lookup(key), this);
+	}
+
+	template<class K2>
+	const_iterator	find(const K2 &key) const {
+		return const_iterator(lookup(key), this);
+	}
+
+	/** Return true if hashmap is empty. */
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+/**
+ * Base constructor, creates an empty hashmap. No memory is allocated
+ * until the first element is added.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal(),
+	_ctrl(const_cast<int8 *>(FlatHashMapImpl::emptyGroup())), _slots(nullptr), _mask(0), _size(0), _growthLeft(0) {
+}
+
+/**
+ * Copy constructor, creates a full copy of the given hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const FHM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+/**
+ * Destructor, frees all used memory.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	freeStorage();
+}
+
+/**
+ * Internal method allocating empty storage for @p capacity elements.
+ *
+ * @note The previous storage is *not* freed here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	assert(capacity >= FLATHASHMAP_MIN_CAPACITY && (capacity & (capacity - 1)) == 0);
+
+	_ctrl = (int8 *)malloc(capacity + Group::kWidth);
+	_slots = (Node *)malloc(sizeof(Node) * capacity);
+	if (!_ctrl || !_slots)
+		::error("Common::FlatHashMap: failure to allocate %u elements", capacity);
+
+	memset(_ctrl, FlatHashMapImpl::kCtrlEmpty, capacity + Group::kWidth);
+	_mask = capacity - 1;
+	_size = 0;
+	_growthLeft = maxLoad(capacity);
+}
+
+/**
+ * Internal method destroying all elements and freeing the storage.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::freeStorage() {
+	if (!_slots)
+		return;
+
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (_ctrl[ctr] >= 0)
+			_slots[ctr].~Node();
+	}
+
+	free(_ctrl);
+	free(_slots);
+	_ctrl = const_cast<int8 *>(FlatHashMapImpl::emptyGroup());
+	_slots = nullptr;
+	_mask = 0;
+	_size = 0;
+	_growthLeft = 0;
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note The previous storage is *not* deallocated here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const FHM_t &map) {
+	_ctrl = const_cast<int8 *>(FlatHashMapImpl::emptyGroup());
+	_slots = nullptr;
+	_mask = 0;
+	_size = 0;
+	_growthLeft = 0;
+
+	if (!map._slots)
+		return;
+
+	// Keep the same layout, so that no lookup is needed
+	const size_type capacity = map._mask + 1;
+	allocStorage(capacity);
+	memcpy(_ctrl, map._ctrl, capacity + Group::kWidth);
+	for (size_type ctr = 0; ctr < capacity; ++ctr) {
+		if (_ctrl[ctr] >= 0)
+			new ((void *)&_slots[ctr]) Node(map._slots[ctr]);
+	}
+	_size = map._size;
+	_growthLeft = map._growthLeft;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rehash(size_type newCapacity) {
+	int8 *oldCtrl = _ctrl;
+	Node *oldSlots = _slots;
+	const size_type oldCapacity = capacity();
+#ifndef RELEASE_BUILD
+	const size_type oldSize = _size;
+#endif
+
+	allocStorage(newCapacity);
+
+	for (size_type ctr = 0; ctr < oldCapacity; ++ctr) {
+		if (oldCtrl[ctr] < 0)
+			continue;
+
+		// No key exists twice, so the first free slot can be taken
+		const uint32 hash = FlatHashMapImpl::mixHash(_hash(oldSlots[ctr]._key));
+		const size_type idx = findFreeSlot(hash);
+		setCtrl(idx, hash & 0x7F);
+		new ((void *)&_slots[idx]) Node(Common::move(oldSlots[ctr]));
+		oldSlots[ctr].~Node();
+		_size++;
+	}
+	_growthLeft -= _size;
+
+#ifndef RELEASE_BUILD
+	// Perform a sanity check: Old number of elements should match the new one!
+	assert(_size == oldSize);
+#endif
+
+	if (oldSlots) {
+		free(oldCtrl);
+		free(oldSlots);
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	uint32 hash = FlatHashMapImpl::mixHash(_hash(key));
+	size_type ctr = lookup(key, hash);
+	if (ctr != NONE_FOUND)
+		return ctr;
+
+	if (_growthLeft == 0) {
+		// Reuse the same capacity if most used slots are only deleted ones
+		const size_type oldCapacity = capacity();
+		if (oldCapacity == 0)
+			rehash(FLATHASHMAP_MIN_CAPACITY);
+		else if (_size * 2 < maxLoad(oldCapacity))
+			rehash(oldCapacity);
+		else
+			rehash(oldCapacity * 2);
+	}
+
+	ctr = findFreeSlot(hash);
+	if (_ctrl[ctr] == FlatHashMapImpl::kCtrlEmpty)
+		_growthLeft--;
+	setCtrl(ctr, hash & 0x7F);
+	new ((void *)&_slots[ctr]) Node(key);
+	_size++;
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::reserve(size_type count) {
+	size_type newCapacity = FLATHASHMAP_MIN_CAPACITY;
+	while (maxLoad(newCapacity) < count)
+		newCapacity *= 2;
+
+	if (newCapacity > capacity())
+		rehash(newCapacity);
+}
+
+/**
+ * Clear all values in the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	if (shrinkArray || !_slots) {
+		freeStorage();
+		return;
+	}
+
+	const size_type oldCapacity = _mask + 1;
+	for (size_type ctr = 0; ctr < oldCapacity; ++ctr) {
+		if (_ctrl[ctr] >= 0)
+			_slots[ctr].~Node();
+	}
+
+	memset(_ctrl, FlatHashMapImpl::kCtrlEmpty, oldCapacity + Group::kWidth);
+	_size = 0;
+	_growthLeft = maxLoad(oldCapacity);
+}
+
+/**
+ * Get a value from the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getOrCreateVal(key);
+}
+
+/**
+ * @overload
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+/**
+ * Get a value from the hashmap.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getOrCreateVal(const Key &key) {
+	// The storage may move while inserting
+	size_type ctr = lookupAndCreateIfMissing(key);
+	return _slots[ctr]._value;
+}
+
+/**
+ * @overload
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr != NONE_FOUND)
+		return _slots[ctr]._value;
+	else
+		// See comment in HashMap::getVal()
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	size_type ctr = lookup(key);
+	if (ctr != NONE_FOUND)
+		return _slots[ctr]._value;
+	else
+		// See comment in HashMap::getVal()
+#ifdef RELEASE_BUILD
+		return _defaultVal;
+#else
+		unknownKeyError(key);
+#endif
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getValOrDefault(const Key &key) const {
+	return getValOrDefault(key, _defaultVal);
+}
+
+/**
+ * Assign an element specified by @p key to a value @p val.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	_slots[ctr]._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseAt(size_type idx) {
+	_slots[idx].~Node();
+	_size--;
+
+	// If the group around the slot never filled up, no probe sequence went
+	// past it, so the slot can become empty again instead of deleted.
+	const size_type before = (idx - Group::kWidth) & _mask;
+	const uint32 emptyAfter = Group(_ctrl + idx).matchEmpty();
+	const uint32 emptyBefore = Group(_ctrl + before).matchEmpty();
+	if (emptyBefore && emptyAfter) {
+		const uint leadingFull = Group::kWidth - 1 - intLog2(emptyBefore);
+		const uint trailingFull = FlatHashMapImpl::lowestBit(emptyAfter);
+		if (leadingFull + trailingFull < Group::kWidth) {
+			setCtrl(idx, FlatHashMapImpl::kCtrlEmpty);
+			_growthLeft++;
+			return;
+		}
+	}
+
+	setCtrl(idx, FlatHashMapImpl::kCtrlDeleted);
+}
+
+/**
+ * Erase an element referred to by an iterator.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	assert(entry._idx < capacity());
+	assert(_ctrl[entry._idx] >= 0);
+
+	eraseAt(entry._idx);
+}
+
+/**
+ * Erase an element specified by a key.
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr != NONE_FOUND)
+		eraseAt(ctr);
+}
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -252,6 +252,17 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieve the size and the last modification time of the file referred
+	 * by this node, without opening it.
+	 *
+	 * The modification time is only meant to be compared with an earlier value
+	 * for the same file, its unit and epoch depend on the backend.
+	 *
+	 * @return True if the backend could provide both values, false otherwise.
+	 */
+	bool getFileStats(int64 &size, int64 &modificationTime) const;
+
 	/**
 	 * Create a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
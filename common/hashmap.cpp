@@ -29,7 +29,7 @@ namespace Common {
 
 // Hash function for strings, taken from CPython.
 uint hashit(const char *p) {
-	uint hash = *p << 7;
+	uint hash = (byte)*p << 7;
 	byte c;
 	int size = 0;
 	while ((c = *p++)) {
@@ -27,11 +27,19 @@
 
 #include "common/md5.h"
 #include "common/endian.h"
+#include "common/ptr.h"
 #include "common/str.h"
 #include "common/stream.h"
+#include "common/util.h"
 
 namespace Common {
 
+enum {
+	// Size of the reads through the stream. Large reads avoid the overhead
+	// of the stream layers, and keep the data aligned on whole blocks.
+	kMD5ReadBufferSize = 64 * 1024
+};
+
 struct md5_context {
 	uint32 total[2];
 	uint32 state[4];
@@ -56,126 +64,146 @@ void md5_starts(md5_context *ctx) {
 	ctx->state[3] = 0x10325476;
 }
 
-static void md5_process(md5_context *ctx, const uint8 data[64]) {
+/**
+ * Process whole 64-byte blocks. The state stays in local variables for all
+ * the blocks, and each round is fully unrolled.
+ */
+static void md5_process(md5_context *ctx, const uint8 *data, uint32 blocks) {
 	uint32 X[16], A, B, C, D;
 
-	GET_UINT32(X[0],  data,  0);
-	GET_UINT32(X[1],  data,  4);
-	GET_UINT32(X[2],  data,  8);
-	GET_UINT32(X[3],  data, 12);
-	GET_UINT32(X[4],  data, 16);
-	GET_UINT32(X[5],  data, 20);
-	GET_UINT32(X[6],  data, 24);
-	GET_UINT32(X[7],  data, 28);
-	GET_UINT32(X[8],  data, 32);
-	GET_UINT32(X[9],  data, 36);
-	GET_UINT32(X[10], data, 40);
-	GET_UINT32(X[11], data, 44);
-	GET_UINT32(X[12], data, 48);
-	GET_UINT32(X[13], data, 52);
-	GET_UINT32(X[14], data, 56);
-	GET_UINT32(X[15], data, 60);
-
-#define S(x, n) ((x << n) | ((x & 0xFFFFFFFF) >> (32 - n)))
+#define S(x, n) ROTATE_LEFT_32(x, n)
 
 #define P(a, b, c, d, k, s, t)                    \
 {                                                 \
 	a += F(b,c,d) + X[k] + t; a = S(a,s) + b; \
 }
 
+	// The two halves of the second round function are disjoint, so they can
+	// be added separately, which shortens the dependency chain on b
+#define P2(a, b, c, d, k, s, t)                                 \
+{                                                               \
+	a += (c & ~d) + X[k] + t; a += (b & d); a = S(a,s) + b; \
+}
+
 	A = ctx->state[0];
 	B = ctx->state[1];
 	C = ctx->state[2];
 	D = ctx->state[3];
 
+	for (; blocks; blocks--, data += 64) {
+		const uint32 AA = A, BB = B, CC = C, DD = D;
+
+		GET_UINT32(X[0],  data,  0);
+		GET_UINT32(X[1],  data,  4);
+		GET_UINT32(X[2],  data,  8);
+		GET_UINT32(X[3],  data, 12);
+		GET_UINT32(X[4],  data, 16);
+		GET_UINT32(X[5],  data, 20);
+		GET_UINT32(X[6],  data, 24);
+		GET_UINT32(X[7],  data, 28);
+		GET_UINT32(X[8],  data, 32);
+		GET_UINT32(X[9],  data, 36);
+		GET_UINT32(X[10], data, 40);
+		GET_UINT32(X[11], data, 44);
+		GET_UINT32(X[12], data, 48);
+		GET_UINT32(X[13], data, 52);
+		GET_UINT32(X[14], data, 56);
+		GET_UINT32(X[15], data, 60);
+
 #define F(x, y, z) (z ^ (x & (y ^ z)))
 
-	P(A, B, C, D,  0,  7, 0xD76AA478);
-	P(D, A, B, C,  1, 12, 0xE8C7B756);
-	P(C, D, A, B,  2, 17, 0x242070DB);
-	P(B, C, D, A,  3, 22, 0xC1BDCEEE);
-	P(A, B, C, D,  4,  7, 0xF57C0FAF);
-	P(D, A, B, C,  5, 12, 0x4787C62A);
-	P(C, D, A, B,  6, 17, 0xA8304613);
-	P(B, C, D, A,  7, 22, 0xFD469501);
-	P(A, B, C, D,  8,  7, 0x698098D8);
-	P(D, A, B, C,  9, 12, 0x8B44F7AF);
-	P(C, D, A, B, 10, 17, 0xFFFF5BB1);
-	P(B, C, D, A, 11, 22, 0x895CD7BE);
-	P(A, B, C, D, 12,  7, 0x6B901122);
-	P(D, A, B, C, 13, 12, 0xFD987193);
-	P(C, D, A, B, 14, 17, 0xA679438E);
-	P(B, C, D, A, 15, 22, 0x49B40821);
+		P(A, B, C, D,  0,  7, 0xD76AA478);
+		P(D, A, B, C,  1, 12, 0xE8C7B756);
+		P(C, D, A, B,  2, 17, 0x242070DB);
+		P(B, C, D, A,  3, 22, 0xC1BDCEEE);
+		P(A, B, C, D,  4,  7, 0xF57C0FAF);
+		P(D, A, B, C,  5, 12, 0x4787C62A);
+		P(C, D, A, B,  6, 17, 0xA8304613);
+		P(B, C, D, A,  7, 22, 0xFD469501);
+		P(A, B, C, D,  8,  7, 0x698098D8);
+		P(D, A, B, C,  9, 12, 0x8B44F7AF);
+		P(C, D, A, B, 10, 17, 0xFFFF5BB1);
+		P(B, C, D, A, 11, 22, 0x895CD7BE);
+		P(A, B, C, D, 12,  7, 0x6B901122);
+		P(D, A, B, C, 13, 12, 0xFD987193);
+		P(C, D, A, B, 14, 17, 0xA679438E);
+		P(B, C, D, A, 15, 22, 0x49B40821);
 
 #undef F
 
-#define F(x, y, z) (y ^ (z & (x ^ y)))
-
-	P(A, B, C, D,  1,  5, 0xF61E2562);
-	P(D, A, B, C,  6,  9, 0xC040B340);
-	P(C, D, A, B, 11, 14, 0x265E5A51);
-	P(B, C, D, A,  0, 20, 0xE9B6C7AA);
-	P(A, B, C, D,  5,  5, 0xD62F105D);
-	P(D, A, B, C, 10,  9, 0x02441453);
-	P(C, D, A, B, 15, 14, 0xD8A1E681);
-	P(B, C, D, A,  4, 20, 0xE7D3FBC8);
-	P(A, B, C, D,  9,  5, 0x21E1CDE6);
-	P(D, A, B, C, 14,  9, 0xC33707D6);
-	P(C, D, A, B,  3, 14, 0xF4D50D87);
-	P(B, C, D, A,  8, 20, 0x455A14ED);
-	P(A, B, C, D, 13,  5, 0xA9E3E905);
-	P(D, A, B, C,  2,  9, 0xFCEFA3F8);
-	P(C, D, A, B,  7, 14, 0x676F02D9);
-	P(B, C, D, A, 12, 20, 0x8D2A4C8A);
-
-#undef F
+		P2(A, B, C, D,  1,  5, 0xF61E2562);
+		P2(D, A, B, C,  6,  9, 0xC040B340);
+		P2(C, D, A, B, 11, 14, 0x265E5A51);
+		P2(B, C, D, A,  0, 20, 0xE9B6C7AA);
+		P2(A, B, C, D,  5,  5, 0xD62F105D);
+		P2(D, A, B, C, 10,  9, 0x02441453);
+		P2(C, D, A, B, 15, 14, 0xD8A1E681);
+		P2(B, C, D, A,  4, 20, 0xE7D3FBC8);
+		P2(A, B, C, D,  9,  5, 0x21E1CDE6);
+		P2(D, A, B, C, 14,  9, 0xC33707D6);
+		P2(C, D, A, B,  3, 14, 0xF4D50D87);
+		P2(B, C, D, A,  8, 20, 0x455A14ED);
+		P2(A, B, C, D, 13,  5, 0xA9E3E905);
+		P2(D, A, B, C,  2,  9, 0xFCEFA3F8);
+		P2(C, D, A, B,  7, 14, 0x676F02D9);
+		P2(B, C, D, A, 12, 20, 0x8D2A4C8A);
 
 #define F(x, y, z) (x ^ y ^ z)
 
-	P(A, B, C, D,  5,  4, 0xFFFA3942);
-	P(D, A, B, C,  8, 11, 0x8771F681);
-	P(C, D, A, B, 11, 16, 0x6D9D6122);
-	P(B, C, D, A, 14, 23, 0xFDE5380C);
-	P(A, B, C, D,  1,  4, 0xA4BEEA44);
-	P(D, A, B, C,  4, 11, 0x4BDECFA9);
-	P(C, D, A, B,  7, 16, 0xF6BB4B60);
-	P(B, C, D, A, 10, 23, 0xBEBFBC70);
-	P(A, B, C, D, 13,  4, 0x289B7EC6);
-	P(D, A, B, C,  0, 11, 0xEAA127FA);
-	P(C, D, A, B,  3, 16, 0xD4EF3085);
-	P(B, C, D, A,  6, 23, 0x04881D05);
-	P(A, B, C, D,  9,  4, 0xD9D4D039);
-	P(D, A, B, C, 12, 11, 0xE6DB99E5);
-	P(C, D, A, B, 15, 16, 0x1FA27CF8);
-	P(B, C, D, A,  2, 23, 0xC4AC5665);
+		P(A, B, C, D,  5,  4, 0xFFFA3942);
+		P(D, A, B, C,  8, 11, 0x8771F681);
+		P(C, D, A, B, 11, 16, 0x6D9D6122);
+		P(B, C, D, A, 14, 23, 0xFDE5380C);
+		P(A, B, C, D,  1,  4, 0xA4BEEA44);
+		P(D, A, B, C,  4, 11, 0x4BDECFA9);
+		P(C, D, A, B,  7, 16, 0xF6BB4B60);
+		P(B, C, D, A, 10, 23, 0xBEBFBC70);
+		P(A, B, C, D, 13,  4, 0x289B7EC6);
+		P(D, A, B, C,  0, 11, 0xEAA127FA);
+		P(C, D, A, B,  3, 16, 0xD4EF3085);
+		P(B, C, D, A,  6, 23, 0x04881D05);
+		P(A, B, C, D,  9,  4, 0xD9D4D039);
+		P(D, A, B, C, 12, 11, 0xE6DB99E5);
+		P(C, D, A, B, 15, 16, 0x1FA27CF8);
+		P(B, C, D, A,  2, 23, 0xC4AC5665);
 
 #undef F
 
 #define F(x, y, z) (y ^ (x | ~z))
 
-	P(A, B, C, D,  0,  6, 0xF4292244);
-	P(D, A, B, C,  7, 10, 0x432AFF97);
-	P(C, D, A, B, 14, 15, 0xAB9423A7);
-	P(B, C, D, A,  5, 21, 0xFC93A039);
-	P(A, B, C, D, 12,  6, 0x655B59C3);
-	P(D, A, B, C,  3, 10, 0x8F0CCC92);
-	P(C, D, A, B, 10, 15, 0xFFEFF47D);
-	P(B, C, D, A,  1, 21, 0x85845DD1);
-	P(A, B, C, D,  8,  6, 0x6FA87E4F);
-	P(D, A, B, C, 15, 10, 0xFE2CE6E0);
-	P(C, D, A, B,  6, 15, 0xA3014314);
-	P(B, C, D, A, 13, 21, 0x4E0811A1);
-	P(A, B, C, D,  4,  6, 0xF7537E82);
-	P(D, A, B, C, 11, 10, 0xBD3AF235);
-	P(C, D, A, B,  2, 15, 0x2AD7D2BB);
-	P(B, C, D, A,  9, 21, 0xEB86D391);
+		P(A, B, C, D,  0,  6, 0xF4292244);
+		P(D, A, B, C,  7, 10, 0x432AFF97);
+		P(C, D, A, B, 14, 15, 0xAB9423A7);
+		P(B, C, D, A,  5, 21, 0xFC93A039);
+		P(A, B, C, D, 12,  6, 0x655B59C3);
+		P(D, A, B, C,  3, 10, 0x8F0CCC92);
+		P(C, D, A, B, 10, 15, 0xFFEFF47D);
+		P(B, C, D, A,  1, 21, 0x85845DD1);
+		P(A, B, C, D,  8,  6, 0x6FA87E4F);
+		P(D, A, B, C, 15, 10, 0xFE2CE6E0);
+		P(C, D, A, B,  6, 15, 0xA3014314);
+		P(B, C, D, A, 13, 21, 0x4E0811A1);
+		P(A, B, C, D,  4,  6, 0xF7537E82);
+		P(D, A, B, C, 11, 10, 0xBD3AF235);
+		P(C, D, A, B,  2, 15, 0x2AD7D2BB);
+		P(B, C, D, A,  9, 21, 0xEB86D391);
 
 #undef F
 
-	ctx->state[0] += A;
-	ctx->state[1] += B;
-	ctx->state[2] += C;
-	ctx->state[3] += D;
+		A += AA;
+		B += BB;
+		C += CC;
+		D += DD;
+	}
+
+#undef P2
+#undef P
+#undef S
+
+	ctx->state[0] = A;
+	ctx->state[1] = B;
+	ctx->state[2] = C;
+	ctx->state[3] = D;
 }
 
 void md5_update(md5_context *ctx, const uint8 *input, uint32 length) {
@@ -195,16 +223,16 @@ void md5_update(md5_context *ctx, const uint8 *input, uint32 length) {
 
 	if (left && length >= fill) {
 		memcpy((void *)(ctx->buffer + left), (const void *)input, fill);
-		md5_process(ctx, ctx->buffer);
+		md5_process(ctx, ctx->buffer, 1);
 		length -= fill;
 		input  += fill;
 		left = 0;
 	}
 
-	while (length >= 64) {
-		md5_process(ctx, input);
-		length -= 64;
-		input  += 64;
+	if (length >= 64) {
+		md5_process(ctx, input, length / 64);
+		input  += length & ~0x3F;
+		length &= 0x3F;
 	}
 
 	if (length) {
@@ -250,31 +278,34 @@ bool computeStreamMD5(ReadStream &stream, uint8 digest[16], uint32 length, Progr
 #else
 	md5_context ctx;
 	int i;
-	unsigned char buf[1000];
 	bool restricted = (length != 0);
+	uint32 bufSize;
 	uint32 readlen;
 
-	if (!restricted || sizeof(buf) <= length)
-		readlen = sizeof(buf);
+	if (!restricted || kMD5ReadBufferSize <= length)
+		bufSize = kMD5ReadBufferSize;
 	else
-		readlen = length;
+		bufSize = length;
+	readlen = bufSize;
+
+	ScopedPtr<uint8, ArrayDeleter<uint8> > buf(new uint8[bufSize]);
 
 	md5_starts(&ctx);
 
-	while ((i = stream.read(buf, readlen)) > 0) {
+	while ((i = stream.read(buf.get(), readlen)) > 0) {
 
 		if (progressUpdateCallback != nullptr && !progressUpdateCallback(callbackParameter, i)) {
 			return false;
 		}
 
-		md5_update(&ctx, buf, i);
+		md5_update(&ctx, buf.get(), i);
 
 		if (restricted) {
 			length -= i;
 			if (length == 0)
 				break;
 
-			if (sizeof(buf) > length)
+			if (bufSize > length)
 				readlen = length;
 		}
 	}
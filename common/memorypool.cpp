@@ -20,6 +20,7 @@
  */
 
 #include "common/memorypool.h"
+#include "common/textconsole.h"
 #include "common/util.h"
 
 namespace Common {
@@ -174,4 +175,97 @@ void MemoryPool::freeUnusedPages() {
 	}
 }
 
+
+Arena::Arena(size_t blockSize) : _blockSize(blockSize), _current(0), _offset(0) {
+}
+
+Arena::~Arena() {
+	freeMemory();
+}
+
+void *Arena::allocate(size_t size, size_t alignment) {
+	assert(alignment && (alignment & (alignment - 1)) == 0);
+
+	if (_current < _blocks.size()) {
+		const Block &block = _blocks[_current];
+		const uintptr start = (uintptr)block.start + _offset;
+		const uintptr aligned = (start + alignment - 1) & ~(uintptr)(alignment - 1);
+		const size_t offset = _offset + (aligned - start);
+		if (offset <= block.size && size <= block.size - offset) {
+			_offset = offset + size;
+			return (void *)aligned;
+		}
+	}
+
+	return allocateSlow(size, alignment);
+}
+
+void *Arena::allocateSlow(size_t size, size_t alignment) {
+	// Move on to the next block large enough, keeping the ones skipped for
+	// after the next rewind. The first block has no space used up yet.
+	size_t next = _current < _blocks.size() && _offset == 0 ? _current : _current + 1;
+	while (next < _blocks.size() && _blocks[next].size < size + alignment - 1)
+		next++;
+
+	if (next >= _blocks.size()) {
+		addBlock(MAX(_blockSize, size + alignment - 1));
+		next = _blocks.size() - 1;
+	}
+
+	_current = next;
+	_offset = 0;
+	return allocate(size, alignment);
+}
+
+void Arena::addBlock(size_t size) {
+	Block block;
+	block.start = (byte *)::malloc(size);
+	if (!block.start)
+		error("Common::Arena: failure to allocate %u bytes", (uint)size);
+	block.size = size;
+	_blocks.push_back(block);
+}
+
+void Arena::rewind(const Marker &marker) {
+	assert(marker._block < _current || (marker._block == _current && marker._offset <= _offset));
+	_current = marker._block;
+	_offset = marker._offset;
+}
+
+void Arena::reset() {
+	if (_blocks.size() > 1) {
+		const size_t capacity = getCapacity();
+		freeMemory();
+		addBlock(capacity);
+	}
+
+	_current = 0;
+	_offset = 0;
+}
+
+void Arena::freeMemory() {
+	for (size_t i = 0; i < _blocks.size(); ++i)
+		::free(_blocks[i].start);
+	_blocks.clear();
+	_current = 0;
+	_offset = 0;
+}
+
+size_t Arena::getUsedSize() const {
+	if (_current >= _blocks.size())
+		return 0;
+
+	size_t used = _offset;
+	for (size_t i = 0; i < _current; ++i)
+		used += _blocks[i].size;
+	return used;
+}
+
+size_t Arena::getCapacity() const {
+	size_t capacity = 0;
+	for (size_t i = 0; i < _blocks.size(); ++i)
+		capacity += _blocks[i].size;
+	return capacity;
+}
+
 } // End of namespace Common
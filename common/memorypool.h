@@ -24,6 +24,7 @@
 
 #include "common/scummsys.h"
 #include "common/array.h"
+#include "common/util.h"
 
 
 namespace Common {
@@ -152,6 +153,183 @@ public:
 	}
 };
 
+/**
+ * This class provides a bump allocator for short-lived data, like the
+ * data needed for a single frame or while a room is loaded.
+ *
+ * Allocations are taken one after the other from large blocks, and are
+ * never freed on their own. Instead, the whole arena is released at once
+ * with reset(), or everything allocated after a marker with rewind().
+ * The blocks are kept for reuse, so an arena reset every frame stops
+ * allocating memory once it has grown to the size of a frame.
+ *
+ * Destructors of objects created in an arena are not called. The
+ * containers in Common take no allocator, so arrays are allocated with
+ * allocateArray() instead.
+ */
+class Arena {
+public:
+	enum {
+		DEFAULT_BLOCK_SIZE = 64 * 1024,
+		DEFAULT_ALIGNMENT = 8
+	};
+
+	/**
+	 * Position in an arena, which can be restored with rewind().
+	 */
+	class Marker {
+		friend class Arena;
+
+		size_t _block;
+		size_t _offset;
+
+		Marker(size_t block, size_t offset) : _block(block), _offset(offset) {}
+	};
+
+	/**
+	 * Constructor for an arena allocating blocks of the given size.
+	 * No memory is allocated until the first allocation.
+	 * @param blockSize		the minimum size of each block
+	 */
+	explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+	~Arena();
+
+	/**
+	 * Allocate memory from the arena.
+	 * @param size			the number of bytes to allocate
+	 * @param alignment		the alignment of the result, which must be a power of two
+	 */
+	void	*allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT);
+
+	/**
+	 * Allocate uninitialized memory for @p count objects of type T.
+	 */
+	template<class T>
+	T		*allocateArray(size_t count) {
+		return (T *)allocate(sizeof(T) * count, alignof(T));
+	}
+
+	/**
+	 * Construct an object in memory from the arena. Its destructor is
+	 * never called.
+	 */
+	template<class T, class... TArgs>
+	T		*create(TArgs &&...args) {
+		return new (allocate(sizeof(T), alignof(T))) T(Common::forward<TArgs>(args)...);
+	}
+
+	/**
+	 * Return the current position, to release everything allocated
+	 * afterwards with rewind().
+	 */
+	Marker	getMarker() const { return Marker(_current, _offset); }
+
+	/**
+	 * Release everything allocated since the given marker was taken.
+	 * The memory is kept for the next allocations.
+	 */
+	void	rewind(const Marker &marker);
+
+	/**
+	 * Release everything allocated from the arena. If more than one block
+	 * was needed, they are replaced by a single block large enough for
+	 * all of them, so that the next use of the arena allocates nothing.
+	 */
+	void	reset();
+
+	/**
+	 * Free all the memory held by the arena.
+	 */
+	void	freeMemory();
+
+	/**
+	 * Return the number of bytes used by allocations, including padding.
+	 */
+	size_t	getUsedSize() const;
+
+	/**
+	 * Return the number of bytes held by the arena.
+	 */
+	size_t	getCapacity() const;
+
+	/**
+	 * Return the number of memory blocks held by the arena.
+	 */
+	size_t	getBlockCount() const { return _blocks.size(); }
+
+private:
+	Arena(const Arena &);
+	Arena &operator=(const Arena &);
+
+	struct Block {
+		byte *start;
+		size_t size;
+	};
+
+	const size_t	_blockSize;
+	Array<Block>	_blocks;
+	size_t			_current;
+	size_t			_offset;
+
+	void	*allocateSlow(size_t size, size_t alignment);
+	void	addBlock(size_t size);
+};
+
+/**
+ * Restores an arena to its state at construction time when going out
+ * of scope, releasing everything allocated in between.
+ */
+class ArenaScope {
+public:
+	explicit ArenaScope(Arena &arena) : _arena(arena), _marker(arena.getMarker()) {}
+	~ArenaScope() { _arena.rewind(_marker); }
+
+private:
+	ArenaScope(const ArenaScope &);
+	ArenaScope &operator=(const ArenaScope &);
+
+	Arena &_arena;
+	Arena::Marker _marker;
+};
+
+/**
+ * A pair of arenas for data which must live for one frame after the one
+ * it was allocated in, e.g. to compare a frame with the previous one.
+ *
+ * Each call to nextFrame() makes the arena of the frame before the
+ * previous one current, and resets it.
+ */
+class FrameAllocator {
+public:
+	explicit FrameAllocator(size_t blockSize = Arena::DEFAULT_BLOCK_SIZE)
+		: _frame0(blockSize), _frame1(blockSize), _current(&_frame0), _previous(&_frame1) {}
+
+	void	*allocate(size_t size, size_t alignment = Arena::DEFAULT_ALIGNMENT) {
+		return _current->allocate(size, alignment);
+	}
+
+	/** Return the arena of the current frame. */
+	Arena	&getArena() { return *_current; }
+
+	/** Return the arena of the previous frame. */
+	Arena	&getPreviousArena() { return *_previous; }
+
+	/** Release the data of the frame before the previous one, and start a new frame. */
+	void	nextFrame() {
+		SWAP(_current, _previous);
+		_current->reset();
+	}
+
+private:
+	FrameAllocator(const FrameAllocator &);
+	FrameAllocator &operator=(const FrameAllocator &);
+
+	Arena	_frame0;
+	Arena	_frame1;
+	Arena	*_current;
+	Arena	*_previous;
+};
+
 /** @} */
 
 } // End of namespace Common
@@ -173,4 +351,14 @@ inline void operator delete(void *p, Common::MemoryPool &pool) {
 	pool.freeChunk(p);
 }
 
+/**
+ * A custom placement new operator, using an Arena.
+ */
+inline void *operator new(size_t nbytes, Common::Arena &arena) {
+	return arena.allocate(nbytes);
+}
+
+inline void operator delete(void *p, Common::Arena &arena) {
+}
+
 #endif
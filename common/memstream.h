@@ -93,6 +93,9 @@ public:
 	int64 size() const override { return _size; }
 
 	bool seek(int64 offs, int whence = SEEK_SET) override;
+
+	/** Return the start of the memory read by the stream, valid as long as the stream. */
+	const byte *getData() const { return _ptr - _pos; }
 };
 
 
@@ -23,6 +23,7 @@ MODULE_OBJS := \
 	memorypool.o \
 	md5.o \
 	mutex.o \
+	threadpool.o \
 	osd_message_queue.o \
 	path.o \
 	platform.o \
@@ -37,6 +38,7 @@ MODULE_OBJS := \
 	streamdebug.o \
 	str-base.o \
 	str-enc.o \
+	str-intern.o \
 	encodings/singlebyte.o \
 	system.o \
 	textconsole.o \
@@ -47,6 +49,7 @@ MODULE_OBJS := \
 	ustr.o \
 	util.o \
 	xpfloat.o \
+	xxhash.o \
 	zip-set.o \
 	std/std.o
 
@@ -0,0 +1,363 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_RINGBUFFER_H
+#define COMMON_RINGBUFFER_H
+
+#include "common/scummsys.h"
+#include "common/util.h"
+
+#include <atomic>
+
+namespace Common {
+
+/**
+ * @defgroup common_ringbuffer Ring buffer
+ * @ingroup common
+ *
+ * @brief Lock-free single-producer/single-consumer FIFO.
+ * @{
+ */
+
+/**
+ * A lock-free FIFO ring-buffer with contiguous buffers for production.
+ *
+ * The producer (tryProduce()/produced(), or push()/write()) and the consumer
+ * (tryConsume()/consumed(), or pop()/read()) may run on different threads
+ * without any locking. Several producers or several consumers must be
+ * serialized by the caller.
+ */
+template<typename T>
+class RingBuffer {
+public:
+	RingBuffer(size_t n) : _size(n + 1), _buffer(new T[_size]), _pendingRead(0), _pendingWrite(0), _wraparoundWrite(false), _read(0), _write(0), _last(0) { }
+	RingBuffer(const RingBuffer<T> &) = delete;
+
+	/**
+	 * Construct a new RingBuffer moving data from the old one.
+	 * The other RingBuffer must not be in use and destroyed afterwards.
+	 *
+	 * When the new RingBuffer is smaller than the previous one, the older samples are dropped.
+	 */
+	RingBuffer(size_t n, RingBuffer<T> &&o) : RingBuffer(n) {
+		// First make the RingBuffer was in a valid state and make it invalid
+		const size_t write = o._write.exchange(-1);
+		const size_t read = o._read.exchange(-1);
+		assert(o._pendingWrite == write);
+		o._pendingWrite = 0;
+		assert(o._pendingRead == read);
+		o._pendingRead = -1;
+
+		T const *buffer = o._buffer;
+		o._buffer = nullptr;
+
+		// From here, o is completely invalid
+
+		if (read == write) {
+			// Empty queue: nothing to move
+			delete[] buffer;
+			return;
+		}
+		if (read < write) {
+			// Cap the kept data to our own buffer size
+			size_t nread = read;
+			if (nread + n < write) {
+				nread = write - n;
+			}
+			_pendingWrite = write - nread;
+
+			memcpy(&_buffer[0], &buffer[nread], _pendingWrite * sizeof(T));
+
+			_last.store(_pendingWrite, std::memory_order_relaxed);
+			_write.store(_pendingWrite, std::memory_order_release);
+			delete[] buffer;
+			return;
+		}
+
+		// read > write: the buffer is in two parts
+		if (n <= write) {
+			// Easy: we can take the last n samples in one shot
+			_pendingWrite = n;
+			memcpy(&_buffer[0], &buffer[write - n], n * sizeof(T));
+
+			_last.store(_pendingWrite, std::memory_order_relaxed);
+			_write.store(_pendingWrite, std::memory_order_release);
+
+			delete[] buffer;
+			return;
+		}
+
+		// n > write
+		size_t last = o._last.load(std::memory_order_relaxed);
+		size_t endPartSize = last - read;
+		if (endPartSize > (n - write)) {
+			endPartSize = n - write;
+		}
+
+		// First, copy the end of the buffer up to last, then copy the whole beginning
+		_pendingWrite = endPartSize + write;
+		memcpy(&_buffer[0], &buffer[last - endPartSize], endPartSize * sizeof(T));
+		memcpy(&_buffer[endPartSize], &buffer[0], write * sizeof(T));
+
+		_last.store(_pendingWrite, std::memory_order_relaxed);
+		_write.store(_pendingWrite, std::memory_order_release);
+
+		delete[] buffer;
+	}
+
+	~RingBuffer() { delete[] _buffer; }
+
+	/** Maximum number of queued elements. */
+	size_t capacity() const { return _size - 1; }
+
+	/** Number of queued elements. Exact only from the producer or consumer thread. */
+	size_t size() const {
+		const size_t write = _write.load(std::memory_order_acquire);
+		const size_t read = _read.load(std::memory_order_acquire);
+		if (read <= write)
+			return write - read;
+
+		// The elements up to _last, then from the start of the buffer
+		return _last.load(std::memory_order_relaxed) - read + write;
+	}
+
+	bool empty() const { return size() == 0; }
+	bool full() const { return size() >= capacity(); }
+
+	/**
+	 * Try to produce at least n elements.
+	 * The ring-buffer will adjust n with the real element count
+	 * which should be produced.
+	 * In case of failure, nullptr is returned.
+	 *
+	 * When successful, n is guaranteed to be at least what has been queried.
+	 * A pointer to the buffer to fill is returned.
+	 */
+	T *tryProduce(size_t *n) {
+		size_t realN = *n;
+		assert(realN > 0);
+
+		size_t write = _write.load(std::memory_order_relaxed);
+		size_t read = _read.load(std::memory_order_acquire);
+		assert(_pendingWrite == write);
+
+		// Try to acquire at at least realN records
+		if (read <= write) {
+			if (write + realN <= _size) {
+				realN = _size - write;
+				*n = realN;
+				_wraparoundWrite = false;
+				_pendingWrite = write + realN;
+				return &_buffer[write];
+			} else if (realN < read) { // Don't go up to read: that would make believe it's empty
+				realN = read - 1;
+				*n = realN;
+				_wraparoundWrite = true;
+				_pendingWrite = realN;
+				return &_buffer[0];
+			} else {
+				return nullptr;
+			}
+		} else {
+			if (write + realN < read) { // Don't go up to read: that would make believe it's empty
+				realN = read - write - 1;
+				*n = realN;
+				_wraparoundWrite = false;
+				_pendingWrite = write + realN;
+				return &_buffer[write];
+			} else {
+				return nullptr;
+			}
+		}
+	}
+
+	/**
+	 * Indicate that n samples have been produced.
+	 * n must be less than or equal to what have been returned by tryProduce.
+	 */
+	void produced(size_t n) {
+		size_t write = _write.load(std::memory_order_relaxed);
+		size_t pendingWrite;
+		if (_wraparoundWrite) {
+			pendingWrite = n;
+			_last.store(write, std::memory_order_relaxed);
+		} else {
+			pendingWrite = write + n;
+		}
+		// Make sure we didn't overshoot
+		assert(_pendingWrite >= pendingWrite);
+		if (pendingWrite > _last.load(std::memory_order_relaxed)) {
+			_last.store(pendingWrite, std::memory_order_relaxed);
+		}
+		_pendingWrite = pendingWrite;
+		_write.store(pendingWrite, std::memory_order_release);
+	}
+
+	/**
+	 * Try to consume at most n elements.
+	 * If there is less than n elements (or if the buffer is not contiguous), adjusts n to the real count.
+	 * If there is no element available, returns nullptr.
+	 *
+	 * Loop over tryConsume until it returns nullptr to fetch all the expected elements.
+	 */
+	T *tryConsume(size_t *n) {
+		size_t realN = *n;
+		assert(realN > 0);
+
+		size_t read = _read.load(std::memory_order_relaxed);
+		assert(_pendingRead == read);
+
+		// Try to acquire at most n records
+		size_t write = _write.load(std::memory_order_acquire);
+
+		if (read == write) {
+			// Empty queue: nothing to return
+			return nullptr;
+		} else if (read < write) {
+			if (read + realN > write) {
+				realN = write - read;
+			}
+			*n = realN;
+			_pendingRead = read + realN;
+			return &_buffer[read];
+		} else {
+			size_t last = _last.load(std::memory_order_relaxed);
+			if (read == last) { // This happens when we read up to the end the last time: consider read as 0
+				if (0 == write) {
+					// Empty queue: nothing to return
+					return nullptr;
+				}
+				if (realN > write) {
+					realN = write;
+				}
+				*n = realN;
+				_pendingRead = realN;
+				return &_buffer[0];
+			} else if (read + realN < last) {
+				*n = realN;
+				_pendingRead = read + realN;
+				return &_buffer[read];
+			} else {
+				*n = last - read;
+				_pendingRead = 0;
+				return &_buffer[read];
+			}
+		}
+	}
+
+	/**
+	 * Indicate that the previous consume request has been done.
+	 *
+	 * Frees the buffer for more produced samples.
+	 */
+	void consumed() {
+		_read.store(_pendingRead, std::memory_order_release);
+	}
+
+	/** Append one element. Returns false if the buffer is full. Producer only. */
+	bool push(const T &value) {
+		return write(&value, 1) == 1;
+	}
+
+	/** Remove the oldest element. Returns false if the buffer is empty. Consumer only. */
+	bool pop(T &value) {
+		return read(&value, 1) == 1;
+	}
+
+	/**
+	 * Append up to @p count elements. Returns the number appended. Producer only.
+	 *
+	 * As the elements are produced one block at a time, up to the end of
+	 * the buffer, this always accepts as many elements as capacity() allows.
+	 */
+	size_t write(const T *data, size_t count) {
+		count = MIN<size_t>(count, capacity() - size());
+
+		size_t done = 0;
+		while (done < count) {
+			size_t n = 1;
+			T *dst = tryProduce(&n);
+			if (!dst)
+				break;
+
+			n = MIN<size_t>(n, count - done);
+			for (size_t i = 0; i < n; i++)
+				dst[i] = data[done + i];
+			produced(n);
+			done += n;
+		}
+
+		return done;
+	}
+
+	/** Remove up to @p count elements. Returns the number removed. Consumer only. */
+	size_t read(T *data, size_t count) {
+		size_t done = 0;
+		while (done < count) {
+			size_t n = count - done;
+			const T *src = tryConsume(&n);
+			if (!src)
+				break;
+
+			for (size_t i = 0; i < n; i++)
+				data[done + i] = src[i];
+			consumed();
+			done += n;
+		}
+
+		return done;
+	}
+
+	/** Drop all queued elements. Consumer only. */
+	void clear() {
+		_pendingRead = _write.load(std::memory_order_acquire);
+		_read.store(_pendingRead, std::memory_order_release);
+	}
+
+private:
+	const size_t _size;
+	T *_buffer;
+
+	size_t _pendingRead;
+	size_t _pendingWrite;
+	bool _wraparoundWrite;
+
+	// Keep the positions on separate cache lines, so that the producer and
+	// the consumer do not invalidate each other's. This uses padding rather
+	// than alignas, as over-aligned types cannot be allocated with new
+	// before C++17. 64 bytes is a good fit for most platforms.
+	enum {
+		kCacheLineSize = 64
+	};
+
+	char _padding0[kCacheLineSize];
+	std::atomic<size_t> _read;
+	char _padding1[kCacheLineSize - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> _write;
+	char _padding2[kCacheLineSize - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> _last;
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
@@ -22,6 +22,7 @@
 #ifndef COMMON_SAVEFILE_H
 #define COMMON_SAVEFILE_H
 
+#include "common/callback.h"
 #include "common/noncopyable.h"
 #include "common/scummsys.h"
 #include "common/stream.h"
@@ -54,9 +55,15 @@ typedef SeekableReadStream InSaveFile;
 class OutSaveFile: public SeekableWriteStream {
 protected:
 	WriteStream *_wrapped; /*!< @todo Doc required. */
+	bool _syncOnClose;     /*!< Whether to sync the saves with the cloud once deleted. */
 
 public:
-	OutSaveFile(WriteStream *w); /*!< Create an OutSaveFile that uses the given WriteStream to write the data. */
+	/**
+	 * Create an OutSaveFile that uses the given WriteStream to write the data.
+	 * Unless @p syncOnClose is false, the saves are synced with the cloud
+	 * once it is deleted.
+	 */
+	OutSaveFile(WriteStream *w, bool syncOnClose = true);
 	virtual ~OutSaveFile();
 
 	/**
@@ -120,6 +127,21 @@ public:
 	int64 size() const override;
 };
 
+/**
+ * Outcome of writing a save file opened with
+ * SaveFileManager::openForSavingAsync().
+ */
+struct AsyncSaveResult {
+	String name;  /*!< Name of the save file. */
+	bool success; /*!< Whether the save file was written completely. */
+};
+
+/**
+ * Callback notified once a save file opened with
+ * SaveFileManager::openForSavingAsync() has been written.
+ */
+typedef BaseCallback<const AsyncSaveResult &> AsyncSaveCallback;
+
 /**
  * The SaveFileManager serves as a factory for InSaveFile
  * and OutSaveFile objects.
@@ -140,6 +162,7 @@ public:
  * SaveFileManager instances to be used.
  */
 class SaveFileManager : NonCopyable {
+	friend class AsyncSaveStream;
 
 protected:
 	Error _error;      /*!< Error code. */
@@ -153,6 +176,25 @@ protected:
 	virtual void setError(Error error, const String &errorDesc) { _error = error; _errorDesc = errorDesc; }
 
 public:
+	/**
+	 * Contents of a save file opened with openForSavingAsync(), waiting
+	 * to be compressed and written.
+	 */
+	struct AsyncSave {
+		String name;
+		bool compress;
+		int compressionLevel;
+		byte *data;
+		uint32 size;
+		AsyncSaveCallback *callback;
+
+		AsyncSave() : compress(true), compressionLevel(-1), data(nullptr), size(0), callback(nullptr) {}
+		~AsyncSave() {
+			free(data);
+			delete callback;
+		}
+	};
+
 	virtual ~SaveFileManager() {}
 
 	/**
@@ -201,6 +243,64 @@ public:
 	 */
 	virtual OutSaveFile *openForSaving(const String &name, bool compress = true) = 0;
 
+	/**
+	 * Open the save file with the specified @p name for saving without
+	 * blocking the caller on compression and disk access.
+	 *
+	 * The data written to the returned stream is kept in memory. Once the
+	 * stream is finalized (or deleted), it is compressed and written to
+	 * the save file, in the background if the backend supports it. Since
+	 * this may happen later, err() does not report failures to write the
+	 * file: use @p callback to be notified of them.
+	 *
+	 * Loading, removing or saving over a save file waits for pending
+	 * asynchronous saves to complete first.
+	 *
+	 * @param name              Name of the save file.
+	 * @param compress          Whether to compress the resulting save file (default) or not.
+	 * @param compressionLevel  zlib level, from 1 (fastest) to 9 (smallest), or -1 for the default.
+	 * @param callback          Called with the outcome once the file is written, which
+	 *                          may happen on a worker thread. Ownership is taken.
+	 *
+	 * @return Pointer to an OutSaveFile.
+	 */
+	virtual OutSaveFile *openForSavingAsync(const String &name, bool compress = true, int compressionLevel = -1, AsyncSaveCallback *callback = nullptr);
+
+	/**
+	 * Block until all save files opened with openForSavingAsync() have
+	 * been written.
+	 */
+	virtual void waitForPendingSaves() {}
+
+	/**
+	 * Return the metadata stored for a save file with storeSaveMetadata(),
+	 * or nullptr if there is none. Metadata is dropped whenever the save
+	 * file is written or removed through this save file manager, and by the
+	 * default manager when the size or modification time of the save file
+	 * no longer match.
+	 *
+	 * This lets save lists avoid opening every save file. The default
+	 * implementation keeps no metadata.
+	 *
+	 * @param name  Name of the save file.
+	 */
+	virtual SeekableReadStream *openSaveMetadata(const String &name) { return nullptr; }
+
+	/**
+	 * Store metadata describing a save file, in a format chosen by the
+	 * caller. It may only be written to disk by flushSaveMetadata().
+	 *
+	 * @param name  Name of the save file.
+	 * @param data  Metadata to store.
+	 * @param size  Size of the metadata.
+	 */
+	virtual void storeSaveMetadata(const String &name, const byte *data, uint32 size) {}
+
+	/**
+	 * Write the metadata stored since the last call to disk.
+	 */
+	virtual void flushSaveMetadata() {}
+
 	/**
 	 * Open the file with the specified @p name in the given directory for loading.
 	 *
@@ -276,6 +376,29 @@ public:
 	 * @return true if the file exists. false otherwise.
 	 */
 	virtual bool exists(const String &name) = 0;
+
+protected:
+	/**
+	 * Write a save file opened with openForSavingAsync() once it has been
+	 * finalized. Takes ownership of @p save.
+	 *
+	 * The default implementation writes it right away through
+	 * openForSaving().
+	 */
+	virtual void commitAsyncSave(AsyncSave *save);
+
+	/**
+	 * Compress and write the contents of @p save to @p stream, then finalize
+	 * and delete the stream. This is safe to call from any thread.
+	 *
+	 * @return True if no error occurred, false otherwise.
+	 */
+	static bool writeAsyncSave(const AsyncSave &save, WriteStream *stream);
+
+	/**
+	 * Notify the callback of @p save, and delete it.
+	 */
+	static void finishAsyncSave(AsyncSave *save, bool success);
 };
 
 /** @} */
@@ -0,0 +1,77 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/str-intern.h"
+#include "common/hash-str.h"
+#include "common/singleton.h"
+
+namespace Common {
+
+class InternTable : public Singleton<InternTable> {
+public:
+	const String *intern(const char *str) {
+		// The node of each key stays at the same address until the table
+		// is destroyed, even when the hash map grows.
+		const String key(str);
+		Table::iterator it = _table.find(key);
+		if (it == _table.end()) {
+			_table[key] = true;
+			it = _table.find(key);
+		}
+		return &it->_key;
+	}
+
+	const String &getEmptyString() const {
+		return _empty;
+	}
+
+	uint size() const {
+		return _table.size();
+	}
+
+private:
+	friend class Singleton<SingletonBaseType>;
+
+	typedef HashMap<String, bool, CaseSensitiveString_Hash, CaseSensitiveString_EqualTo> Table;
+
+	InternTable() {}
+
+	Table _table;
+	const String _empty;
+};
+
+DECLARE_SINGLETON(InternTable);
+
+const String *InternedString::intern(const char *str) {
+	if (!str || !*str)
+		return nullptr;
+	return InternTable::instance().intern(str);
+}
+
+const String &InternedString::getEmptyString() {
+	return InternTable::instance().getEmptyString();
+}
+
+uint InternedString::getTableSize() {
+	return InternTable::hasInstance() ? InternTable::instance().size() : 0;
+}
+
+} // End of namespace Common
@@ -0,0 +1,107 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_STR_INTERN_H
+#define COMMON_STR_INTERN_H
+
+#include "common/func.h"
+#include "common/str.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_str_intern Interned strings
+ * @ingroup common_str
+ *
+ * @brief API for interned strings.
+ *
+ * @{
+ */
+
+/**
+ * An immutable string kept once in a global table. Two interned strings
+ * with the same contents always refer to the same entry of the table, so
+ * comparing and hashing them costs as much as for a pointer, and copying
+ * them never allocates.
+ *
+ * This is meant for identifiers which are compared over and over, like
+ * script symbols or property names. Interning a string needs a lookup in
+ * the table, and interned strings are never freed, so do not intern
+ * arbitrary text.
+ *
+ * The table is not thread safe: strings should only be interned from the
+ * main thread.
+ */
+class InternedString {
+public:
+	/** Construct an empty string. */
+	InternedString() : _entry(nullptr) {}
+
+	/**
+	 * Intern a string. Empty strings and null pointers give the empty
+	 * interned string. Looking up long strings allocates a temporary copy,
+	 * so intern identifiers once, for example when loading a script, rather
+	 * than every time they are used.
+	 */
+	explicit InternedString(const String &str) : _entry(intern(str.c_str())) {}
+	explicit InternedString(const char *str) : _entry(intern(str)) {}
+
+	bool operator==(const InternedString &x) const { return _entry == x._entry; }
+	bool operator!=(const InternedString &x) const { return _entry != x._entry; }
+
+	/**
+	 * Order by address of the entries, which is fast but not alphabetical,
+	 * and differs from one run to the next.
+	 */
+	bool operator<(const InternedString &x) const { return _entry < x._entry; }
+
+	bool empty() const { return _entry == nullptr; }
+	uint size() const { return _entry ? _entry->size() : 0; }
+
+	const String &toString() const { return _entry ? *_entry : getEmptyString(); }
+	const char *c_str() const { return _entry ? _entry->c_str() : ""; }
+
+	uint hash() const {
+		return (uint)(reinterpret_cast<uintptr>(_entry) >> 3);
+	}
+
+	/** Return the number of strings interned so far. */
+	static uint getTableSize();
+
+private:
+	const String *_entry;
+
+	static const String *intern(const char *str);
+	static const String &getEmptyString();
+};
+
+template<>
+struct Hash<InternedString> {
+	uint operator()(const InternedString &x) const {
+		return x.hash();
+	}
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
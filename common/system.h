@@ -57,6 +57,8 @@ class Store;
 namespace Common {
 class EventManager;
 class MutexInternal;
+class SemaphoreInternal;
+class ThreadInternal;
 struct Rect;
 class SaveFileManager;
 class SearchSet;
@@ -296,6 +298,14 @@ private:
 	 */
 	bool _backendInitialized;
 
+protected:
+	/**
+	 * Mark the backend as initialized without the checks of initBackend(),
+	 * for backends which do not provide all the managers, like the null
+	 * backend used by the tests.
+	 */
+	void setBackendInitialized() { _backendInitialized = true; }
+
 	//@}
 
 public:
@@ -1659,6 +1669,10 @@ public:
 	 *
 	 * Hence, backends that do not use threads to implement the timers can simply
 	 * use dummy implementations for these methods.
+	 *
+	 * Backends may optionally provide worker threads through createThread()
+	 * and createSemaphore(). These are only used by Common::ThreadPool, which
+	 * runs its tasks synchronously when they are not available.
 	 */
 
 	/**
@@ -1668,6 +1682,27 @@ public:
 	 */
 	virtual Common::MutexInternal *createMutex() = 0;
 
+	/**
+	 * Create a new thread executing @p proc with @p data as its argument.
+	 *
+	 * This is only meant to be used by Common::ThreadPool. Backends which
+	 * do not support threads keep the default implementation, in which case
+	 * the pool runs all its tasks synchronously.
+	 *
+	 * @return The newly created thread, or 0 if threads are not supported
+	 *         or an error occurred.
+	 */
+	virtual Common::ThreadInternal *createThread(void (*proc)(void *data), void *data) { return nullptr; }
+
+	/**
+	 * Create a new counting semaphore with the given initial count.
+	 *
+	 * Backends implementing createThread() must implement this as well.
+	 *
+	 * @return The newly created semaphore, or 0 if an error occurred.
+	 */
+	virtual Common::SemaphoreInternal *createSemaphore(uint initialCount) { return nullptr; }
+
 	/** @} */
 
 
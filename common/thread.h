@@ -0,0 +1,69 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_THREAD_H
+#define COMMON_THREAD_H
+
+#include "common/scummsys.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_thread Threads
+ * @ingroup common
+ *
+ * @brief Low-level thread and semaphore primitives provided by the backend.
+ *
+ * Engines should not use these directly; use Common::ThreadPool instead,
+ * which transparently falls back to synchronous execution on backends
+ * without thread support.
+ * @{
+ */
+
+/** Entry point of a thread created with OSystem::createThread(). */
+typedef void (*ThreadProc)(void *data);
+
+class ThreadInternal {
+public:
+	virtual ~ThreadInternal() {}
+
+	/**
+	 * Block until the thread has returned from its ThreadProc.
+	 * Must be called exactly once, before the object is deleted.
+	 */
+	virtual bool join() = 0;
+};
+
+class SemaphoreInternal {
+public:
+	virtual ~SemaphoreInternal() {}
+
+	/** Block until the count is positive, then decrement it. */
+	virtual bool wait() = 0;
+	/** Increment the count, waking up one waiting thread if any. */
+	virtual bool post() = 0;
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
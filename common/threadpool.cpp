@@ -0,0 +1,265 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "common/threadpool.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+namespace Common {
+
+bool Task::isDone() const {
+	if (!_pool)
+		return _state == kStateDone;
+
+	StackLock lock(_pool->_mutex);
+	return _state == kStateDone;
+}
+
+void Task::wait() {
+	if (_pool)
+		_pool->wait(this);
+}
+
+ThreadPool::ThreadPool(uint numThreads) : _workAvailable(nullptr), _quit(false), _nextWorker(0),
+		_pendingTasks(0), _allDone(nullptr), _waitingForAll(false) {
+	if (numThreads == 0)
+		return;
+
+	_workAvailable = g_system->createSemaphore(0);
+	_allDone = g_system->createSemaphore(0);
+	if (!_workAvailable || !_allDone) {
+		delete _workAvailable;
+		delete _allDone;
+		_workAvailable = _allDone = nullptr;
+		return;
+	}
+
+	// Workers only look at the other queues once a task has been submitted,
+	// but the array must not be reallocated after that point.
+	_workers.reserve(numThreads);
+	for (uint i = 0; i < numThreads; i++) {
+		Worker *worker = new Worker();
+		worker->pool = this;
+		worker->index = i;
+		_workers.push_back(worker);
+
+		worker->thread = g_system->createThread(workerProc, worker);
+		if (!worker->thread) {
+			_workers.pop_back();
+			delete worker;
+			break;
+		}
+	}
+
+	if (_workers.empty()) {
+		delete _workAvailable;
+		delete _allDone;
+		_workAvailable = _allDone = nullptr;
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	if (_workers.empty())
+		return;
+
+	waitAll();
+
+	_quit = true;
+	for (uint i = 0; i < _workers.size(); i++)
+		_workAvailable->post();
+
+	// A worker still running may steal from the others' queues, so none of
+	// them may be freed before all the threads are stopped
+	for (uint i = 0; i < _workers.size(); i++)
+		_workers[i]->thread->join();
+
+	for (uint i = 0; i < _workers.size(); i++) {
+		delete _workers[i]->thread;
+		delete _workers[i];
+	}
+
+	for (uint i = 0; i < _idleWaiters.size(); i++)
+		delete _idleWaiters[i];
+
+	delete _allDone;
+	delete _workAvailable;
+}
+
+void ThreadPool::submit(Task *task) {
+	assert(task);
+
+	Worker *worker = nullptr;
+	{
+		StackLock lock(_mutex);
+		assert(task->_state == Task::kStateIdle || task->_state == Task::kStateDone);
+		task->_pool = this;
+		task->_state = Task::kStateQueued;
+		_pendingTasks++;
+
+		if (!_workers.empty()) {
+			worker = _workers[_nextWorker];
+			_nextWorker = (_nextWorker + 1) % _workers.size();
+		}
+	}
+
+	if (!worker) {
+		execute(task);
+		return;
+	}
+
+	{
+		StackLock lock(worker->queueMutex);
+		worker->queue.push_back(task);
+	}
+	_workAvailable->post();
+}
+
+void ThreadPool::wait(Task *task) {
+	assert(task->_pool == this);
+
+	for (;;) {
+		{
+			StackLock lock(_mutex);
+			if (task->_state == Task::kStateDone)
+				return;
+		}
+
+		// Help with the queued work instead of sleeping
+		Task *other = popTask(0);
+		if (!other)
+			break;
+		execute(other);
+	}
+
+	// The task is running on a worker thread
+	SemaphoreInternal *waiter;
+	{
+		StackLock lock(_mutex);
+		if (task->_state == Task::kStateDone)
+			return;
+		assert(!task->_waiter);
+		if (_idleWaiters.empty()) {
+			waiter = g_system->createSemaphore(0);
+		} else {
+			waiter = _idleWaiters.back();
+			_idleWaiters.pop_back();
+		}
+		task->_waiter = waiter;
+	}
+
+	// The semaphore was posted exactly once, so it can be used again
+	waiter->wait();
+
+	StackLock lock(_mutex);
+	_idleWaiters.push_back(waiter);
+}
+
+void ThreadPool::waitAll() {
+	for (;;) {
+		{
+			StackLock lock(_mutex);
+			if (_pendingTasks == 0)
+				return;
+		}
+
+		Task *other = popTask(0);
+		if (!other)
+			break;
+		execute(other);
+	}
+
+	{
+		StackLock lock(_mutex);
+		if (_pendingTasks == 0)
+			return;
+		assert(!_waitingForAll);
+		_waitingForAll = true;
+	}
+
+	_allDone->wait();
+}
+
+Task *ThreadPool::popTask(uint index) {
+	if (_workers.empty())
+		return nullptr;
+
+	// Take the oldest task from our own queue first...
+	Worker *self = _workers[index];
+	{
+		StackLock lock(self->queueMutex);
+		if (!self->queue.empty()) {
+			Task *task = self->queue.front();
+			self->queue.pop_front();
+			return task;
+		}
+	}
+
+	// ...then steal the newest task from the others
+	for (uint i = 1; i < _workers.size(); i++) {
+		Worker *victim = _workers[(index + i) % _workers.size()];
+		StackLock lock(victim->queueMutex);
+		if (!victim->queue.empty()) {
+			Task *task = victim->queue.back();
+			victim->queue.pop_back();
+			return task;
+		}
+	}
+
+	return nullptr;
+}
+
+void ThreadPool::execute(Task *task) {
+	{
+		StackLock lock(_mutex);
+		task->_state = Task::kStateRunning;
+	}
+
+	task->run();
+
+	StackLock lock(_mutex);
+	task->_state = Task::kStateDone;
+	if (task->_waiter) {
+		task->_waiter->post();
+		task->_waiter = nullptr;
+	}
+
+	assert(_pendingTasks > 0);
+	if (--_pendingTasks == 0 && _waitingForAll) {
+		_allDone->post();
+		_waitingForAll = false;
+	}
+}
+
+void ThreadPool::workerProc(void *data) {
+	Worker *worker = (Worker *)data;
+	ThreadPool *pool = worker->pool;
+
+	for (;;) {
+		pool->_workAvailable->wait();
+		if (pool->_quit)
+			break;
+
+		Task *task;
+		while ((task = pool->popTask(worker->index)) != nullptr)
+			pool->execute(task);
+	}
+}
+
+} // End of namespace Common
@@ -0,0 +1,186 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef COMMON_THREADPOOL_H
+#define COMMON_THREADPOOL_H
+
+#include "common/array.h"
+#include "common/func.h"
+#include "common/list.h"
+#include "common/mutex.h"
+#include "common/noncopyable.h"
+#include "common/thread.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_threadpool Thread pool
+ * @ingroup common
+ *
+ * @brief API for running tasks on worker threads.
+ * @{
+ */
+
+class ThreadPool;
+
+/**
+ * A unit of work which can be submitted to a ThreadPool.
+ *
+ * Tasks are owned by the caller. A submitted task must stay alive until
+ * it is done, which can be checked with isDone() or waited for with wait().
+ * A task which is done may be submitted again.
+ */
+class Task {
+	friend class ThreadPool;
+
+public:
+	Task() : _pool(nullptr), _state(kStateIdle), _waiter(nullptr) {}
+	virtual ~Task() {}
+
+	/**
+	 * Perform the work. This is called from a worker thread, or from
+	 * the submitting thread when the pool runs synchronously.
+	 */
+	virtual void run() = 0;
+
+	/** Return true once run() has returned. */
+	bool isDone() const;
+
+	/**
+	 * Block until run() has returned. While waiting, the calling thread
+	 * helps executing queued tasks. Only one thread may wait on a given
+	 * task at a time.
+	 */
+	void wait();
+
+private:
+	enum State {
+		kStateIdle,
+		kStateQueued,
+		kStateRunning,
+		kStateDone
+	};
+
+	ThreadPool *_pool;
+	State _state;
+	SemaphoreInternal *_waiter;
+};
+
+/**
+ * A task computing a value.
+ *
+ * Example usage:
+ *
+ * Common::Future<int> future(new Common::Functor0Mem<int, Foo>(&foo, &Foo::compute));
+ * pool.submit(&future);
+ * ...
+ * int result = future.get();
+ */
+template<class T>
+class Future : public Task {
+public:
+	/** Create a future evaluating @p func. Takes ownership of @p func. */
+	explicit Future(Functor0<T> *func) : _func(func), _result() {}
+	~Future() override { delete _func; }
+
+	void run() override { _result = (*_func)(); }
+
+	/** Wait for the value to be computed and return it. */
+	const T &get() {
+		wait();
+		return _result;
+	}
+
+private:
+	Functor0<T> *_func;
+	T _result;
+};
+
+/**
+ * A fixed set of worker threads executing Tasks.
+ *
+ * Every worker has its own task queue. Tasks are distributed round-robin,
+ * and idle workers steal queued tasks from the other workers.
+ *
+ * When the backend does not support threads (see OSystem::createThread()),
+ * or when created with no threads at all, the pool runs every task
+ * synchronously inside submit().
+ */
+class ThreadPool : NonCopyable {
+public:
+	/** Create a pool with @p numThreads worker threads. */
+	explicit ThreadPool(uint numThreads);
+	/** Wait for all submitted tasks and stop the worker threads. */
+	~ThreadPool();
+
+	/** Return the number of worker threads, 0 if running synchronously. */
+	uint getThreadCount() const { return _workers.size(); }
+
+	/** Return true if tasks are executed on worker threads. */
+	bool isAsync() const { return !_workers.empty(); }
+
+	/** Queue @p task for execution. */
+	void submit(Task *task);
+
+	/** Block until @p task is done. Same as Task::wait(). */
+	void wait(Task *task);
+
+	/**
+	 * Block until all submitted tasks are done.
+	 * Only one thread may call this at a time.
+	 */
+	void waitAll();
+
+private:
+	friend class Task;
+
+	struct Worker {
+		ThreadPool *pool;
+		uint index;
+		ThreadInternal *thread;
+		Mutex queueMutex;
+		List<Task *> queue;
+	};
+
+	static void workerProc(void *data);
+
+	Task *popTask(uint index);
+	void execute(Task *task);
+
+	Array<Worker *> _workers;
+	SemaphoreInternal *_workAvailable;
+	bool _quit;
+
+	/** Protects the task states, the waiters, _nextWorker and _pendingTasks. */
+	Mutex _mutex;
+	uint _nextWorker;
+	uint _pendingTasks;
+	/** Posted when the last pending task is done while waitAll() blocks */
+	SemaphoreInternal *_allDone;
+	bool _waitingForAll;
+	/** Semaphores of finished wait() calls, reused by the next ones */
+	Array<SemaphoreInternal *> _idleWaiters;
+};
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
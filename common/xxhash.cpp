@@ -0,0 +1,198 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Implementation of the XXH64 algorithm, as specified in
+ * https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+ */
+
+#include "common/xxhash.h"
+#include "common/endian.h"
+#include "common/ptr.h"
+#include "common/stream.h"
+
+namespace Common {
+
+static const uint64 kPrime1 = 0x9E3779B185EBCA87ULL;
+static const uint64 kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64 kPrime3 = 0x165667B19E3779F9ULL;
+static const uint64 kPrime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64 kPrime5 = 0x27D4EB2F165667C5ULL;
+
+enum {
+	kXXHashReadBufferSize = 64 * 1024
+};
+
+static inline uint64 rotateLeft64(uint64 x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64 round64(uint64 acc, uint64 input) {
+	acc += input * kPrime2;
+	acc = rotateLeft64(acc, 31);
+	return acc * kPrime1;
+}
+
+static inline uint64 mergeRound64(uint64 acc, uint64 value) {
+	acc ^= round64(0, value);
+	return acc * kPrime1 + kPrime4;
+}
+
+/** Process whole 32-byte stripes, and return the number of bytes consumed. */
+static uint32 processStripes(uint64 acc[4], const byte *data, uint32 length) {
+	uint64 v1 = acc[0], v2 = acc[1], v3 = acc[2], v4 = acc[3];
+	const byte *p = data;
+	const byte *const end = data + (length & ~31);
+
+	for (; p < end; p += 32) {
+		v1 = round64(v1, READ_LE_UINT64(p));
+		v2 = round64(v2, READ_LE_UINT64(p + 8));
+		v3 = round64(v3, READ_LE_UINT64(p + 16));
+		v4 = round64(v4, READ_LE_UINT64(p + 24));
+	}
+
+	acc[0] = v1;
+	acc[1] = v2;
+	acc[2] = v3;
+	acc[3] = v4;
+	return p - data;
+}
+
+void XXHash64::reset(uint64 seed) {
+	_seed = seed;
+	_acc[0] = seed + kPrime1 + kPrime2;
+	_acc[1] = seed + kPrime2;
+	_acc[2] = seed;
+	_acc[3] = seed - kPrime1;
+	_totalLength = 0;
+	_bufferSize = 0;
+}
+
+void XXHash64::update(const void *data, uint32 length) {
+	const byte *p = (const byte *)data;
+	_totalLength += length;
+
+	if (_bufferSize) {
+		const uint32 fill = MIN<uint32>(32 - _bufferSize, length);
+		memcpy(_buffer + _bufferSize, p, fill);
+		_bufferSize += fill;
+		p += fill;
+		length -= fill;
+
+		if (_bufferSize < 32)
+			return;
+
+		processStripes(_acc, _buffer, 32);
+		_bufferSize = 0;
+	}
+
+	const uint32 consumed = processStripes(_acc, p, length);
+	p += consumed;
+	length -= consumed;
+
+	memcpy(_buffer, p, length);
+	_bufferSize = length;
+}
+
+uint64 XXHash64::digest() const {
+	uint64 h;
+
+	if (_totalLength >= 32) {
+		h = rotateLeft64(_acc[0], 1) + rotateLeft64(_acc[1], 7) + rotateLeft64(_acc[2], 12) + rotateLeft64(_acc[3], 18);
+		h = mergeRound64(h, _acc[0]);
+		h = mergeRound64(h, _acc[1]);
+		h = mergeRound64(h, _acc[2]);
+		h = mergeRound64(h, _acc[3]);
+	} else {
+		h = _seed + kPrime5;
+	}
+
+	h += _totalLength;
+
+	// Consume the remaining bytes
+	const byte *p = _buffer;
+	uint32 remaining = _bufferSize;
+
+	for (; remaining >= 8; remaining -= 8, p += 8) {
+		h ^= round64(0, READ_LE_UINT64(p));
+		h = rotateLeft64(h, 27) * kPrime1 + kPrime4;
+	}
+
+	if (remaining >= 4) {
+		h ^= (uint64)READ_LE_UINT32(p) * kPrime1;
+		h = rotateLeft64(h, 23) * kPrime2 + kPrime3;
+		remaining -= 4;
+		p += 4;
+	}
+
+	for (; remaining; remaining--, p++) {
+		h ^= *p * kPrime5;
+		h = rotateLeft64(h, 11) * kPrime1;
+	}
+
+	// Final avalanche
+	h ^= h >> 33;
+	h *= kPrime2;
+	h ^= h >> 29;
+	h *= kPrime3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+uint64 computeXXHash64(const void *data, uint32 length, uint64 seed) {
+	XXHash64 hash(seed);
+	hash.update(data, length);
+	return hash.digest();
+}
+
+uint64 computeStreamXXHash64(ReadStream &stream, uint32 length, uint64 seed) {
+	XXHash64 hash(seed);
+	bool restricted = (length != 0);
+	uint32 bufSize;
+	uint32 readlen;
+	int i;
+
+	if (!restricted || kXXHashReadBufferSize <= length)
+		bufSize = kXXHashReadBufferSize;
+	else
+		bufSize = length;
+	readlen = bufSize;
+
+	ScopedPtr<byte, ArrayDeleter<byte> > buf(new byte[bufSize]);
+
+	while ((i = stream.read(buf.get(), readlen)) > 0) {
+		hash.update(buf.get(), i);
+
+		if (restricted) {
+			length -= i;
+			if (length == 0)
+				break;
+
+			if (bufSize > length)
+				readlen = length;
+		}
+	}
+
+	return hash.digest();
+}
+
+} // End of namespace Common
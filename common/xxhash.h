@@ -0,0 +1,92 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef COMMON_XXHASH_H
+#define COMMON_XXHASH_H
+
+#include "common/scummsys.h"
+
+namespace Common {
+
+/**
+ * @defgroup common_xxhash xxHash
+ * @ingroup common
+ *
+ * @brief API for computing the 64-bit xxHash (XXH64) of data.
+ *
+ * xxHash is a fast non-cryptographic hash, many times faster than MD5.
+ * Use it for internal purposes, such as cache keys or change detection,
+ * where compatibility with published checksums is not needed.
+ *
+ * @{
+ */
+
+class ReadStream;
+
+/**
+ * Incremental XXH64 computation, for data which is not available at once.
+ *
+ * Example usage:
+ *
+ * Common::XXHash64 hash;
+ * hash.update(header, headerSize);
+ * hash.update(data, dataSize);
+ * uint64 value = hash.digest();
+ */
+class XXHash64 {
+public:
+	explicit XXHash64(uint64 seed = 0) { reset(seed); }
+
+	/** Start a new computation, dropping all the data added so far. */
+	void reset(uint64 seed = 0);
+
+	/** Add @p length bytes to the hashed data. */
+	void update(const void *data, uint32 length);
+
+	/** Return the hash of the data added so far. More data may still be added. */
+	uint64 digest() const;
+
+private:
+	uint64 _acc[4];
+	uint64 _seed;
+	uint64 _totalLength;
+	byte _buffer[32];
+	uint32 _bufferSize;
+};
+
+/** Compute the XXH64 of @p length bytes at @p data. */
+uint64 computeXXHash64(const void *data, uint32 length, uint64 seed = 0);
+
+/**
+ * Compute the XXH64 of the content of the given ReadStream.
+ * If length is set to a positive value, then only the first length
+ * bytes of the stream are hashed.
+ * @param[in] stream	the stream of whose data the hash is computed
+ * @param[in] length	the number of bytes to hash; 0 means all
+ * @param[in] seed	the seed of the hash
+ */
+uint64 computeStreamXXHash64(ReadStream &stream, uint32 length = 0, uint64 seed = 0);
+
+/** @} */
+
+} // End of namespace Common
+
+#endif
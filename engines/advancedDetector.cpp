@@ -490,6 +490,252 @@ namespace Common {
 	DECLARE_SINGLETON(AdvancedDetectorCacheManager);
 }
 
+#define PERSISTENT_CACHE_FILENAME "detection-md5.cache"
+#define PERSISTENT_CACHE_HEADER "# ScummVM detection MD5 cache v1"
+
+enum {
+	kPersistentCacheSaveInterval = 5000
+};
+
+static Common::Path getPersistentCachePath() {
+	// Keep the cache next to the configuration file
+	Common::Path configFile = ConfMan.getCustomConfigFileName();
+	if (configFile.empty())
+		configFile = g_system->getDefaultConfigFileName();
+	if (configFile.empty())
+		return Common::Path();
+
+	return configFile.getParent().appendComponent(PERSISTENT_CACHE_FILENAME);
+}
+
+static Common::String makePersistentCacheKey(MD5Properties md5prop, uint md5Bytes, const Common::FSNode &node, const Common::String &member) {
+	Common::String key = md5PropToCachePrefix(md5prop);
+	key += Common::String::format(":%u:", md5Bytes);
+	key += node.getPath().toConfig();
+	if (!member.empty()) {
+		key += '|';
+		key += member;
+	}
+
+	return key;
+}
+
+/** Return the path of the file on disk which a persistent cache key refers to. */
+static Common::Path getPersistentCacheKeyPath(const Common::String &key) {
+	// Skip the "<prefix>:<md5 bytes>:" part, and the archive member if any
+	const char *path = strchr(key.c_str(), ':');
+	if (path)
+		path = strchr(path + 1, ':');
+	if (!path)
+		return Common::Path();
+
+	Common::String pathString(path + 1);
+	const size_t member = pathString.findFirstOf('|');
+	if (member != Common::String::npos)
+		pathString.erase(member);
+
+	return Common::Path::fromConfig(pathString);
+}
+
+void AdvancedDetectorCacheManager::preloadPersistentCache() {
+	Common::StackLock lock(persistentMutex);
+
+	if (!persistentLoaded)
+		loadPersistentCache();
+}
+
+void AdvancedDetectorCacheManager::loadPersistentCache() {
+	persistentLoaded = true;
+
+	persistentPath = getPersistentCachePath();
+	if (persistentPath.empty())
+		return;
+
+	Common::FSNode node(persistentPath);
+	if (!node.exists())
+		return;
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(node.createReadStream());
+	if (!stream || stream->readLine() != PERSISTENT_CACHE_HEADER)
+		return;
+
+	// Each line is "<file size> <modification time> <size> <md5> <key>"
+	while (!stream->eos() && !stream->err()) {
+		Common::String line = stream->readLine();
+		long long fileSize, modificationTime, size;
+		char md5[33];
+		int keyStart = 0;
+
+		if (sscanf(line.c_str(), "%lld %lld %lld %32s %n", &fileSize, &modificationTime, &size, md5, &keyStart) != 4 || !keyStart)
+			continue;
+
+		PersistentEntry &entry = persistentHashMap[Common::String(line.c_str() + keyStart)];
+		entry.fileSize = fileSize;
+		entry.modificationTime = modificationTime;
+		entry.size = size;
+		entry.md5 = md5;
+		entry.used = false;
+	}
+
+	debugC(2, kDebugGlobalDetection, "Loaded %u entries from the detection MD5 cache", persistentHashMap.size());
+}
+
+bool AdvancedDetectorCacheManager::getPersistentMD5(const Common::String &key, int64 fileSize, int64 modificationTime, Common::String &md5, int64 &size) {
+	Common::StackLock lock(persistentMutex);
+
+	if (!persistentLoaded)
+		loadPersistentCache();
+
+	PersistentHashMap::iterator it = persistentHashMap.find(key);
+	if (it == persistentHashMap.end() || it->_value.fileSize != fileSize || it->_value.modificationTime != modificationTime)
+		return false;
+
+	it->_value.used = true;
+	md5 = it->_value.md5;
+	size = it->_value.size;
+	return true;
+}
+
+void AdvancedDetectorCacheManager::setPersistentMD5(const Common::String &key, int64 fileSize, int64 modificationTime, const Common::String &md5, int64 size) {
+	Common::StackLock lock(persistentMutex);
+
+	if (!persistentLoaded)
+		loadPersistentCache();
+
+	// The key ends the line in the cache file, and the MD5 has no spaces
+	if (key.contains('\n') || md5.empty() || md5.size() > 32 || md5.contains(' '))
+		return;
+
+	PersistentEntry &entry = persistentHashMap[key];
+	entry.fileSize = fileSize;
+	entry.modificationTime = modificationTime;
+	entry.size = size;
+	entry.md5 = md5;
+	entry.used = true;
+	persistentDirty = true;
+}
+
+void AdvancedDetectorCacheManager::prefetchMD5(const Common::FSNode &node, uint md5Bytes) {
+	int64 fileSize, modificationTime;
+	if (!node.getFileStats(fileSize, modificationTime))
+		return;
+
+	Common::String key = makePersistentCacheKey(kMD5Head, md5Bytes, node, Common::String());
+	Common::String md5;
+	int64 size;
+	if (getPersistentMD5(key, fileSize, modificationTime, md5, size))
+		return;
+
+	Common::File file;
+	if (!file.open(node))
+		return;
+
+	md5 = Common::computeStreamMD5AsString(file, md5Bytes);
+	setPersistentMD5(key, fileSize, modificationTime, md5, file.size());
+}
+
+void AdvancedDetectorCacheManager::savePersistentCache(bool force) {
+	Common::StackLock lock(persistentMutex);
+
+	if (!persistentDirty)
+		return;
+
+	const uint32 now = g_system->getMillis();
+	if (!force && lastPersistentSave && now - lastPersistentSave < kPersistentCacheSaveInterval)
+		return;
+
+	// Being dirty, the cache has been loaded, which set its path
+	if (persistentPath.empty())
+		return;
+
+	Common::ScopedPtr<Common::SeekableWriteStream> stream(Common::FSNode(persistentPath).createWriteStream(true));
+	if (!stream) {
+		warning("Could not write the detection MD5 cache to '%s'", persistentPath.toString(Common::Path::kNativeSeparator).c_str());
+		return;
+	}
+
+	stream->writeString(PERSISTENT_CACHE_HEADER "\n");
+	for (const auto &entry : persistentHashMap) {
+		stream->writeString(Common::String::format("%lld %lld %lld %s %s\n",
+			(long long)entry._value.fileSize, (long long)entry._value.modificationTime, (long long)entry._value.size,
+			entry._value.md5.c_str(), entry._key.c_str()));
+	}
+	stream->finalize();
+
+	persistentDirty = false;
+	lastPersistentSave = now;
+}
+
+void AdvancedDetectorCacheManager::prunePersistentCache() {
+	Common::StackLock lock(persistentMutex);
+
+	if (!persistentLoaded)
+		loadPersistentCache();
+
+	// Each directory is listed once. Entries in directories which cannot be
+	// found, like on a disconnected drive, are kept.
+	typedef Common::HashMap<Common::Path, bool, Common::Path::Hash, Common::Path::EqualTo> PathSet;
+	PathSet listedDirs, existingFiles;
+
+	uint pruned = 0;
+	for (PersistentHashMap::iterator it = persistentHashMap.begin(); it != persistentHashMap.end(); ++it) {
+		// The entries used in this session are known to exist
+		if (it->_value.used)
+			continue;
+
+		const Common::Path path = getPersistentCacheKeyPath(it->_key);
+		if (path.empty())
+			continue;
+
+		const Common::Path dir = path.getParent();
+		if (!listedDirs.contains(dir)) {
+			Common::FSList children;
+			const Common::FSNode dirNode(dir);
+			const bool available = dirNode.isDirectory() && dirNode.getChildren(children, Common::FSNode::kListFilesOnly);
+			for (const auto &child : children)
+				existingFiles.setVal(child.getPath(), true);
+			listedDirs.setVal(dir, available);
+		}
+
+		if (listedDirs.getVal(dir) && !existingFiles.contains(path)) {
+			persistentHashMap.erase(it);
+			pruned++;
+		}
+	}
+
+	if (pruned)
+		persistentDirty = true;
+
+	debugC(2, kDebugGlobalDetection, "Pruned %u entries from the detection MD5 cache", pruned);
+}
+
+/**
+ * Build the persistent cache key for a file, and retrieve the stats which
+ * validate its entry. Only plain files on disk and members of archives on
+ * disk have such a key, as Mac forks may be spread over several files.
+ */
+static Common::String getPersistentCacheKey(uint md5Bytes, const AdvancedMetaEngineBase::FileMap &allFiles, MD5Properties md5prop, const Common::Path &fname, int64 &fileSize, int64 &modificationTime) {
+	if (md5prop & (kMD5MacResFork | kMD5MacDataFork))
+		return Common::String();
+
+	Common::Path diskName = fname;
+	Common::String member;
+
+	if (md5prop & kMD5Archive) {
+		Common::StringTokenizer tok(fname.toString(), ":");
+		member = tok.nextToken();
+		diskName = Common::Path(tok.nextToken());
+		member += ':';
+		member += tok.nextToken();
+	}
+
+	AdvancedMetaEngineBase::FileMap::const_iterator it = allFiles.find(diskName);
+	if (it == allFiles.end() || !it->_value.getFileStats(fileSize, modificationTime))
+		return Common::String();
+
+	return makePersistentCacheKey(md5prop, md5Bytes, it->_value, member);
+}
+
 
 static MD5Properties gameFileToMD5Props(const ADGameFileDescription *fileEntry, uint32 gameFlags) {
 	MD5Properties ret = kMD5Head;
@@ -563,11 +809,24 @@ bool AdvancedMetaEngineDetectionBase::getFileProperties(const FileMap &allFiles,
 		return true;
 	}
 
+	int64 fileSize = 0, modificationTime = 0;
+	Common::String persistentKey = getPersistentCacheKey(_md5Bytes, allFiles, md5prop, fname, fileSize, modificationTime);
+
+	if (!persistentKey.empty() && ADCacheMan.getPersistentMD5(persistentKey, fileSize, modificationTime, fileProps.md5, fileProps.size)) {
+		fileProps.md5prop = (MD5Properties)(md5prop & kMD5Tail);
+		ADCacheMan.setMD5(hashname, fileProps.md5);
+		ADCacheMan.setSize(hashname, fileProps.size);
+		return true;
+	}
+
 	bool res = getFilePropertiesIntern(_md5Bytes, allFiles, md5prop, fname, fileProps);
 
 	if (res) {
 		ADCacheMan.setMD5(hashname, fileProps.md5);
 		ADCacheMan.setSize(hashname, fileProps.size);
+
+		if (!persistentKey.empty())
+			ADCacheMan.setPersistentMD5(persistentKey, fileSize, modificationTime, fileProps.md5, fileProps.size);
 	}
 
 	return res;
@@ -720,6 +979,26 @@ void AdvancedMetaEngineDetectionBase::dumpDetectionEntries() const {
 	}
 }
 
+void AdvancedMetaEngineDetectionBase::getMD5FileNames(Common::StringArray &fileNames) const {
+	Common::HashMap<Common::String, bool, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> seen;
+
+	for (const byte *descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameId != nullptr; descPtr += _descItemSize) {
+		const ADGameDescription *g = (const ADGameDescription *)descPtr;
+
+		for (const ADGameFileDescription *fileDesc = g->filesDescriptions; fileDesc->fileName; fileDesc++) {
+			// Only plain files hashed from their beginning can be hashed ahead
+			if (!fileDesc->md5 || gameFileToMD5Props(fileDesc, g->flags) != kMD5Head)
+				continue;
+
+			Common::String name = Common::lastPathComponent(fileDesc->fileName, '/');
+			if (!seen.contains(name)) {
+				seen[name] = true;
+				fileNames.push_back(name);
+			}
+		}
+	}
+}
+
 ADDetectedGames AdvancedMetaEngineDetectionBase::detectGame(const Common::FSNode &parent, const FileMap &allFiles, Common::Language language, Common::Platform platform, const Common::String &extra, uint32 skipADFlags, bool skipIncomplete) {
 	CachedPropertiesMap filesProps;
 	ADDetectedGames matched;
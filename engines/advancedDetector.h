@@ -26,6 +26,7 @@
 #include "engines/engine.h"
 
 #include "common/hash-str.h"
+#include "common/mutex.h"
 
 #include "common/gui_options.h" // Keep it here, so detection tables can refer to them
 
@@ -526,6 +527,8 @@ public:
 
 	void dumpDetectionEntries() const override;
 
+	void getMD5FileNames(Common::StringArray &fileNames) const override;
+
 	/**
 	 * Sanitizes a string to be usable by gameId
 	 */
@@ -746,6 +749,11 @@ private:
 
 /**
  * Singleton Cache Storage for Computed MD5s and Open Archives
+ *
+ * Besides the per-detection maps, MD5s of files on disk are also kept in a
+ * persistent cache shared by all engines. Its entries are keyed on the file
+ * path and are only valid as long as the size and modification time of the
+ * file on disk do not change.
  */
 class AdvancedDetectorCacheManager : public Common::Singleton<AdvancedDetectorCacheManager> {
 public:
@@ -786,7 +794,45 @@ public:
 		return archiveHashMap.getValOrDefault(node.getPath(), nullptr);
 	}
 
-	AdvancedDetectorCacheManager() {
+	/**
+	 * Load the persistent cache, unless this has been done already. Locating
+	 * it queries the config manager and the backend, so this has to be called
+	 * from the main thread before the cache is used from other threads.
+	 */
+	void preloadPersistentCache();
+
+	/**
+	 * Look up an MD5 in the persistent cache. The entry is ignored when the
+	 * file on disk has been modified since it was stored.
+	 */
+	bool getPersistentMD5(const Common::String &key, int64 fileSize, int64 modificationTime, Common::String &md5, int64 &size);
+
+	/** Store an MD5 in the persistent cache. */
+	void setPersistentMD5(const Common::String &key, int64 fileSize, int64 modificationTime, const Common::String &md5, int64 size);
+
+	/**
+	 * Write the persistent cache to disk, if it changed. Unless forced, writes
+	 * are throttled so that back-to-back detections do not rewrite it each time.
+	 */
+	void savePersistentCache(bool force = false);
+
+	/**
+	 * Drop the entries of the files which do not exist anymore. This lists
+	 * the directories of all the entries not used in this session, so it is
+	 * never done automatically. Directories which cannot be found, like those
+	 * of a disconnected drive, are left alone.
+	 */
+	void prunePersistentCache();
+
+	/**
+	 * Hash the first @p md5Bytes bytes of a file into the persistent cache,
+	 * unless it is already there. Unlike the other methods, the persistent
+	 * cache ones can be called from any thread, once preloadPersistentCache()
+	 * has been called.
+	 */
+	void prefetchMD5(const Common::FSNode &node, uint md5Bytes);
+
+	AdvancedDetectorCacheManager() : persistentLoaded(false), persistentDirty(false), lastPersistentSave(0) {
 		clear();
 	}
 
@@ -797,6 +843,7 @@ public:
 		archiveHashMap.clear(true);
 	}
 
+	/** Clear the per-detection caches. The persistent cache is kept. */
 	void clear() {
 		md5HashMap.clear(true);
 		sizeHashMap.clear(true);
@@ -806,12 +853,31 @@ public:
 private:
 	friend class Common::Singleton<AdvancedDetectorCacheManager>;
 
+	struct PersistentEntry {
+		int64 fileSize;
+		int64 modificationTime;
+		int64 size;
+		Common::String md5;
+		/** Whether the entry has been looked up or stored in this session */
+		bool used;
+	};
+
+	void loadPersistentCache();
+
 	typedef Common::HashMap<Common::String, Common::String, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> FileHashMap;
 	typedef Common::HashMap<Common::String, int64, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> SizeHashMap;
 	typedef Common::HashMap<Common::Path, Common::Archive *, Common::Path::IgnoreCase_Hash, Common::Path::IgnoreCase_EqualTo> ArchiveHashMap;
+	typedef Common::HashMap<Common::String, PersistentEntry> PersistentHashMap;
 	FileHashMap md5HashMap;
 	SizeHashMap sizeHashMap;
 	ArchiveHashMap archiveHashMap;
+	PersistentHashMap persistentHashMap;
+	/** Location of the persistent cache, set when loading it */
+	Common::Path persistentPath;
+	bool persistentLoaded;
+	bool persistentDirty;
+	uint32 lastPersistentSave;
+	Common::Mutex persistentMutex;
 };
 
 /** Convenience shortcut for accessing the MD5CacheManager. */
@@ -26,6 +26,7 @@
 #include "backends/keymapper/keymap.h"
 #include "backends/keymapper/standard-actions.h"
 
+#include "common/memstream.h"
 #include "common/savefile.h"
 #include "common/system.h"
 #include "common/translation.h"
@@ -359,6 +360,72 @@ WARN_UNUSED_RESULT bool MetaEngine::readSavegameHeader(Common::InSaveFile *in, E
 	return true;
 }
 
+bool MetaEngine::readCachedSavegameHeader(const Common::String &filename, ExtendedSavegameHeader *header) {
+	Common::ScopedPtr<Common::SeekableReadStream> in(g_system->getSavefileManager()->openSaveMetadata(filename));
+	if (!in)
+		return false;
+
+	// Entries written by another version of the header format are ignored
+	if (in->readByte() != EXTENDED_SAVE_VERSION)
+		return false;
+
+	Common::strcpy_s(header->id, "SVMCR");
+	header->version = in->readByte();
+	header->date = in->readUint32LE();
+	header->time = in->readUint16LE();
+	header->playtime = in->readUint32LE();
+	header->saveName = in->readPascalString();
+	header->description = in->readPascalString();
+	header->isAutosave = in->readByte() != 0;
+	header->thumbnail = nullptr;
+
+	const bool hasThumbnail = in->readByte() != 0;
+	if (in->err() || in->eos())
+		return false;
+
+	if (hasThumbnail && !Graphics::loadThumbnail(*in, header->thumbnail))
+		return false;
+
+	return true;
+}
+
+void MetaEngine::cacheSavegameHeader(const Common::String &filename, const ExtendedSavegameHeader *header) {
+	Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+	out.writeByte(EXTENDED_SAVE_VERSION);
+	out.writeByte(header->version);
+	out.writeUint32LE(header->date);
+	out.writeUint16LE(header->time);
+	out.writeUint32LE(header->playtime);
+	out.writeByte(MIN<uint>(header->saveName.size(), 0xFF));
+	out.write(header->saveName.c_str(), MIN<uint>(header->saveName.size(), 0xFF));
+	out.writeByte(MIN<uint>(header->description.size(), 0xFF));
+	out.write(header->description.c_str(), MIN<uint>(header->description.size(), 0xFF));
+	out.writeByte(header->isAutosave);
+
+	// Thumbnails bigger than what the save/load dialogs show are downscaled,
+	// to keep the index small
+	out.writeByte(header->thumbnail != nullptr);
+	if (header->thumbnail) {
+		const Graphics::Surface *thumbnail = header->thumbnail;
+		if (thumbnail->w <= kThumbnailWidth && thumbnail->h <= kThumbnailHeight2) {
+			Graphics::saveThumbnail(out, *thumbnail);
+		} else {
+			int16 width = kThumbnailWidth, height = kThumbnailHeight2;
+			if (thumbnail->w * kThumbnailHeight2 > thumbnail->h * kThumbnailWidth)
+				height = MAX<int>(thumbnail->h * kThumbnailWidth / thumbnail->w, 1);
+			else
+				width = MAX<int>(thumbnail->w * kThumbnailHeight2 / thumbnail->h, 1);
+
+			Graphics::Surface *scaled = thumbnail->scale(width, height, thumbnail->format.bytesPerPixel > 1);
+			Graphics::saveThumbnail(out, *scaled);
+			scaled->free();
+			delete scaled;
+		}
+	}
+
+	g_system->getSavefileManager()->storeSaveMetadata(filename, out.getData(), out.size());
+}
+
 
 //////////////////////////////////////////////
 // MetaEngine default implementations
@@ -409,6 +476,9 @@ SaveStateList MetaEngine::listSaves(const char *target) const {
 		}
 	}
 
+	// Write the headers read from the save files for the next list
+	saveFileMan->flushSaveMetadata();
+
 	// Sort saves based on slot number.
 	Common::sort(saveList.begin(), saveList.end(), SaveStateDescriptorSlotComparator());
 	return saveList;
@@ -473,15 +543,25 @@ SaveStateDescriptor MetaEngine::querySaveMetaInfos(const char *target, int slot)
 	if (!hasFeature(kSavesUseExtendedFormat))
 		return SaveStateDescriptor();
 
-	Common::ScopedPtr<Common::InSaveFile> f(g_system->getSavefileManager()->openForLoading(
-		getSavegameFile(slot, target)));
+	const Common::String filename = getSavegameFile(slot, target);
+	ExtendedSavegameHeader header;
+	if (readCachedSavegameHeader(filename, &header)) {
+		SaveStateDescriptor desc(this, slot);
+		parseSavegameHeader(&header, &desc);
+		desc.setThumbnail(header.thumbnail);
+		desc.setAutosave(header.isAutosave);
+		return desc;
+	}
+
+	Common::ScopedPtr<Common::InSaveFile> f(g_system->getSavefileManager()->openForLoading(filename));
 
 	if (f) {
-		ExtendedSavegameHeader header;
 		if (!readSavegameHeader(f.get(), &header, false)) {
 			return SaveStateDescriptor();
 		}
 
+		cacheSavegameHeader(filename, &header);
+
 		// Create the return descriptor
 		SaveStateDescriptor desc(this, slot);
 		parseSavegameHeader(&header, &desc);
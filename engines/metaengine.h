@@ -172,6 +172,12 @@ public:
 		return -1;
 	}
 
+	/**
+	 * Returns the names of the files whose first getMD5Bytes() bytes are hashed
+	 * by detectGames(), so that they can be hashed ahead of time.
+	 */
+	virtual void getMD5FileNames(Common::StringArray &fileNames) const {}
+
 	/** Returns formatted data from game descriptor for dumping into a file */
 	virtual void dumpDetectionEntries() const = 0;
 
@@ -592,6 +598,19 @@ public:
 	 * Read the extended savegame header from the given savegame file.
 	 */
 	WARN_UNUSED_RESULT static bool readSavegameHeader(Common::InSaveFile *in, ExtendedSavegameHeader *header, bool skipThumbnail = true);
+
+private:
+	/**
+	 * Read the extended savegame header of a save file, with its thumbnail
+	 * if it has one, from the metadata cached by the save file manager.
+	 */
+	static bool readCachedSavegameHeader(const Common::String &filename, ExtendedSavegameHeader *header);
+
+	/**
+	 * Cache the extended savegame header of a save file in the save file
+	 * manager, with a downscaled copy of its thumbnail.
+	 */
+	static void cacheSavegameHeader(const Common::String &filename, const ExtendedSavegameHeader *header);
 };
 
 /**
@@ -52,4 +52,192 @@ bool DirtyRectList::unionRectangle(Common::Rect &destRect, const Common::Rect &s
 	return !destRect.isEmpty();
 }
 
+DirtyRegion::DirtyRegion() : _width(0), _height(0), _tileSize(16), _tilesX(0), _tilesY(0), _rowWords(0) {
+}
+
+DirtyRegion::DirtyRegion(int16 width, int16 height, int16 tileSize) {
+	create(width, height, tileSize);
+}
+
+void DirtyRegion::create(int16 width, int16 height, int16 tileSize) {
+	assert(width >= 0 && height >= 0 && tileSize > 0);
+
+	_width = width;
+	_height = height;
+	_tileSize = tileSize;
+	_tilesX = (width + tileSize - 1) / tileSize;
+	_tilesY = (height + tileSize - 1) / tileSize;
+	_rowWords = (_tilesX + 31) / 32;
+
+	_tiles.clear();
+	_tiles.resize(_tilesY * _rowWords);
+	clear();
+}
+
+bool DirtyRegion::empty() const {
+	for (uint i = 0; i < _tiles.size(); i++) {
+		if (_tiles[i])
+			return false;
+	}
+	return true;
+}
+
+void DirtyRegion::clear() {
+	for (uint i = 0; i < _tiles.size(); i++)
+		_tiles[i] = 0;
+}
+
+void DirtyRegion::markAll() {
+	setTiles(Common::Rect(_tilesX, _tilesY), true);
+}
+
+bool DirtyRegion::getTileArea(const Common::Rect &r, Common::Rect &tileArea) const {
+	Common::Rect area = r;
+	area.clip(_width, _height);
+	if (area.isEmpty())
+		return false;
+
+	tileArea.left = area.left / _tileSize;
+	tileArea.top = area.top / _tileSize;
+	tileArea.right = (area.right + _tileSize - 1) / _tileSize;
+	tileArea.bottom = (area.bottom + _tileSize - 1) / _tileSize;
+	return true;
+}
+
+void DirtyRegion::setTiles(const Common::Rect &tileArea, bool dirty) {
+	for (int y = tileArea.top; y < tileArea.bottom; y++) {
+		uint32 *row = &_tiles[y * _rowWords];
+
+		// Set the bits of the span a word at a time
+		int x = tileArea.left;
+		while (x < tileArea.right) {
+			const int count = MIN<int>(32 - (x & 31), tileArea.right - x);
+			const uint32 mask = (count == 32 ? 0xFFFFFFFF : ((1u << count) - 1)) << (x & 31);
+			if (dirty)
+				row[x >> 5] |= mask;
+			else
+				row[x >> 5] &= ~mask;
+			x += count;
+		}
+	}
+}
+
+void DirtyRegion::addRect(const Common::Rect &r) {
+	Common::Rect tileArea;
+	if (getTileArea(r, tileArea))
+		setTiles(tileArea, true);
+}
+
+void DirtyRegion::subtractRect(const Common::Rect &r) {
+	Common::Rect area = r;
+	area.clip(_width, _height);
+	if (area.isEmpty())
+		return;
+
+	// Only keep the tiles which are fully covered. The last tiles of a row
+	// or column may be cut by the edge of the surface.
+	Common::Rect tileArea;
+	tileArea.left = (area.left + _tileSize - 1) / _tileSize;
+	tileArea.top = (area.top + _tileSize - 1) / _tileSize;
+	tileArea.right = (area.right == _width) ? _tilesX : area.right / _tileSize;
+	tileArea.bottom = (area.bottom == _height) ? _tilesY : area.bottom / _tileSize;
+
+	if (tileArea.left < tileArea.right && tileArea.top < tileArea.bottom)
+		setTiles(tileArea, false);
+}
+
+void DirtyRegion::addRegion(const DirtyRegion &region) {
+	assert(region._width == _width && region._height == _height && region._tileSize == _tileSize);
+
+	for (uint i = 0; i < _tiles.size(); i++)
+		_tiles[i] |= region._tiles[i];
+}
+
+void DirtyRegion::subtractRegion(const DirtyRegion &region) {
+	assert(region._width == _width && region._height == _height && region._tileSize == _tileSize);
+
+	for (uint i = 0; i < _tiles.size(); i++)
+		_tiles[i] &= ~region._tiles[i];
+}
+
+bool DirtyRegion::intersects(const Common::Rect &r) const {
+	Common::Rect tileArea;
+	if (!getTileArea(r, tileArea))
+		return false;
+
+	for (int y = tileArea.top; y < tileArea.bottom; y++) {
+		for (int x = tileArea.left; x < tileArea.right; x++) {
+			if (isTileDirty(x, y))
+				return true;
+		}
+	}
+	return false;
+}
+
+void DirtyRegion::getRects(Common::Array<Common::Rect> &rects, uint maxRects) const {
+	rects.clear();
+
+	// Rectangles still growing downwards, in tiles, sorted from left to
+	// right. Their bottom is not set yet.
+	Common::Array<Common::Rect> open, next;
+	Common::Rect bounds;
+
+	for (int y = 0; y <= _tilesY; y++) {
+		next.clear();
+		uint prev = 0;
+
+		// Go through the spans of dirty tiles of the row. The row after the
+		// last one has none, so that all rectangles get closed.
+		int x = 0;
+		while (y < _tilesY && x < _tilesX) {
+			// Skip the clean tiles, a word at a time when possible
+			const uint32 *row = &_tiles[y * _rowWords];
+			if (!(x & 31) && !row[x >> 5]) {
+				x += 32;
+				continue;
+			}
+			if (!isTileDirty(x, y)) {
+				x++;
+				continue;
+			}
+
+			const int spanStart = x;
+			while (x < _tilesX && isTileDirty(x, y))
+				x++;
+
+			// Close the rectangles left of the span, and extend the one
+			// with the same span
+			while (prev < open.size() && open[prev].left < spanStart)
+				addTileRect(rects, bounds, open[prev++], y);
+
+			if (prev < open.size() && open[prev].left == spanStart && open[prev].right == x) {
+				next.push_back(open[prev++]);
+			} else {
+				next.push_back(Common::Rect(spanStart, y, x, y));
+			}
+		}
+
+		while (prev < open.size())
+			addTileRect(rects, bounds, open[prev++], y);
+
+		SWAP(open, next);
+	}
+
+	if (maxRects && rects.size() > maxRects) {
+		rects.clear();
+		rects.push_back(bounds);
+	}
+}
+
+void DirtyRegion::addTileRect(Common::Array<Common::Rect> &rects, Common::Rect &bounds, const Common::Rect &tileRect, int bottom) const {
+	Common::Rect r(tileRect.left * _tileSize, tileRect.top * _tileSize,
+		MIN<int>(tileRect.right * _tileSize, _width), MIN<int>(bottom * _tileSize, _height));
+
+	if (rects.empty())
+		bounds = r;
+	else
+		bounds.extend(r);
+	rects.push_back(r);
+}
+
 } // End of namespace Graphics
@@ -22,6 +22,7 @@
 #ifndef GRAPHICS_DIRTYRECTS_H
 #define GRAPHICS_DIRTYRECTS_H
 
+#include "common/array.h"
 #include "common/list.h"
 #include "common/rect.h"
 
@@ -31,7 +32,7 @@ namespace Graphics {
  * @defgroup graphics_dirtyrects DirtyRects
  * @ingroup graphics
  *
- * @brief DirtyRectList class for tracking dirty rectangles.
+ * @brief DirtyRectList and DirtyRegion classes for tracking dirty rectangles.
  *
  * @{
  */
@@ -104,6 +105,106 @@ public:
 		return _dirtyRects.end();
 	}
 };
+
+/**
+ * This class keeps track of the areas of a surface that are updated by
+ * drawing calls, as a bitmap of fixed size tiles.
+ *
+ * Adding, removing and merging areas is done in time proportional to the
+ * number of tiles they cover, whatever the number of areas already added.
+ * The dirty area is then turned into a small set of disjoint rectangles,
+ * ready to be copied to the screen. Since whole tiles are marked, these
+ * rectangles can be slightly larger than the areas which were added.
+ */
+class DirtyRegion {
+public:
+	DirtyRegion();
+	DirtyRegion(int16 width, int16 height, int16 tileSize = 16);
+
+	/**
+	 * Set the size of the tracked surface, and clear the dirty area.
+	 */
+	void create(int16 width, int16 height, int16 tileSize = 16);
+
+	int16 getWidth() const { return _width; }
+	int16 getHeight() const { return _height; }
+	int16 getTileSize() const { return _tileSize; }
+
+	/**
+	 * Returns true if no area is dirty
+	 */
+	bool empty() const;
+
+	/**
+	 * Clear the whole dirty area
+	 */
+	void clear();
+
+	/**
+	 * Marks the whole surface as dirty
+	 */
+	void markAll();
+
+	/**
+	 * Marks an area as dirty. Parts outside of the surface are ignored.
+	 */
+	void addRect(const Common::Rect &r);
+
+	/**
+	 * Removes an area from the dirty area, for instance because it was
+	 * redrawn in an other way. Only the tiles which are fully covered by the
+	 * area are removed.
+	 */
+	void subtractRect(const Common::Rect &r);
+
+	/**
+	 * Adds the dirty area of another region of the same size and tile size
+	 */
+	void addRegion(const DirtyRegion &region);
+
+	/**
+	 * Removes the dirty area of another region of the same size and tile size
+	 */
+	void subtractRegion(const DirtyRegion &region);
+
+	/**
+	 * Returns true if any part of the given area is dirty
+	 */
+	bool intersects(const Common::Rect &r) const;
+
+	/**
+	 * Returns the dirty area as a set of disjoint rectangles.
+	 *
+	 * Consecutive dirty tiles of a tile row are joined, as well as rows with
+	 * the same spans of dirty tiles.
+	 *
+	 * @param rects     Array receiving the rectangles.
+	 * @param maxRects  Maximum number of rectangles. If the dirty area needs
+	 *                  more, its bounding rectangle is returned instead.
+	 *                  Zero means no limit.
+	 */
+	void getRects(Common::Array<Common::Rect> &rects, uint maxRects = 0) const;
+
+private:
+	int16 _width;
+	int16 _height;
+	int16 _tileSize;
+	int16 _tilesX;
+	int16 _tilesY;
+	uint _rowWords;
+
+	/** One bit per tile, each row of tiles starting on a new word */
+	Common::Array<uint32> _tiles;
+
+	/** Tile area covered, fully or not, by the given area */
+	bool getTileArea(const Common::Rect &r, Common::Rect &tileArea) const;
+
+	void setTiles(const Common::Rect &tileArea, bool dirty);
+	void addTileRect(Common::Array<Common::Rect> &rects, Common::Rect &bounds, const Common::Rect &tileRect, int bottom) const;
+	bool isTileDirty(int x, int y) const {
+		return (_tiles[y * _rowWords + (x >> 5)] >> (x & 31)) & 1;
+	}
+};
  /** @} */
 } // End of namespace Graphics
 
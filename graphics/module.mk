@@ -195,6 +195,19 @@ ifdef USE_HQ_SCALERS
 MODULE_OBJS += \
 	scaler/hq.o
 
+ifdef SCUMMVM_NEON
+MODULE_OBJS += \
+	scaler/hq_neon.o
+endif
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	scaler/hq_sse2.o
+endif
+ifdef SCUMMVM_AVX2
+MODULE_OBJS += \
+	scaler/hq_avx2.o
+endif
+
 ifdef USE_NASM
 MODULE_OBJS += \
 	scaler/hq2x_i386.o \
@@ -217,15 +230,18 @@ endif
 
 ifdef SCUMMVM_NEON
 MODULE_OBJS += \
-	blit/blit-neon.o
+	blit/blit-neon.o \
+	yuv_to_rgb_neon.o
 endif
 ifdef SCUMMVM_SSE2
 MODULE_OBJS += \
-	blit/blit-sse2.o
+	blit/blit-sse2.o \
+	yuv_to_rgb_sse2.o
 endif
 ifdef SCUMMVM_AVX2
 MODULE_OBJS += \
-	blit/blit-avx2.o
+	blit/blit-avx2.o \
+	yuv_to_rgb_avx2.o
 endif
 
 # Include common rules
@@ -20,8 +20,11 @@
 
 #include "graphics/scaler/hq.h"
 #include "graphics/scaler.h"
+#include "graphics/scaler/hq_intern.h"
 #include "graphics/scaler/intern.h"
 
+#include "common/system.h"
+
 // RGB-to-YUV lookup table
 
 #ifdef USE_NASM
@@ -173,7 +176,8 @@ void HQScaler::initLUT(Graphics::PixelFormat format) {
 #define PIXEL11_90	*(q+1+nextlineDst) = interpolate_2_3_3(w5, w6, w8);
 #define PIXEL11_100	*(q+1+nextlineDst) = interpolate_14_1_1(w5, w6, w8);
 
-#define YUV(x)	(sizeof(Pixel) == 2 ? RGBtoYUV[w ## x] : ConvertYUV<ColorMask>(w ## x, RGBtoYUV))
+// The YUV value of w1 to w9, from the rows converted by convertYUVRow()
+#define YUV(x)	(yuvRows[((x) - 1) / 3][i + ((x) - 1) % 3])
 
 /**
  * Convert 32 bit RGB values to Yuv
@@ -193,13 +197,90 @@ static inline uint32 ConvertYUV(uint32 x, const uint32 *RGBtoYUV) {
 	return RGBtoYUV[r | g | b];
 }
 
+const HQKernels *getHQKernels() {
+	const HQKernels *kernels = nullptr;
+
+	if (!g_system)
+		return nullptr;
+
+#ifdef SCUMMVM_NEON
+	if (g_system->hasFeature(OSystem::kFeatureCpuNEON))
+		kernels = &g_hqKernelsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+	if (g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+		kernels = &g_hqKernelsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+	if (g_system->hasFeature(OSystem::kFeatureCpuAVX2))
+		kernels = &g_hqKernelsAVX2;
+#endif
+
+	return kernels;
+}
+
+/**
+ * Convert a row of pixels to YUV, so that every value is only computed
+ * once instead of for each of its neighbours.
+ */
+template<typename ColorMask>
+static void convertYUVRow(uint32 *yuv, const typename ColorMask::PixelType *p, int count, const uint32 *RGBtoYUV) {
+	for (int i = 0; i < count; i++)
+		yuv[i] = sizeof(typename ColorMask::PixelType) == 2 ? RGBtoYUV[p[i]] : ConvertYUV<ColorMask>(p[i], RGBtoYUV);
+}
+
+/**
+ * Compute the patterns of a row, see HQKernels::classifyRow(). Pixels equal
+ * to the center one have the same YUV value, so they never set a bit.
+ */
+static void classifyRow(byte *patterns, const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, int width, const HQKernels *kernels) {
+	int x = kernels ? kernels->classifyRow(patterns, yuvAbove, yuv, yuvBelow, width) : 0;
+
+	for (; x < width; x++) {
+		const int yuv5 = yuv[x + 1];
+		int pattern = 0;
+		if (diffYUV(yuv5, yuvAbove[x])) pattern |= 0x0001;
+		if (diffYUV(yuv5, yuvAbove[x + 1])) pattern |= 0x0002;
+		if (diffYUV(yuv5, yuvAbove[x + 2])) pattern |= 0x0004;
+		if (diffYUV(yuv5, yuv[x])) pattern |= 0x0008;
+		if (diffYUV(yuv5, yuv[x + 2])) pattern |= 0x0010;
+		if (diffYUV(yuv5, yuvBelow[x])) pattern |= 0x0020;
+		if (diffYUV(yuv5, yuvBelow[x + 1])) pattern |= 0x0040;
+		if (diffYUV(yuv5, yuvBelow[x + 2])) pattern |= 0x0080;
+		patterns[x] = pattern;
+	}
+}
+
+enum {
+	/**
+	 * Widest part of a rect scaled at once. Wider rects are scaled in
+	 * strips, so that the rows of YUV values and patterns fit on the stack
+	 * of the calling thread, whichever band it scales.
+	 */
+	kHQStripWidth = 512
+};
+
+typedef void (*HQStripProc)(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV, const HQKernels *kernels);
+
+/**
+ * Scale a rect in strips of at most kHQStripWidth columns. Each pixel only
+ * depends on its neighbours, which are read on both sides of the strips.
+ */
+template<typename Pixel, int factor>
+static void scaleInStrips(HQStripProc strip, const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV, const HQKernels *kernels) {
+	for (int x = 0; x < width; x += kHQStripWidth) {
+		strip(srcPtr + x * sizeof(Pixel), srcPitch, dstPtr + x * factor * sizeof(Pixel), dstPitch,
+		      MIN<int>(width - x, kHQStripWidth), height, RGBtoYUV, kernels);
+	}
+}
+
 /*
  * The HQ2x high quality 2x graphics filter.
  * Original author Maxim Stepin (https://web.archive.org/web/20090204033742/http://www.hiend3d.com/hq2x.html).
  * Adapted for ScummVM to 16 bit output and optimized by Max Horn.
  */
 template<typename ColorMask>
-static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV) {
+static void HQ2x_strip(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV, const HQKernels *kernels) {
 	typedef typename ColorMask::PixelType Pixel;
 
 	int w1, w2, w3, w4, w5, w6, w7, w8, w9;
@@ -221,7 +302,22 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 	//	 | w7 | w8 | w9 |
 	//	 +----+----+----+
 
+	// The YUV values of the rows above, at and below the current one,
+	// starting with the pixel left of the first one
+	assert(width <= kHQStripWidth);
+	uint32 yuvBuffer[(kHQStripWidth + 2) * 3];
+	uint32 *yuvRows[3];
+	for (int row = 0; row < 3; row++)
+		yuvRows[row] = &yuvBuffer[(width + 2) * row];
+	convertYUVRow<ColorMask>(&yuvBuffer[0], p - 1 - nextlineSrc, width + 2, RGBtoYUV);
+	convertYUVRow<ColorMask>(&yuvBuffer[width + 2], p - 1, width + 2, RGBtoYUV);
+
+	byte patterns[kHQStripWidth];
+
 	while (height--) {
+		convertYUVRow<ColorMask>(yuvRows[2], p - 1 + nextlineSrc, width + 2, RGBtoYUV);
+		classifyRow(&patterns[0], yuvRows[0], yuvRows[1], yuvRows[2], width, kernels);
+
 		w1 = *(p - 1 - nextlineSrc);
 		w4 = *(p - 1);
 		w7 = *(p - 1 + nextlineSrc);
@@ -230,26 +326,14 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		w5 = *(p);
 		w8 = *(p + nextlineSrc);
 
-		int tmpWidth = width;
-		while (tmpWidth--) {
+		for (int i = 0; i < width; i++) {
 			p++;
 
 			w3 = *(p - nextlineSrc);
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
-
-			switch (pattern) {
+			switch (patterns[i]) {
 			case 0:
 			case 1:
 			case 4:
@@ -2053,6 +2137,12 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		}
 		p += nextlineSrc - width;
 		q += (nextlineDst - width) * 2;
+
+		// Move the YUV rows up
+		uint32 *yuvAbove = yuvRows[0];
+		yuvRows[0] = yuvRows[1];
+		yuvRows[1] = yuvRows[2];
+		yuvRows[2] = yuvAbove;
 	}
 }
 
@@ -2116,7 +2206,7 @@ static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
  * Adapted for ScummVM to 16 bit output and optimized by Max Horn.
  */
 template<typename ColorMask>
-static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV) {
+static void HQ3x_strip(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV, const HQKernels *kernels) {
 	typedef typename ColorMask::PixelType Pixel;
 
 	int  w1, w2, w3, w4, w5, w6, w7, w8, w9;
@@ -2139,7 +2229,22 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 	//	 | w7 | w8 | w9 |
 	//	 +----+----+----+
 
+	// The YUV values of the rows above, at and below the current one,
+	// starting with the pixel left of the first one
+	assert(width <= kHQStripWidth);
+	uint32 yuvBuffer[(kHQStripWidth + 2) * 3];
+	uint32 *yuvRows[3];
+	for (int row = 0; row < 3; row++)
+		yuvRows[row] = &yuvBuffer[(width + 2) * row];
+	convertYUVRow<ColorMask>(&yuvBuffer[0], p - 1 - nextlineSrc, width + 2, RGBtoYUV);
+	convertYUVRow<ColorMask>(&yuvBuffer[width + 2], p - 1, width + 2, RGBtoYUV);
+
+	byte patterns[kHQStripWidth];
+
 	while (height--) {
+		convertYUVRow<ColorMask>(yuvRows[2], p - 1 + nextlineSrc, width + 2, RGBtoYUV);
+		classifyRow(&patterns[0], yuvRows[0], yuvRows[1], yuvRows[2], width, kernels);
+
 		w1 = *(p - 1 - nextlineSrc);
 		w4 = *(p - 1);
 		w7 = *(p - 1 + nextlineSrc);
@@ -2148,26 +2253,14 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		w5 = *(p);
 		w8 = *(p + nextlineSrc);
 
-		int tmpWidth = width;
-		while (tmpWidth--) {
+		for (int i = 0; i < width; i++) {
 			p++;
 
 			w3 = *(p - nextlineSrc);
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
-
-			switch (pattern) {
+			switch (patterns[i]) {
 			case 0:
 			case 1:
 			case 4:
@@ -4944,14 +5037,30 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		}
 		p += nextlineSrc - width;
 		q += (nextlineDst - width) * 3;
+
+		// Move the YUV rows up
+		uint32 *yuvAbove = yuvRows[0];
+		yuvRows[0] = yuvRows[1];
+		yuvRows[1] = yuvRows[2];
+		yuvRows[2] = yuvAbove;
 	}
 }
 
+template<typename ColorMask>
+static void HQ2x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV, const HQKernels *kernels) {
+	scaleInStrips<typename ColorMask::PixelType, 2>(HQ2x_strip<ColorMask>, srcPtr, srcPitch, dstPtr, dstPitch, width, height, RGBtoYUV, kernels);
+}
+
+template<typename ColorMask>
+static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, const uint32 *RGBtoYUV, const HQKernels *kernels) {
+	scaleInStrips<typename ColorMask::PixelType, 3>(HQ3x_strip<ColorMask>, srcPtr, srcPitch, dstPtr, dstPitch, width, height, RGBtoYUV, kernels);
+}
+
 HQScaler::HQScaler(const Graphics::PixelFormat &format) : Scaler(format),
 #ifdef USE_NASM
 	_hqx_params(nullptr),
 #endif
-	_RGBtoYUV(nullptr) {
+	_RGBtoYUV(nullptr), _kernels(getHQKernels()) {
 	_factor = 2;
 
 	if (format.bytesPerPixel == 2) {
@@ -4987,19 +5096,19 @@ void HQScaler::HQ3x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint3
 void HQScaler::HQ2x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	if (_format.gLoss == 2)
 		HQ2x_implementation<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _kernels);
 	else
 		HQ2x_implementation<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _kernels);
 }
 
 void HQScaler::HQ3x16(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height) {
 	if (_format.gLoss == 2)
 		HQ3x_implementation<Graphics::ColorMasks<565> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _kernels);
 	else
 		HQ3x_implementation<Graphics::ColorMasks<555> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _kernels);
 }
 #endif
 
@@ -5007,15 +5116,15 @@ void HQScaler::HQ2x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint3
 	if (_format.aLoss == 0) {
 		if (_format.aShift == 0) {
 			HQ2x_implementation<Graphics::ColorMasks<-8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _kernels);
 		} else {
 			HQ2x_implementation<Graphics::ColorMasks<8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _kernels);
 		}
 	} else {
 		assert((_format.rMax() | _format.gMax() | _format.bMax()) <= 0xffffff);
 		HQ2x_implementation<Graphics::ColorMasks<888> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _kernels);
 	}
 }
 
@@ -5023,15 +5132,15 @@ void HQScaler::HQ3x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint3
 	if (_format.aLoss == 0) {
 		if (_format.aShift == 0) {
 			HQ3x_implementation<Graphics::ColorMasks<-8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _kernels);
 		} else {
 			HQ3x_implementation<Graphics::ColorMasks<8888> >(srcPtr, srcPitch, dstPtr,
-					dstPitch, width, height, _RGBtoYUV);
+					dstPitch, width, height, _RGBtoYUV, _kernels);
 		}
 	} else {
 		assert((_format.rMax() | _format.gMax() | _format.bMax()) <= 0xffffff);
 		HQ3x_implementation<Graphics::ColorMasks<888> >(srcPtr, srcPitch, dstPtr,
-				dstPitch, width, height, _RGBtoYUV);
+				dstPitch, width, height, _RGBtoYUV, _kernels);
 	}
 }
 
@@ -5079,6 +5188,8 @@ public:
 
 	bool canDrawCursor() const override { return false; }
 	uint extraPixels() const override { return 1; }
+	bool isThreadSafe() const override { return true; }
+	bool isExpensive() const override { return true; }
 	const char *getName() const override;
 	const char *getPrettyName() const override;
 };
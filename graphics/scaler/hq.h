@@ -26,6 +26,7 @@
 #ifdef USE_NASM
 struct hqx_parameters;
 #endif
+struct HQKernels;
 
 class HQScaler : public Scaler {
 public:
@@ -44,6 +45,8 @@ protected:
 	inline void HQ3x32(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height);
 
 	uint32 *_RGBtoYUV;
+	/** SIMD kernels for the pattern classification, if supported by the CPU */
+	const HQKernels *_kernels;
 #ifdef USE_NASM
 	hqx_parameters *_hqx_params;
 #endif
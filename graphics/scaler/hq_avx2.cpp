@@ -0,0 +1,84 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/scaler/hq_intern.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+/** See sse2_diffBit(). */
+static FORCEINLINE __m256i avx2_diffBit(__m256i yuv, const uint32 *neighbour, __m256i thresholds, int bit) {
+	const __m256i other = _mm256_loadu_si256((const __m256i *)neighbour);
+	const __m256i absDiff = _mm256_or_si256(_mm256_subs_epu8(yuv, other), _mm256_subs_epu8(other, yuv));
+	const __m256i same = _mm256_cmpeq_epi32(_mm256_subs_epu8(absDiff, thresholds), _mm256_setzero_si256());
+	return _mm256_andnot_si256(same, _mm256_set1_epi32(bit));
+}
+
+/** Patterns of eight pixels, as 32 bit lanes. */
+static FORCEINLINE __m256i avx2_classify(const uint32 *above, const uint32 *cur, const uint32 *below, __m256i thresholds) {
+	const __m256i yuv = _mm256_loadu_si256((const __m256i *)(cur + 1));
+
+	__m256i pattern = avx2_diffBit(yuv, above, thresholds, 0x01);
+	pattern = _mm256_or_si256(pattern, avx2_diffBit(yuv, above + 1, thresholds, 0x02));
+	pattern = _mm256_or_si256(pattern, avx2_diffBit(yuv, above + 2, thresholds, 0x04));
+	pattern = _mm256_or_si256(pattern, avx2_diffBit(yuv, cur, thresholds, 0x08));
+	pattern = _mm256_or_si256(pattern, avx2_diffBit(yuv, cur + 2, thresholds, 0x10));
+	pattern = _mm256_or_si256(pattern, avx2_diffBit(yuv, below, thresholds, 0x20));
+	pattern = _mm256_or_si256(pattern, avx2_diffBit(yuv, below + 1, thresholds, 0x40));
+	pattern = _mm256_or_si256(pattern, avx2_diffBit(yuv, below + 2, thresholds, 0x80));
+	return pattern;
+}
+
+static int classifyRowAVX2(byte *patterns, const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, int width) {
+	const __m256i thresholds = _mm256_set1_epi32(kHQThresholds);
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		const __m256i lo = avx2_classify(yuvAbove + x, yuv + x, yuvBelow + x, thresholds);
+		const __m256i hi = avx2_classify(yuvAbove + x + 8, yuv + x + 8, yuvBelow + x + 8, thresholds);
+
+		// Packing works within 128 bit lanes, so restore the pixel order
+		// before narrowing to bytes
+		const __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+		const __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+		_mm_storeu_si128((__m128i *)(patterns + x), bytes);
+	}
+
+	return x;
+}
+
+const HQKernels g_hqKernelsAVX2 = {
+	classifyRowAVX2
+};
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,73 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_SCALER_HQ_INTERN_H
+#define GRAPHICS_SCALER_HQ_INTERN_H
+
+#include "common/scummsys.h"
+
+/**
+ * Thresholds of diffYUV(), one byte per YUV component. Two values differ
+ * if any component differs by more than its threshold.
+ */
+enum {
+	kHQThresholdY = 0x30,
+	kHQThresholdU = 0x07,
+	kHQThresholdV = 0x06,
+	kHQThresholds = (kHQThresholdY << 16) | (kHQThresholdU << 8) | kHQThresholdV
+};
+
+/**
+ * Row kernels of the HQ scalers.
+ *
+ * They must give exactly the same results as diffYUV(). They only handle
+ * a multiple of their block size, and return the number of pixels done;
+ * the rest of the row is left to the C code.
+ */
+struct HQKernels {
+	/**
+	 * Compute the pattern of each pixel of a row: bit n is set if the
+	 * YUV value of neighbour n differs from the one of the pixel, with
+	 * the neighbours numbered as in the HQ scalers, skipping the pixel.
+	 *
+	 * The YUV rows are the ones above, at and below the pixels, and
+	 * start one pixel to the left of the first one.
+	 */
+	int (*classifyRow)(byte *patterns, const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, int width);
+};
+
+/**
+ * Return the fastest kernels supported by the CPU, or nullptr if none of
+ * them is better than the C code.
+ */
+const HQKernels *getHQKernels();
+
+#ifdef SCUMMVM_NEON
+extern const HQKernels g_hqKernelsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+extern const HQKernels g_hqKernelsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+extern const HQKernels g_hqKernelsAVX2;
+#endif
+
+#endif
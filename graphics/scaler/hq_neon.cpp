@@ -0,0 +1,91 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/scaler/hq_intern.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+/** Return `bit` in each lane where the neighbour differs from the pixel. */
+static FORCEINLINE uint32x4_t neon_diffBit(uint8x16_t yuv, const uint32 *neighbour, uint8x16_t thresholds, uint32 bit) {
+	const uint8x16_t other = vreinterpretq_u8_u32(vld1q_u32(neighbour));
+	const uint32x4_t over = vreinterpretq_u32_u8(vqsubq_u8(vabdq_u8(yuv, other), thresholds));
+	return vandq_u32(vtstq_u32(over, over), vdupq_n_u32(bit));
+}
+
+/** Patterns of four pixels, as 32 bit lanes. */
+static FORCEINLINE uint32x4_t neon_classify(const uint32 *above, const uint32 *cur, const uint32 *below, uint8x16_t thresholds) {
+	const uint8x16_t yuv = vreinterpretq_u8_u32(vld1q_u32(cur + 1));
+
+	uint32x4_t pattern = neon_diffBit(yuv, above, thresholds, 0x01);
+	pattern = vorrq_u32(pattern, neon_diffBit(yuv, above + 1, thresholds, 0x02));
+	pattern = vorrq_u32(pattern, neon_diffBit(yuv, above + 2, thresholds, 0x04));
+	pattern = vorrq_u32(pattern, neon_diffBit(yuv, cur, thresholds, 0x08));
+	pattern = vorrq_u32(pattern, neon_diffBit(yuv, cur + 2, thresholds, 0x10));
+	pattern = vorrq_u32(pattern, neon_diffBit(yuv, below, thresholds, 0x20));
+	pattern = vorrq_u32(pattern, neon_diffBit(yuv, below + 1, thresholds, 0x40));
+	pattern = vorrq_u32(pattern, neon_diffBit(yuv, below + 2, thresholds, 0x80));
+	return pattern;
+}
+
+static int classifyRowNEON(byte *patterns, const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, int width) {
+	const uint8x16_t thresholds = vreinterpretq_u8_u32(vdupq_n_u32(kHQThresholds));
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		const uint32x4_t lo = neon_classify(yuvAbove + x, yuv + x, yuvBelow + x, thresholds);
+		const uint32x4_t hi = neon_classify(yuvAbove + x + 4, yuv + x + 4, yuvBelow + x + 4, thresholds);
+		const uint16x8_t words = vcombine_u16(vmovn_u32(lo), vmovn_u32(hi));
+		vst1_u8(patterns + x, vmovn_u16(words));
+	}
+
+	return x;
+}
+
+const HQKernels g_hqKernelsNEON = {
+	classifyRowNEON
+};
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
@@ -217,6 +217,7 @@ public:
 
 	bool canDrawCursor() const override { return false; }
 	uint extraPixels() const override { return 1; }
+	bool isThreadSafe() const override { return true; }
 	const char *getName() const override;
 	const char *getPrettyName() const override;
 };
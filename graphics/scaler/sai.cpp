@@ -423,6 +423,8 @@ public:
 
 	bool canDrawCursor() const override { return false; }
 	uint extraPixels() const override { return 2; }
+	bool isThreadSafe() const override { return true; }
+	bool isExpensive() const override { return true; }
 	const char *getName() const override;
 	const char *getPrettyName() const override;
 };
@@ -479,6 +481,8 @@ public:
 
 	bool canDrawCursor() const override { return false; }
 	uint extraPixels() const override { return 2; }
+	bool isThreadSafe() const override { return true; }
+	bool isExpensive() const override { return true; }
 	const char *getName() const override;
 	const char *getPrettyName() const override;
 };
@@ -535,6 +539,8 @@ public:
 
 	bool canDrawCursor() const override { return false; }
 	uint extraPixels() const override { return 2; }
+	bool isThreadSafe() const override { return true; }
+	bool isExpensive() const override { return true; }
 	const char *getName() const override;
 	const char *getPrettyName() const override;
 };
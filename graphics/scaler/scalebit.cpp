@@ -85,6 +85,19 @@ static inline void stage_scale4x(void* dst0, void* dst1, void* dst2, void* dst3,
 	stage_scale2x(dst2, dst3, src1, src2, src3, pixel, 2 * pixel_per_row);
 }
 
+/**
+ * Repeat the border pixels of two buffer rows into their margins, as the
+ * second Scale2x pass of Scale4x reads one pixel beyond them. Used internally.
+ */
+static inline void stage_mid_border(unsigned char* mid0, unsigned char* mid1, unsigned pixel, unsigned pixel_per_row) {
+	const unsigned last = 2 * pixel_per_row * pixel;
+
+	memcpy(mid0 - pixel, mid0, pixel);
+	memcpy(mid0 + last, mid0 + last - pixel, pixel);
+	memcpy(mid1 - pixel, mid1, pixel);
+	memcpy(mid1 + last, mid1 + last - pixel, pixel);
+}
+
 #define SCDST(i) (dst+(i)*dst_slice)
 #define SCSRC(i) (src+(i)*src_slice)
 #define SCMID(i) (mid[(i)])
@@ -166,7 +179,7 @@ static void scale3x(void* void_dst, unsigned dst_slice, const void* void_src, un
  * The destination bitmap must be manually allocated before calling the function,
  * note that the resulting size is exactly 4x4 times the size of the source bitmap.
  * \note This function requires also a small buffer bitmap used internally to store
- * intermediate results. This bitmap must have at least a horizontal size in bytes of 2*width*pixel,
+ * intermediate results. This bitmap must have at least a horizontal size in bytes of 2*(width+1)*pixel,
  * and a vertical size of 6 rows. The memory of this buffer must not be allocated
  * in video memory because it's also read and not only written. Generally
  * a heap (malloc) or a stack (alloca) buffer is the best choices.
@@ -191,7 +204,7 @@ static void scale4x_buf(void* void_dst, unsigned dst_slice, void* void_mid, unsi
 	count = height;
 
 	/* set the 6 buffer pointers */
-	mid[0] = (unsigned char*)void_mid;
+	mid[0] = (unsigned char*)void_mid + pixel;
 	mid[1] = mid[0] + mid_slice;
 	mid[2] = mid[1] + mid_slice;
 	mid[3] = mid[2] + mid_slice;
@@ -199,11 +212,14 @@ static void scale4x_buf(void* void_dst, unsigned dst_slice, void* void_mid, unsi
 	mid[5] = mid[4] + mid_slice;
 
 	stage_scale2x(SCMID(0), SCMID(1), SCSRC(0), SCSRC(1), SCSRC(2), pixel, width);
+	stage_mid_border(SCMID(0), SCMID(1), pixel, width);
 	stage_scale2x(SCMID(2), SCMID(3), SCSRC(1), SCSRC(2), SCSRC(3), pixel, width);
+	stage_mid_border(SCMID(2), SCMID(3), pixel, width);
 	while (count) {
 		unsigned char* tmp;
 
 		stage_scale2x(SCMID(4), SCMID(5), SCSRC(2), SCSRC(3), SCSRC(4), pixel, width);
+		stage_mid_border(SCMID(4), SCMID(5), pixel, width);
 		stage_scale4x(SCDST(0), SCDST(1), SCDST(2), SCDST(3), SCMID(1), SCMID(2), SCMID(3), SCMID(4), pixel, width);
 
 		dst = SCDST(4);
@@ -246,7 +262,7 @@ static void scale4x(void* void_dst, unsigned dst_slice, const void* void_src, un
 	unsigned mid_slice;
 	void* mid;
 
-	mid_slice = 2 * pixel * width; /* required space for 1 row buffer */
+	mid_slice = 2 * pixel * (width + 1); /* required space for 1 row buffer and its margins */
 
 	mid_slice = (mid_slice + 0x7) & ~0x7; /* align to 8 bytes */
 
@@ -382,6 +398,8 @@ public:
 
 	bool canDrawCursor() const override { return true; }
 	uint extraPixels() const override { return 4; }
+	bool isThreadSafe() const override { return true; }
+	bool isExpensive() const override { return true; }
 	const char *getName() const override;
 	const char *getPrettyName() const override;
 };
@@ -20,6 +20,8 @@
 
 #include "graphics/scalerplugin.h"
 
+#include "common/threadpool.h"
+
 namespace {
 /**
  * Trivial 'scaler' - in fact it doesn't do any scaling but just copies the
@@ -42,6 +44,57 @@ void Normal1x(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPit
 }
 } // End of anonymous namespace
 
+/** Scales one band of a rect on a worker thread */
+class Scaler::BandTask : public Common::Task {
+public:
+	explicit BandTask(Scaler *scaler) : _scaler(scaler), _srcPtr(nullptr), _srcPitch(0),
+		_dstPtr(nullptr), _dstPitch(0), _width(0), _height(0), _x(0), _y(0) {}
+
+	void setBand(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch,
+	             int width, int height, int x, int y) {
+		_srcPtr = srcPtr;
+		_srcPitch = srcPitch;
+		_dstPtr = dstPtr;
+		_dstPitch = dstPitch;
+		_width = width;
+		_height = height;
+		_x = x;
+		_y = y;
+	}
+
+	void run() override {
+		_scaler->scaleIntern(_srcPtr, _srcPitch, _dstPtr, _dstPitch, _width, _height, _x, _y);
+	}
+
+private:
+	Scaler *_scaler;
+	const uint8 *_srcPtr;
+	uint32 _srcPitch;
+	uint8 *_dstPtr;
+	uint32 _dstPitch;
+	int _width, _height, _x, _y;
+};
+
+Scaler::~Scaler() {
+	setThreadPool(nullptr);
+}
+
+void Scaler::setThreadPool(Common::ThreadPool *pool) {
+	for (auto *task : _bandTasks)
+		delete task;
+	_bandTasks.clear();
+
+	_threadPool = pool;
+	if (!pool)
+		return;
+
+	// One band per worker, plus the one scaled by the calling thread.
+	// A pool without threads still gets split, running the bands in turn.
+	const uint numTasks = MAX<uint>(pool->getThreadCount(), 1);
+	for (uint i = 0; i < numTasks; i++)
+		_bandTasks.push_back(new BandTask(this));
+}
+
 void Scaler::scale(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 	                           uint32 dstPitch, int width, int height, int x, int y) {
 	if (_factor == 1) {
@@ -52,11 +105,38 @@ void Scaler::scale(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 		} else {
 			Normal1x<uint32>(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
 		}
+	} else if (_threadPool && height >= 2 * kMinBandHeight) {
+		scaleBands(srcPtr, srcPitch, dstPtr, dstPitch, width, height, x, y);
 	} else {
 		scaleIntern(srcPtr, srcPitch, dstPtr, dstPitch, width, height, x, y);
 	}
 }
 
+void Scaler::scaleBands(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
+                        uint32 dstPitch, int width, int height, int x, int y) {
+	const int numBands = MIN<int>(_bandTasks.size() + 1, height / kMinBandHeight);
+	const int bandHeight = height / numBands;
+
+	// Each band writes its own destination rows. The source rows around
+	// the bands are shared, but only read.
+	for (int i = 0; i < numBands - 1; i++) {
+		const int offset = i * bandHeight;
+		_bandTasks[i]->setBand(srcPtr + offset * srcPitch, srcPitch,
+		                       dstPtr + offset * _factor * dstPitch, dstPitch,
+		                       width, bandHeight, x, y + offset);
+		_threadPool->submit(_bandTasks[i]);
+	}
+
+	// The last band takes the remaining rows
+	const int offset = (numBands - 1) * bandHeight;
+	scaleIntern(srcPtr + offset * srcPitch, srcPitch,
+	            dstPtr + offset * _factor * dstPitch, dstPitch,
+	            width, height - offset, x, y + offset);
+
+	for (int i = 0; i < numBands - 1; i++)
+		_bandTasks[i]->wait();
+}
+
 SourceScaler::SourceScaler(const Graphics::PixelFormat &format) : Scaler(format), _width(0), _height(0), _oldSrc(NULL), _enable(false) {
 }
 
@@ -25,10 +25,14 @@
 #include "graphics/pixelformat.h"
 #include "graphics/surface.h"
 
+namespace Common {
+class ThreadPool;
+}
+
 class Scaler {
 public:
-	Scaler(const Graphics::PixelFormat &format) : _format(format) {}
-	virtual ~Scaler() {}
+	Scaler(const Graphics::PixelFormat &format) : _format(format), _threadPool(nullptr) {}
+	virtual ~Scaler();
 
 	/**
 	 * Scale a rect.
@@ -45,6 +49,18 @@ public:
 	void scale(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
 	           uint32 dstPitch, int width, int height, int x, int y);
 
+	/**
+	 * Scale large rects in horizontal bands on the worker threads of a
+	 * pool. The calling thread scales one band itself, and scale() only
+	 * returns once all bands are done.
+	 *
+	 * Only use this with scalers whose plugin declares them thread-safe.
+	 *
+	 * @param pool The pool to use, or nullptr to scale on the calling thread.
+	 * @see ScalerPluginObject::isThreadSafe
+	 */
+	void setThreadPool(Common::ThreadPool *pool);
+
 	/**
 	 * Increase the factor of scaling.
 	 * @return The new factor
@@ -103,6 +119,21 @@ protected:
 
 	uint _factor;
 	Graphics::PixelFormat _format;
+
+private:
+	class BandTask;
+
+	enum {
+		/** Minimum number of source rows per band */
+		kMinBandHeight = 16
+	};
+
+	/** Scale a rect in bands on the thread pool */
+	void scaleBands(const uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr,
+	                uint32 dstPitch, int width, int height, int x, int y);
+
+	Common::ThreadPool *_threadPool;
+	Common::Array<BandTask *> _bandTasks;
 };
 
 /**
@@ -199,6 +230,25 @@ public:
 	 */
 	virtual bool useOldSource() const { return false; }
 
+	/**
+	 * Whether a Scaler instance can scale several parts of the same
+	 * surface at once. Scalers which keep state between pixels or calls
+	 * must return false. The rows read around each part, as given by
+	 * extraPixels(), are only read, so they may overlap.
+	 *
+	 * @see Scaler::setThreadPool
+	 */
+	virtual bool isThreadSafe() const { return false; }
+
+	/**
+	 * Whether scaling by more than 1x is slow enough for spreading it over
+	 * worker threads to pay for them. Only meaningful for thread-safe
+	 * scalers; cheap ones are better off on the calling thread.
+	 *
+	 * @see isThreadSafe
+	 */
+	virtual bool isExpensive() const { return false; }
+
 protected:
 	Common::Array<uint> _factors;
 };
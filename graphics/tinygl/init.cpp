@@ -354,9 +354,7 @@ void GLContext::init(int screenW, int screenH, Graphics::PixelFormat pixelFormat
 	// color mask
 	color_mask_red = color_mask_green = color_mask_blue = color_mask_alpha = true;
 
-	_currentAllocatorIndex = 0;
-	_drawCallAllocator[0].initialize(drawCallMemorySize);
-	_drawCallAllocator[1].initialize(drawCallMemorySize);
+	_drawCallAllocator = new Common::FrameAllocator(drawCallMemorySize);
 	_debugRectsEnabled = false;
 	_profilingEnabled = false;
 }
@@ -372,6 +370,7 @@ void GLContext::deinit() {
 	endSharedState();
 	gl_free(vertex);
 	delete fb;
+	delete _drawCallAllocator;
 }
 
 } // end of namespace TinyGL
@@ -245,8 +245,7 @@ void GLContext::presentBufferDirtyRects(Common::List<Common::Rect> &dirtyAreas)
 
 	disposeResources();
 
-	_currentAllocatorIndex = (_currentAllocatorIndex + 1) & 0x1;
-	_drawCallAllocator[_currentAllocatorIndex].reset();
+	_drawCallAllocator->nextFrame();
 }
 
 void GLContext::presentBufferSimple(Common::List<Common::Rect> &dirtyAreas) {
@@ -261,7 +260,7 @@ void GLContext::presentBufferSimple(Common::List<Common::Rect> &dirtyAreas) {
 
 	disposeResources();
 
-	_drawCallAllocator[_currentAllocatorIndex].reset();
+	_drawCallAllocator->getArena().reset();
 }
 
 void presentBuffer(Common::List<Common::Rect> &dirtyAreas) {
@@ -817,7 +816,7 @@ bool RasterizationDrawCall::RasterizationState::operator==(const RasterizationSt
 
 void *Internal::allocateFrame(int size) {
 	GLContext *c = gl_get_context();
-	return c->_drawCallAllocator[c->_currentAllocatorIndex].allocate(size);
+	return c->_drawCallAllocator->allocate(size);
 }
 
 } // end of namespace TinyGL
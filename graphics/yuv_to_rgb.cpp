@@ -82,8 +82,10 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/system.h"
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
+#include "graphics/yuv_to_rgb_intern.h"
 
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
@@ -91,6 +93,28 @@ DECLARE_SINGLETON(Graphics::YUVToRGBManager);
 
 namespace Graphics {
 
+const YUVToRGBKernels *getYUVToRGBKernels() {
+	const YUVToRGBKernels *kernels = nullptr;
+
+	if (!g_system)
+		return nullptr;
+
+#ifdef SCUMMVM_NEON
+	if (g_system->hasFeature(OSystem::kFeatureCpuNEON))
+		kernels = &g_yuvToRGBKernelsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+	if (g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+		kernels = &g_yuvToRGBKernelsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+	if (g_system->hasFeature(OSystem::kFeatureCpuAVX2))
+		kernels = &g_yuvToRGBKernelsAVX2;
+#endif
+
+	return kernels;
+}
+
 class YUVToRGBLookup {
 public:
 	YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::LuminanceScale scale);
@@ -99,15 +123,20 @@ public:
 	YUVToRGBManager::LuminanceScale getScale() const { return _scale; }
 	const int16 *getColorTable() const { return _colorTab; }
 	const byte *getClipTable() const { return _clipTable; }
+	const YUVToRGBKernels *getKernels() const { return _kernels; }
+	const YUVToRGBRowParams &getRowParams() const { return _rowParams; }
 
 private:
 	Graphics::PixelFormat _format;
 	YUVToRGBManager::LuminanceScale _scale;
+	const YUVToRGBKernels *_kernels;
+	YUVToRGBRowParams _rowParams;
 	int16 _colorTab[4 * 256]; // 2048 bytes
 	byte _clipTable[3 * 768];
 };
 
-YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::LuminanceScale scale) {
+YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::LuminanceScale scale) :
+	_kernels(getYUVToRGBKernels()), _rowParams(format, scale) {
 	_format = format;
 	_scale = scale;
 
@@ -215,9 +244,20 @@ void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const byte g_shift = lookup->getFormat().gShift;
 	const byte b_shift = lookup->getFormat().bShift;
 	const PixelInt a_mask = (0xFF >> lookup->getFormat().aLoss) << lookup->getFormat().aShift;
+	const YUVToRGBKernels *kernels = lookup->getKernels();
 
 	for (int h = 0; h < yHeight; h++) {
-		for (int w = 0; w < yWidth; w++) {
+		// Let the SIMD kernels do most of the row, and finish it here
+		int w = 0;
+		if (kernels) {
+			w = kernels->convertRow444(dstPtr, ySrc, uSrc, vSrc, yWidth, lookup->getRowParams());
+			dstPtr += w * sizeof(PixelInt);
+			ySrc += w;
+			uSrc += w;
+			vSrc += w;
+		}
+
+		for (; w < yWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -268,9 +308,20 @@ void convertYUV422ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const byte g_shift = lookup->getFormat().gShift;
 	const byte b_shift = lookup->getFormat().bShift;
 	const PixelInt a_mask = (0xFF >> lookup->getFormat().aLoss) << lookup->getFormat().aShift;
+	const YUVToRGBKernels *kernels = lookup->getKernels();
 
 	for (int h = 0; h < yHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		int w = 0;
+		if (kernels) {
+			const int converted = kernels->convertRow422(dstPtr, ySrc, uSrc, vSrc, yWidth, lookup->getRowParams());
+			dstPtr += converted * sizeof(PixelInt);
+			ySrc += converted;
+			w = converted >> 1;
+			uSrc += w;
+			vSrc += w;
+		}
+
+		for (; w < halfWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -326,9 +377,22 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const byte g_shift = lookup->getFormat().gShift;
 	const byte b_shift = lookup->getFormat().bShift;
 	const PixelInt a_mask = (0xFF >> lookup->getFormat().aLoss) << lookup->getFormat().aShift;
+	const YUVToRGBKernels *kernels = lookup->getKernels();
 
 	for (int h = 0; h < halfHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		int w = 0;
+		if (kernels) {
+			// Both rows share the chroma samples, like a 4:2:2 row
+			const int converted = kernels->convertRow422(dstPtr, ySrc, uSrc, vSrc, yWidth, lookup->getRowParams());
+			kernels->convertRow422(dstPtr + dstPitch, ySrc + yPitch, uSrc, vSrc, yWidth, lookup->getRowParams());
+			dstPtr += converted * sizeof(PixelInt);
+			ySrc += converted;
+			w = converted >> 1;
+			uSrc += w;
+			vSrc += w;
+		}
+
+		for (; w < halfWidth; w++) {
 			const byte *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
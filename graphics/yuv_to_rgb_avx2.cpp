@@ -0,0 +1,169 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/yuv_to_rgb_intern.h"
+
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Graphics {
+
+/** Chroma terms of 16 pixels, see YUVToRGBLookup. */
+struct ChromaAVX2 {
+	__m256i r, g, b;
+};
+
+/** Apply the sign of c (0 or -1 in sign) to the unsigned term. */
+static FORCEINLINE __m256i avx2_applySign(__m256i term, __m256i sign) {
+	return _mm256_sub_epi16(_mm256_xor_si256(term, sign), sign);
+}
+
+static FORCEINLINE ChromaAVX2 avx2_chroma(__m256i u, __m256i v) {
+	const __m256i bias = _mm256_set1_epi16(128);
+	const __m256i cb = _mm256_sub_epi16(u, bias);
+	const __m256i cr = _mm256_sub_epi16(v, bias);
+	const __m256i cbSign = _mm256_srai_epi16(cb, 15);
+	const __m256i crSign = _mm256_srai_epi16(cr, 15);
+	const __m256i cbAbs = _mm256_abs_epi16(cb);
+	const __m256i crAbs = _mm256_abs_epi16(cr);
+
+	ChromaAVX2 chroma;
+	chroma.r = avx2_applySign(_mm256_add_epi16(crAbs, _mm256_mulhi_epu16(crAbs, _mm256_set1_epi16((int16)kYUVCrRMul))), crSign);
+	chroma.b = avx2_applySign(_mm256_add_epi16(cbAbs, _mm256_mulhi_epu16(cbAbs, _mm256_set1_epi16((int16)kYUVCbBMul))), cbSign);
+
+	// The green terms have the opposite sign
+	const __m256i crG = avx2_applySign(_mm256_mulhi_epu16(crAbs, _mm256_set1_epi16((int16)kYUVCrGMul)), _mm256_xor_si256(crSign, _mm256_set1_epi16(-1)));
+	const __m256i cbG = avx2_applySign(_mm256_mulhi_epu16(cbAbs, _mm256_set1_epi16((int16)kYUVCbGMul)), _mm256_xor_si256(cbSign, _mm256_set1_epi16(-1)));
+	chroma.g = _mm256_add_epi16(crG, cbG);
+	return chroma;
+}
+
+/** Clip a color component like the clip table, and reduce it to the format. */
+static FORCEINLINE __m256i avx2_component(__m256i val, __m128i loss, bool itu) {
+	if (itu) {
+		val = _mm256_sub_epi16(_mm256_min_epi16(_mm256_max_epi16(val, _mm256_set1_epi16(16)), _mm256_set1_epi16(235)), _mm256_set1_epi16(16));
+		val = _mm256_add_epi16(val, _mm256_mulhi_epu16(val, _mm256_set1_epi16((int16)kYUVITUScaleMul)));
+	} else {
+		val = _mm256_min_epi16(_mm256_max_epi16(val, _mm256_setzero_si256()), _mm256_set1_epi16(255));
+	}
+	return _mm256_srl_epi16(val, loss);
+}
+
+/** Convert and store 16 pixels, held in order in the 16-bit lanes. */
+template<typename PixelInt, bool itu>
+static FORCEINLINE void avx2_putPixels(byte *dst, __m256i y, const ChromaAVX2 &chroma, const YUVToRGBRowParams &params) {
+	const __m256i r = avx2_component(_mm256_add_epi16(y, chroma.r), _mm_cvtsi32_si128(params.rLoss), itu);
+	const __m256i g = avx2_component(_mm256_add_epi16(y, chroma.g), _mm_cvtsi32_si128(params.gLoss), itu);
+	const __m256i b = avx2_component(_mm256_add_epi16(y, chroma.b), _mm_cvtsi32_si128(params.bLoss), itu);
+
+	const __m128i rShift = _mm_cvtsi32_si128(params.rShift);
+	const __m128i gShift = _mm_cvtsi32_si128(params.gShift);
+	const __m128i bShift = _mm_cvtsi32_si128(params.bShift);
+
+	if (sizeof(PixelInt) == 2) {
+		__m256i pixels = _mm256_set1_epi16((int16)params.aMask);
+		pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(r, rShift));
+		pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(g, gShift));
+		pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(b, bShift));
+		_mm256_storeu_si256((__m256i *)dst, pixels);
+	} else {
+		// Widening the halves separately keeps the pixel order
+		const __m256i alpha = _mm256_set1_epi32(params.aMask);
+		__m256i lo = alpha, hi = alpha;
+		lo = _mm256_or_si256(lo, _mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(r)), rShift));
+		hi = _mm256_or_si256(hi, _mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(r, 1)), rShift));
+		lo = _mm256_or_si256(lo, _mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(g)), gShift));
+		hi = _mm256_or_si256(hi, _mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(g, 1)), gShift));
+		lo = _mm256_or_si256(lo, _mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(b)), bShift));
+		hi = _mm256_or_si256(hi, _mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(b, 1)), bShift));
+		_mm256_storeu_si256((__m256i *)dst, lo);
+		_mm256_storeu_si256((__m256i *)(dst + 32), hi);
+	}
+}
+
+template<typename PixelInt, bool itu>
+static int convertRow444(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(ySrc + x)));
+		const __m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(uSrc + x)));
+		const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(vSrc + x)));
+
+		avx2_putPixels<PixelInt, itu>(dst + x * sizeof(PixelInt), y, avx2_chroma(u, v), params);
+	}
+
+	return x;
+}
+
+/** Load 8 chroma samples, each one duplicated to two 16-bit lanes. */
+static FORCEINLINE __m256i avx2_loadChroma422(const byte *src) {
+	const __m256i val = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)src));
+	return _mm256_or_si256(val, _mm256_slli_epi32(val, 16));
+}
+
+template<typename PixelInt, bool itu>
+static int convertRow422(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(ySrc + x)));
+		const __m256i u = avx2_loadChroma422(uSrc + x / 2);
+		const __m256i v = avx2_loadChroma422(vSrc + x / 2);
+
+		avx2_putPixels<PixelInt, itu>(dst + x * sizeof(PixelInt), y, avx2_chroma(u, v), params);
+	}
+
+	return x;
+}
+
+static int convertRow444AVX2(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	if (params.bytesPerPixel == 2)
+		return params.itu ? convertRow444<uint16, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow444<uint16, false>(dst, ySrc, uSrc, vSrc, width, params);
+	else
+		return params.itu ? convertRow444<uint32, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow444<uint32, false>(dst, ySrc, uSrc, vSrc, width, params);
+}
+
+static int convertRow422AVX2(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	if (params.bytesPerPixel == 2)
+		return params.itu ? convertRow422<uint16, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow422<uint16, false>(dst, ySrc, uSrc, vSrc, width, params);
+	else
+		return params.itu ? convertRow422<uint32, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow422<uint32, false>(dst, ySrc, uSrc, vSrc, width, params);
+}
+
+const YUVToRGBKernels g_yuvToRGBKernelsAVX2 = {
+	convertRow444AVX2,
+	convertRow422AVX2
+};
+
+} // End of namespace Graphics
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
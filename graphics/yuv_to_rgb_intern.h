@@ -0,0 +1,98 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHICS_YUV_TO_RGB_INTERN_H
+#define GRAPHICS_YUV_TO_RGB_INTERN_H
+
+#include "common/scummsys.h"
+
+#include "graphics/pixelformat.h"
+#include "graphics/yuv_to_rgb.h"
+
+namespace Graphics {
+
+/**
+ * Target pixel format of the YUV to RGB row kernels.
+ */
+struct YUVToRGBRowParams {
+	int bytesPerPixel;
+	bool itu;
+	byte rLoss, gLoss, bLoss;
+	byte rShift, gShift, bShift;
+	uint32 aMask;
+
+	YUVToRGBRowParams(const PixelFormat &format, YUVToRGBManager::LuminanceScale scale) :
+		bytesPerPixel(format.bytesPerPixel), itu(scale == YUVToRGBManager::kScaleITU),
+		rLoss(format.rLoss), gLoss(format.gLoss), bLoss(format.bLoss),
+		rShift(format.rShift), gShift(format.gShift), bShift(format.bShift),
+		aMask((0xFF >> format.aLoss) << format.aShift) {}
+};
+
+/**
+ * Fixed-point versions of the lookup tables built by YUVToRGBLookup.
+ *
+ * With a = |c| for a chroma value c = u - 128 or v - 128, each chroma term
+ * of the tables is sign(c) * (a * kMulBase + ((a * kMul) >> 16)), with the
+ * sign flipped for the green terms. The ITU luminance scale maps x in
+ * [0, 219] to x + ((x * kITUScaleMul) >> 16). These were checked to give
+ * exactly the table values for every input.
+ */
+enum {
+	kYUVCrRMul = 26266,    // a + (a * kYUVCrRMul >> 16) = trunc(a * 0.419 / 0.299)
+	kYUVCrGMul = 46773,    // (a * kYUVCrGMul >> 16) = trunc(a * 0.299 / 0.419)
+	kYUVCbGMul = 22567,    // (a * kYUVCbGMul >> 16) = trunc(a * 0.114 / 0.331)
+	kYUVCbBMul = 50684,    // a + (a * kYUVCbBMul >> 16) = trunc(a * 0.587 / 0.331)
+	kYUVITUScaleMul = 10776 // x + (x * kYUVITUScaleMul >> 16) = x * 255 / 219
+};
+
+/**
+ * Row kernels converting YUV pixels to RGB.
+ *
+ * They must give exactly the same results as the lookup tables. They only
+ * convert a multiple of their block size, and return the number of pixels
+ * converted; the rest of the row is left to the table code.
+ */
+struct YUVToRGBKernels {
+	/** One chroma sample per pixel. */
+	int (*convertRow444)(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params);
+	/** One chroma sample per two pixels; the converted pixel count is even. */
+	int (*convertRow422)(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params);
+};
+
+/**
+ * Return the fastest kernels supported by the CPU, or nullptr if none of
+ * them is better than the table code.
+ */
+const YUVToRGBKernels *getYUVToRGBKernels();
+
+#ifdef SCUMMVM_NEON
+extern const YUVToRGBKernels g_yuvToRGBKernelsNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+extern const YUVToRGBKernels g_yuvToRGBKernelsSSE2;
+#endif
+#ifdef SCUMMVM_AVX2
+extern const YUVToRGBKernels g_yuvToRGBKernelsAVX2;
+#endif
+
+} // End of namespace Graphics
+
+#endif
@@ -0,0 +1,184 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#ifdef SCUMMVM_NEON
+
+#include "graphics/yuv_to_rgb_intern.h"
+
+#include <arm_neon.h>
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("neon"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("fpu=neon")
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+namespace Graphics {
+
+/** Chroma terms of 8 pixels, see YUVToRGBLookup. */
+struct ChromaNEON {
+	int16x8_t r, g, b;
+};
+
+/** Unsigned (a * mul) >> 16 of each lane. */
+static FORCEINLINE int16x8_t neon_mulhi(int16x8_t a, uint16 mul) {
+	const uint16x8_t val = vreinterpretq_u16_s16(a);
+	const uint16x4_t lo = vshrn_n_u32(vmull_n_u16(vget_low_u16(val), mul), 16);
+	const uint16x4_t hi = vshrn_n_u32(vmull_n_u16(vget_high_u16(val), mul), 16);
+	return vreinterpretq_s16_u16(vcombine_u16(lo, hi));
+}
+
+/** Apply the sign of c (0 or -1 in sign) to the unsigned term. */
+static FORCEINLINE int16x8_t neon_applySign(int16x8_t term, int16x8_t sign) {
+	return vsubq_s16(veorq_s16(term, sign), sign);
+}
+
+static FORCEINLINE ChromaNEON neon_chroma(uint8x8_t u, uint8x8_t v) {
+	const int16x8_t cb = vreinterpretq_s16_u16(vsubl_u8(u, vdup_n_u8(128)));
+	const int16x8_t cr = vreinterpretq_s16_u16(vsubl_u8(v, vdup_n_u8(128)));
+	const int16x8_t cbSign = vshrq_n_s16(cb, 15);
+	const int16x8_t crSign = vshrq_n_s16(cr, 15);
+	const int16x8_t cbAbs = vabsq_s16(cb);
+	const int16x8_t crAbs = vabsq_s16(cr);
+
+	ChromaNEON chroma;
+	chroma.r = neon_applySign(vaddq_s16(crAbs, neon_mulhi(crAbs, kYUVCrRMul)), crSign);
+	chroma.b = neon_applySign(vaddq_s16(cbAbs, neon_mulhi(cbAbs, kYUVCbBMul)), cbSign);
+
+	// The green terms have the opposite sign
+	const int16x8_t crG = neon_applySign(neon_mulhi(crAbs, kYUVCrGMul), vmvnq_s16(crSign));
+	const int16x8_t cbG = neon_applySign(neon_mulhi(cbAbs, kYUVCbGMul), vmvnq_s16(cbSign));
+	chroma.g = vaddq_s16(crG, cbG);
+	return chroma;
+}
+
+/** Clip a color component like the clip table, and reduce it to the format. */
+static FORCEINLINE uint16x8_t neon_component(int16x8_t val, byte loss, bool itu) {
+	if (itu) {
+		val = vsubq_s16(vminq_s16(vmaxq_s16(val, vdupq_n_s16(16)), vdupq_n_s16(235)), vdupq_n_s16(16));
+		val = vaddq_s16(val, neon_mulhi(val, kYUVITUScaleMul));
+	} else {
+		val = vminq_s16(vmaxq_s16(val, vdupq_n_s16(0)), vdupq_n_s16(255));
+	}
+	return vshlq_u16(vreinterpretq_u16_s16(val), vdupq_n_s16(-loss));
+}
+
+/** Shift the low or high half of a component into place in 32-bit lanes. */
+static FORCEINLINE uint32x4_t neon_widen(uint16x4_t val, byte shift) {
+	return vshlq_u32(vmovl_u16(val), vdupq_n_s32(shift));
+}
+
+/** Convert and store 8 pixels. */
+template<typename PixelInt, bool itu>
+static FORCEINLINE void neon_putPixels(byte *dst, uint8x8_t y8, int16x8_t r, int16x8_t g, int16x8_t b, const YUVToRGBRowParams &params) {
+	const int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(y8));
+	const uint16x8_t rVal = neon_component(vaddq_s16(y, r), params.rLoss, itu);
+	const uint16x8_t gVal = neon_component(vaddq_s16(y, g), params.gLoss, itu);
+	const uint16x8_t bVal = neon_component(vaddq_s16(y, b), params.bLoss, itu);
+
+	if (sizeof(PixelInt) == 2) {
+		uint16x8_t pixels = vdupq_n_u16((uint16)params.aMask);
+		pixels = vorrq_u16(pixels, vshlq_u16(rVal, vdupq_n_s16(params.rShift)));
+		pixels = vorrq_u16(pixels, vshlq_u16(gVal, vdupq_n_s16(params.gShift)));
+		pixels = vorrq_u16(pixels, vshlq_u16(bVal, vdupq_n_s16(params.bShift)));
+		vst1q_u16((uint16 *)dst, pixels);
+	} else {
+		const uint32x4_t alpha = vdupq_n_u32(params.aMask);
+		uint32x4_t lo = alpha, hi = alpha;
+		lo = vorrq_u32(lo, neon_widen(vget_low_u16(rVal), params.rShift));
+		hi = vorrq_u32(hi, neon_widen(vget_high_u16(rVal), params.rShift));
+		lo = vorrq_u32(lo, neon_widen(vget_low_u16(gVal), params.gShift));
+		hi = vorrq_u32(hi, neon_widen(vget_high_u16(gVal), params.gShift));
+		lo = vorrq_u32(lo, neon_widen(vget_low_u16(bVal), params.bShift));
+		hi = vorrq_u32(hi, neon_widen(vget_high_u16(bVal), params.bShift));
+		vst1q_u32((uint32 *)dst, lo);
+		vst1q_u32((uint32 *)(dst + 16), hi);
+	}
+}
+
+template<typename PixelInt, bool itu>
+static int convertRow444(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		const ChromaNEON chroma = neon_chroma(vld1_u8(uSrc + x), vld1_u8(vSrc + x));
+		neon_putPixels<PixelInt, itu>(dst + x * sizeof(PixelInt), vld1_u8(ySrc + x), chroma.r, chroma.g, chroma.b, params);
+	}
+
+	return x;
+}
+
+template<typename PixelInt, bool itu>
+static int convertRow422(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		const uint8x16_t y = vld1q_u8(ySrc + x);
+
+		// Each chroma term is used for two pixels
+		const ChromaNEON chroma = neon_chroma(vld1_u8(uSrc + x / 2), vld1_u8(vSrc + x / 2));
+		const int16x8x2_t r = vzipq_s16(chroma.r, chroma.r);
+		const int16x8x2_t g = vzipq_s16(chroma.g, chroma.g);
+		const int16x8x2_t b = vzipq_s16(chroma.b, chroma.b);
+		neon_putPixels<PixelInt, itu>(dst + x * sizeof(PixelInt), vget_low_u8(y), r.val[0], g.val[0], b.val[0], params);
+		neon_putPixels<PixelInt, itu>(dst + (x + 8) * sizeof(PixelInt), vget_high_u8(y), r.val[1], g.val[1], b.val[1], params);
+	}
+
+	return x;
+}
+
+static int convertRow444NEON(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	if (params.bytesPerPixel == 2)
+		return params.itu ? convertRow444<uint16, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow444<uint16, false>(dst, ySrc, uSrc, vSrc, width, params);
+	else
+		return params.itu ? convertRow444<uint32, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow444<uint32, false>(dst, ySrc, uSrc, vSrc, width, params);
+}
+
+static int convertRow422NEON(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	if (params.bytesPerPixel == 2)
+		return params.itu ? convertRow422<uint16, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow422<uint16, false>(dst, ySrc, uSrc, vSrc, width, params);
+	else
+		return params.itu ? convertRow422<uint32, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow422<uint32, false>(dst, ySrc, uSrc, vSrc, width, params);
+}
+
+const YUVToRGBKernels g_yuvToRGBKernelsNEON = {
+	convertRow444NEON,
+	convertRow422NEON
+};
+
+} // End of namespace Graphics
+
+#if !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__aarch64__) && !defined(__ARM_NEON)
+
+#endif // SCUMMVM_NEON
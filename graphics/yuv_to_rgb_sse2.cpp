@@ -0,0 +1,181 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "common/scummsys.h"
+
+#include "graphics/yuv_to_rgb_intern.h"
+
+#include <emmintrin.h>
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse2"))), apply_to=function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#endif // !defined(__x86_64__)
+
+namespace Graphics {
+
+/** Chroma terms of 8 pixels, see YUVToRGBLookup. */
+struct ChromaSSE2 {
+	__m128i r, g, b;
+};
+
+/** Apply the sign of c (0 or -1 in sign) to the unsigned term. */
+static FORCEINLINE __m128i sse2_applySign(__m128i term, __m128i sign) {
+	return _mm_sub_epi16(_mm_xor_si128(term, sign), sign);
+}
+
+static FORCEINLINE ChromaSSE2 sse2_chroma(__m128i u, __m128i v) {
+	const __m128i bias = _mm_set1_epi16(128);
+	const __m128i cb = _mm_sub_epi16(u, bias);
+	const __m128i cr = _mm_sub_epi16(v, bias);
+	const __m128i cbSign = _mm_srai_epi16(cb, 15);
+	const __m128i crSign = _mm_srai_epi16(cr, 15);
+	const __m128i cbAbs = sse2_applySign(cb, cbSign);
+	const __m128i crAbs = sse2_applySign(cr, crSign);
+
+	ChromaSSE2 chroma;
+	chroma.r = sse2_applySign(_mm_add_epi16(crAbs, _mm_mulhi_epu16(crAbs, _mm_set1_epi16((int16)kYUVCrRMul))), crSign);
+	chroma.b = sse2_applySign(_mm_add_epi16(cbAbs, _mm_mulhi_epu16(cbAbs, _mm_set1_epi16((int16)kYUVCbBMul))), cbSign);
+
+	// The green terms have the opposite sign
+	const __m128i crG = sse2_applySign(_mm_mulhi_epu16(crAbs, _mm_set1_epi16((int16)kYUVCrGMul)), _mm_xor_si128(crSign, _mm_set1_epi16(-1)));
+	const __m128i cbG = sse2_applySign(_mm_mulhi_epu16(cbAbs, _mm_set1_epi16((int16)kYUVCbGMul)), _mm_xor_si128(cbSign, _mm_set1_epi16(-1)));
+	chroma.g = _mm_add_epi16(crG, cbG);
+	return chroma;
+}
+
+/** Clip a color component like the clip table, and reduce it to the format. */
+static FORCEINLINE __m128i sse2_component(__m128i val, __m128i loss, bool itu) {
+	if (itu) {
+		val = _mm_sub_epi16(_mm_min_epi16(_mm_max_epi16(val, _mm_set1_epi16(16)), _mm_set1_epi16(235)), _mm_set1_epi16(16));
+		val = _mm_add_epi16(val, _mm_mulhi_epu16(val, _mm_set1_epi16((int16)kYUVITUScaleMul)));
+	} else {
+		val = _mm_min_epi16(_mm_max_epi16(val, _mm_setzero_si128()), _mm_set1_epi16(255));
+	}
+	return _mm_srl_epi16(val, loss);
+}
+
+/** Convert and store 8 pixels. */
+template<typename PixelInt, bool itu>
+static FORCEINLINE void sse2_putPixels(byte *dst, __m128i y, __m128i r, __m128i g, __m128i b, const YUVToRGBRowParams &params) {
+	r = sse2_component(_mm_add_epi16(y, r), _mm_cvtsi32_si128(params.rLoss), itu);
+	g = sse2_component(_mm_add_epi16(y, g), _mm_cvtsi32_si128(params.gLoss), itu);
+	b = sse2_component(_mm_add_epi16(y, b), _mm_cvtsi32_si128(params.bLoss), itu);
+
+	const __m128i rShift = _mm_cvtsi32_si128(params.rShift);
+	const __m128i gShift = _mm_cvtsi32_si128(params.gShift);
+	const __m128i bShift = _mm_cvtsi32_si128(params.bShift);
+
+	if (sizeof(PixelInt) == 2) {
+		__m128i pixels = _mm_set1_epi16((int16)params.aMask);
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(r, rShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(g, gShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(b, bShift));
+		_mm_storeu_si128((__m128i *)dst, pixels);
+	} else {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alpha = _mm_set1_epi32(params.aMask);
+		__m128i lo = alpha, hi = alpha;
+		lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_unpacklo_epi16(r, zero), rShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_unpackhi_epi16(r, zero), rShift));
+		lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_unpacklo_epi16(g, zero), gShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_unpackhi_epi16(g, zero), gShift));
+		lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_unpacklo_epi16(b, zero), bShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_unpackhi_epi16(b, zero), bShift));
+		_mm_storeu_si128((__m128i *)dst, lo);
+		_mm_storeu_si128((__m128i *)(dst + 16), hi);
+	}
+}
+
+template<typename PixelInt, bool itu>
+static int convertRow444(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	const __m128i zero = _mm_setzero_si128();
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(ySrc + x)), zero);
+		const __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(uSrc + x)), zero);
+		const __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(vSrc + x)), zero);
+
+		const ChromaSSE2 chroma = sse2_chroma(u, v);
+		sse2_putPixels<PixelInt, itu>(dst + x * sizeof(PixelInt), y, chroma.r, chroma.g, chroma.b, params);
+	}
+
+	return x;
+}
+
+template<typename PixelInt, bool itu>
+static int convertRow422(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	const __m128i zero = _mm_setzero_si128();
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		const __m128i y = _mm_loadu_si128((const __m128i *)(ySrc + x));
+		const __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(uSrc + x / 2)), zero);
+		const __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(vSrc + x / 2)), zero);
+
+		// Each chroma term is used for two pixels
+		const ChromaSSE2 chroma = sse2_chroma(u, v);
+		sse2_putPixels<PixelInt, itu>(dst + x * sizeof(PixelInt), _mm_unpacklo_epi8(y, zero),
+			_mm_unpacklo_epi16(chroma.r, chroma.r), _mm_unpacklo_epi16(chroma.g, chroma.g), _mm_unpacklo_epi16(chroma.b, chroma.b), params);
+		sse2_putPixels<PixelInt, itu>(dst + (x + 8) * sizeof(PixelInt), _mm_unpackhi_epi8(y, zero),
+			_mm_unpackhi_epi16(chroma.r, chroma.r), _mm_unpackhi_epi16(chroma.g, chroma.g), _mm_unpackhi_epi16(chroma.b, chroma.b), params);
+	}
+
+	return x;
+}
+
+static int convertRow444SSE2(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	if (params.bytesPerPixel == 2)
+		return params.itu ? convertRow444<uint16, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow444<uint16, false>(dst, ySrc, uSrc, vSrc, width, params);
+	else
+		return params.itu ? convertRow444<uint32, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow444<uint32, false>(dst, ySrc, uSrc, vSrc, width, params);
+}
+
+static int convertRow422SSE2(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowParams &params) {
+	if (params.bytesPerPixel == 2)
+		return params.itu ? convertRow422<uint16, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow422<uint16, false>(dst, ySrc, uSrc, vSrc, width, params);
+	else
+		return params.itu ? convertRow422<uint32, true>(dst, ySrc, uSrc, vSrc, width, params) : convertRow422<uint32, false>(dst, ySrc, uSrc, vSrc, width, params);
+}
+
+const YUVToRGBKernels g_yuvToRGBKernelsSSE2 = {
+	convertRow444SSE2,
+	convertRow422SSE2
+};
+
+} // End of namespace Graphics
+
+#if !defined(__x86_64__)
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // !defined(__x86_64__)
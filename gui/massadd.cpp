@@ -25,6 +25,7 @@
 #include "common/debug.h"
 #include "common/system.h"
 #include "common/taskbar.h"
+#include "common/threadpool.h"
 #include "common/translation.h"
 
 #include "engines/advancedDetector.h"
@@ -49,15 +50,71 @@ enum {
 	kMaxScanTime = 50
 };
 
+enum {
+	// Number of worker threads listing directories and hashing files.
+	// They mostly wait for the disk or the network, so this does not
+	// depend on the number of CPU cores.
+	kScanThreads = 8,
+
+	// Number of directories which may be listed ahead of detection
+	kScanQueueSize = 32
+};
+
 enum {
 	kOkCmd = 'OK  ',
 	kCancelCmd = 'CNCL'
 };
 
+/**
+ * Lists a directory and hashes the files engines will look at, so that
+ * detection finds their MD5 in the persistent cache.
+ */
+class MassAddScanTask : public Common::Task {
+public:
+	MassAddScanTask(const Common::FSNode &dir, const MassAddDialog::MD5FileNameMap &md5FileNames, const std::atomic<bool> &cancelled)
+		: _dir(dir), _md5FileNames(md5FileNames), _cancelled(cancelled), _listed(false) {}
+
+	void run() override {
+		if (_cancelled.load(std::memory_order_relaxed))
+			return;
+
+		_listed = _dir.getChildren(_files, Common::FSNode::kListAll);
+		if (!_listed)
+			return;
+
+		for (const auto &file : _files) {
+			if (_cancelled.load(std::memory_order_relaxed))
+				return;
 
+			if (file.isDirectory())
+				continue;
+
+			MassAddDialog::MD5FileNameMap::const_iterator it = _md5FileNames.find(file.getName());
+			if (it == _md5FileNames.end())
+				continue;
+
+			for (uint md5Bytes : it->_value)
+				ADCacheMan.prefetchMD5(file, md5Bytes);
+		}
+	}
+
+	const Common::FSNode &getDir() const { return _dir; }
+	const Common::FSList &getFiles() const { return _files; }
+	bool isListed() const { return _listed; }
+
+private:
+	Common::FSNode _dir;
+	Common::FSList _files;
+	const MassAddDialog::MD5FileNameMap &_md5FileNames;
+	const std::atomic<bool> &_cancelled;
+	bool _listed;
+};
 
 MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	: Dialog("MassAdd"),
+	_scanPool(nullptr),
+	_scanQueueSize(1),
+	_scanCancelled(false),
 	_dirsScanned(0),
 	_oldGamesCount(0),
 	_dirTotal(0),
@@ -107,6 +164,45 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 			_pathToTargets[path].push_back(iter->_key);
 		}
 	}
+
+	// Collect the files hashed during detection, so that the workers can
+	// hash them ahead of time
+	const PluginList &plugins = EngineMan.getPlugins(PLUGIN_TYPE_ENGINE_DETECTION);
+	for (const auto &plugin : plugins) {
+		const MetaEngineDetection &metaEngine = plugin->get<MetaEngineDetection>();
+		const uint md5Bytes = metaEngine.getMD5Bytes();
+		if (!md5Bytes)
+			continue;
+
+		Common::StringArray fileNames;
+		metaEngine.getMD5FileNames(fileNames);
+		for (const auto &name : fileNames) {
+			Common::Array<uint> &sizes = _md5FileNames[name];
+			if (Common::find(sizes.begin(), sizes.end(), md5Bytes) == sizes.end())
+				sizes.push_back(md5Bytes);
+		}
+	}
+
+	// Locating the cache needs the config manager, so load it here
+	// rather than from the workers
+	ADCacheMan.preloadPersistentCache();
+
+	_scanPool = new Common::ThreadPool(kScanThreads);
+
+	// Without worker threads, every directory is listed right when it is
+	// queued, so only queue one at a time to keep the GUI responsive
+	if (_scanPool->isAsync())
+		_scanQueueSize = kScanQueueSize;
+}
+
+MassAddDialog::~MassAddDialog() {
+	// Wait for the workers before deleting their tasks. The queued scans
+	// return right away, and the running ones stop at their next file.
+	_scanCancelled.store(true, std::memory_order_relaxed);
+	delete _scanPool;
+
+	while (!_scanQueue.empty())
+		delete _scanQueue.pop();
 }
 
 struct GameTargetLess {
@@ -157,6 +253,7 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 		close();
 	} else if (cmd == kCancelCmd) {
 		// User cancelled, so we don't do anything and just leave.
+		_scanCancelled.store(true, std::memory_order_relaxed);
 		_games.clear();
 		close();
 	} else if (cmd == kListSelectionChangedCmd) {
@@ -183,100 +280,113 @@ void MassAddDialog::updateGameList() {
 	}
 }
 
-void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
-		return;	// We have finished scanning
-
-	uint32 t = g_system->getMillis();
+void MassAddDialog::fillScanQueue() {
+	while (_scanQueue.size() < (int)_scanQueueSize && !_scanStack.empty()) {
+		MassAddScanTask *task = new MassAddScanTask(_scanStack.pop(), _md5FileNames, _scanCancelled);
+		_scanQueue.push(task);
+		_scanPool->submit(task);
+	}
+}
 
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
+void MassAddDialog::scanDirectory(const Common::FSNode &dir, const Common::FSList &files) {
+	// Run the detector on the dir
+	DetectionResults detectionResults = EngineMan.detectGames(files, (ADGF_WARNING | ADGF_UNSUPPORTED | ADGF_ADDON), true);
 
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-			continue;
-		}
-
-		// Run the detector on the dir
-		DetectionResults detectionResults = EngineMan.detectGames(files, (ADGF_WARNING | ADGF_UNSUPPORTED | ADGF_ADDON), true);
+	if (detectionResults.foundUnknownGames()) {
+		Common::U32String report = detectionResults.generateUnknownGameReport(false, 80);
+		g_system->logMessage(LogMessageType::kInfo, report.encode().c_str());
+	}
 
-		if (detectionResults.foundUnknownGames()) {
-			Common::U32String report = detectionResults.generateUnknownGameReport(false, 80);
-			g_system->logMessage(LogMessageType::kInfo, report.encode().c_str());
-		}
+	// Just add all detected games / game variants. If we get more than one,
+	// that either means the directory contains multiple games, or the detector
+	// could not fully determine which game variant it was seeing. In either
+	// case, let the user choose which entries he wants to keep.
+	//
+	// However, we only add games which are not already in the config file.
+	DetectedGames candidates = detectionResults.listRecognizedGames();
+	for (const auto &cand : candidates) {
+		const DetectedGame &result = cand;
+
+		Common::Path path = dir.getPath();
+		path.removeTrailingSeparators();
 
-		// Just add all detected games / game variants. If we get more than one,
-		// that either means the directory contains multiple games, or the detector
-		// could not fully determine which game variant it was seeing. In either
-		// case, let the user choose which entries he wants to keep.
-		//
-		// However, we only add games which are not already in the config file.
-		DetectedGames candidates = detectionResults.listRecognizedGames();
-		for (const auto &cand : candidates) {
-			const DetectedGame &result = cand;
-
-			Common::Path path = dir.getPath();
-			path.removeTrailingSeparators();
-
-			// Check for existing config entries for this path/engineid/gameid/lang/platform combination
-			if (_pathToTargets.contains(path)) {
-				Common::String resultPlatformCode = Common::getPlatformCode(result.platform);
-				Common::String resultLanguageCode = Common::getLanguageCode(result.language);
-
-				bool duplicate = false;
-				const Common::StringArray &targets = _pathToTargets[path];
-				for (const auto &target : targets) {
-					// If the engineid, gameid, platform and language match -> skip it
-					Common::ConfigManager::Domain *dom = ConfMan.getDomain(target);
-					assert(dom);
-
-					if ((!dom->contains("engineid") || (*dom)["engineid"] == result.engineId) &&
-						(*dom)["gameid"] == result.gameId &&
-					    dom->getValOrDefault("platform") == resultPlatformCode &&
-						parseLanguage(dom->getValOrDefault("language")) == parseLanguage(resultLanguageCode)) {
-						duplicate = true;
-						break;
-					}
-				}
-				if (duplicate) {
-					_oldGamesCount++;
-					continue;	// Skip duplicates
+		// Check for existing config entries for this path/engineid/gameid/lang/platform combination
+		if (_pathToTargets.contains(path)) {
+			Common::String resultPlatformCode = Common::getPlatformCode(result.platform);
+			Common::String resultLanguageCode = Common::getLanguageCode(result.language);
+
+			bool duplicate = false;
+			const Common::StringArray &targets = _pathToTargets[path];
+			for (const auto &target : targets) {
+				// If the engineid, gameid, platform and language match -> skip it
+				Common::ConfigManager::Domain *dom = ConfMan.getDomain(target);
+				assert(dom);
+
+				if ((!dom->contains("engineid") || (*dom)["engineid"] == result.engineId) &&
+					(*dom)["gameid"] == result.gameId &&
+				    dom->getValOrDefault("platform") == resultPlatformCode &&
+					parseLanguage(dom->getValOrDefault("language")) == parseLanguage(resultLanguageCode)) {
+					duplicate = true;
+					break;
 				}
 			}
-			_games.push_back(result);
-
-			_list->append(result.description);
+			if (duplicate) {
+				_oldGamesCount++;
+				continue;	// Skip duplicates
+			}
 		}
+		_games.push_back(result);
 
-		for (DetectedGame &game : _games) {
-			game.isSelected = true;
-		}
+		_list->append(result.description);
+	}
 
-		updateGameList();
+	for (DetectedGame &game : _games) {
+		game.isSelected = true;
+	}
 
-		// Recurse into all subdirs
-		for (const auto &file : files) {
-			if (file.isDirectory()) {
-				_scanStack.push(file);
+	updateGameList();
 
-				_dirTotal++;
-			}
+	// Recurse into all subdirs
+	for (const auto &file : files) {
+		if (file.isDirectory()) {
+			_scanStack.push(file);
+
+			_dirTotal++;
 		}
+	}
 
-		_dirsScanned++;
+	_dirsScanned++;
 
 #if defined(USE_TASKBAR)
-		g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
-		g_system->getTaskbarManager()->setCount(_games.size());
+	g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
+	g_system->getTaskbarManager()->setCount(_games.size());
 #endif
+}
+
+void MassAddDialog::handleTickle() {
+	if (_scanQueue.empty() && _scanStack.empty())
+		return;	// We have finished scanning
+
+	uint32 t = g_system->getMillis();
+
+	// Perform a depth-first scan of the filesystem. The directories are
+	// listed by the worker threads, while detection runs here, in order.
+	fillScanQueue();
+
+	while (!_scanQueue.empty() && _scanQueue.front()->isDone() && (g_system->getMillis() - t) < kMaxScanTime) {
+		MassAddScanTask *task = _scanQueue.pop();
+		if (task->isListed())
+			scanDirectory(task->getDir(), task->getFiles());
+		delete task;
+
+		fillScanQueue();
 	}
 
 
 	// Update the dialog
 	Common::U32String buf;
 
-	if (_scanStack.empty()) {
+	if (_scanQueue.empty() && _scanStack.empty()) {
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
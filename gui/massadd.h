@@ -26,17 +26,29 @@
 #include "gui/widgets/list.h"
 #include "common/fs.h"
 #include "common/hashmap.h"
+#include "common/queue.h"
 #include "common/stack.h"
 #include "common/str.h"
 
+#include <atomic>
+
+namespace Common {
+class ThreadPool;
+}
+
 namespace GUI {
 
 class StaticTextWidget;
 class MassAddListWidget;
+class MassAddScanTask;
 
 class MassAddDialog : public Dialog {
 public:
+	typedef Common::HashMap<Common::String, Common::Array<uint>,
+		Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> MD5FileNameMap;
+
 	MassAddDialog(const Common::FSNode &startDir);
+	~MassAddDialog() override;
 
 	//void open();
 	void handleCommand(CommandSender *sender, uint32 cmd, uint32 data) override;
@@ -49,10 +61,27 @@ public:
 	}
 
 private:
+	/** Directories waiting to be listed */
 	Common::Stack<Common::FSNode>  _scanStack;
 	DetectedGames _games;
 
+	/**
+	 * Directories being listed and hashed by the worker threads, in the order
+	 * their detection results are consumed. Its size is bounded, so that the
+	 * workers do not get too far ahead of detection.
+	 */
+	Common::Queue<MassAddScanTask *> _scanQueue;
+	Common::ThreadPool *_scanPool;
+	uint _scanQueueSize;
+	/** Set when the dialog closes, so that the queued scans stop early */
+	std::atomic<bool> _scanCancelled;
+
+	/** Names of the files engines hash during detection, see getMD5FileNames() */
+	MD5FileNameMap _md5FileNames;
+
 	void updateGameList();
+	void fillScanQueue();
+	void scanDirectory(const Common::FSNode &dir, const Common::FSList &files);
 
 	/**
 	 * Map each path occurring in the config file to the target(s) using that path.
@@ -24,9 +24,11 @@
 #include "image/codecs/dither.h"
 
 #include "common/debug.h"
+#include "common/memstream.h"
 #include "common/stream.h"
 #include "common/system.h"
 #include "common/textconsole.h"
+#include "common/threadpool.h"
 #include "common/util.h"
 
 #include "graphics/surface.h"
@@ -279,12 +281,42 @@ void decodeVectorsTmpl(CinepakFrame &frame, const byte *clipTable, Common::Seeka
 
 } // End of anonymous namespace
 
+/**
+ * Decodes a vector chunk of a strip from a copy of its data. Every strip
+ * has its own codebooks and covers its own rows of the surface, so the
+ * strips of a frame can be decoded at the same time.
+ */
+class CinepakDecoder::StripTask : public Common::Task {
+public:
+	StripTask(CinepakDecoder *decoder, uint16 strip) : _decoder(decoder), _strip(strip), _chunkID(0), _chunkSize(0) {}
+
+	void setChunk(Common::SeekableReadStream &stream, byte chunkID, uint32 chunkSize) {
+		_chunkID = chunkID;
+		_chunkSize = chunkSize;
+		_data.resize(chunkSize);
+		_data.resize(stream.read(_data.data(), chunkSize));
+	}
+
+	void run() override {
+		Common::MemoryReadStream stream(_data.data(), _data.size());
+		_decoder->decodeVectors(stream, _strip, _chunkID, _chunkSize);
+	}
+
+private:
+	CinepakDecoder *_decoder;
+	uint16 _strip;
+	byte _chunkID;
+	uint32 _chunkSize;
+	Common::Array<byte> _data;
+};
+
 CinepakDecoder::CinepakDecoder(int bitsPerPixel) : Codec(), _bitsPerPixel(bitsPerPixel), _ditherPalette(0) {
 	_curFrame.surface = 0;
 	_curFrame.strips = 0;
 	_y = 0;
 	_colorMap = 0;
 	_ditherType = kDitherTypeUnknown;
+	_threadPool = nullptr;
 
 	if (bitsPerPixel == 8) {
 		_pixelFormat = Graphics::PixelFormat::createFormatCLUT8();
@@ -309,6 +341,8 @@ CinepakDecoder::CinepakDecoder(int bitsPerPixel) : Codec(), _bitsPerPixel(bitsPe
 }
 
 CinepakDecoder::~CinepakDecoder() {
+	setThreadPool(nullptr);
+
 	if (_curFrame.surface) {
 		_curFrame.surface->free();
 		delete _curFrame.surface;
@@ -396,26 +430,27 @@ const Graphics::Surface *CinepakDecoder::decodeFrame(Common::SeekableReadStream
 			case 0x21:
 			case 0x24:
 			case 0x25:
+				waitForVectors(i);
 				loadCodebook(stream, i, 4, chunkID, chunkSize);
 				break;
 			case 0x22:
 			case 0x23:
 			case 0x26:
 			case 0x27:
+				waitForVectors(i);
 				loadCodebook(stream, i, 1, chunkID, chunkSize);
 				break;
 			case 0x30:
 			case 0x31:
 			case 0x32:
-				if (_ditherPalette.size() > 0)
-					ditherVectors(stream, i, chunkID, chunkSize);
-				else if (_bitsPerPixel == 8)
-					decodeVectors8(stream, i, chunkID, chunkSize);
+				if (_threadPool)
+					queueVectors(stream, i, chunkID, chunkSize);
 				else
-					decodeVectors24(stream, i, chunkID, chunkSize);
+					decodeVectors(stream, i, chunkID, chunkSize);
 				break;
 			default:
 				warning("Unknown Cinepak chunk ID %02x", chunkID);
+				waitForVectors();
 				return _curFrame.surface;
 			}
 
@@ -426,9 +461,32 @@ const Graphics::Surface *CinepakDecoder::decodeFrame(Common::SeekableReadStream
 		_y = _curFrame.strips[i].rect.bottom;
 	}
 
+	waitForVectors();
 	return _curFrame.surface;
 }
 
+void CinepakDecoder::queueVectors(Common::SeekableReadStream &stream, uint16 strip, byte chunkID, uint32 chunkSize) {
+	while (_stripTasks.size() <= strip)
+		_stripTasks.push_back(new StripTask(this, _stripTasks.size()));
+
+	// Several vector chunks in one strip are decoded in order
+	StripTask *task = _stripTasks[strip];
+	task->wait();
+	task->setChunk(stream, chunkID, chunkSize);
+	_threadPool->submit(task);
+}
+
+void CinepakDecoder::waitForVectors(int strip) {
+	if (strip >= 0) {
+		if (strip < (int)_stripTasks.size())
+			_stripTasks[strip]->wait();
+		return;
+	}
+
+	for (uint i = 0; i < _stripTasks.size(); i++)
+		_stripTasks[i]->wait();
+}
+
 void CinepakDecoder::initializeCodebook(uint16 strip, byte codebookType) {
 	CinepakCodebook *codebook = (codebookType == 1) ? _curFrame.strips[strip].v1_codebook : _curFrame.strips[strip].v4_codebook;
 
@@ -630,6 +688,15 @@ void CinepakDecoder::ditherCodebookVFW(uint16 strip, byte codebookType, uint16 c
 	}
 }
 
+void CinepakDecoder::decodeVectors(Common::SeekableReadStream &stream, uint16 strip, byte chunkID, uint32 chunkSize) {
+	if (_ditherPalette.size() > 0)
+		ditherVectors(stream, strip, chunkID, chunkSize);
+	else if (_bitsPerPixel == 8)
+		decodeVectors8(stream, strip, chunkID, chunkSize);
+	else
+		decodeVectors24(stream, strip, chunkID, chunkSize);
+}
+
 void CinepakDecoder::decodeVectors8(Common::SeekableReadStream &stream, uint16 strip, byte chunkID, uint32 chunkSize) {
 	decodeVectorsTmpl<byte, CodebookConverterPalette>(_curFrame, _clipTable, stream, strip, chunkID, chunkSize);
 }
@@ -653,6 +720,16 @@ bool CinepakDecoder::setOutputPixelFormat(const Graphics::PixelFormat &format) {
 	return true;
 }
 
+void CinepakDecoder::setThreadPool(Common::ThreadPool *pool) {
+	// The tasks remember the pool they were submitted to
+	waitForVectors();
+	for (uint i = 0; i < _stripTasks.size(); i++)
+		delete _stripTasks[i];
+	_stripTasks.clear();
+
+	_threadPool = pool;
+}
+
 bool CinepakDecoder::canDither(DitherType type) const {
 	return (type == kDitherTypeVFW || type == kDitherTypeQT) && _bitsPerPixel == 24;
 }
@@ -23,6 +23,7 @@
 #define IMAGE_CODECS_CINEPAK_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/rect.h"
 #include "graphics/pixelformat.h"
 #include "graphics/palette.h"
@@ -82,8 +83,11 @@ public:
 	bool hasDirtyPalette() const override { return _dirtyPalette; }
 	bool canDither(DitherType type) const override;
 	void setDither(DitherType type, const byte *palette) override;
+	void setThreadPool(Common::ThreadPool *pool) override;
 
 private:
+	class StripTask;
+
 	CinepakFrame _curFrame;
 	int32 _y;
 	int _bitsPerPixel;
@@ -95,8 +99,18 @@ private:
 	byte *_colorMap;
 	DitherType _ditherType;
 
+	/** Decodes the vectors of the strips in parallel, if set. */
+	Common::ThreadPool *_threadPool;
+	Common::Array<StripTask *> _stripTasks;
+
+	/** Decode the vectors of a strip on a worker thread. */
+	void queueVectors(Common::SeekableReadStream &stream, uint16 strip, byte chunkID, uint32 chunkSize);
+	/** Wait for the queued vectors of a strip, or of all strips with -1. */
+	void waitForVectors(int strip = -1);
+
 	void initializeCodebook(uint16 strip, byte codebookType);
 	void loadCodebook(Common::SeekableReadStream &stream, uint16 strip, byte codebookType, byte chunkID, uint32 chunkSize);
+	void decodeVectors(Common::SeekableReadStream &stream, uint16 strip, byte chunkID, uint32 chunkSize);
 	void decodeVectors8(Common::SeekableReadStream &stream, uint16 strip, byte chunkID, uint32 chunkSize);
 	void decodeVectors24(Common::SeekableReadStream &stream, uint16 strip, byte chunkID, uint32 chunkSize);
 
@@ -29,6 +29,7 @@
 
 namespace Common {
 class SeekableReadStream;
+class ThreadPool;
 }
 
 namespace Image {
@@ -123,6 +124,15 @@ public:
 	 */
 	virtual void setCodecAccuracy(CodecAccuracy accuracy) {}
 
+	/**
+	 * Let the codec decode independent parts of a frame, such as strips or
+	 * slices, on the worker threads of a pool. Passing nullptr goes back to
+	 * decoding on the calling thread. Codecs without such parts ignore this.
+	 *
+	 * The pool must outlive the codec, or be reset before it is destroyed.
+	 */
+	virtual void setThreadPool(Common::ThreadPool *pool) {}
+
 	/**
 	 * Get the preferred default pixel format for use with YUV codecs
 	 */
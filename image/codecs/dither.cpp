@@ -206,6 +206,10 @@ void DitherCodec::setCodecAccuracy(CodecAccuracy accuracy) {
 	return _codec->setCodecAccuracy(accuracy);
 }
 
+void DitherCodec::setThreadPool(Common::ThreadPool *pool) {
+	_codec->setThreadPool(pool);
+}
+
 byte *DitherCodec::createQuickTimeDitherTable(const byte *palette, uint colorCount) {
 	byte *buf = new byte[0x10000]();
 
@@ -44,6 +44,7 @@ public:
 	bool canDither(DitherType type) const override;
 	void setDither(DitherType type, const byte *palette) override;
 	void setCodecAccuracy(CodecAccuracy accuracy) override;
+	void setThreadPool(Common::ThreadPool *pool) override;
 
 	/**
 	 * Specify the source palette when dithering from CLUT8 to CLUT8.
@@ -1,8 +1,10 @@
 #include <cxxtest/TestSuite.h>
 
 #include "audio/audiostream.h"
+#include "common/system.h"
 
 #include "helper.h"
+#include "../system/null_osystem.h"
 
 class AudioStreamTestSuite : public CxxTest::TestSuite
 {
@@ -173,6 +175,16 @@ private:
 		delete[] sine;
 	}
 
+	static bool waitForBufferedSamples(Audio::PrefetchingAudioStream *prefetch, uint count) {
+		const uint32 start = g_system->getMillis();
+		while (prefetch->getBufferedSamples() < count) {
+			if (g_system->getMillis() - start > 5000)
+				return false;
+			g_system->delayMillis(1);
+		}
+		return true;
+	}
+
 public:
 	void test_sub_looping_audio_stream_mono_11025_mid_fixed_iter() {
 		testSubLoopingAudioStreamFixedIter(11025, false, 2, 1);
@@ -205,4 +217,94 @@ public:
 	void test_sub_looping_audio_stream_stereo_22050_end_fixed_iter() {
 		testSubLoopingAudioStreamFixedIter(22050, true, 2, 2);
 	}
+
+	void test_prefetching_audio_stream() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		// The worker needs OSystem for its thread
+		Common::install_null_g_system();
+
+		const int sampleRate = 11025;
+		const int length = sampleRate * 2 * 2;
+
+		int16 *sine = 0;
+		Audio::SeekableAudioStream *s = createSineStream<int16>(sampleRate, 2, &sine, false, true);
+		Audio::PrefetchingAudioStream *prefetch = Audio::makePrefetchingAudioStream(s, 100);
+
+		TS_ASSERT_EQUALS(prefetch->isStereo(), true);
+		TS_ASSERT_EQUALS(prefetch->getRate(), sampleRate);
+
+		int16 *buffer = new int16[length];
+		int samplesRead = 0;
+		while (!prefetch->endOfData() && samplesRead < length)
+			samplesRead += prefetch->readBuffer(buffer + samplesRead, MIN(length - samplesRead, 5000));
+
+		TS_ASSERT_EQUALS(samplesRead, length);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, length * sizeof(int16)), 0);
+		TS_ASSERT(prefetch->endOfStream());
+
+		delete prefetch;
+		delete[] buffer;
+		delete[] sine;
+
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_prefetching_audio_stream_refill() {
+#if NULL_OSYSTEM_IS_AVAILABLE && defined(POSIX)
+		// The null OSystem of the tests has threads on POSIX
+		Common::install_null_g_system();
+
+		Audio::PrefetchingAudioStream *prefetch = Audio::makePrefetchingAudioStream(Audio::makeSilentAudioStream(11025, false), 1000);
+
+		// The worker fills the whole buffer on its own. It holds 11025
+		// samples, one second of lookahead.
+		TS_ASSERT(waitForBufferedSamples(prefetch, 11025));
+
+		// Reading half of it wakes the worker up again
+		int16 buffer[1000];
+		for (int i = 0; i < 9; i++)
+			TS_ASSERT_EQUALS(prefetch->readBuffer(buffer, 1000), 1000);
+		TS_ASSERT(waitForBufferedSamples(prefetch, 11025));
+		TS_ASSERT_EQUALS(prefetch->getUnderrunCount(), 0U);
+
+		delete prefetch;
+
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_prefetching_audio_stream_underrun() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+
+		Audio::QueuingAudioStream *queue = Audio::makeQueuingAudioStream(11025, false);
+		Audio::PrefetchingAudioStream *prefetch = Audio::makePrefetchingAudioStream(queue, 100);
+
+		// Nothing queued yet
+		int16 buffer[100];
+		TS_ASSERT_EQUALS(prefetch->readBuffer(buffer, 100), 0);
+		TS_ASSERT_EQUALS(prefetch->getUnderrunCount(), 1U);
+		TS_ASSERT_EQUALS(prefetch->getUnderrunSamples(), 100U);
+		TS_ASSERT(!prefetch->endOfStream());
+
+		byte *data = (byte *)malloc(60);
+		memset(data, 0x40, 60);
+		queue->queueBuffer(data, 60, DisposeAfterUse::YES, 0);
+		queue->finish();
+
+		// 60 signed 8-bit samples, then the end of the stream. With
+		// threads, the worker may need some time to catch up.
+		int samplesRead = 0;
+		while (!prefetch->endOfStream() && samplesRead < 100)
+			samplesRead += prefetch->readBuffer(buffer + samplesRead, 100 - samplesRead);
+		TS_ASSERT_EQUALS(samplesRead, 60);
+		TS_ASSERT_EQUALS(buffer[0], 0x4000);
+		TS_ASSERT_EQUALS(buffer[59], 0x4000);
+
+		delete prefetch;
+
+		Common::uninstall_null_g_system();
+#endif
+	}
 };
@@ -0,0 +1,230 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+#include "common/threadpool.h"
+
+#include "../system/null_osystem.h"
+
+namespace {
+
+class ConstantStream : public Audio::AudioStream {
+public:
+	int readBuffer(int16 *buffer, const int numSamples) override {
+		for (int i = 0; i < numSamples; i++)
+			buffer[i] = 8000;
+		return numSamples;
+	}
+
+	bool isStereo() const override { return false; }
+	int getRate() const override { return 22050; }
+	bool endOfData() const override { return false; }
+};
+
+class MixTask : public Common::Task {
+public:
+	explicit MixTask(Audio::MixerImpl *mixer) : _mixer(mixer) {}
+
+	void run() override {
+		int16 samples[128 * 2];
+		for (int i = 0; i < 200; i++)
+			_mixer->mixCallback((byte *)samples, sizeof(samples));
+	}
+
+private:
+	Audio::MixerImpl *_mixer;
+};
+
+} // End of anonymous namespace
+
+class MixerTestSuite : public CxxTest::TestSuite {
+public:
+	void setUp() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+#endif
+	}
+
+	void tearDown() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_queued_parameters() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Audio::MixerImpl mixer(22050, true, 256);
+		mixer.setReady(true);
+
+		Audio::SoundHandle handle;
+		playConstant(mixer, handle);
+		TS_ASSERT(mixer.isSoundHandleActive(handle));
+		const int16 full = mixLeft(mixer);
+		TS_ASSERT_LESS_THAN(0, full);
+
+		// The getters see the changes before they are mixed
+		mixer.setChannelVolume(handle, 64);
+		mixer.setChannelBalance(handle, 127);
+		mixer.setChannelRate(handle, 11025);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 64);
+		TS_ASSERT_EQUALS(mixer.getChannelBalance(handle), 127);
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), 11025U);
+
+		mixer.setChannelRate(handle, 22050);
+		mixer.setChannelBalance(handle, 0);
+		TS_ASSERT_LESS_THAN(mixLeft(mixer), full);
+
+		mixer.resetChannelRate(handle);
+		TS_ASSERT_EQUALS(mixer.getChannelRate(handle), 22050U);
+
+		mixer.setChannelVolume(handle, 0);
+		TS_ASSERT_EQUALS(mixLeft(mixer), 0);
+
+		mixer.setChannelVolume(handle, Audio::Mixer::kMaxChannelVolume);
+		TS_ASSERT_EQUALS(mixLeft(mixer), full);
+
+		mixer.muteSoundType(Audio::Mixer::kSFXSoundType, true);
+		TS_ASSERT(mixer.isSoundTypeMuted(Audio::Mixer::kSFXSoundType));
+		TS_ASSERT_EQUALS(mixLeft(mixer), 0);
+		mixer.muteSoundType(Audio::Mixer::kSFXSoundType, false);
+		TS_ASSERT_EQUALS(mixLeft(mixer), full);
+
+		// Changes to stopped sounds are dropped, even if the slot is reused
+		mixer.stopHandle(handle);
+		mixer.setChannelVolume(handle, 0);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 0);
+
+		Audio::SoundHandle newHandle;
+		playConstant(mixer, newHandle);
+		mixer.setChannelVolume(handle, 0);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(newHandle), Audio::Mixer::kMaxChannelVolume);
+		TS_ASSERT_EQUALS(mixLeft(mixer), full);
+#endif
+	}
+
+	void test_queue_overflow() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Audio::MixerImpl mixer(22050, true, 256);
+		mixer.setReady(true);
+
+		Audio::SoundHandle handle;
+		playConstant(mixer, handle);
+		const int16 full = mixLeft(mixer);
+
+		// Far more changes than the queue holds, without any mixing: the
+		// setter applies the queued ones itself, in order
+		for (int i = 0; i < 1000; i++)
+			mixer.setChannelVolume(handle, i % 256);
+		TS_ASSERT_EQUALS(mixer.getChannelVolume(handle), 1000 % 256 - 1);
+
+		mixer.setChannelVolume(handle, 0);
+		TS_ASSERT_EQUALS(mixLeft(mixer), 0);
+		mixer.setChannelVolume(handle, Audio::Mixer::kMaxChannelVolume);
+		TS_ASSERT_EQUALS(mixLeft(mixer), full);
+#endif
+	}
+
+	void test_concurrent_mixing() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Audio::MixerImpl mixer(22050, true, 128);
+		mixer.setReady(true);
+
+		Audio::SoundHandle handle;
+		playConstant(mixer, handle);
+
+		// The mixer runs on a worker while the settings change, which
+		// takes the overflow path whenever the worker falls behind
+		Common::ThreadPool pool(1);
+		MixTask task(&mixer);
+		pool.submit(&task);
+		for (int i = 0; i < 5000; i++) {
+			mixer.setChannelVolume(handle, i % 256);
+			mixer.setChannelBalance(handle, (int8)(i % 255 - 127));
+		}
+		task.wait();
+
+		mixer.setChannelVolume(handle, 0);
+		TS_ASSERT_EQUALS(mixLeft(mixer), 0);
+#endif
+	}
+
+	void test_ids_and_pause() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Audio::MixerImpl mixer(22050, true, 256);
+		mixer.setReady(true);
+
+		Audio::Mixer &base = mixer;
+		Audio::SoundHandle handle;
+		base.playStream(Audio::Mixer::kSFXSoundType, &handle, new ConstantStream(), 42);
+		TS_ASSERT(mixer.isSoundIDActive(42));
+		TS_ASSERT_EQUALS(mixer.getSoundID(handle), 42);
+		TS_ASSERT(mixer.hasActiveChannelOfType(Audio::Mixer::kSFXSoundType));
+		TS_ASSERT(!mixer.hasActiveChannelOfType(Audio::Mixer::kMusicSoundType));
+
+		// Sounds with the same id are not played twice
+		Audio::SoundHandle duplicate;
+		base.playStream(Audio::Mixer::kSFXSoundType, &duplicate, new ConstantStream(), 42);
+		TS_ASSERT(!mixer.isSoundHandleActive(duplicate));
+
+		// A mix at time 0 would not count
+		g_system->delayMillis(1);
+		const int16 full = mixLeft(mixer);
+		TS_ASSERT_LESS_THAN(0, full);
+		TS_ASSERT_EQUALS(mixer.getElapsedTime(Audio::SoundHandle()).totalNumberOfFrames(), 0);
+		mixLeft(mixer);
+		TS_ASSERT_LESS_THAN_EQUALS(128, mixer.getElapsedTime(handle).totalNumberOfFrames());
+
+		mixer.pauseID(42, true);
+		TS_ASSERT_EQUALS(mixLeft(mixer), 0);
+		mixer.pauseAll(true);
+		mixer.pauseHandle(handle, false);
+		TS_ASSERT_EQUALS(mixLeft(mixer), 0);
+		mixer.pauseAll(false);
+		TS_ASSERT_EQUALS(mixLeft(mixer), full);
+
+		mixer.stopID(42);
+		TS_ASSERT(!mixer.isSoundIDActive(42));
+		TS_ASSERT(!mixer.isSoundHandleActive(handle));
+		TS_ASSERT_EQUALS(mixLeft(mixer), 0);
+#endif
+	}
+
+	void test_stop_while_mixing() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Audio::MixerImpl mixer(22050, true, 128);
+		mixer.setReady(true);
+
+		Common::ThreadPool pool(1);
+		MixTask task(&mixer);
+		pool.submit(&task);
+
+		// The streams are ours: once stopHandle() returns, the mixer
+		// must not read them anymore
+		for (int i = 0; i < 500; i++) {
+			ConstantStream *stream = new ConstantStream();
+			Audio::SoundHandle handle;
+			mixer.playStream(Audio::Mixer::kSFXSoundType, &handle, stream, -1,
+				Audio::Mixer::kMaxChannelVolume, 0, DisposeAfterUse::NO, false, false);
+			if (i % 2)
+				mixer.pauseHandle(handle, true);
+			mixer.stopHandle(handle);
+			delete stream;
+		}
+		task.wait();
+
+		TS_ASSERT(!mixer.hasActiveChannelOfType(Audio::Mixer::kSFXSoundType));
+		TS_ASSERT_EQUALS(mixLeft(mixer), 0);
+#endif
+	}
+
+private:
+	static void playConstant(Audio::Mixer &mixer, Audio::SoundHandle &handle) {
+		mixer.playStream(Audio::Mixer::kSFXSoundType, &handle, new ConstantStream());
+	}
+
+	static int16 mixLeft(Audio::MixerImpl &mixer) {
+		int16 samples[128 * 2];
+		mixer.mixCallback((byte *)samples, sizeof(samples));
+		return samples[254];
+	}
+};
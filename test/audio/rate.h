@@ -0,0 +1,255 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/rate_intern.h"
+
+#include "test/benchmark.h"
+#include "test/instrset_detect.h"
+
+namespace {
+
+/** Sawtooth (or constant, with a step of 0) of a fixed length. */
+class TestToneStream : public Audio::AudioStream {
+public:
+	TestToneStream(bool stereo, int rate, int frames, int16 start, int16 step) :
+		_stereo(stereo), _rate(rate), _remaining(frames), _value(start), _step(step) {}
+
+	int readBuffer(int16 *buffer, const int numSamples) override {
+		const int channels = _stereo ? 2 : 1;
+		const int frames = MIN(numSamples / channels, _remaining);
+		for (int i = 0; i < frames; i++) {
+			for (int c = 0; c < channels; c++)
+				*buffer++ = _value;
+			_value += _step;
+		}
+		_remaining -= frames;
+		return frames * channels;
+	}
+
+	bool isStereo() const override { return _stereo; }
+	int getRate() const override { return _rate; }
+	bool endOfData() const override { return _remaining == 0; }
+
+private:
+	bool _stereo;
+	int _rate;
+	int _remaining;
+	int16 _value, _step;
+};
+
+} // End of anonymous namespace
+
+class RateTestSuite : public CxxTest::TestSuite
+{
+private:
+	static int16 randomSample(uint32 &seed) {
+		seed = seed * 1103515245 + 12345;
+		// Favor the extremes to exercise the saturation
+		switch ((seed >> 8) & 7) {
+		case 0:
+			return 32767;
+		case 1:
+			return -32768;
+		default:
+			return (int16)(seed >> 16);
+		}
+	}
+
+	void checkKernels(const Audio::RateMixKernels &kernels) {
+		const int volumes[][2] = { { 256, 256 }, { 255, 1 }, { 0, 128 }, { 77, 0 }, { 200, 256 } };
+		const uint frameCounts[] = { 1, 3, 8, 17, 64, 101 };
+		uint32 seed = 1;
+
+		for (int v = 0; v < ARRAYSIZE(volumes); v++) {
+			for (int f = 0; f < ARRAYSIZE(frameCounts); f++) {
+				for (int clamp = 0; clamp < 2; clamp++) {
+					const uint frames = frameCounts[f];
+					const int volL = volumes[v][0];
+					const int volR = volumes[v][1];
+
+					int16 in[101 * 2];
+					int16 out[3][101 * 2];
+					int16 expected[3][101 * 2];
+					for (uint i = 0; i < frames * 2; i++) {
+						in[i] = randomSample(seed);
+						out[0][i] = out[1][i] = out[2][i] = randomSample(seed);
+						expected[0][i] = expected[1][i] = expected[2][i] = out[0][i];
+					}
+
+					for (uint i = 0; i < frames; i++) {
+						Audio::rateMixSampleScalar(expected[0][i * 2], in[i * 2], volL, clamp);
+						Audio::rateMixSampleScalar(expected[0][i * 2 + 1], in[i * 2 + 1], volR, clamp);
+						Audio::rateMixSampleScalar(expected[1][i * 2 + 1], in[i * 2], volL, clamp);
+						Audio::rateMixSampleScalar(expected[1][i * 2], in[i * 2 + 1], volR, clamp);
+						Audio::rateMixSampleScalar(expected[2][i * 2], in[i], volL, clamp);
+						Audio::rateMixSampleScalar(expected[2][i * 2 + 1], in[i], volR, clamp);
+					}
+
+					kernels.mixStereo(out[0], in, frames, volL, volR, clamp);
+					kernels.mixStereoReversed(out[1], in, frames, volL, volR, clamp);
+					kernels.mixMono(out[2], in, frames, volL, volR, clamp);
+
+					for (int k = 0; k < 3; k++)
+						TS_ASSERT_EQUALS(memcmp(out[k], expected[k], frames * 2 * sizeof(int16)), 0);
+				}
+
+				// 32-bit bus versions, which never clamp
+				const uint frames = frameCounts[f];
+				const int volL = volumes[v][0];
+				const int volR = volumes[v][1];
+
+				int16 in[101 * 2];
+				int32 out[3][101 * 2];
+				int32 expected[3][101 * 2];
+				for (uint i = 0; i < frames * 2; i++) {
+					in[i] = randomSample(seed);
+					out[0][i] = out[1][i] = out[2][i] = randomSample(seed) * 3;
+					expected[0][i] = expected[1][i] = expected[2][i] = out[0][i];
+				}
+
+				for (uint i = 0; i < frames; i++) {
+					Audio::rateMixSampleScalar(expected[0][i * 2], in[i * 2], volL, false);
+					Audio::rateMixSampleScalar(expected[0][i * 2 + 1], in[i * 2 + 1], volR, false);
+					Audio::rateMixSampleScalar(expected[1][i * 2 + 1], in[i * 2], volL, false);
+					Audio::rateMixSampleScalar(expected[1][i * 2], in[i * 2 + 1], volR, false);
+					Audio::rateMixSampleScalar(expected[2][i * 2], in[i], volL, false);
+					Audio::rateMixSampleScalar(expected[2][i * 2 + 1], in[i], volR, false);
+				}
+
+				kernels.mixStereo32(out[0], in, frames, volL, volR, false);
+				kernels.mixStereoReversed32(out[1], in, frames, volL, volR, false);
+				kernels.mixMono32(out[2], in, frames, volL, volR, false);
+
+				for (int k = 0; k < 3; k++)
+					TS_ASSERT_EQUALS(memcmp(out[k], expected[k], frames * 2 * sizeof(int32)), 0);
+			}
+		}
+
+		for (int f = 0; f < ARRAYSIZE(frameCounts); f++) {
+			const uint samples = frameCounts[f] * 2;
+			int32 in[101 * 2];
+			int16 out[101 * 2], expected[101 * 2];
+			for (uint i = 0; i < samples; i++) {
+				in[i] = randomSample(seed) * 4 + randomSample(seed);
+				expected[i] = Audio::rateSaturateScalar(in[i]);
+			}
+
+			kernels.saturate(out, in, samples);
+			TS_ASSERT_EQUALS(memcmp(out, expected, samples * sizeof(int16)), 0);
+		}
+
+		for (uint taps = 16; taps <= 32; taps += 16) {
+			int16 samples[32], coeffs[32];
+			for (uint i = 0; i < taps; i++) {
+				samples[i] = randomSample(seed);
+				coeffs[i] = randomSample(seed) / 2;
+			}
+			TS_ASSERT_EQUALS(kernels.filter(samples, coeffs, taps), Audio::rateFilterScalar(samples, coeffs, taps));
+		}
+	}
+
+	/** Resample a whole stream, and return the number of output frames. */
+	static int convertAll(Audio::RateConverter *converter, Audio::AudioStream &stream, int16 *out, int maxFrames) {
+		int total = 0;
+		while (total < maxFrames) {
+			const int frames = converter->convert(stream, (byte *)(out + total * 2), sizeof(int16), MIN(maxFrames - total, 300), 256, 256, Audio::MIX_CLAMPED_ADD);
+			if (frames == 0)
+				break;
+			total += frames;
+		}
+		return total;
+	}
+
+	void checkSincConstant(Audio::RateConverterQuality quality, bool stereo, int inRate, int outRate) {
+		const int inFrames = 5000;
+		const int maxFrames = inFrames * outRate / inRate + 64;
+		TestToneStream stream(stereo, inRate, inFrames, 10000, 0);
+		int16 *out = new int16[maxFrames * 2]();
+
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, stereo, true, false, quality);
+		const int total = convertAll(converter, stream, out, maxFrames);
+		TS_ASSERT(!converter->needsDraining());
+		delete converter;
+
+		// Every input frame comes out, including those still in the filter
+		// when the stream ended
+		const int expected = (int)((int64)inFrames * outRate / inRate);
+		TS_ASSERT_LESS_THAN_EQUALS(ABS(total - expected), 1);
+
+		// Each filter phase has unity gain, so away from the edges constant
+		// input gives the exact same output
+		for (int i = 64; i < total - 64; i++) {
+			TS_ASSERT_EQUALS(out[i * 2], 10000);
+			TS_ASSERT_EQUALS(out[i * 2 + 1], 10000);
+		}
+
+		delete[] out;
+	}
+
+public:
+	void test_scalar_rounding() {
+		// The converters divide, so negative values round towards zero
+		int16 out = 0;
+		Audio::rateMixSampleScalar(out, -1, 255, false);
+		TS_ASSERT_EQUALS(out, 0);
+		Audio::rateMixSampleScalar(out, -32768, 128, true);
+		TS_ASSERT_EQUALS(out, -16384);
+		Audio::rateMixSampleScalar(out, -32768, 256, true);
+		TS_ASSERT_EQUALS(out, -32768);
+	}
+
+	void test_kernels() {
+#ifdef SCUMMVM_NEON
+		checkKernels(Audio::g_rateMixKernelsNEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			checkKernels(Audio::g_rateMixKernelsSSE2);
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			checkKernels(Audio::g_rateMixKernelsAVX2);
+#endif
+	}
+
+	void test_sinc_upsample() {
+		checkSincConstant(Audio::kRateConverterSincMedium, false, 11025, 44100);
+		checkSincConstant(Audio::kRateConverterSincHigh, true, 11025, 44100);
+		checkSincConstant(Audio::kRateConverterSincHigh, false, 22050, 48000);
+	}
+
+	void test_sinc_downsample() {
+		checkSincConstant(Audio::kRateConverterSincMedium, true, 48000, 22050);
+		checkSincConstant(Audio::kRateConverterSincHigh, false, 44100, 11025);
+	}
+
+	void test_resampler_speed() {
+#if RUN_BENCHMARKS
+		static const char *const names[] = { "linear", "sinc medium", "sinc high" };
+		Benchmark benchmark;
+		const int inFrames = 22050 * 60;
+		const int maxFrames = (int)((int64)inFrames * 48000 / 22050) + 64;
+		int16 *out = new int16[maxFrames * 2]();
+
+		for (int quality = Audio::kRateConverterLinear; quality <= Audio::kRateConverterSincHigh; quality++) {
+			Audio::RateConverter *converter = Audio::makeRateConverter(22050, 48000, true, true, false, (Audio::RateConverterQuality)quality);
+			TestToneStream stream(true, 22050, inFrames, 0, 97);
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+			const uint64 startCycles = __builtin_ia32_rdtsc();
+#endif
+			benchmark.start();
+			const int total = convertAll(converter, stream, out, maxFrames);
+			benchmark.report(Common::String::format("Resampler %s output frames", names[quality]).c_str(), total);
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+			const uint64 cycles = __builtin_ia32_rdtsc() - startCycles;
+			debug("Resampler %s: %f cycles per output frame\n", names[quality], (double)cycles / total);
+#endif
+
+			delete converter;
+		}
+
+		delete[] out;
+#endif
+	}
+};
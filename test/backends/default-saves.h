@@ -0,0 +1,324 @@
+#include <cxxtest/TestSuite.h>
+
+#include "backends/saves/default/default-saves.h"
+#include "common/fs.h"
+#include "common/ptr.h"
+
+#include "../system/file_mode.h"
+#include "../system/null_osystem.h"
+
+namespace {
+
+/** Default save file manager using a directory of the test run. */
+class TestSaveFileManager : public DefaultSaveFileManager {
+public:
+	using DefaultSaveFileManager::waitForPendingSaves;
+
+protected:
+	Common::Path getSavePath() const override {
+		return Common::Path("test_saves");
+	}
+};
+
+struct SaveResults {
+	SaveResults() : count(0), successes(0) {}
+
+	void onSaved(const Common::AsyncSaveResult &result) {
+		count++;
+		if (result.success)
+			successes++;
+		lastName = result.name;
+	}
+
+	int count;
+	int successes;
+	Common::String lastName;
+};
+
+} // End of anonymous namespace
+
+class DefaultSavesTestSuite : public CxxTest::TestSuite {
+public:
+	void setUp() {
+		Common::install_null_g_system();
+	}
+
+	void tearDown() {
+		Common::uninstall_null_g_system();
+	}
+
+	void test_async_save() {
+		SaveResults results;
+		{
+			TestSaveFileManager saveMan;
+			writeAsync(saveMan, "async.s01", 1, 10000, &results);
+			saveMan.waitForPendingSaves();
+
+			TS_ASSERT_EQUALS(results.count, 1);
+			TS_ASSERT_EQUALS(results.successes, 1);
+			TS_ASSERT_EQUALS(results.lastName, "async.s01");
+			TS_ASSERT(checkSave(saveMan, "async.s01", 1, 10000));
+
+			// The data went through a temporary file, which is gone
+			TS_ASSERT(!Common::FSNode(Common::Path("test_saves/async.s01.tmp")).exists());
+
+			TS_ASSERT(saveMan.removeSavefile("async.s01"));
+		}
+		Common::remove_file("test_saves");
+	}
+
+	void test_async_order() {
+		SaveResults results;
+		{
+			TestSaveFileManager saveMan;
+
+			// Saves over the same file end up in submission order, and
+			// loading waits for them without being asked to
+			for (int i = 1; i <= 5; i++)
+				writeAsync(saveMan, "order.s01", i, 50000 + i, &results);
+			writeAsync(saveMan, "order.s02", 9, 1000, &results);
+			TS_ASSERT(checkSave(saveMan, "order.s01", 5, 50005));
+			TS_ASSERT(checkSave(saveMan, "order.s02", 9, 1000));
+
+			saveMan.waitForPendingSaves();
+			TS_ASSERT_EQUALS(results.count, 6);
+			TS_ASSERT_EQUALS(results.successes, 6);
+
+			// Only the saves themselves are listed
+			Common::StringArray saves = saveMan.listSavefiles("order.*");
+			TS_ASSERT_EQUALS(saves.size(), 2u);
+
+			TS_ASSERT(saveMan.removeSavefile("order.s01"));
+			TS_ASSERT(saveMan.removeSavefile("order.s02"));
+		}
+		Common::remove_file("test_saves");
+	}
+
+	void test_pending_saves_on_destruction() {
+		SaveResults results;
+		{
+			// Deleting the manager writes the pending saves first
+			TestSaveFileManager saveMan;
+			writeAsync(saveMan, "exit.s01", 3, 200000, &results);
+		}
+		TS_ASSERT_EQUALS(results.successes, 1);
+
+		{
+			TestSaveFileManager saveMan;
+			TS_ASSERT(checkSave(saveMan, "exit.s01", 3, 200000));
+			TS_ASSERT(saveMan.removeSavefile("exit.s01"));
+		}
+		Common::remove_file("test_saves");
+	}
+
+	void test_metadata_index() {
+		{
+			TestSaveFileManager saveMan;
+			storeMetadata(saveMan, "meta.s01", 1);
+			storeMetadata(saveMan, "meta.s02", 2);
+			storeMetadata(saveMan, "other.s01", 3);
+			saveMan.flushSaveMetadata();
+
+			// One index per name up to the extension
+			TS_ASSERT(Common::FSNode(Common::Path("test_saves/meta.svmindex")).exists());
+			TS_ASSERT(Common::FSNode(Common::Path("test_saves/other.svmindex")).exists());
+			TS_ASSERT(saveMan.listSavefiles("meta.*").empty());
+		}
+
+		Common::ScopedPtr<Common::SeekableReadStream> in(Common::FSNode(Common::Path("test_saves/meta.svmindex")).createReadStream());
+		TS_ASSERT(in);
+		if (in) {
+			TS_ASSERT_EQUALS(in->readUint32BE(), MKTAG('S', 'V', 'M', 'I'));
+			TS_ASSERT_EQUALS(in->readUint32LE(), 2u);
+			TS_ASSERT_EQUALS(in->readUint32LE(), 2u);
+			in.reset();
+		}
+
+		{
+			TestSaveFileManager saveMan;
+			TS_ASSERT(checkMetadata(saveMan, "meta.s01", 1));
+			TS_ASSERT(checkMetadata(saveMan, "meta.s02", 2));
+			TS_ASSERT(checkMetadata(saveMan, "other.s01", 3));
+			TS_ASSERT(!saveMan.openSaveMetadata("meta.s03"));
+		}
+
+		Common::remove_file("test_saves/meta.svmindex");
+		Common::remove_file("test_saves/other.svmindex");
+		Common::remove_file("test_saves");
+	}
+
+	void test_metadata_invalidation() {
+		{
+			TestSaveFileManager saveMan;
+			storeMetadata(saveMan, "inval.s01", 1);
+			storeMetadata(saveMan, "inval.s02", 2);
+			saveMan.flushSaveMetadata();
+
+			// Writing a save drops its metadata, and the index on disk,
+			// until the next flush
+			Common::OutSaveFile *file = saveMan.openForSaving("inval.s01", false);
+			TS_ASSERT(file);
+			delete file;
+			TS_ASSERT(!saveMan.openSaveMetadata("inval.s01"));
+			TS_ASSERT(checkMetadata(saveMan, "inval.s02", 2));
+
+			{
+				// Nothing outdated is seen if the index is never written
+				TestSaveFileManager otherMan;
+				TS_ASSERT(!otherMan.openSaveMetadata("inval.s01"));
+			}
+
+			saveMan.flushSaveMetadata();
+			TS_ASSERT(Common::FSNode(Common::Path("test_saves/inval.svmindex")).exists());
+
+			// So do removing it and saving asynchronously
+			TS_ASSERT(saveMan.removeSavefile("inval.s01"));
+			storeMetadata(saveMan, "inval.s01", 5);
+			writeAsync(saveMan, "inval.s01", 5, 1000, nullptr);
+			TS_ASSERT(!saveMan.openSaveMetadata("inval.s01"));
+		}
+
+		{
+			TestSaveFileManager saveMan;
+			TS_ASSERT(!saveMan.openSaveMetadata("inval.s01"));
+			TS_ASSERT(checkMetadata(saveMan, "inval.s02", 2));
+			TS_ASSERT(saveMan.removeSavefile("inval.s01"));
+		}
+
+		Common::remove_file("test_saves/inval.svmindex");
+		Common::remove_file("test_saves");
+	}
+
+	void test_metadata_outdated() {
+		{
+			TestSaveFileManager saveMan;
+			writeSave(saveMan, "stale.s01", 10);
+			writeSave(saveMan, "stale.s02", 10);
+			storeMetadata(saveMan, "stale.s01", 1);
+			storeMetadata(saveMan, "stale.s02", 2);
+			saveMan.flushSaveMetadata();
+		}
+
+		// Replace a save file behind the manager's back
+		Common::SeekableWriteStream *out = Common::FSNode(Common::Path("test_saves/stale.s01")).createWriteStream(false);
+		TS_ASSERT(out);
+		if (out) {
+			for (uint32 i = 0; i < 20; i++)
+				out->writeByte(0);
+			delete out;
+		}
+
+		{
+			TestSaveFileManager saveMan;
+			TS_ASSERT(!saveMan.openSaveMetadata("stale.s01"));
+			TS_ASSERT(checkMetadata(saveMan, "stale.s02", 2));
+			TS_ASSERT(saveMan.removeSavefile("stale.s01"));
+			TS_ASSERT(saveMan.removeSavefile("stale.s02"));
+		}
+
+		Common::remove_file("test_saves/stale.svmindex");
+		Common::remove_file("test_saves");
+	}
+
+	void test_metadata_corrupt_index() {
+		{
+			TestSaveFileManager saveMan;
+			storeMetadata(saveMan, "bad.s01", 1);
+			storeMetadata(saveMan, "bad.s02", 2);
+			saveMan.flushSaveMetadata();
+		}
+
+		// Cut the index in the middle of the last entry
+		Common::FSNode indexNode(Common::Path("test_saves/bad.svmindex"));
+		Common::SeekableReadStream *in = indexNode.createReadStream();
+		TS_ASSERT(in);
+		if (!in)
+			return;
+		const uint32 size = in->size() - 5;
+		byte *data = new byte[size];
+		in->read(data, size);
+		delete in;
+		Common::SeekableWriteStream *out = indexNode.createWriteStream(false);
+		out->write(data, size);
+		delete out;
+		delete[] data;
+
+		{
+			// The whole index is ignored, and replaced on the next flush
+			TestSaveFileManager saveMan;
+			TS_ASSERT(!saveMan.openSaveMetadata("bad.s01"));
+			TS_ASSERT(!saveMan.openSaveMetadata("bad.s02"));
+			storeMetadata(saveMan, "bad.s02", 7);
+			saveMan.flushSaveMetadata();
+		}
+
+		{
+			TestSaveFileManager saveMan;
+			TS_ASSERT(!saveMan.openSaveMetadata("bad.s01"));
+			TS_ASSERT(checkMetadata(saveMan, "bad.s02", 7));
+		}
+
+		Common::remove_file("test_saves/bad.svmindex");
+		Common::remove_file("test_saves");
+	}
+
+private:
+	static void storeMetadata(Common::SaveFileManager &saveMan, const char *name, int seed) {
+		byte data[100];
+		for (uint32 i = 0; i < sizeof(data); i++)
+			data[i] = patternByte(seed, i);
+		saveMan.storeSaveMetadata(name, data, sizeof(data));
+	}
+
+	static bool checkMetadata(Common::SaveFileManager &saveMan, const char *name, int seed) {
+		Common::ScopedPtr<Common::SeekableReadStream> in(saveMan.openSaveMetadata(name));
+		if (!in || in->size() != 100)
+			return false;
+		for (uint32 i = 0; i < 100; i++) {
+			if (in->readByte() != patternByte(seed, i))
+				return false;
+		}
+		return true;
+	}
+
+	static byte patternByte(int seed, uint32 i) {
+		return (byte)(seed * 31 + i * 7 + (i >> 9));
+	}
+
+	static void writeAsync(Common::SaveFileManager &saveMan, const char *name, int seed, uint32 size, SaveResults *results) {
+		Common::AsyncSaveCallback *callback = nullptr;
+		if (results)
+			callback = new Common::Callback<SaveResults, const Common::AsyncSaveResult &>(results, &SaveResults::onSaved);
+		Common::OutSaveFile *file = saveMan.openForSavingAsync(name, true, 1, callback);
+		TS_ASSERT(file);
+		if (!file)
+			return;
+		for (uint32 i = 0; i < size; i++)
+			file->writeByte(patternByte(seed, i));
+		file->finalize();
+		TS_ASSERT(!file->err());
+		delete file;
+	}
+
+	static void writeSave(Common::SaveFileManager &saveMan, const char *name, uint32 size) {
+		Common::OutSaveFile *file = saveMan.openForSaving(name, false);
+		TS_ASSERT(file);
+		if (!file)
+			return;
+		for (uint32 i = 0; i < size; i++)
+			file->writeByte(patternByte(0, i));
+		delete file;
+	}
+
+	static bool checkSave(Common::SaveFileManager &saveMan, const char *name, int seed, uint32 size) {
+		Common::InSaveFile *file = saveMan.openForLoading(name);
+		if (!file)
+			return false;
+
+		bool matches = (uint32)file->size() == size;
+		for (uint32 i = 0; matches && i < size; i++)
+			matches = file->readByte() == patternByte(seed, i);
+		delete file;
+		return matches;
+	}
+};
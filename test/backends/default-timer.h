@@ -0,0 +1,232 @@
+#include <cxxtest/TestSuite.h>
+
+#include "backends/timer/default/default-timer.h"
+
+#include "../system/null_osystem.h"
+
+namespace {
+
+/** Timer manager driven by the test instead of the clock. */
+class TestTimerManager : public DefaultTimerManager {
+public:
+	TestTimerManager() : now(0) {}
+
+	void run(uint32 time) {
+		now = time;
+		runTimers(time);
+	}
+
+	/** Return the time the callback is next due, in milliseconds. */
+	uint32 fireTime(TimerProc proc) const {
+		return _slots.getVal(proc)->nextFireTime;
+	}
+
+	/** Time passed to the run in progress. */
+	uint32 now;
+};
+
+struct TimerRecord {
+	TimerRecord() : timers(nullptr), count(0), firstTime(0), remove(nullptr) {}
+
+	TestTimerManager *timers;
+	uint32 count;
+	uint32 firstTime;	// time of the run making the first call
+	Common::TimerManager::TimerProc remove;	// removed by the callback
+};
+
+template<int N>
+void recordCall(void *refCon) {
+	TimerRecord *record = (TimerRecord *)refCon;
+	if (!record->count)
+		record->firstTime = record->timers->now;
+	record->count++;
+	if (record->remove)
+		record->timers->removeTimerProc(record->remove);
+}
+
+} // End of anonymous namespace
+
+class DefaultTimerTestSuite : public CxxTest::TestSuite {
+public:
+	void setUp() {
+		Common::install_null_g_system();
+	}
+
+	void tearDown() {
+		Common::uninstall_null_g_system();
+	}
+
+	void test_cascades() {
+		// Around the spans of the first level (256 ms) and of the second
+		// one (16384 ms), where the timers move between the levels
+		static const int32 intervals[] = { 1, 255, 256, 257, 300, 16383, 16384, 16385, 20000 };
+		static const Common::TimerManager::TimerProc procs[] = {
+			recordCall<0>, recordCall<1>, recordCall<2>, recordCall<3>, recordCall<4>,
+			recordCall<5>, recordCall<6>, recordCall<7>, recordCall<8>
+		};
+		const int count = ARRAYSIZE(intervals);
+
+		TestTimerManager timers;
+		TimerRecord records[count];
+		uint32 due[count];
+		for (int i = 0; i < count; i++) {
+			records[i].timers = &timers;
+			timers.installTimerProc(procs[i], intervals[i] * 1000, &records[i], Common::String::format("cascade%d", i));
+			due[i] = timers.fireTime(procs[i]);
+		}
+
+		// A callback is called by the first run after its fire time
+		const uint32 start = timers.fireTime(procs[0]) - 1;
+		for (uint32 time = start; time != start + 20100; time++)
+			timers.run(time);
+
+		for (int i = 0; i < count; i++) {
+			TS_ASSERT_EQUALS(records[i].firstTime, due[i] + 1);
+			TS_ASSERT_EQUALS(records[i].count, (start + 20099 - due[i] - 1) / intervals[i] + 1);
+
+			DefaultTimerManager::TimerStats stats;
+			TS_ASSERT(timers.getTimerStats(procs[i], stats));
+			TS_ASSERT_EQUALS(stats.lateCount, 0U);
+			TS_ASSERT_EQUALS(stats.skipCount, 0U);
+			TS_ASSERT_EQUALS(stats.maxLateness, 1U);
+		}
+	}
+
+	void test_long_runs() {
+		// Runs spanning many ticks, most of them without any timer
+		TestTimerManager timers;
+		TimerRecord shortRecord, longRecord;
+		shortRecord.timers = longRecord.timers = &timers;
+		timers.installTimerProc(recordCall<0>, 300 * 1000, &shortRecord, "short");
+		timers.installTimerProc(recordCall<1>, 20000 * 1000, &longRecord, "long");
+		const uint32 shortDue = timers.fireTime(recordCall<0>);
+		const uint32 due = timers.fireTime(recordCall<1>);
+
+		for (uint32 time = shortDue - 300; (int32)(due - time) > 0; time += 400)
+			timers.run(time);
+		timers.run(due);
+		TS_ASSERT_EQUALS(longRecord.count, 0U);
+		timers.run(due + 1);
+		TS_ASSERT_EQUALS(longRecord.count, 1U);
+		TS_ASSERT_EQUALS(timers.fireTime(recordCall<1>), due + 20000);
+
+		// Every call to the short timer was made
+		TS_ASSERT_EQUALS(shortRecord.count, (due - shortDue) / 300 + 1);
+		DefaultTimerManager::TimerStats stats;
+		TS_ASSERT(timers.getTimerStats(recordCall<0>, stats));
+		TS_ASSERT_EQUALS(stats.skipCount, 0U);
+	}
+
+	void test_sub_millisecond() {
+		TestTimerManager timers;
+		TimerRecord record;
+		record.timers = &timers;
+		timers.installTimerProc(recordCall<0>, 250, &record, "fast");
+		const uint32 start = timers.fireTime(recordCall<0>);
+
+		// Every quarter of millisecond before the run time
+		timers.run(start + 1);
+		TS_ASSERT_EQUALS(record.count, 3U);
+		timers.run(start + 2);
+		TS_ASSERT_EQUALS(record.count, 7U);
+		timers.run(start + 100);
+		TS_ASSERT_EQUALS(record.count, 399U);
+		TS_ASSERT_EQUALS(timers.fireTime(recordCall<0>), start + 100);
+	}
+
+	void test_microsecond_carry() {
+		TestTimerManager timers;
+		TimerRecord record;
+		record.timers = &timers;
+		timers.installTimerProc(recordCall<0>, 1500, &record, "carry");
+		const uint32 start = timers.fireTime(recordCall<0>) - 1;
+
+		// Due at 1.5 ms, 3 ms, 4.5 ms and so on, without drifting
+		timers.run(start + 2);
+		TS_ASSERT_EQUALS(record.count, 1U);
+		timers.run(start + 3);
+		TS_ASSERT_EQUALS(record.count, 1U);
+		timers.run(start + 4);
+		TS_ASSERT_EQUALS(record.count, 2U);
+		timers.run(start + 5);
+		TS_ASSERT_EQUALS(record.count, 3U);
+
+		for (uint32 time = start + 6; time <= start + 1000; time++)
+			timers.run(time);
+		TS_ASSERT_EQUALS(record.count, 666U);
+		TS_ASSERT_EQUALS(timers.fireTime(recordCall<0>), start + 1000);
+	}
+
+	void test_remove_self() {
+		TestTimerManager timers;
+		TimerRecord record;
+		record.timers = &timers;
+		record.remove = recordCall<0>;
+		timers.installTimerProc(recordCall<0>, 250, &record, "self");
+		const uint32 start = timers.fireTime(recordCall<0>);
+
+		// Removed by its first call, even though it was due again in the tick
+		timers.run(start + 10);
+		TS_ASSERT_EQUALS(record.count, 1U);
+		DefaultTimerManager::TimerStats stats;
+		TS_ASSERT(!timers.getTimerStats(recordCall<0>, stats));
+
+		timers.run(start + 20);
+		TS_ASSERT_EQUALS(record.count, 1U);
+
+		// The name may be used again
+		timers.installTimerProc(recordCall<1>, 1000, &record, "self");
+		TS_ASSERT(timers.getTimerStats(recordCall<1>, stats));
+	}
+
+	void test_remove_other() {
+		TestTimerManager timers;
+		TimerRecord first, second;
+		first.timers = second.timers = &timers;
+		first.remove = recordCall<1>;
+		second.remove = recordCall<0>;
+		timers.installTimerProc(recordCall<0>, 10 * 1000, &first, "first");
+		timers.installTimerProc(recordCall<1>, 10 * 1000, &second, "second");
+		const uint32 start = timers.fireTime(recordCall<0>);
+
+		// Both are due in the same tick unless the clock ticked in between,
+		// and the first one removes the other from the tick
+		timers.run(start + 100);
+		TS_ASSERT_EQUALS(first.count, 10U);
+		TS_ASSERT_EQUALS(second.count, 0U);
+
+		DefaultTimerManager::TimerStats stats;
+		TS_ASSERT(timers.getTimerStats(recordCall<0>, stats));
+		TS_ASSERT(!timers.getTimerStats(recordCall<1>, stats));
+	}
+
+	void test_skip_behind() {
+		TestTimerManager timers;
+		TimerRecord record;
+		record.timers = &timers;
+		timers.installTimerProc(recordCall<0>, 10 * 1000, &record, "behind");
+		const uint32 start = timers.fireTime(recordCall<0>) - 10;
+
+		timers.run(start + 11);
+		TS_ASSERT_EQUALS(record.count, 1U);
+
+		// Two seconds late: the call due at 20 ms is made, the following ones
+		// are skipped up to the one due at 2010 ms
+		timers.run(start + 2011);
+		TS_ASSERT_EQUALS(record.count, 3U);
+		TS_ASSERT_EQUALS(timers.fireTime(recordCall<0>), start + 2020);
+
+		DefaultTimerManager::TimerStats stats;
+		TS_ASSERT(timers.getTimerStats(recordCall<0>, stats));
+		TS_ASSERT_EQUALS(stats.fireCount, 3U);
+		TS_ASSERT_EQUALS(stats.skipCount, 198U);
+		TS_ASSERT_EQUALS(stats.lateCount, 1U);
+		TS_ASSERT_EQUALS(stats.maxLateness, 1991U);
+
+		// Less than the limit behind: every call is made
+		timers.run(start + 2500);
+		TS_ASSERT_EQUALS(record.count, 51U);
+		TS_ASSERT(timers.getTimerStats(recordCall<0>, stats));
+		TS_ASSERT_EQUALS(stats.skipCount, 198U);
+	}
+};
@@ -0,0 +1,96 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/fs.h"
+#include "common/ptr.h"
+#include "common/stream.h"
+
+#include "backends/fs/posix/posix-mappedstream.h"
+#include "../system/file_mode.h"
+#include "../system/null_osystem.h"
+
+class PosixMappedStreamTestSuite : public CxxTest::TestSuite {
+public:
+	void setUp() {
+		Common::install_null_g_system();
+	}
+
+	void tearDown() {
+		Common::uninstall_null_g_system();
+	}
+
+	void test_mapped_read() {
+		const char *name = "posix-mappedstream-test.tmp";
+		TS_ASSERT(writeFile(name, 128 * 1024));
+
+		// Writable files could be truncated while mapped
+		Common::ScopedPtr<PosixMappedStream> mapped(PosixMappedStream::makeFromPath(name));
+		TS_ASSERT(!mapped);
+		checkStream(name, 128 * 1024);
+
+		Common::set_file_read_only(name, true);
+		mapped.reset(PosixMappedStream::makeFromPath(name));
+#if defined(__linux__)
+		if (sizeof(void *) >= 8)
+			TS_ASSERT(mapped);
+#endif
+		mapped.reset();
+		checkStream(name, 128 * 1024);
+
+		Common::set_file_read_only(name, false);
+		Common::remove_file(name);
+	}
+
+	void test_small_file() {
+		const char *name = "posix-mappedstream-test.tmp";
+		TS_ASSERT(writeFile(name, 1000));
+		Common::set_file_read_only(name, true);
+
+		Common::ScopedPtr<PosixMappedStream> mapped(PosixMappedStream::makeFromPath(name));
+		TS_ASSERT(!mapped);
+		checkStream(name, 1000);
+
+		Common::set_file_read_only(name, false);
+		Common::remove_file(name);
+	}
+
+private:
+	static byte patternByte(uint32 pos) {
+		return (byte)(pos * 7 + (pos >> 8));
+	}
+
+	static bool writeFile(const char *name, uint32 size) {
+		Common::ScopedPtr<Common::SeekableWriteStream> stream(Common::FSNode(Common::Path(name)).createWriteStream(false));
+		if (!stream)
+			return false;
+
+		for (uint32 i = 0; i < size; i++)
+			stream->writeByte(patternByte(i));
+		stream->finalize();
+		return !stream->err();
+	}
+
+	// The stream has to behave the same, whether the file is mapped or not
+	void checkStream(const char *name, uint32 size) {
+		Common::ScopedPtr<Common::SeekableReadStream> stream(Common::FSNode(Common::Path(name)).createReadStream());
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+
+		TS_ASSERT_EQUALS(stream->size(), (int64)size);
+
+		byte buffer[256];
+		TS_ASSERT_EQUALS(stream->read(buffer, sizeof(buffer)), sizeof(buffer));
+		for (uint32 i = 0; i < sizeof(buffer); i++)
+			TS_ASSERT_EQUALS(buffer[i], patternByte(i));
+
+		TS_ASSERT(stream->seek(size / 2));
+		TS_ASSERT_EQUALS(stream->readByte(), patternByte(size / 2));
+		TS_ASSERT_EQUALS(stream->pos(), (int64)size / 2 + 1);
+
+		TS_ASSERT(stream->seek(-10, SEEK_END));
+		TS_ASSERT_EQUALS(stream->read(buffer, sizeof(buffer)), 10U);
+		TS_ASSERT_EQUALS(buffer[9], patternByte(size - 1));
+		TS_ASSERT(stream->eos());
+		TS_ASSERT(!stream->err());
+	}
+};
@@ -0,0 +1,53 @@
+#ifndef TEST_BENCHMARK_H
+#define TEST_BENCHMARK_H
+
+#include "common/debug.h"
+#include "common/system.h"
+
+#include "system/null_osystem.h"
+
+/*
+ * Speed tests only check their results in passing, and take far longer than
+ * the rest of the suite, so they are only built with SLOW_TESTS defined.
+ * They need the null OSystem for its clock.
+ */
+#if defined(SLOW_TESTS) && NULL_OSYSTEM_IS_AVAILABLE
+#define RUN_BENCHMARKS 1
+#else
+#define RUN_BENCHMARKS 0
+#endif
+
+#if RUN_BENCHMARKS
+
+/** Installs the null OSystem for its lifetime, and times the measured steps. */
+class Benchmark {
+public:
+	Benchmark() : _start(0) {
+		Common::install_null_g_system();
+	}
+
+	~Benchmark() {
+		Common::uninstall_null_g_system();
+	}
+
+	void start() {
+		_start = g_system->getMillis();
+	}
+
+	/** Return the milliseconds elapsed since start(). */
+	uint32 elapsed() const {
+		return g_system->getMillis() - _start;
+	}
+
+	/** Print the milliseconds elapsed since start() for count operations. */
+	void report(const char *what, uint32 count) const {
+		debug("%s: %u in %u milliseconds\n", what, count, elapsed());
+	}
+
+private:
+	uint32 _start;
+};
+
+#endif
+
+#endif
@@ -0,0 +1,301 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/stream.h"
+#include "common/threadpool.h"
+
+#include "../system/null_osystem.h"
+
+class MemcachingTestArchive : public Common::MemcachingCaseInsensitiveArchive {
+public:
+	MemcachingTestArchive(uint32 maxStronglyCachedSize) : Common::MemcachingCaseInsensitiveArchive(maxStronglyCachedSize), reads(0) {}
+
+	bool hasFile(const Common::Path &path) const override {
+		return getMemberSize(path) != 0;
+	}
+
+	int listMembers(Common::ArchiveMemberList &list) const override {
+		return 0;
+	}
+
+	const Common::ArchiveMemberPtr getMember(const Common::Path &path) const override {
+		return Common::ArchiveMemberPtr();
+	}
+
+	Common::SharedArchiveContents readContentsForPath(const Common::Path &translatedPath) const override {
+		uint32 size = getMemberSize(translatedPath);
+		if (!size)
+			return Common::SharedArchiveContents();
+
+		reads++;
+		byte *contents = new byte[size];
+		memset(contents, size & 0xFF, size);
+		return Common::SharedArchiveContents(contents, size);
+	}
+
+	mutable int reads;
+
+private:
+	// Members are named after their size
+	static uint32 getMemberSize(const Common::Path &path) {
+		return atoi(path.toString().c_str());
+	}
+};
+
+class NamedTestArchive : public Common::Archive {
+public:
+	NamedTestArchive(byte archiveId) : id(archiveId), lookups(0) {}
+
+	bool hasFile(const Common::Path &path) const override {
+		lookups++;
+		return names.contains(path);
+	}
+
+	int listMembers(Common::ArchiveMemberList &list) const override {
+		return 0;
+	}
+
+	const Common::ArchiveMemberPtr getMember(const Common::Path &path) const override {
+		if (!hasFile(path))
+			return Common::ArchiveMemberPtr();
+		return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(path, *this));
+	}
+
+	Common::SeekableReadStream *createReadStreamForMember(const Common::Path &path) const override {
+		if ((!names.contains(path) && !unlistedNames.contains(path)) || unopenableNames.contains(path))
+			return nullptr;
+		return new Common::MemoryReadStream(&id, 1);
+	}
+
+	Common::HashMap<Common::Path, bool, Common::Path::IgnoreCase_Hash, Common::Path::IgnoreCase_EqualTo> names;
+	// Members which can be opened, but which hasFile() does not report
+	Common::HashMap<Common::Path, bool, Common::Path::IgnoreCase_Hash, Common::Path::IgnoreCase_EqualTo> unlistedNames;
+	// Members which hasFile() reports, but which can not be opened
+	Common::HashMap<Common::Path, bool, Common::Path::IgnoreCase_Hash, Common::Path::IgnoreCase_EqualTo> unopenableNames;
+	byte id;
+	mutable int lookups;
+};
+
+/** Reads the members of one archive over and over, keeping a few streams open. */
+class MemcachingReadTask : public Common::Task {
+public:
+	explicit MemcachingReadTask(const MemcachingTestArchive *archive) : _archive(archive), _errors(0) {}
+
+	void run() override {
+		Common::SeekableReadStream *open[3] = { nullptr, nullptr, nullptr };
+		for (int i = 0; i < 3000; i++) {
+			const uint32 size = 100 + i % 7;
+			Common::SeekableReadStream *stream = _archive->createReadStreamForMember(Common::Path(Common::String::format("%u", size)));
+			if (!stream || (uint32)stream->size() != size || stream->readByte() != (byte)size) {
+				_errors++;
+				delete stream;
+				continue;
+			}
+			delete open[i % 3];
+			open[i % 3] = stream;
+		}
+		for (int i = 0; i < 3; i++)
+			delete open[i];
+	}
+
+	int getErrors() const { return _errors; }
+
+private:
+	const MemcachingTestArchive *_archive;
+	int _errors;
+};
+
+class ArchiveTestSuite : public CxxTest::TestSuite {
+public:
+	void test_searchset_lookup() {
+		NamedTestArchive *low = new NamedTestArchive(1);
+		NamedTestArchive *high = new NamedTestArchive(2);
+		low->names[Common::Path("a")] = true;
+		low->names[Common::Path("b")] = true;
+		high->names[Common::Path("b")] = true;
+
+		Common::SearchSet set;
+		set.add("low", low, 0);
+		set.add("high", high, 1);
+
+		TS_ASSERT_EQUALS(openMember(set, "a"), 1);
+		TS_ASSERT_EQUALS(openMember(set, "b"), 2);
+		TS_ASSERT_EQUALS(openMember(set, "c"), 0);
+
+		// Repeated lookups don't query every archive again, even misses
+		int lowLookups = low->lookups;
+		TS_ASSERT(set.hasFile(Common::Path("b")));
+		TS_ASSERT(!set.hasFile(Common::Path("c")));
+		TS_ASSERT_EQUALS(openMember(set, "c"), 0);
+		TS_ASSERT_EQUALS(low->lookups, lowLookups);
+
+		Common::Archive *container = nullptr;
+		TS_ASSERT(set.getMember(Common::Path("a"), &container));
+		TS_ASSERT_EQUALS(container, (Common::Archive *)low);
+
+		// Changing the order invalidates the index
+		set.setPriority("low", 2);
+		TS_ASSERT_EQUALS(openMember(set, "b"), 1);
+
+		// So does adding an archive, which may have files found before
+		NamedTestArchive *top = new NamedTestArchive(3);
+		top->names[Common::Path("a")] = true;
+		set.add("top", top, 3);
+		TS_ASSERT_EQUALS(openMember(set, "a"), 3);
+		set.remove("top");
+		TS_ASSERT_EQUALS(openMember(set, "a"), 1);
+
+		// Files added to or removed from an archive need an invalidation
+		TS_ASSERT(!set.hasFile(Common::Path("c")));
+		low->names.erase(Common::Path("b"));
+		high->names[Common::Path("c")] = true;
+		TS_ASSERT(!set.hasFile(Common::Path("c")));
+		set.invalidateIndex();
+		TS_ASSERT_EQUALS(openMember(set, "b"), 2);
+		TS_ASSERT(set.hasFile(Common::Path("c")));
+		TS_ASSERT_EQUALS(openMember(set, "c"), 2);
+
+		// Members which an archive reports but can not open are looked for
+		// in the following archives
+		low->unlistedNames[Common::Path("d")] = true;
+		high->names[Common::Path("d")] = true;
+		high->unopenableNames[Common::Path("d")] = true;
+		set.setPriority("high", 3);
+		TS_ASSERT_EQUALS(openMember(set, "d"), 1);
+
+		// The index stays bounded, and keeps working once it has been cleared
+		for (int i = 0; i < 5000; i++)
+			low->names[Common::Path(Common::String::format("file%d", i))] = true;
+		set.invalidateIndex();
+		for (int i = 0; i < 5000; i++)
+			TS_ASSERT(set.hasFile(Common::Path(Common::String::format("file%d", i))));
+		TS_ASSERT_EQUALS(openMember(set, "file0"), 1);
+		TS_ASSERT_EQUALS(openMember(set, "c"), 2);
+
+		set.remove("high");
+		TS_ASSERT_EQUALS(openMember(set, "c"), 0);
+	}
+
+	void test_searchset_nested() {
+		Common::SearchSet inner;
+		Common::SearchSet outer;
+		outer.add("inner", &inner, 0, false);
+
+		TS_ASSERT(!outer.hasFile(Common::Path("a")));
+
+		// Adding to a nested search set invalidates its parents too
+		NamedTestArchive *archive = new NamedTestArchive(3);
+		archive->names[Common::Path("a")] = true;
+		inner.add("archive", archive);
+		TS_ASSERT_EQUALS(openMember(outer, "a"), 3);
+
+		// Once removed from its parent, it does not invalidate it anymore
+		outer.remove("inner");
+		TS_ASSERT(!outer.hasFile(Common::Path("a")));
+		inner.remove("archive");
+		TS_ASSERT(!inner.hasFile(Common::Path("a")));
+	}
+
+	void test_memcaching_lru() {
+		Common::MemcachingCaseInsensitiveArchive::setCacheBudget(250);
+		Common::MemcachingCaseInsensitiveArchive::resetCacheStats();
+
+		MemcachingTestArchive archive(200);
+		readMember(archive, "100");
+		readMember(archive, "101");
+		TS_ASSERT_EQUALS(archive.reads, 2);
+
+		// Touch 100, so that adding 102 evicts 101
+		readMember(archive, "100");
+		readMember(archive, "102");
+		TS_ASSERT_EQUALS(archive.reads, 3);
+
+		Common::ArchiveCacheStats stats = Common::MemcachingCaseInsensitiveArchive::getCacheStats();
+		TS_ASSERT_EQUALS(stats.hits, 1u);
+		TS_ASSERT_EQUALS(stats.misses, 3u);
+		TS_ASSERT_EQUALS(stats.evictions, 1u);
+		TS_ASSERT_EQUALS(stats.usedBytes, 202u);
+
+		readMember(archive, "100");
+		readMember(archive, "101");
+		TS_ASSERT_EQUALS(archive.reads, 4);
+
+		// Members above the strong caching size are never kept
+		readMember(archive, "300");
+		readMember(archive, "300");
+		TS_ASSERT_EQUALS(archive.reads, 6);
+
+		// Missing members are remembered
+		TS_ASSERT(!archive.createReadStreamForMember(Common::Path("missing")));
+		TS_ASSERT(!archive.createReadStreamForMember(Common::Path("missing")));
+
+		stats = Common::MemcachingCaseInsensitiveArchive::getCacheStats();
+		TS_ASSERT_EQUALS(stats.hits, 3u);
+		TS_ASSERT_EQUALS(stats.misses, 7u);
+
+		Common::MemcachingCaseInsensitiveArchive::setCacheBudget(150);
+		stats = Common::MemcachingCaseInsensitiveArchive::getCacheStats();
+		TS_ASSERT_EQUALS(stats.usedBytes, 101u);
+		TS_ASSERT_EQUALS(stats.evictions, 3u);
+	}
+
+	void test_memcaching_purge() {
+		Common::MemcachingCaseInsensitiveArchive::setCacheBudget(1000);
+
+		MemcachingTestArchive *archive = new MemcachingTestArchive(200);
+		readMember(*archive, "50");
+		readMember(*archive, "60");
+		uint32 used = Common::MemcachingCaseInsensitiveArchive::getCacheStats().usedBytes;
+		delete archive;
+
+		TS_ASSERT_EQUALS(Common::MemcachingCaseInsensitiveArchive::getCacheStats().usedBytes, used - 110);
+	}
+
+	void test_memcaching_threads() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+		Common::MemcachingCaseInsensitiveArchive::setCacheBudget(300);
+
+		// Both archives share the contents cache, which keeps evicting the
+		// members of one archive while the other thread uses them
+		{
+			MemcachingTestArchive first(200), second(200);
+			MemcachingReadTask firstTask(&first), secondTask(&second);
+			Common::ThreadPool pool(2);
+			pool.submit(&firstTask);
+			pool.submit(&secondTask);
+			firstTask.wait();
+			secondTask.wait();
+
+			TS_ASSERT_EQUALS(firstTask.getErrors(), 0);
+			TS_ASSERT_EQUALS(secondTask.getErrors(), 0);
+			TS_ASSERT_LESS_THAN_EQUALS(Common::MemcachingCaseInsensitiveArchive::getCacheStats().usedBytes, 300u);
+		}
+
+		TS_ASSERT_EQUALS(Common::MemcachingCaseInsensitiveArchive::getCacheStats().usedBytes, 0u);
+		Common::MemcachingCaseInsensitiveArchive::setCacheBudget(1000);
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+private:
+	static int openMember(const Common::SearchSet &set, const char *name) {
+		Common::SeekableReadStream *stream = set.createReadStreamForMember(Common::Path(name));
+		if (!stream)
+			return 0;
+		int id = stream->readByte();
+		delete stream;
+		return id;
+	}
+
+	static void readMember(const MemcachingTestArchive &archive, const char *name) {
+		Common::SeekableReadStream *stream = archive.createReadStreamForMember(Common::Path(name));
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+		TS_ASSERT_EQUALS((uint32)stream->size(), (uint32)atoi(name));
+		TS_ASSERT_EQUALS(stream->readByte(), (byte)(atoi(name) & 0xFF));
+		delete stream;
+	}
+};
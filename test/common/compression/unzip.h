@@ -0,0 +1,222 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/crc.h"
+#include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/compression/deflate.h"
+#include "common/compression/unzip.h"
+
+/**
+ * Checks reading members from a ZIP archive built at runtime, both through
+ * the in-memory path and the streaming path used for large members.
+ */
+class UnzipTestSuite : public CxxTest::TestSuite {
+public:
+	void test_stored_members() {
+		Common::Array<byte> small = makeData(1000, 1);
+		Common::Array<byte> large = makeData(300 * 1024, 2);
+
+		ZipBuilder zip;
+		zip.addMember("small.bin", small, 0, small);
+		zip.addMember("large.bin", large, 0, large);
+
+		Common::ScopedPtr<Common::Archive> archive(zip.open());
+		TS_ASSERT(archive);
+		if (!archive)
+			return;
+
+		checkMember(*archive, "small.bin", small);
+		checkMember(*archive, "large.bin", large);
+		TS_ASSERT(!archive->createReadStreamForMember(Common::Path("missing.bin")));
+	}
+
+	void test_stream_outlives_archive() {
+		Common::Array<byte> large = makeData(100 * 1024, 3);
+
+		ZipBuilder zip;
+		zip.addMember("large.bin", large, 0, large);
+
+		Common::Archive *archive = zip.open();
+		TS_ASSERT(archive);
+		if (!archive)
+			return;
+
+		Common::ScopedPtr<Common::SeekableReadStream> stream(archive->createReadStreamForMember(Common::Path("large.bin")));
+		delete archive;
+
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+		stream->seek(5000);
+		TS_ASSERT_EQUALS(stream->readByte(), large[5000]);
+	}
+
+	void test_memory_members() {
+		Common::Array<byte> large = makeData(100 * 1024, 6);
+
+		ZipBuilder zip;
+		zip.addMember("large.bin", large, 0, large);
+
+		// Stored members of zipfiles in memory, like memory mapped ones,
+		// read the memory directly, other ones go through the zipfile stream
+		for (int inMemory = 0; inMemory < 2; inMemory++) {
+			Common::ScopedPtr<Common::Archive> archive(zip.open(inMemory != 0));
+			TS_ASSERT(archive);
+			if (!archive)
+				return;
+
+			Common::ScopedPtr<Common::SeekableReadStream> stream(archive->createReadStreamForMember(Common::Path("large.bin")));
+			TS_ASSERT_EQUALS(dynamic_cast<Common::MemoryReadStream *>(stream.get()) != nullptr, inMemory != 0);
+			checkMember(*archive, "large.bin", large);
+		}
+	}
+
+	void test_deflated_members() {
+#ifdef USE_ZLIB
+		// Large enough to record a few seek checkpoints
+		Common::Array<byte> small = makeData(4000, 4);
+		Common::Array<byte> large = makeData(5 * 1024 * 1024, 5);
+
+		ZipBuilder zip;
+		zip.addMember("small.bin", small, Z_DEFLATED_METHOD, deflate(small));
+		zip.addMember("large.bin", large, Z_DEFLATED_METHOD, deflate(large));
+
+		Common::ScopedPtr<Common::Archive> archive(zip.open());
+		TS_ASSERT(archive);
+		if (!archive)
+			return;
+
+		checkMember(*archive, "small.bin", small);
+		checkMember(*archive, "large.bin", large);
+#endif
+	}
+
+private:
+	enum {
+		Z_DEFLATED_METHOD = 8
+	};
+
+	// Compressible data which still spans many deflate blocks
+	static Common::Array<byte> makeData(uint32 size, uint32 seed) {
+		Common::Array<byte> data(size);
+		uint32 state = seed;
+		for (uint32 i = 0; i < size; i++) {
+			state = state * 1103515245 + 12345;
+			data[i] = 'a' + ((state >> 16) & 7);
+		}
+		return data;
+	}
+
+#ifdef USE_ZLIB
+	// Raw deflate data, taken out of the gzip stream written by wrapCompressedWriteStream()
+	static Common::Array<byte> deflate(const Common::Array<byte> &data) {
+		Common::MemoryWriteStreamDynamic *out = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(out);
+		gzip->write(data.data(), data.size());
+		gzip->finalize();
+
+		// The gzip header has no optional fields, and is followed by the
+		// deflate data and an 8 byte trailer
+		TS_ASSERT_EQUALS(out->getData()[3], 0);
+		Common::Array<byte> result(out->getData() + 10, out->size() - 18);
+		delete gzip;
+		return result;
+	}
+#endif
+
+	static void checkMember(const Common::Archive &archive, const char *name, const Common::Array<byte> &expected) {
+		Common::ScopedPtr<Common::SeekableReadStream> stream(archive.createReadStreamForMember(Common::Path(name)));
+		TS_ASSERT(stream);
+		if (!stream)
+			return;
+		TS_ASSERT_EQUALS(stream->size(), (int64)expected.size());
+
+		// Sequential read of everything
+		Common::Array<byte> contents(expected.size());
+		TS_ASSERT_EQUALS(stream->read(contents.data(), contents.size()), expected.size());
+		TS_ASSERT(contents == expected);
+
+		// Seeks in both directions
+		const uint32 size = expected.size();
+		const uint32 offsets[] = { size - 100, 10, size / 2, size / 3, size - 1, 0, size / 5 * 4, 1 };
+		for (uint i = 0; i < ARRAYSIZE(offsets); i++) {
+			byte buf[64];
+			uint32 count = MIN<uint32>(sizeof(buf), size - offsets[i]);
+			TS_ASSERT(stream->seek(offsets[i]));
+			TS_ASSERT_EQUALS(stream->read(buf, count), count);
+			TS_ASSERT_EQUALS(memcmp(buf, expected.data() + offsets[i], count), 0);
+		}
+	}
+
+	class ZipBuilder {
+	public:
+		ZipBuilder() : _local(DisposeAfterUse::YES), _central(DisposeAfterUse::YES), _count(0) {}
+
+		void addMember(const char *name, const Common::Array<byte> &data, uint16 method, const Common::Array<byte> &stored) {
+			Common::CRC32 crc;
+			uint32 crcValue = crc.crcFast(data.data(), data.size());
+			uint32 offset = _local.size();
+			uint16 nameLength = strlen(name);
+
+			_local.writeUint32LE(0x04034b50);
+			_local.writeUint16LE(20);
+			_local.writeUint16LE(0);
+			_local.writeUint16LE(method);
+			_local.writeUint32LE(0);
+			_local.writeUint32LE(crcValue);
+			_local.writeUint32LE(stored.size());
+			_local.writeUint32LE(data.size());
+			_local.writeUint16LE(nameLength);
+			_local.writeUint16LE(0);
+			_local.write(name, nameLength);
+			_local.write(stored.data(), stored.size());
+
+			_central.writeUint32LE(0x02014b50);
+			_central.writeUint16LE(20);
+			_central.writeUint16LE(20);
+			_central.writeUint16LE(0);
+			_central.writeUint16LE(method);
+			_central.writeUint32LE(0);
+			_central.writeUint32LE(crcValue);
+			_central.writeUint32LE(stored.size());
+			_central.writeUint32LE(data.size());
+			_central.writeUint16LE(nameLength);
+			_central.writeUint16LE(0);
+			_central.writeUint16LE(0);
+			_central.writeUint16LE(0);
+			_central.writeUint16LE(0);
+			_central.writeUint32LE(0);
+			_central.writeUint32LE(offset);
+			_central.write(name, nameLength);
+
+			_count++;
+		}
+
+		Common::Archive *open(bool inMemory = true) {
+			Common::MemoryWriteStreamDynamic *zip = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+			zip->write(_local.getData(), _local.size());
+			zip->write(_central.getData(), _central.size());
+			zip->writeUint32LE(0x06054b50);
+			zip->writeUint16LE(0);
+			zip->writeUint16LE(0);
+			zip->writeUint16LE(_count);
+			zip->writeUint16LE(_count);
+			zip->writeUint32LE(_central.size());
+			zip->writeUint32LE(_local.size());
+			zip->writeUint16LE(0);
+
+			Common::SeekableReadStream *stream = new Common::MemoryReadStream(zip->getData(), zip->size(), DisposeAfterUse::YES);
+			if (!inMemory)
+				stream = new Common::SeekableSubReadStream(stream, 0, zip->size(), DisposeAfterUse::YES);
+			delete zip;
+			return Common::makeZipArchive(stream);
+		}
+
+	private:
+		Common::MemoryWriteStreamDynamic _local;
+		Common::MemoryWriteStreamDynamic _central;
+		uint16 _count;
+	};
+};
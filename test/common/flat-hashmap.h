@@ -0,0 +1,236 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flat-hashmap.h"
+#include "common/hash-str.h"
+#include "common/hashmap.h"
+
+#include "test/benchmark.h"
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_empty_clear() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(!container.empty());
+		container.clear();
+		TS_ASSERT(container.empty());
+		TS_ASSERT(!container.contains(0));
+		container[2] = 5;
+		TS_ASSERT_EQUALS(container.size(), 1u);
+		container.clear(true);
+		TS_ASSERT(container.empty());
+		TS_ASSERT(!container.contains(2));
+	}
+
+	void test_contains() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(!container.contains(0));
+		container[0] = 17;
+		container[1] = 33;
+		TS_ASSERT(container.contains(0));
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(17));
+		TS_ASSERT(!container.contains(-1));
+	}
+
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+		TS_ASSERT(container.contains(1));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container[1] = 42;
+		TS_ASSERT(container.contains(1));
+		container.erase(container.find(0));
+		container.erase(1);
+		container.erase(2);
+		container.erase(container.find(3));
+		TS_ASSERT(!container.empty());
+		container.erase(4);
+		TS_ASSERT(container.empty());
+		container[1] = 33;
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT_EQUALS(container.size(), 1u);
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+		container.setVal(2, 45);
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef.getVal(2), 45);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(1, -10), -1);
+		TS_ASSERT_EQUALS(containerRef.getValOrDefault(17, -10), -10);
+
+		int val = 0;
+		TS_ASSERT(containerRef.tryGetVal(0, val));
+		TS_ASSERT_EQUALS(val, 17);
+		TS_ASSERT(!containerRef.tryGetVal(3, val));
+		TS_ASSERT_EQUALS(container.size(), 3u);
+	}
+
+	void test_iterator() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		container[3] = 12;
+		container[4] = 96;
+		container.erase(1);
+		container[1] = 42;
+		container.erase(0);
+		container.erase(1);
+
+		int found = 0;
+		for (Common::FlatHashMap<int, int>::const_iterator i = container.begin(); i != container.end(); ++i) {
+			int key = i->_key;
+			TS_ASSERT(key >= 0 && key <= 4);
+			TS_ASSERT(!(found & (1 << key)));
+			found |= 1 << key;
+		}
+		TS_ASSERT(found == 16+8+4);
+
+		for (auto &node : container)
+			node._value = node._key * 2;
+		TS_ASSERT_EQUALS(container[4], 8);
+	}
+
+	void test_copy() {
+		Common::FlatHashMap<int, int> map1, container2;
+		map1[323] = 32;
+		container2 = map1;
+		map1[323] = 1;
+		TS_ASSERT_EQUALS(container2[323], 32);
+
+		Common::FlatHashMap<int, int> container3(container2);
+		TS_ASSERT_EQUALS(container3[323], 32);
+		TS_ASSERT_EQUALS(container3.size(), 1u);
+	}
+
+	void test_string_keys() {
+		Common::FlatHashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> container;
+		container["foo"] = 1;
+		container["Quux"] = 2;
+		TS_ASSERT_EQUALS(container["FOO"], 1);
+
+		// Lookups with a C string don't construct a String
+		const char *name = "quux";
+		TS_ASSERT(container.contains(name));
+		TS_ASSERT_EQUALS(container.find(name)->_value, 2);
+		TS_ASSERT_EQUALS(container.getValOrDefault("bar", -1), -1);
+
+		Common::FlatHashMap<Common::String, int> sensitive;
+		sensitive["\xe9t\xe9"] = 3;
+		TS_ASSERT(sensitive.contains("\xe9t\xe9"));
+		TS_ASSERT(!sensitive.contains("\xc9T\xc9"));
+	}
+
+	void test_many_elements() {
+		// Enough to grow several times, with collisions in the low bits
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 5000; i++)
+			container[i * 64] = i;
+		TS_ASSERT_EQUALS(container.size(), 5000u);
+
+		for (int i = 0; i < 5000; i += 2)
+			container.erase(i * 64);
+		TS_ASSERT_EQUALS(container.size(), 2500u);
+
+		for (int i = 0; i < 5000; i++) {
+			if (i & 1) {
+				TS_ASSERT_EQUALS(container.getValOrDefault(i * 64, -1), i);
+			} else {
+				TS_ASSERT(!container.contains(i * 64));
+			}
+		}
+
+		// Churn through deleted slots without growing forever
+		for (int i = 0; i < 20000; i++) {
+			container[-1 - i] = i;
+			container.erase(-1 - i);
+		}
+		TS_ASSERT_EQUALS(container.size(), 2500u);
+
+		uint count = 0;
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i)
+			count++;
+		TS_ASSERT_EQUALS(count, 2500u);
+
+		Common::FlatHashMap<int, int> reserved;
+		reserved.reserve(1000);
+		for (int i = 0; i < 1000; i++)
+			reserved[i] = i;
+		TS_ASSERT_EQUALS(reserved[999], 999);
+	}
+
+	void test_flat_hashmap_speed() {
+#if RUN_BENCHMARKS
+		Benchmark benchmark;
+		const int count = 200000;
+		Common::Array<Common::String> names;
+		for (int i = 0; i < count; i++)
+			names.push_back(Common::String::format("file%d.dat", i));
+
+		benchmarkInt<Common::HashMap<int, int> >(benchmark, "HashMap<int>", count);
+		benchmarkInt<Common::FlatHashMap<int, int> >(benchmark, "FlatHashMap<int>", count);
+		benchmarkString<Common::HashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >(benchmark, "HashMap<String>", names);
+		benchmarkString<Common::FlatHashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >(benchmark, "FlatHashMap<String>", names);
+#endif
+	}
+
+#if RUN_BENCHMARKS
+private:
+	template<class Map>
+	static void benchmarkInt(Benchmark &benchmark, const char *name, int count) {
+		Map map;
+		benchmark.start();
+		for (int i = 0; i < count; i++)
+			map[i * 7] = i;
+		benchmark.report(Common::String::format("%s inserts", name).c_str(), count);
+
+		// Half of the lookups miss
+		int hits = 0;
+		benchmark.start();
+		for (int round = 0; round < 4; round++) {
+			for (int i = 0; i < count * 2; i++)
+				hits += map.contains(i * 7 / 2);
+		}
+		benchmark.report(Common::String::format("%s lookups", name).c_str(), count * 8);
+		TS_ASSERT_EQUALS(hits, count * 4);
+	}
+
+	template<class Map>
+	static void benchmarkString(Benchmark &benchmark, const char *name, const Common::Array<Common::String> &names) {
+		Map map;
+		benchmark.start();
+		for (uint i = 0; i < names.size(); i++)
+			map[names[i]] = i;
+		benchmark.report(Common::String::format("%s inserts", name).c_str(), names.size());
+
+		int hits = 0;
+		benchmark.start();
+		for (int round = 0; round < 4; round++) {
+			for (uint i = 0; i < names.size(); i++) {
+				hits += map.contains(names[i]);
+				hits += map.contains("missing.dat");
+			}
+		}
+		benchmark.report(Common::String::format("%s lookups", name).c_str(), names.size() * 8);
+		TS_ASSERT_EQUALS(hits, (int)names.size() * 4);
+	}
+#endif
+};
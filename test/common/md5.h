@@ -1,7 +1,10 @@
 #include <cxxtest/TestSuite.h>
 
 #include "common/md5.h"
-#include "common/stream.h"
+#include "common/memstream.h"
+#include "common/xxhash.h"
+
+#include "test/benchmark.h"
 
 /*
  * those are the standard RFC 1321 test vectors
@@ -47,4 +50,48 @@ class MD5TestSuite : public CxxTest::TestSuite {
 		}
 	}
 
+	void test_computeStreamMD5_length() {
+		// Hash a prefix crossing several blocks, compared to hashing it whole
+		byte data[1000];
+		for (int i = 0; i < 1000; i++)
+			data[i] = (byte)(i * 7 + (i >> 3));
+
+		const uint32 lengths[] = { 1, 63, 64, 65, 129, 500, 999 };
+		for (int i = 0; i < ARRAYSIZE(lengths); i++) {
+			Common::MemoryReadStream full(data, 1000);
+			Common::MemoryReadStream prefix(data, lengths[i]);
+			TS_ASSERT_EQUALS(Common::computeStreamMD5AsString(full, lengths[i]), Common::computeStreamMD5AsString(prefix));
+		}
+	}
+
+	void test_md5_speed() {
+#if RUN_BENCHMARKS
+		Benchmark benchmark;
+		const uint32 size = 64 * 1024 * 1024;
+		byte *data = new byte[size];
+		for (uint32 i = 0; i < size; i++)
+			data[i] = (byte)(i ^ (i >> 11));
+
+		Common::MemoryReadStream stream(data, size);
+		benchmark.start();
+		Common::computeStreamMD5AsString(stream);
+		benchmark.report("MD5 KiB", size / 1024);
+
+		// Detection hashes the first few KiB of many files
+		benchmark.start();
+		for (int i = 0; i < 2000; i++) {
+			Common::MemoryReadStream head(data + i * 16, 5000);
+			Common::computeStreamMD5AsString(head, 5000);
+		}
+		benchmark.report("MD5 detection heads", 2000);
+
+		// The non-cryptographic hash, for comparison
+		stream.seek(0);
+		benchmark.start();
+		Common::computeStreamXXHash64(stream);
+		benchmark.report("XXH64 KiB", size / 1024);
+
+		delete[] data;
+#endif
+	}
 };
@@ -0,0 +1,85 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memorypool.h"
+
+class MemoryPoolTestSuite : public CxxTest::TestSuite {
+public:
+	void test_arena_alignment() {
+		Common::Arena arena(256);
+		for (size_t alignment = 1; alignment <= 64; alignment *= 2) {
+			byte *ptr = (byte *)arena.allocate(3, alignment);
+			TS_ASSERT_EQUALS((uintptr)ptr & (alignment - 1), 0u);
+			memset(ptr, 0xFF, 3);
+		}
+
+		double *values = arena.allocateArray<double>(4);
+		TS_ASSERT_EQUALS((uintptr)values % alignof(double), 0u);
+
+		// Requests larger than a block get their own block
+		byte *big = (byte *)arena.allocate(1000);
+		memset(big, 0, 1000);
+		TS_ASSERT_EQUALS(arena.getBlockCount(), 2u);
+	}
+
+	void test_arena_reset() {
+		Common::Arena arena(100);
+		for (int i = 0; i < 10; i++)
+			arena.allocate(64);
+		TS_ASSERT(arena.getBlockCount() > 1);
+		size_t capacity = arena.getCapacity();
+
+		// Resetting merges the blocks, so that the next frame fits into one
+		arena.reset();
+		TS_ASSERT_EQUALS(arena.getBlockCount(), 1u);
+		TS_ASSERT_EQUALS(arena.getCapacity(), capacity);
+		TS_ASSERT_EQUALS(arena.getUsedSize(), 0u);
+
+		for (int i = 0; i < 10; i++)
+			arena.allocate(64);
+		TS_ASSERT_EQUALS(arena.getBlockCount(), 1u);
+		TS_ASSERT_EQUALS(arena.getUsedSize(), 640u);
+
+		arena.freeMemory();
+		TS_ASSERT_EQUALS(arena.getCapacity(), 0u);
+	}
+
+	void test_arena_scope() {
+		Common::Arena arena(128);
+		int *first = arena.create<int>(42);
+		size_t used = arena.getUsedSize();
+
+		{
+			Common::ArenaScope scope(arena);
+			for (int i = 0; i < 20; i++)
+				arena.create<int>(i);
+			TS_ASSERT(arena.getUsedSize() > used);
+		}
+
+		TS_ASSERT_EQUALS(arena.getUsedSize(), used);
+		TS_ASSERT_EQUALS(*first, 42);
+
+		// The released memory is handed out again
+		size_t blocks = arena.getBlockCount();
+		for (int i = 0; i < 20; i++)
+			arena.create<int>(i);
+		TS_ASSERT_EQUALS(arena.getBlockCount(), blocks);
+	}
+
+	void test_frame_allocator() {
+		Common::FrameAllocator frames(64);
+		int *previous = (int *)frames.allocate(sizeof(int));
+		*previous = 1;
+
+		frames.nextFrame();
+		int *current = (int *)frames.allocate(sizeof(int));
+		*current = 2;
+
+		// The data of the previous frame is still there
+		TS_ASSERT_EQUALS(*previous, 1);
+		TS_ASSERT_EQUALS(frames.getPreviousArena().getUsedSize(), sizeof(int));
+
+		frames.nextFrame();
+		TS_ASSERT_EQUALS(frames.getArena().getUsedSize(), 0u);
+		TS_ASSERT_EQUALS(*current, 2);
+	}
+};
@@ -0,0 +1,100 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/ringbuffer.h"
+
+class RingBufferTestSuite : public CxxTest::TestSuite {
+public:
+	void test_capacity() {
+		Common::RingBuffer<int> ring(5);
+		TS_ASSERT_EQUALS(ring.capacity(), 5U);
+		TS_ASSERT(ring.empty());
+		TS_ASSERT(!ring.full());
+	}
+
+	void test_produce_consume() {
+		Common::RingBuffer<int> ring(4);
+
+		// Production gets the whole contiguous space up to the end
+		size_t n = 2;
+		int *out = ring.tryProduce(&n);
+		TS_ASSERT(out);
+		TS_ASSERT_EQUALS(n, 5U);
+		out[0] = 1;
+		out[1] = 2;
+		out[2] = 3;
+		ring.produced(3);
+		TS_ASSERT_EQUALS(ring.size(), 3U);
+
+		n = 2;
+		const int *in = ring.tryConsume(&n);
+		TS_ASSERT(in);
+		TS_ASSERT_EQUALS(n, 2U);
+		TS_ASSERT_EQUALS(in[1], 2);
+		ring.consumed();
+
+		// Not enough room at the end, so this wraps around
+		n = 3;
+		TS_ASSERT(!ring.tryProduce(&n));
+		n = 1;
+		out = ring.tryProduce(&n);
+		TS_ASSERT_EQUALS(n, 2U);
+		out[0] = 4;
+		out[1] = 5;
+		ring.produced(2);
+		TS_ASSERT_EQUALS(ring.size(), 3U);
+
+		int values[4];
+		TS_ASSERT_EQUALS(ring.read(values, 4), 3U);
+		TS_ASSERT_EQUALS(values[0], 3);
+		TS_ASSERT_EQUALS(values[1], 4);
+		TS_ASSERT_EQUALS(values[2], 5);
+	}
+
+	void test_push_pop() {
+		Common::RingBuffer<int> ring(4);
+
+		for (int i = 0; i < 4; i++)
+			TS_ASSERT(ring.push(i));
+		TS_ASSERT(ring.full());
+		TS_ASSERT(!ring.push(4));
+
+		int value = -1;
+		for (int i = 0; i < 4; i++) {
+			TS_ASSERT(ring.pop(value));
+			TS_ASSERT_EQUALS(value, i);
+		}
+		TS_ASSERT(!ring.pop(value));
+		TS_ASSERT(ring.empty());
+	}
+
+	void test_wraparound() {
+		Common::RingBuffer<int> ring(4);
+
+		int in[3] = { 1, 2, 3 };
+		int out[4];
+		for (int round = 0; round < 10; round++) {
+			TS_ASSERT_EQUALS(ring.write(in, 3), 3U);
+			TS_ASSERT_EQUALS(ring.size(), 3U);
+			TS_ASSERT_EQUALS(ring.read(out, 4), 3U);
+			TS_ASSERT_EQUALS(out[0], 1);
+			TS_ASSERT_EQUALS(out[1], 2);
+			TS_ASSERT_EQUALS(out[2], 3);
+		}
+	}
+
+	void test_partial_write() {
+		Common::RingBuffer<int> ring(4);
+
+		int in[6] = { 1, 2, 3, 4, 5, 6 };
+		TS_ASSERT_EQUALS(ring.write(in, 6), 4U);
+		TS_ASSERT_EQUALS(ring.write(in, 6), 0U);
+
+		int out[2];
+		TS_ASSERT_EQUALS(ring.read(out, 2), 2U);
+		TS_ASSERT_EQUALS(out[1], 2);
+		TS_ASSERT_EQUALS(ring.write(in + 4, 2), 2U);
+
+		ring.clear();
+		TS_ASSERT(ring.empty());
+	}
+};
@@ -0,0 +1,122 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/hash-str.h"
+#include "common/str-intern.h"
+
+#include "test/benchmark.h"
+#include "../system/alloc_count.h"
+
+class InternedStringTestSuite : public CxxTest::TestSuite {
+public:
+	void test_identity() {
+		Common::InternedString a("playerName");
+		Common::InternedString b(Common::String("player") + "Name");
+		Common::InternedString c("playername");
+
+		TS_ASSERT(a == b);
+		TS_ASSERT(a != c);
+		TS_ASSERT_EQUALS(a.c_str(), b.c_str());
+		TS_ASSERT_EQUALS(a.toString(), "playerName");
+		TS_ASSERT_EQUALS(a.size(), 10u);
+		TS_ASSERT_EQUALS(a.hash(), b.hash());
+
+		uint tableSize = Common::InternedString::getTableSize();
+		Common::InternedString d("playerName");
+		TS_ASSERT_EQUALS(Common::InternedString::getTableSize(), tableSize);
+		TS_ASSERT(d == a);
+	}
+
+	void test_empty() {
+		Common::InternedString empty;
+		TS_ASSERT(empty.empty());
+		TS_ASSERT(empty == Common::InternedString(""));
+		TS_ASSERT(empty == Common::InternedString(Common::String()));
+		TS_ASSERT_EQUALS(empty.toString(), "");
+		TS_ASSERT_EQUALS(empty.size(), 0u);
+		TS_ASSERT(empty != Common::InternedString("x"));
+		TS_ASSERT(empty == Common::InternedString((const char *)nullptr));
+	}
+
+	void test_frame_allocations() {
+		// A script looking up the same properties every frame, by names too
+		// long to be stored inside Common::String itself
+		static const char *const properties[] = {
+			"character_walking_speed_horizontal", "character_walking_speed_vertical",
+			"inventory_item_highlight_color", "dialogue_subtitle_display_time"
+		};
+		const int lookups = 100;
+
+		Common::HashMap<Common::String, int> stringMap;
+		Common::HashMap<Common::InternedString, int> atomMap;
+		Common::InternedString atoms[ARRAYSIZE(properties)];
+		for (int i = 0; i < ARRAYSIZE(properties); i++) {
+			stringMap[properties[i]] = i;
+			atoms[i] = Common::InternedString(properties[i]);
+			atomMap[atoms[i]] = i;
+		}
+
+		int sum = 0;
+		unsigned int start = Common::getAllocationCount();
+		for (int i = 0; i < lookups; i++)
+			sum += stringMap[properties[i % ARRAYSIZE(properties)]];
+		const unsigned int stringAllocations = Common::getAllocationCount() - start;
+
+		// The names are interned once, when the script is loaded
+		start = Common::getAllocationCount();
+		for (int i = 0; i < lookups; i++)
+			sum -= atomMap[atoms[i % ARRAYSIZE(properties)]];
+		const unsigned int atomAllocations = Common::getAllocationCount() - start;
+
+		TS_ASSERT_EQUALS(sum, 0);
+		TS_ASSERT_EQUALS(stringAllocations, (unsigned int)lookups);
+		TS_ASSERT_EQUALS(atomAllocations, 0u);
+	}
+
+	void test_hashmap_key() {
+		Common::HashMap<Common::InternedString, int> map;
+		map[Common::InternedString("width")] = 320;
+		map[Common::InternedString("height")] = 200;
+
+		TS_ASSERT_EQUALS(map[Common::InternedString("width")], 320);
+		TS_ASSERT_EQUALS(map[Common::InternedString("height")], 200);
+		TS_ASSERT(!map.contains(Common::InternedString("depth")));
+	}
+
+	void test_interned_speed() {
+#if RUN_BENCHMARKS
+		Benchmark benchmark;
+
+		const int count = 1000;
+		const int rounds = 1000;
+		Common::Array<Common::String> names;
+		Common::Array<Common::InternedString> atoms;
+		for (int i = 0; i < count; i++) {
+			names.push_back(Common::String::format("property_name_%d", i));
+			atoms.push_back(Common::InternedString(names[i]));
+		}
+
+		Common::HashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> stringMap;
+		Common::HashMap<Common::InternedString, int> atomMap;
+		for (int i = 0; i < count; i++) {
+			stringMap[names[i]] = i;
+			atomMap[atoms[i]] = i;
+		}
+
+		int sum = 0;
+		benchmark.start();
+		for (int round = 0; round < rounds; round++) {
+			for (int i = 0; i < count; i++)
+				sum += stringMap[names[i]];
+		}
+		benchmark.report("String key lookups", count * rounds);
+
+		benchmark.start();
+		for (int round = 0; round < rounds; round++) {
+			for (int i = 0; i < count; i++)
+				sum -= atomMap[atoms[i]];
+		}
+		benchmark.report("InternedString key lookups", count * rounds);
+		TS_ASSERT_EQUALS(sum, 0);
+#endif
+	}
+};
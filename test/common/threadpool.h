@@ -0,0 +1,195 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/system.h"
+#include "common/threadpool.h"
+#include "../system/null_osystem.h"
+
+#include <atomic>
+
+namespace {
+
+class SumTask : public Common::Task {
+public:
+	SumTask(const int *values, uint count) : _values(values), _count(count), _sum(0) {}
+
+	void run() override {
+		for (uint i = 0; i < _count; i++)
+			_sum += _values[i];
+	}
+
+	int getSum() const { return _sum; }
+
+private:
+	const int *_values;
+	uint _count;
+	int _sum;
+};
+
+struct Answer {
+	int compute() { return 42; }
+};
+
+/** Waits for its partner to run, which only works if they run concurrently. */
+class HandshakeTask : public Common::Task {
+public:
+	HandshakeTask() : _partner(nullptr), _arrived(false), _sawPartner(false) {}
+
+	void setPartner(HandshakeTask *partner) { _partner = partner; }
+
+	void run() override {
+		_arrived.store(true);
+
+		const uint32 start = g_system->getMillis();
+		while (!_partner->_arrived.load()) {
+			if (g_system->getMillis() - start > 5000)
+				return;
+			g_system->delayMillis(1);
+		}
+		_sawPartner = true;
+	}
+
+	bool sawPartner() const { return _sawPartner; }
+
+private:
+	HandshakeTask *_partner;
+	std::atomic<bool> _arrived;
+	bool _sawPartner;
+};
+
+} // End of anonymous namespace
+
+class ThreadPoolTestSuite : public CxxTest::TestSuite {
+public:
+	// The pool needs OSystem for its mutexes
+	void setUp() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+#endif
+	}
+
+	void tearDown() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_synchronous_fallback() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::ThreadPool pool(0);
+		TS_ASSERT(!pool.isAsync());
+		TS_ASSERT_EQUALS(pool.getThreadCount(), 0U);
+
+		int values[] = { 1, 2, 3, 4 };
+		SumTask task(values, 4);
+		TS_ASSERT(!task.isDone());
+
+		pool.submit(&task);
+		TS_ASSERT(task.isDone());
+		TS_ASSERT_EQUALS(task.getSum(), 10);
+#endif
+	}
+
+	void test_threads() {
+#if NULL_OSYSTEM_IS_AVAILABLE && defined(POSIX)
+		// The null OSystem of the tests has pthreads on POSIX
+		Common::ThreadPool pool(2);
+		TS_ASSERT(pool.isAsync());
+		TS_ASSERT_EQUALS(pool.getThreadCount(), 2U);
+
+		HandshakeTask first, second;
+		first.setPartner(&second);
+		second.setPartner(&first);
+		pool.submit(&first);
+		pool.submit(&second);
+		pool.waitAll();
+		TS_ASSERT(first.sawPartner());
+		TS_ASSERT(second.sawPartner());
+#endif
+	}
+
+	void test_many_tasks() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		// More tasks than workers, of uneven length, so that the workers
+		// steal from each other
+		Common::ThreadPool pool(3);
+
+		int values[1000];
+		for (int i = 0; i < 1000; i++)
+			values[i] = i;
+
+		Common::Array<SumTask *> tasks;
+		for (int round = 0; round < 20; round++) {
+			for (int i = 0; i < 40; i++) {
+				const uint count = (i % 5) * 50 + 1;
+				tasks.push_back(new SumTask(values, count));
+				pool.submit(tasks.back());
+			}
+
+			// The calling thread helps while waiting on a task in the middle
+			tasks[tasks.size() / 2]->wait();
+		}
+		pool.waitAll();
+
+		for (uint i = 0; i < tasks.size(); i++) {
+			const int count = ((i % 40) % 5) * 50 + 1;
+			TS_ASSERT(tasks[i]->isDone());
+			TS_ASSERT_EQUALS(tasks[i]->getSum(), count * (count - 1) / 2);
+			delete tasks[i];
+		}
+#endif
+	}
+
+	void test_wait() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::ThreadPool pool(4);
+
+		int values[64];
+		for (int i = 0; i < 64; i++)
+			values[i] = i;
+
+		SumTask *tasks[8];
+		for (int i = 0; i < 8; i++) {
+			tasks[i] = new SumTask(values + i * 8, 8);
+			pool.submit(tasks[i]);
+		}
+
+		int sum = 0;
+		for (int i = 0; i < 8; i++) {
+			tasks[i]->wait();
+			TS_ASSERT(tasks[i]->isDone());
+			sum += tasks[i]->getSum();
+			delete tasks[i];
+		}
+		TS_ASSERT_EQUALS(sum, 63 * 64 / 2);
+#endif
+	}
+
+	void test_wait_all_and_resubmit() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::ThreadPool pool(2);
+
+		int values[] = { 5, 6 };
+		SumTask task(values, 2);
+
+		pool.submit(&task);
+		pool.waitAll();
+		TS_ASSERT(task.isDone());
+		TS_ASSERT_EQUALS(task.getSum(), 11);
+
+		pool.submit(&task);
+		pool.waitAll();
+		TS_ASSERT_EQUALS(task.getSum(), 22);
+#endif
+	}
+
+	void test_future() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::ThreadPool pool(2);
+
+		Answer answer;
+		Common::Future<int> future(new Common::Functor0Mem<int, Answer>(&answer, &Answer::compute));
+		pool.submit(&future);
+		TS_ASSERT_EQUALS(future.get(), 42);
+#endif
+	}
+};
@@ -0,0 +1,42 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/xxhash.h"
+
+class XXHashTestSuite : public CxxTest::TestSuite {
+public:
+	void test_vectors() {
+		TS_ASSERT_EQUALS(Common::computeXXHash64("", 0), 0xEF46DB3751D8E999ULL);
+		TS_ASSERT_EQUALS(Common::computeXXHash64("a", 1), 0xD24EC4F1A98C6E5BULL);
+		TS_ASSERT_EQUALS(Common::computeXXHash64("abc", 3), 0x44BC2CF5AD770999ULL);
+	}
+
+	void test_incremental() {
+		// Split the data at every possible point, crossing the 32-byte stripes
+		byte data[100];
+		for (int i = 0; i < 100; i++)
+			data[i] = (byte)(i * 13 + 5);
+
+		const uint64 expected = Common::computeXXHash64(data, 100, 42);
+		for (uint32 split = 0; split <= 100; split++) {
+			Common::XXHash64 hash(42);
+			hash.update(data, split);
+			hash.update(data + split, 100 - split);
+			TS_ASSERT_EQUALS(hash.digest(), expected);
+		}
+
+		TS_ASSERT_DIFFERS(Common::computeXXHash64(data, 100, 0), expected);
+	}
+
+	void test_stream() {
+		byte data[100];
+		for (int i = 0; i < 100; i++)
+			data[i] = (byte)(i ^ 0x5A);
+
+		Common::MemoryReadStream stream(data, 100);
+		TS_ASSERT_EQUALS(Common::computeStreamXXHash64(stream), Common::computeXXHash64(data, 100));
+
+		stream.seek(0);
+		TS_ASSERT_EQUALS(Common::computeStreamXXHash64(stream, 37), Common::computeXXHash64(data, 37));
+	}
+};
@@ -0,0 +1,91 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/dirtyrects.h"
+
+class DirtyRegionTestSuite : public CxxTest::TestSuite {
+public:
+	void test_add_rects() {
+		Graphics::DirtyRegion region(100, 50, 10);
+		TS_ASSERT(region.empty());
+
+		// Overlapping and adjacent rects are joined
+		region.addRect(Common::Rect(5, 5, 25, 15));
+		region.addRect(Common::Rect(20, 10, 30, 20));
+		region.addRect(Common::Rect(30, 5, 38, 9));
+		TS_ASSERT(!region.empty());
+
+		Common::Array<Common::Rect> rects;
+		region.getRects(rects);
+		TS_ASSERT_EQUALS(rects.size(), 2u);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(0, 0, 40, 10));
+		TS_ASSERT_EQUALS(rects[1], Common::Rect(0, 10, 30, 20));
+
+		TS_ASSERT(region.intersects(Common::Rect(35, 5, 36, 6)));
+		TS_ASSERT(!region.intersects(Common::Rect(45, 0, 100, 50)));
+	}
+
+	void test_disjoint_cover() {
+		Graphics::DirtyRegion region(64, 64, 8);
+		region.addRect(Common::Rect(0, 0, 20, 20));
+		region.addRect(Common::Rect(10, 10, 40, 30));
+		region.addRect(Common::Rect(50, 50, 70, 70));
+
+		Common::Array<Common::Rect> rects;
+		region.getRects(rects);
+
+		// Each dirty tile is covered exactly once, and nothing else
+		for (int y = 0; y < 64; y += 8) {
+			for (int x = 0; x < 64; x += 8) {
+				int count = 0;
+				for (uint i = 0; i < rects.size(); i++) {
+					if (rects[i].contains(x, y))
+						count++;
+				}
+				TS_ASSERT_EQUALS(count, region.intersects(Common::Rect(x, y, x + 1, y + 1)) ? 1 : 0);
+			}
+		}
+
+		// Rects are clipped to the surface
+		TS_ASSERT_EQUALS(rects.back(), Common::Rect(48, 48, 64, 64));
+	}
+
+	void test_subtract() {
+		Graphics::DirtyRegion region(100, 35, 10);
+		region.markAll();
+
+		// Only fully covered tiles are removed, up to the edges
+		region.subtractRect(Common::Rect(15, 0, 100, 35));
+		Common::Array<Common::Rect> rects;
+		region.getRects(rects);
+		TS_ASSERT_EQUALS(rects.size(), 1u);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(0, 0, 20, 35));
+
+		Graphics::DirtyRegion other(100, 35, 10);
+		other.addRect(Common::Rect(0, 0, 5, 5));
+		region.subtractRegion(other);
+		TS_ASSERT(!region.intersects(Common::Rect(0, 0, 10, 10)));
+
+		other.clear();
+		other.addRect(Common::Rect(90, 30, 95, 31));
+		region.addRegion(other);
+		TS_ASSERT(region.intersects(Common::Rect(99, 34, 100, 35)));
+
+		region.subtractRect(Common::Rect(0, 0, 100, 35));
+		TS_ASSERT(region.empty());
+	}
+
+	void test_max_rects() {
+		Graphics::DirtyRegion region(320, 200, 16);
+		for (int i = 0; i < 10; i++)
+			region.addRect(Common::Rect(i * 32, i * 16, i * 32 + 1, i * 16 + 1));
+
+		Common::Array<Common::Rect> rects;
+		region.getRects(rects);
+		TS_ASSERT_EQUALS(rects.size(), 10u);
+
+		// Too many rects are replaced by their bounds
+		region.getRects(rects, 4);
+		TS_ASSERT_EQUALS(rects.size(), 1u);
+		TS_ASSERT_EQUALS(rects[0], Common::Rect(0, 0, 304, 160));
+	}
+};
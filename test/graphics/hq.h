@@ -0,0 +1,168 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/scaler/hq.h"
+#include "graphics/scaler/hq_intern.h"
+#include "graphics/scaler/intern.h"
+#include "graphics/surface.h"
+
+#include "test/benchmark.h"
+#include "test/instrset_detect.h"
+
+class HQScalerTestSuite : public CxxTest::TestSuite {
+public:
+	void test_kernels() {
+#ifdef USE_HQ_SCALERS
+#ifdef SCUMMVM_NEON
+		checkKernels(g_hqKernelsNEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			checkKernels(g_hqKernelsSSE2);
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			checkKernels(g_hqKernelsAVX2);
+#endif
+#endif
+	}
+
+	void test_speed() {
+#if RUN_BENCHMARKS && defined(USE_HQ_SCALERS)
+		// Builds with and without USE_NASM can be compared on x86, since
+		// the assembly versions replace the 16 bit scalers
+		Benchmark benchmark;
+		const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat::createFormatARGB32()
+		};
+		for (uint f = 0; f < ARRAYSIZE(formats); f++) {
+			// A 320x200 screen, with the rows and columns read around it
+			Graphics::Surface src;
+			src.create(322, 202, formats[f]);
+			uint32 seed = 1;
+			for (int y = 0; y < src.h; y++) {
+				for (int x = 0; x < src.w; x++) {
+					// Flat areas with noisy edges, like most game graphics
+					seed = seed * 1103515245 + 12345;
+					const byte level = ((x / 8 + y / 8) & 1) ? 0x40 : 0xC0;
+					const uint32 color = formats[f].RGBToColor(level + (seed >> 29), level, level - (seed >> 30));
+					if (src.format.bytesPerPixel == 2)
+						*(uint16 *)src.getBasePtr(x, y) = color;
+					else
+						*(uint32 *)src.getBasePtr(x, y) = color;
+				}
+			}
+
+			HQScaler scaler(formats[f]);
+			for (uint factor = 2; factor <= 3; factor++) {
+				scaler.setFactor(factor);
+				Graphics::Surface dst;
+				dst.create(320 * factor, 200 * factor, formats[f]);
+				benchmark.start();
+				for (int i = 0; i < 200; i++)
+					scaler.scale((const byte *)src.getBasePtr(1, 1), src.pitch, (byte *)dst.getPixels(), dst.pitch, 320, 200, 0, 0);
+				benchmark.report(Common::String::format("HQ%ux %d bit frames", factor, formats[f].bytesPerPixel * 8).c_str(), 200);
+				dst.free();
+			}
+			src.free();
+		}
+
+		// The pattern classification alone, against the C code. A pixel
+		// changes at each pass, so that none of them can be skipped, and
+		// each one changes an even number of times, so that both end with
+		// the rows they started with.
+		const int passes = (kWidth + 2) * 1500;
+		uint32 above[kWidth + 2], row[kWidth + 2], below[kWidth + 2];
+		byte expected[kWidth], patterns[kWidth];
+		uint32 seed = 1;
+		fillRow(above, seed);
+		fillRow(row, seed);
+		fillRow(below, seed);
+
+		benchmark.start();
+		for (int i = 0; i < passes; i++) {
+			row[i % (kWidth + 2)] ^= 0x100000;
+			for (int x = 0; x < kWidth; x++)
+				expected[x] = expectedPattern(above, row, below, x);
+		}
+		benchmark.report("HQ C rows", passes);
+
+		const HQKernels *kernels = getHQKernels();
+		if (kernels) {
+			int classified = 0;
+			benchmark.start();
+			for (int i = 0; i < passes; i++) {
+				row[i % (kWidth + 2)] ^= 0x100000;
+				classified = kernels->classifyRow(patterns, above, row, below, kWidth);
+			}
+			benchmark.report("HQ SIMD rows", passes);
+
+			TS_ASSERT_SAME_DATA(patterns, expected, classified);
+		}
+#endif
+	}
+
+private:
+	enum {
+		// Not a multiple of the block sizes, so that there is a tail
+		kWidth = 67
+	};
+
+	static void fillRow(uint32 *row, uint32 &seed) {
+		for (int x = 0; x < kWidth + 2; x++) {
+			// Each component close to its threshold from the base value,
+			// on either side, so that both results show up
+			seed = seed * 1103515245 + 12345;
+			const int y = 0x80 + (int)((seed >> 8) % (kHQThresholdY * 2 + 3)) - kHQThresholdY - 1;
+			const int u = 0x80 + (int)((seed >> 16) % (kHQThresholdU * 2 + 3)) - kHQThresholdU - 1;
+			const int v = 0x80 + (int)((seed >> 24) % (kHQThresholdV * 2 + 3)) - kHQThresholdV - 1;
+			row[x] = (y << 16) | (u << 8) | v;
+		}
+	}
+
+	static byte expectedPattern(const uint32 *above, const uint32 *row, const uint32 *below, int x) {
+		const uint32 yuv = row[x + 1];
+		byte pattern = 0;
+		if (diffYUV(yuv, above[x])) pattern |= 0x01;
+		if (diffYUV(yuv, above[x + 1])) pattern |= 0x02;
+		if (diffYUV(yuv, above[x + 2])) pattern |= 0x04;
+		if (diffYUV(yuv, row[x])) pattern |= 0x08;
+		if (diffYUV(yuv, row[x + 2])) pattern |= 0x10;
+		if (diffYUV(yuv, below[x])) pattern |= 0x20;
+		if (diffYUV(yuv, below[x + 1])) pattern |= 0x40;
+		if (diffYUV(yuv, below[x + 2])) pattern |= 0x80;
+		return pattern;
+	}
+
+	void checkKernels(const HQKernels &kernels) {
+		uint32 above[kWidth + 2], row[kWidth + 2], below[kWidth + 2];
+		byte patterns[kWidth];
+		uint32 seed = 1;
+		int errors = 0;
+
+		for (int i = 0; i < 64 && errors < 8; i++) {
+			fillRow(above, seed);
+			fillRow(row, seed);
+			fillRow(below, seed);
+
+			const int classified = kernels.classifyRow(patterns, above, row, below, kWidth);
+			TS_ASSERT(classified > 0 && classified < kWidth);
+			for (int x = 0; x < classified; x++) {
+				if (patterns[x] != expectedPattern(above, row, below, x)) {
+					TS_ASSERT_EQUALS(patterns[x], expectedPattern(above, row, below, x));
+					errors++;
+				}
+			}
+		}
+
+		// Flat areas have no edges, and partial blocks are left alone
+		for (int x = 0; x < kWidth + 2; x++)
+			above[x] = row[x] = below[x] = 0x801010;
+		memset(patterns, 0xAA, sizeof(patterns));
+		const int classified = kernels.classifyRow(patterns, above, row, below, kWidth);
+		for (int x = 0; x < classified; x++)
+			TS_ASSERT_EQUALS(patterns[x], 0);
+		TS_ASSERT_EQUALS(patterns[classified], 0xAA);
+		TS_ASSERT_EQUALS(kernels.classifyRow(patterns, above, row, below, 7), 0);
+	}
+};
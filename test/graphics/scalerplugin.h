@@ -0,0 +1,110 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/threadpool.h"
+#include "graphics/scalerplugin.h"
+#include "graphics/scaler/hq.h"
+#include "graphics/scaler/sai.h"
+#include "graphics/scaler/scalebit.h"
+
+#include "../system/null_osystem.h"
+
+class ScalerPluginTestSuite : public CxxTest::TestSuite {
+public:
+	void setUp() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+#endif
+	}
+
+	void tearDown() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_bands() {
+#if NULL_OSYSTEM_IS_AVAILABLE && defined(USE_SCALERS)
+		for (uint f = 0; f < ARRAYSIZE(kFormats); f++) {
+			const Graphics::PixelFormat &format = kFormats[f];
+
+			AdvMameScaler advMame(format);
+			for (uint factor = 2; factor <= 4; factor++) {
+				advMame.setFactor(factor);
+				checkBands(advMame, format);
+			}
+
+			SAIScaler sai(format);
+			checkBands(sai, format);
+
+#ifdef USE_HQ_SCALERS
+			HQScaler hq(format);
+			for (uint factor = 2; factor <= 3; factor++) {
+				hq.setFactor(factor);
+				checkBands(hq, format);
+			}
+#endif
+		}
+#endif
+	}
+
+private:
+	static const Graphics::PixelFormat kFormats[2];
+
+	enum {
+		kPadding = 4,
+		kWidth = 64,
+		// Not a multiple of the band count, so that the last band is larger
+		kHeight = 67
+	};
+
+	static void fillSurface(Graphics::Surface &surface) {
+		uint32 seed = 1;
+		for (int y = 0; y < surface.h; y++) {
+			for (int x = 0; x < surface.w; x++) {
+				// Large flat areas, so that the scalers find some edges
+				seed = seed * 1103515245 + 12345;
+				const byte level = (x / 5 + y / 3) & 1 ? 0x20 : 0xE0;
+				const uint32 color = surface.format.RGBToColor(level, (seed >> 16) & 0x80 ? level : 0x60, 0xFF - level);
+				if (surface.format.bytesPerPixel == 2)
+					*(uint16 *)surface.getBasePtr(x, y) = color;
+				else
+					*(uint32 *)surface.getBasePtr(x, y) = color;
+			}
+		}
+	}
+
+	void checkBands(Scaler &scaler, const Graphics::PixelFormat &format) {
+		const uint factor = scaler.getFactor();
+
+		Graphics::Surface src, expected, actual;
+		src.create(kWidth + kPadding * 2, kHeight + kPadding * 2, format);
+		fillSurface(src);
+		expected.create(kWidth * factor, kHeight * factor, src.format);
+		actual.create(kWidth * factor, kHeight * factor, src.format);
+
+		const byte *srcPtr = (const byte *)src.getBasePtr(kPadding, kPadding);
+		scaler.setThreadPool(nullptr);
+		scaler.scale(srcPtr, src.pitch, (byte *)expected.getPixels(), expected.pitch, kWidth, kHeight, 0, 0);
+
+		Common::ThreadPool pool(4);
+		scaler.setThreadPool(&pool);
+		scaler.scale(srcPtr, src.pitch, (byte *)actual.getPixels(), actual.pitch, kWidth, kHeight, 0, 0);
+		scaler.setThreadPool(nullptr);
+
+		for (int y = 0; y < actual.h; y++) {
+			if (memcmp(expected.getBasePtr(0, y), actual.getBasePtr(0, y), actual.w * actual.format.bytesPerPixel)) {
+				TS_FAIL(Common::String::format("Row %d differs at factor %u", y, factor).c_str());
+				break;
+			}
+		}
+
+		src.free();
+		expected.free();
+		actual.free();
+	}
+};
+
+const Graphics::PixelFormat ScalerPluginTestSuite::kFormats[2] = {
+	Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+	Graphics::PixelFormat::createFormatARGB32()
+};
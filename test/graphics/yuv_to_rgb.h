@@ -0,0 +1,150 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+#include "graphics/yuv_to_rgb_intern.h"
+
+#include "test/instrset_detect.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite {
+public:
+	void test_convert() {
+		for (uint f = 0; f < ARRAYSIZE(kFormats); f++) {
+			for (int scale = 0; scale < 2; scale++) {
+				const Graphics::PixelFormat &format = kFormats[f];
+				const Graphics::YUVToRGBManager::LuminanceScale lumScale = scale ? Graphics::YUVToRGBManager::kScaleITU : Graphics::YUVToRGBManager::kScaleFull;
+
+				// Odd chroma counts leave a tail for the table code
+				const int width = 2 * 45, height = 6;
+				byte yPlane[width * height], uPlane[width * height], vPlane[width * height];
+				fillPlane(yPlane, width * height, 3);
+				fillPlane(uPlane, width * height, 5);
+				fillPlane(vPlane, width * height, 7);
+
+				Graphics::Surface surface;
+				surface.create(width, height, format);
+
+				YUVToRGBMan.convert444(&surface, lumScale, yPlane, uPlane, vPlane, width, height, width, width);
+				for (int y = 0; y < height; y++)
+					for (int x = 0; x < width; x++)
+						checkPixel(surface, x, y, yPlane[y * width + x], uPlane[y * width + x], vPlane[y * width + x], lumScale);
+
+				YUVToRGBMan.convert422(&surface, lumScale, yPlane, uPlane, vPlane, width, height, width, width / 2);
+				for (int y = 0; y < height; y++)
+					for (int x = 0; x < width; x++)
+						checkPixel(surface, x, y, yPlane[y * width + x], uPlane[y * width / 2 + x / 2], vPlane[y * width / 2 + x / 2], lumScale);
+
+				YUVToRGBMan.convert420(&surface, lumScale, yPlane, uPlane, vPlane, width, height, width, width / 2);
+				for (int y = 0; y < height; y++)
+					for (int x = 0; x < width; x++)
+						checkPixel(surface, x, y, yPlane[y * width + x], uPlane[y / 2 * width / 2 + x / 2], vPlane[y / 2 * width / 2 + x / 2], lumScale);
+
+				surface.free();
+			}
+		}
+	}
+
+	void test_kernels() {
+#ifdef SCUMMVM_NEON
+		checkKernels(Graphics::g_yuvToRGBKernelsNEON);
+#endif
+#ifdef SCUMMVM_SSE2
+		if (instrset_detect() >= 2)
+			checkKernels(Graphics::g_yuvToRGBKernelsSSE2);
+#endif
+#ifdef SCUMMVM_AVX2
+		if (instrset_detect() >= 8)
+			checkKernels(Graphics::g_yuvToRGBKernelsAVX2);
+#endif
+	}
+
+private:
+	static const Graphics::PixelFormat kFormats[5];
+
+	static void fillPlane(byte *plane, int size, uint32 seed) {
+		for (int i = 0; i < size; i++) {
+			seed = seed * 1103515245 + 12345;
+			plane[i] = seed >> 16;
+		}
+	}
+
+	// Same as the lookup tables, written out without them
+	static uint32 expectedPixel(const Graphics::PixelFormat &format, int y, int u, int v, Graphics::YUVToRGBManager::LuminanceScale scale) {
+		const int cr = v - 128, cb = u - 128;
+		const int r = y + (int16)((0.419 / 0.299) * cr);
+		const int g = y + (int16)(-(0.299 / 0.419) * cr) + (int16)(-(0.114 / 0.331) * cb);
+		const int b = y + (int16)((0.587 / 0.331) * cb);
+		return format.RGBToColor(clip(r, scale), clip(g, scale), clip(b, scale));
+	}
+
+	static byte clip(int val, Graphics::YUVToRGBManager::LuminanceScale scale) {
+		if (scale == Graphics::YUVToRGBManager::kScaleITU)
+			return (CLIP(val, 16, 235) - 16) * 255 / 219;
+		return CLIP(val, 0, 255);
+	}
+
+	static void checkPixel(const Graphics::Surface &surface, int x, int y, int yVal, int u, int v, Graphics::YUVToRGBManager::LuminanceScale scale) {
+		const uint32 color = surface.format.bytesPerPixel == 2 ? *(const uint16 *)surface.getBasePtr(x, y) : *(const uint32 *)surface.getBasePtr(x, y);
+		TS_ASSERT_EQUALS(color, expectedPixel(surface.format, yVal, u, v, scale));
+	}
+
+	static uint32 readPixel(const byte *row, int x, int bytesPerPixel) {
+		return bytesPerPixel == 2 ? READ_UINT16(row + x * 2) : READ_UINT32(row + x * 4);
+	}
+
+	void checkKernels(const Graphics::YUVToRGBKernels &kernels) {
+		// Every chroma pair with varying luminance, in rows of 256 pixels
+		byte yRow[256], uRow[256], vRow[256];
+		byte dst[256 * 4];
+
+		for (uint f = 0; f < ARRAYSIZE(kFormats); f++) {
+			for (int scale = 0; scale < 2; scale++) {
+				const Graphics::PixelFormat &format = kFormats[f];
+				const Graphics::YUVToRGBManager::LuminanceScale lumScale = scale ? Graphics::YUVToRGBManager::kScaleITU : Graphics::YUVToRGBManager::kScaleFull;
+				const Graphics::YUVToRGBRowParams params(format, lumScale);
+				int errors = 0;
+
+				for (int v = 0; v < 256 && errors < 8; v++) {
+					for (int x = 0; x < 256; x++) {
+						yRow[x] = x * 7 + v * 13;
+						uRow[x] = x;
+						vRow[x] = v;
+					}
+
+					const int converted444 = kernels.convertRow444(dst, yRow, uRow, vRow, 256, params);
+					TS_ASSERT_EQUALS(converted444, 256);
+					for (int x = 0; x < converted444; x++) {
+						if (readPixel(dst, x, format.bytesPerPixel) != expectedPixel(format, yRow[x], uRow[x], v, lumScale)) {
+							TS_ASSERT_EQUALS(readPixel(dst, x, format.bytesPerPixel), expectedPixel(format, yRow[x], uRow[x], v, lumScale));
+							errors++;
+						}
+					}
+
+					const int converted422 = kernels.convertRow422(dst, yRow, uRow, vRow, 256, params);
+					TS_ASSERT_EQUALS(converted422, 256);
+					for (int x = 0; x < converted422; x++) {
+						if (readPixel(dst, x, format.bytesPerPixel) != expectedPixel(format, yRow[x], uRow[x / 2], v, lumScale)) {
+							TS_ASSERT_EQUALS(readPixel(dst, x, format.bytesPerPixel), expectedPixel(format, yRow[x], uRow[x / 2], v, lumScale));
+							errors++;
+						}
+					}
+				}
+
+				// Partial blocks are left alone
+				memset(dst, 0xAA, sizeof(dst));
+				const int converted = kernels.convertRow444(dst, yRow, uRow, vRow, 7, params);
+				TS_ASSERT_EQUALS(converted, 0);
+				TS_ASSERT_EQUALS(dst[0], 0xAA);
+				TS_ASSERT_EQUALS(kernels.convertRow422(dst, yRow, uRow, vRow, 47, params) % 2, 0);
+			}
+		}
+	}
+};
+
+const Graphics::PixelFormat YUVToRGBTestSuite::kFormats[5] = {
+	Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+	Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15),
+	Graphics::PixelFormat::createFormatARGB32(),
+	Graphics::PixelFormat::createFormatRGBA32(),
+	Graphics::PixelFormat::createFormatABGR32(false)
+};
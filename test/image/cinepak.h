@@ -0,0 +1,193 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/memstream.h"
+#include "common/threadpool.h"
+#include "graphics/surface.h"
+#include "image/codecs/cinepak.h"
+
+#include "../system/null_osystem.h"
+
+namespace {
+
+/** Writes Cinepak frames, with the flag words placed where the decoder reads them. */
+class CinepakWriter {
+public:
+	CinepakWriter(uint32 seed) : _seed(seed), _flagPos(0), _bit(32) {}
+
+	Common::Array<byte> makeFrame(uint16 width, uint16 stripHeight, uint16 stripCount, bool inter) {
+		Common::Array<byte> strips;
+		for (uint16 i = 0; i < stripCount; i++) {
+			Common::Array<byte> chunks;
+
+			if (!inter || i == 1) {
+				// Full codebooks in the first strip, a partial update in the second one
+				if (i == 0) {
+					addCodebook(chunks, 0x20, false);
+					addCodebook(chunks, 0x22, false);
+				} else {
+					addCodebook(chunks, 0x21, true);
+				}
+			}
+
+			addVectors(chunks, inter ? 0x31 : (i == 2 ? 0x32 : 0x30), width, stripHeight / 2);
+			addVectors(chunks, 0x31, width, stripHeight / 2);
+
+			writeUint16(strips, 0x1000);
+			writeUint16(strips, chunks.size() + 12);
+			writeUint16(strips, 0);
+			writeUint16(strips, 0);
+			writeUint16(strips, stripHeight);
+			writeUint16(strips, width);
+			strips.push_back(chunks);
+		}
+
+		Common::Array<byte> frame;
+		const uint32 length = strips.size() + 10;
+		frame.push_back(0);
+		frame.push_back(length >> 16);
+		writeUint16(frame, length & 0xFFFF);
+		writeUint16(frame, width);
+		writeUint16(frame, stripHeight * stripCount);
+		writeUint16(frame, stripCount);
+		frame.push_back(strips);
+		return frame;
+	}
+
+private:
+	uint32 _seed;
+	uint _flagPos, _bit;
+
+	byte nextByte() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 16;
+	}
+
+	static void writeUint16(Common::Array<byte> &data, uint16 value) {
+		data.push_back(value >> 8);
+		data.push_back(value & 0xFF);
+	}
+
+	void putBit(Common::Array<byte> &data, bool set) {
+		if (_bit == 32) {
+			_flagPos = data.size();
+			for (int i = 0; i < 4; i++)
+				data.push_back(0);
+			_bit = 0;
+		}
+
+		if (set)
+			data[_flagPos + _bit / 8] |= 0x80 >> (_bit % 8);
+		_bit++;
+	}
+
+	void addChunk(Common::Array<byte> &chunks, byte chunkID, const Common::Array<byte> &data) {
+		const uint32 size = data.size() + 4;
+		chunks.push_back(chunkID);
+		chunks.push_back(size >> 16);
+		writeUint16(chunks, size & 0xFFFF);
+		chunks.push_back(data);
+	}
+
+	void addCodebook(Common::Array<byte> &chunks, byte chunkID, bool partial) {
+		Common::Array<byte> data;
+		_bit = 32;
+
+		for (int i = 0; i < 256; i++) {
+			if (partial) {
+				const bool update = nextByte() & 1;
+				putBit(data, update);
+				if (!update)
+					continue;
+			}
+
+			for (int j = 0; j < 6; j++)
+				data.push_back(nextByte());
+		}
+
+		addChunk(chunks, chunkID, data);
+	}
+
+	void addVectors(Common::Array<byte> &chunks, byte chunkID, uint16 width, uint16 height) {
+		Common::Array<byte> data;
+		_bit = 32;
+
+		for (uint16 y = 0; y < height; y += 4) {
+			for (uint16 x = 0; x < width; x += 4) {
+				if (chunkID & 0x01) {
+					const bool coded = nextByte() & 1;
+					putBit(data, coded);
+					if (!coded)
+						continue;
+				}
+
+				bool v4 = false;
+				if (!(chunkID & 0x02)) {
+					v4 = nextByte() & 1;
+					putBit(data, v4);
+				}
+
+				for (int i = 0; i < (v4 ? 4 : 1); i++)
+					data.push_back(nextByte());
+			}
+		}
+
+		addChunk(chunks, chunkID, data);
+	}
+};
+
+} // End of anonymous namespace
+
+class CinepakTestSuite : public CxxTest::TestSuite {
+public:
+	void setUp() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+#endif
+	}
+
+	void tearDown() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_parallel_strips() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		// Every strip has two vector chunks, and the strips inherit the
+		// codebooks of the previous ones
+		CinepakWriter writer(1);
+		Common::Array<byte> frames[3];
+		frames[0] = writer.makeFrame(64, 16, 4, false);
+		frames[1] = writer.makeFrame(64, 16, 4, true);
+		frames[2] = writer.makeFrame(64, 16, 4, true);
+
+		// Paletted output, as the null backend has no screen format to
+		// pick the high color format from
+		Common::ThreadPool pool(4);
+		Image::CinepakDecoder serialDecoder(8), parallelDecoder(8);
+		parallelDecoder.setThreadPool(&pool);
+
+		for (uint i = 0; i < ARRAYSIZE(frames); i++) {
+			Common::MemoryReadStream serialStream(frames[i].data(), frames[i].size());
+			Common::MemoryReadStream parallelStream(frames[i].data(), frames[i].size());
+			const Graphics::Surface *expected = serialDecoder.decodeFrame(serialStream);
+			const Graphics::Surface *actual = parallelDecoder.decodeFrame(parallelStream);
+
+			TS_ASSERT(expected && actual);
+			if (!expected || !actual)
+				return;
+			TS_ASSERT_EQUALS(actual->h, 64);
+			TS_ASSERT_EQUALS(memcmp(expected->getPixels(), actual->getPixels(), expected->h * expected->pitch), 0);
+		}
+
+		// Going back to the calling thread gives the same frames
+		parallelDecoder.setThreadPool(nullptr);
+		Common::MemoryReadStream serialStream(frames[1].data(), frames[1].size());
+		Common::MemoryReadStream parallelStream(frames[1].data(), frames[1].size());
+		const Graphics::Surface *expected = serialDecoder.decodeFrame(serialStream);
+		const Graphics::Surface *actual = parallelDecoder.decodeFrame(parallelStream);
+		TS_ASSERT_EQUALS(memcmp(expected->getPixels(), actual->getPixels(), expected->h * expected->pitch), 0);
+#endif
+	}
+};
@@ -8,19 +8,31 @@
 TESTS        := $(srcdir)/test/common/*.h \
 	$(srcdir)/test/common/compression/*.h \
 	$(srcdir)/test/common/formats/*.h \
+	$(srcdir)/test/graphics/dirtyrects.h \
+	$(srcdir)/test/graphics/hq.h \
+	$(srcdir)/test/graphics/scalerplugin.h \
+	$(srcdir)/test/graphics/yuv_to_rgb.h \
 	$(srcdir)/test/audio/*.h \
 	$(srcdir)/test/math/*.h \
-	$(srcdir)/test/image/*.h
+	$(srcdir)/test/image/*.h \
+	$(srcdir)/test/video/*.h
 TEST_LIBS    :=
 
 ifdef POSIX
+TESTS += $(srcdir)/test/backends/*.h
 TEST_LIBS += test/system/null_osystem.o \
+	test/system/file_mode.o \
+	test/system/alloc_count.o \
 	backends/fs/posix/posix-fs-factory.o \
 	backends/fs/posix/posix-fs.o \
 	backends/fs/posix/posix-iostream.o \
+	backends/fs/posix/posix-mappedstream.o \
 	backends/fs/abstract-fs.o \
 	backends/fs/stdiostream.o \
-	backends/modular-backend.o
+	backends/modular-backend.o \
+	backends/mutex/pthread/pthread-mutex.o \
+	backends/thread/pthread/pthread-thread.o \
+	backends/timer/default/default-timer.o
 endif
 
 ifdef WIN32
@@ -38,7 +50,7 @@ TESTS += $(srcdir)/test/graphics/tinygl*.h
 endif
 
 # libcommon needs libformats and libformats needs libcommon: so libcommon is put twice
-TEST_LIBS +=	audio/libaudio.a math/libmath.a common/libcommon.a common/formats/libformats.a common/compression/libcompression.a common/libcommon.a image/libimage.a graphics/libgraphics.a
+TEST_LIBS +=	video/libvideo.a audio/libaudio.a math/libmath.a common/libcommon.a common/formats/libformats.a common/compression/libcompression.a common/libcommon.a image/libimage.a graphics/libgraphics.a
 
 ifeq ($(ENABLE_WINTERMUTE), STATIC_PLUGIN)
 	TESTS += $(srcdir)/test/engines/wintermute/*.h
@@ -93,7 +105,7 @@ test/runner.cpp: $(TESTS) $(srcdir)/test/module.mk
 
 clean: clean-test
 clean-test:
-	-$(RM) test/runner.cpp test/runner test/engine-data/encoding.dat test/system/null_osystem.o
+	-$(RM) test/runner.cpp test/runner test/engine-data/encoding.dat test/system/null_osystem.o test/system/file_mode.o test/system/alloc_count.o
 	-rmdir test/engine-data
 
 test/engine-data/encoding.dat: $(srcdir)/dists/engine-data/encoding.dat
@@ -0,0 +1,60 @@
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/scummsys.h"
+#include "alloc_count.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+// Count the allocations by replacing the global operator new and delete.
+// They still go through malloc() and free(), so that memory checkers such
+// as ASan and valgrind keep seeing every allocation.
+static std::atomic<unsigned int> g_allocationCount(0);
+
+static void *countedAllocation(size_t size) {
+	g_allocationCount++;
+	return malloc(size ? size : 1);
+}
+
+void *operator new(size_t size) {
+	void *ptr = countedAllocation(size);
+	if (!ptr)
+		abort(); // Exceptions are disabled
+	return ptr;
+}
+
+void *operator new[](size_t size) {
+	void *ptr = countedAllocation(size);
+	if (!ptr)
+		abort(); // Exceptions are disabled
+	return ptr;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+	return countedAllocation(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+	return countedAllocation(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+	free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+	free(ptr);
+}
+
+unsigned int Common::getAllocationCount() {
+	return g_allocationCount.load();
+}
@@ -0,0 +1,7 @@
+#ifndef TEST_ALLOC_COUNT
+#define TEST_ALLOC_COUNT 1
+namespace Common {
+/** Return the number of times operator new was called by the test runner so far. */
+unsigned int getAllocationCount();
+}
+#endif
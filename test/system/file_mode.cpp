@@ -0,0 +1,17 @@
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/scummsys.h"
+#include "file_mode.h"
+
+#if defined(POSIX)
+#include <stdio.h>
+#include <sys/stat.h>
+
+bool Common::set_file_read_only(const char *path, bool readOnly) {
+	return chmod(path, readOnly ? 0444 : 0644) == 0;
+}
+
+bool Common::remove_file(const char *path) {
+	return remove(path) == 0;
+}
+#endif
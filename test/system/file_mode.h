@@ -0,0 +1,11 @@
+#ifndef TEST_FILE_MODE
+#define TEST_FILE_MODE 1
+namespace Common {
+#if defined(POSIX)
+/** Remove or restore the write permissions of a file. */
+bool set_file_read_only(const char *path, bool readOnly);
+/** Delete a file or an empty directory. */
+bool remove_file(const char *path);
+#endif
+}
+#endif
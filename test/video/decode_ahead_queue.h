@@ -0,0 +1,215 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/system.h"
+#include "video/decode_ahead_queue.h"
+#include "video/video_decoder.h"
+
+#include "../system/null_osystem.h"
+
+namespace {
+
+/**
+ * Video of 4x4 frames at 10 frames per second, filled with their number.
+ * The first two frames change the palette. The video is never started: its
+ * clock is set by the test.
+ */
+class TestVideoDecoder : public Video::VideoDecoder {
+public:
+	explicit TestVideoDecoder(int frameCount) : _track(new TestVideoTrack(frameCount)) {
+		addTrack(_track);
+		findNextVideoTrack();
+	}
+
+	bool loadStream(Common::SeekableReadStream *stream) override {
+		delete stream;
+		return false;
+	}
+
+	/**
+	 * Set the time of the video. The worker reads it after each frame, so
+	 * only call this once it decoded all the allowed frames.
+	 */
+	void setTime(uint32 time) { _lastTimeChange = Audio::Timestamp(time, 1000); }
+
+	/** Let the worker decode the frames before the given one. */
+	void allowFrames(int count) { _track->allowedFrames.store(count); }
+
+private:
+	class TestVideoTrack : public FixedRateVideoTrack {
+	public:
+		explicit TestVideoTrack(int frameCount) : allowedFrames(0), _frameCount(frameCount), _curFrame(-1), _dirtyPalette(false) {
+			_surface.create(4, 4, Graphics::PixelFormat::createFormatCLUT8());
+			memset(_palette, 0, sizeof(_palette));
+		}
+
+		~TestVideoTrack() override {
+			_surface.free();
+		}
+
+		uint16 getWidth() const override { return 4; }
+		uint16 getHeight() const override { return 4; }
+		Graphics::PixelFormat getPixelFormat() const override { return _surface.format; }
+		int getCurFrame() const override { return _curFrame; }
+		int getFrameCount() const override { return _frameCount; }
+		const byte *getPalette() const override { return _palette; }
+		bool hasDirtyPalette() const override { return _dirtyPalette; }
+
+		const Graphics::Surface *decodeNextFrame() override {
+			// Hold the worker back until the test allows the frame
+			while (_curFrame + 1 >= allowedFrames.load())
+				g_system->delayMillis(1);
+
+			_curFrame++;
+			_surface.fillRect(Common::Rect(4, 4), _curFrame);
+			_dirtyPalette = _curFrame < 2;
+			_palette[0] = _curFrame + 1;
+			return &_surface;
+		}
+
+		std::atomic<int> allowedFrames;
+
+	protected:
+		Common::Rational getFrameRate() const override { return 10; }
+
+	private:
+		int _frameCount;
+		int _curFrame;
+		Graphics::Surface _surface;
+		bool _dirtyPalette;
+		byte _palette[256 * 3];
+	};
+
+	TestVideoTrack *_track;
+};
+
+} // End of anonymous namespace
+
+class DecodeAheadQueueTestSuite : public CxxTest::TestSuite {
+public:
+	void setUp() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::install_null_g_system();
+#endif
+	}
+
+	void tearDown() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		Common::uninstall_null_g_system();
+#endif
+	}
+
+	void test_frames() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		TestVideoDecoder decoder(6);
+		decoder.allowFrames(5);
+		{
+			Video::DecodeAheadQueue queue(&decoder, 3);
+			queue.start();
+			TS_ASSERT(waitForQueuedFrames(queue, 3));
+
+			TS_ASSERT(queue.needsUpdate());
+			TS_ASSERT_EQUALS(frameNumber(queue.getNextFrame()), 0);
+			TS_ASSERT_EQUALS(queue.getCurFrame(), 0);
+			TS_ASSERT(queue.hasDirtyPalette());
+			TS_ASSERT_EQUALS(queue.getPalette()[0], 1);
+			TS_ASSERT(!queue.needsUpdate());
+			TS_ASSERT_EQUALS(queue.getTimeToNextFrame(), 100U);
+
+			// Frame 1 is overtaken by frame 2, but its palette is kept
+			decoder.setTime(250);
+			TS_ASSERT(waitForTime(queue, 250));
+			TS_ASSERT(queue.needsUpdate());
+			TS_ASSERT_EQUALS(frameNumber(queue.getNextFrame()), 2);
+			TS_ASSERT_EQUALS(queue.getCurFrame(), 2);
+			TS_ASSERT(queue.hasDirtyPalette());
+			TS_ASSERT_EQUALS(queue.getPalette()[0], 2);
+			TS_ASSERT(waitForQueuedFrames(queue, 2));
+
+			decoder.setTime(1000);
+			TS_ASSERT(waitForTime(queue, 1000));
+			TS_ASSERT_EQUALS(frameNumber(queue.getNextFrame()), 4);
+			TS_ASSERT(!queue.hasDirtyPalette());
+
+			// The last frame, after which the video ends
+			decoder.allowFrames(6);
+			TS_ASSERT(waitForQueuedFrames(queue, 1));
+			TS_ASSERT(!queue.endOfVideo());
+			TS_ASSERT_EQUALS(frameNumber(queue.getNextFrame()), 5);
+			TS_ASSERT(waitForEnd(queue));
+			TS_ASSERT(!queue.needsUpdate());
+			TS_ASSERT_EQUALS(queue.getTimeToNextFrame(), 0U);
+
+			const Video::DecodeAheadStats stats = queue.getStats();
+			TS_ASSERT_EQUALS(stats.decodedFrames, 6U);
+			TS_ASSERT_EQUALS(stats.shownFrames, 4U);
+			TS_ASSERT_EQUALS(stats.droppedFrames, 2U);
+			TS_ASSERT_EQUALS(stats.lateFrames, 3U);
+			TS_ASSERT_EQUALS(stats.underruns, 0U);
+			TS_ASSERT_EQUALS(stats.maxLateness, 600U);
+		}
+#endif
+	}
+
+	void test_underrun() {
+#if NULL_OSYSTEM_IS_AVAILABLE
+		TestVideoDecoder decoder(4);
+		decoder.allowFrames(2);
+		{
+			Video::DecodeAheadQueue queue(&decoder, 2);
+			queue.start();
+			TS_ASSERT(waitForQueuedFrames(queue, 2));
+			TS_ASSERT_EQUALS(frameNumber(queue.getNextFrame()), 0);
+
+			decoder.setTime(250);
+			TS_ASSERT(waitForTime(queue, 250));
+			TS_ASSERT_EQUALS(frameNumber(queue.getNextFrame()), 1);
+
+			// Frame 2 is due, but held back in the worker
+			TS_ASSERT(queue.needsUpdate());
+			TS_ASSERT(!queue.getNextFrame());
+			TS_ASSERT(!queue.getNextFrame());
+			TS_ASSERT_EQUALS(queue.getCurFrame(), 1);
+			TS_ASSERT_EQUALS(queue.getStats().underruns, 1U);
+
+			decoder.allowFrames(4);
+			TS_ASSERT(waitForQueuedFrames(queue, 2));
+			TS_ASSERT_EQUALS(frameNumber(queue.getNextFrame()), 2);
+
+			decoder.setTime(300);
+			TS_ASSERT(waitForTime(queue, 300));
+			TS_ASSERT_EQUALS(frameNumber(queue.getNextFrame()), 3);
+			TS_ASSERT(waitForEnd(queue));
+
+			const Video::DecodeAheadStats stats = queue.getStats();
+			TS_ASSERT_EQUALS(stats.shownFrames, 4U);
+			TS_ASSERT_EQUALS(stats.droppedFrames, 0U);
+			TS_ASSERT_EQUALS(stats.underruns, 1U);
+		}
+#endif
+	}
+
+private:
+	static int frameNumber(const Graphics::Surface *frame) {
+		return frame ? *(const byte *)frame->getPixels() : -1;
+	}
+
+	// The worker runs on its own, so these wait for it a few seconds at most
+
+	static bool waitForQueuedFrames(const Video::DecodeAheadQueue &queue, uint count) {
+		for (int i = 0; i < 5000 && queue.getQueuedFrames() != count; i++)
+			g_system->delayMillis(1);
+		return queue.getQueuedFrames() == count;
+	}
+
+	static bool waitForTime(const Video::DecodeAheadQueue &queue, uint32 time) {
+		for (int i = 0; i < 5000 && queue.getTime() != time; i++)
+			g_system->delayMillis(1);
+		return queue.getTime() == time;
+	}
+
+	static bool waitForEnd(const Video::DecodeAheadQueue &queue) {
+		for (int i = 0; i < 5000 && !queue.endOfVideo(); i++)
+			g_system->delayMillis(1);
+		return queue.endOfVideo();
+	}
+};
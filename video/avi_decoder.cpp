@@ -973,7 +973,7 @@ VideoDecoder::AudioTrack *AVIDecoder::getAudioTrack(int index) {
 }
 
 AVIDecoder::AVIVideoTrack::AVIVideoTrack(int frameCount, const AVIStreamHeader &streamHeader, const BitmapInfoHeader &bitmapInfoHeader, byte *initialPalette, Image::CodecAccuracy accuracy)
-		: _frameCount(frameCount), _vidsHeader(streamHeader), _bmInfo(bitmapInfoHeader), _palette(256), _initialPalette(initialPalette), _accuracy(accuracy) {
+		: _frameCount(frameCount), _vidsHeader(streamHeader), _bmInfo(bitmapInfoHeader), _palette(256), _initialPalette(initialPalette), _accuracy(accuracy), _threadPool(nullptr) {
 	_videoCodec = createCodec();
 	_lastFrame = 0;
 	_curFrame = -1;
@@ -1082,8 +1082,10 @@ Image::Codec *AVIDecoder::AVIVideoTrack::createCodec() {
 	Image::Codec *codec = Image::createBitmapCodec(_bmInfo.compression, _vidsHeader.streamHandler, _bmInfo.width,
 									_bmInfo.height, _bmInfo.bitCount);
 
-	if (codec != nullptr)
+	if (codec != nullptr) {
 		codec->setCodecAccuracy(_accuracy);
+		codec->setThreadPool(_threadPool);
+	}
 
 	return codec;
 }
@@ -1142,6 +1144,13 @@ void AVIDecoder::AVIVideoTrack::setCodecAccuracy(Image::CodecAccuracy accuracy)
 	}
 }
 
+void AVIDecoder::AVIVideoTrack::setThreadPool(Common::ThreadPool *pool) {
+	_threadPool = pool;
+
+	if (_videoCodec)
+		_videoCodec->setThreadPool(pool);
+}
+
 AVIDecoder::AVIAudioTrack::AVIAudioTrack(const AVIStreamHeader &streamHeader, const PCMWaveFormat &waveFormat, Audio::Mixer::SoundType soundType) :
 		AudioTrack(soundType),
 		_audsHeader(streamHeader),
@@ -215,6 +215,7 @@ protected:
 		Graphics::PixelFormat getPixelFormat() const override;
 		bool setOutputPixelFormat(const Graphics::PixelFormat &format) override;
 		void setCodecAccuracy(Image::CodecAccuracy accuracy) override;
+		void setThreadPool(Common::ThreadPool *pool) override;
 		int getCurFrame() const override { return _curFrame; }
 		int getFrameCount() const override { return _frameCount; }
 		Common::String &getName() { return _vidsHeader.name; }
@@ -280,6 +281,7 @@ protected:
 		Image::Codec *_videoCodec;
 		const Graphics::Surface *_lastFrame;
 		Image::CodecAccuracy _accuracy;
+		Common::ThreadPool *_threadPool;
 
 		Image::Codec *createCodec();
 	};
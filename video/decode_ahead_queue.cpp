@@ -0,0 +1,311 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "video/decode_ahead_queue.h"
+#include "video/video_decoder.h"
+
+#include "common/system.h"
+
+namespace Video {
+
+DecodeAheadQueue::DecodeAheadQueue(VideoDecoder *decoder, uint queueSize)
+	: _decoder(decoder), _running(false), _decoded(0), _taken(0), _released(0),
+	  _pendingStartTime(0), _decoderEnded(false), _quit(false), _workerLeaving(false), _clockSample(0),
+	  _curFrame(-1), _dirtyPalette(false), _decodedFrames(0), _underrunFrame(0xFFFFFFFF),
+	  _pool(1), _task(this), _taskSubmitted(false) {
+	assert(decoder);
+	assert(queueSize >= 2);
+
+	_slots.resize(queueSize);
+	memset(_palette, 0, sizeof(_palette));
+	resetStats();
+}
+
+DecodeAheadQueue::~DecodeAheadQueue() {
+	stop();
+
+	for (auto &slot : _slots)
+		slot.surface.free();
+}
+
+void DecodeAheadQueue::start() {
+	assert(_decoder->isVideoLoaded());
+	stop();
+
+	_decoded.store(0, std::memory_order_relaxed);
+	_taken = 0;
+	_released.store(0, std::memory_order_relaxed);
+	_pendingStartTime.store(_decoder->_nextVideoTrack ? _decoder->_nextVideoTrack->getNextFrameStartTime() : 0, std::memory_order_relaxed);
+	_decoderEnded.store(!_decoder->hasFramesLeft(), std::memory_order_relaxed);
+	_underrunFrame = 0xFFFFFFFF;
+	_curFrame = _decoder->getCurFrame();
+	sampleClock();
+	_running = true;
+
+	if (!_decoderEnded.load(std::memory_order_relaxed)) {
+		_taskSubmitted = true;
+		_pool.submit(&_task);
+	}
+}
+
+void DecodeAheadQueue::stop() {
+	if (!_running)
+		return;
+
+	_quit.store(true, std::memory_order_relaxed);
+	_task.wait();
+	_quit.store(false, std::memory_order_relaxed);
+	_taskSubmitted = false;
+	_running = false;
+}
+
+void DecodeAheadQueue::decode() {
+	const uint32 size = _slots.size();
+
+	while (!_quit.load(std::memory_order_relaxed)) {
+		const uint32 decoded = _decoded.load(std::memory_order_relaxed);
+		if (decoded - _released.load() >= size) {
+			// Leave, unless a slot was released meanwhile. If requestDecode()
+			// saw the flag first, it submits the task again instead.
+			_workerLeaving.store(true);
+			if (decoded - _released.load() >= size || !_workerLeaving.exchange(false))
+				break;
+			continue;
+		}
+
+		if (!_decoder->hasFramesLeft()) {
+			_decoderEnded.store(true, std::memory_order_release);
+			break;
+		}
+
+		Slot &slot = _slots[decoded % size];
+		slot.startTime = _decoder->_nextVideoTrack ? _decoder->_nextVideoTrack->getNextFrameStartTime() : 0;
+
+		const Graphics::Surface *frame = _decoder->decodeNextFrame();
+		slot.frameNum = _decoder->getCurFrame();
+		slot.hasSurface = frame != nullptr;
+
+		if (frame) {
+			// The surfaces are only reallocated when the frame size changes
+			if (slot.surface.w != frame->w || slot.surface.h != frame->h || slot.surface.format != frame->format) {
+				slot.surface.free();
+				slot.surface.create(frame->w, frame->h, frame->format);
+			}
+
+			slot.surface.copyRectToSurface(*frame, 0, 0, Common::Rect(frame->w, frame->h));
+		}
+
+		slot.hasPalette = _decoder->hasDirtyPalette();
+		if (slot.hasPalette)
+			memcpy(slot.palette, _decoder->getPalette(), sizeof(slot.palette));
+
+		const uint32 nextStartTime = _decoder->_nextVideoTrack ? _decoder->_nextVideoTrack->getNextFrameStartTime() : 0;
+		sampleClock();
+
+		_decodedFrames.fetch_add(1, std::memory_order_relaxed);
+		_decoded.store(decoded + 1, std::memory_order_release);
+
+		// Published after the frame, see getNextStartTime()
+		_pendingStartTime.store(nextStartTime, std::memory_order_release);
+	}
+}
+
+void DecodeAheadQueue::requestDecode() {
+	if (_decoderEnded.load(std::memory_order_acquire))
+		return;
+
+	if (_decoded.load(std::memory_order_relaxed) - _released.load(std::memory_order_relaxed) >= _slots.size())
+		return;
+
+	if (_task.isDone() || _workerLeaving.exchange(false)) {
+		// A worker leaving because the ring was full is about to be done
+		_task.wait();
+		_workerLeaving.store(false);
+		_taskSubmitted = true;
+		_pool.submit(&_task);
+	}
+}
+
+bool DecodeAheadQueue::isWorkerIdle() const {
+	return !_taskSubmitted || _task.isDone();
+}
+
+uint32 DecodeAheadQueue::sampleClock() const {
+	const uint32 time = _decoder->getTime();
+	_clockSample.store(((uint64)time << 32) | g_system->getMillis(), std::memory_order_release);
+	return time;
+}
+
+uint32 DecodeAheadQueue::getTime() const {
+	// The worker is only submitted from this thread, so it stays idle
+	// while the decoder is asked
+	if (!_running || isWorkerIdle())
+		return sampleClock();
+
+	const uint64 sample = _clockSample.load(std::memory_order_acquire);
+	const uint32 time = (uint32)(sample >> 32);
+	if (_decoder->isPaused())
+		return time;
+
+	const uint32 elapsed = g_system->getMillis() - (uint32)sample;
+	return time + MAX<int>((_decoder->getRate() * (int)elapsed).toInt(), 0);
+}
+
+void DecodeAheadQueue::pauseVideo(bool pause) {
+	if (!_running) {
+		_decoder->pauseVideo(pause);
+		return;
+	}
+
+	// Let the worker finish its frame, and resume decoding afterwards
+	_quit.store(true, std::memory_order_relaxed);
+	_task.wait();
+	_quit.store(false, std::memory_order_relaxed);
+
+	_decoder->pauseVideo(pause);
+	sampleClock();
+	requestDecode();
+}
+
+bool DecodeAheadQueue::getNextStartTime(uint32 &startTime) const {
+	// Read in the opposite order of the worker's writes, so that the
+	// pending time never belongs to a frame after an unseen one
+	const uint32 pendingStartTime = _pendingStartTime.load(std::memory_order_acquire);
+	const bool decoderEnded = _decoderEnded.load(std::memory_order_acquire);
+
+	if (_decoded.load(std::memory_order_acquire) != _taken) {
+		startTime = _slots[_taken % _slots.size()].startTime;
+		return true;
+	}
+
+	startTime = pendingStartTime;
+	return !decoderEnded;
+}
+
+bool DecodeAheadQueue::needsUpdate() const {
+	uint32 startTime;
+	if (!_running || !getNextStartTime(startTime))
+		return false;
+
+	// This is also true if the due frame is still being decoded, so
+	// that getNextFrame() can account for the underrun
+	return startTime <= getTime();
+}
+
+uint32 DecodeAheadQueue::getTimeToNextFrame() const {
+	uint32 startTime;
+	if (!_running || !getNextStartTime(startTime))
+		return 0;
+
+	const uint32 time = getTime();
+	return startTime > time ? startTime - time : 0;
+}
+
+const Graphics::Surface *DecodeAheadQueue::getNextFrame() {
+	if (!_running)
+		return nullptr;
+
+	// Read the clock first, while the worker may still be idle
+	const uint32 time = getTime();
+
+	// The frame returned last time is not needed anymore. Without
+	// threads, this decodes the frame for the freed slot right away.
+	_released.store(_taken);
+	requestDecode();
+
+	const uint32 size = _slots.size();
+	const uint32 decoded = _decoded.load(std::memory_order_acquire);
+
+	if (decoded == _taken) {
+		uint32 startTime;
+		if (getNextStartTime(startTime) && startTime <= time && _underrunFrame != _taken) {
+			_stats.underruns++;
+			_underrunFrame = _taken;
+		}
+
+		return nullptr;
+	}
+
+	if (_slots[_taken % size].startTime > time)
+		return nullptr;
+
+	// Skip the frames which a later due frame replaces
+	while (decoded - _taken > 1 && _slots[(_taken + 1) % size].startTime <= time) {
+		applyPalette(_slots[_taken % size]);
+		_stats.droppedFrames++;
+		_taken++;
+	}
+
+	_released.store(_taken);
+	requestDecode();
+
+	const Slot &slot = _slots[_taken % size];
+	_taken++;
+
+	applyPalette(slot);
+	_curFrame = slot.frameNum;
+	_stats.shownFrames++;
+
+	const uint32 lateness = time - slot.startTime;
+	if (lateness > kLateFrameMillis)
+		_stats.lateFrames++;
+	_stats.maxLateness = MAX(_stats.maxLateness, lateness);
+
+	return slot.hasSurface ? &slot.surface : nullptr;
+}
+
+void DecodeAheadQueue::applyPalette(const Slot &slot) {
+	if (!slot.hasPalette)
+		return;
+
+	memcpy(_palette, slot.palette, sizeof(_palette));
+	_dirtyPalette = true;
+}
+
+const byte *DecodeAheadQueue::getPalette() {
+	_dirtyPalette = false;
+	return _palette;
+}
+
+bool DecodeAheadQueue::endOfVideo() const {
+	if (!_running)
+		return _decoder->endOfVideo();
+
+	// The worker does not touch the decoder anymore once it ended
+	return _decoderEnded.load(std::memory_order_acquire) && _decoded.load(std::memory_order_acquire) == _taken && _decoder->endOfVideo();
+}
+
+uint DecodeAheadQueue::getQueuedFrames() const {
+	return _running ? _decoded.load(std::memory_order_acquire) - _taken : 0;
+}
+
+DecodeAheadStats DecodeAheadQueue::getStats() const {
+	DecodeAheadStats stats = _stats;
+	stats.decodedFrames = _decodedFrames.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void DecodeAheadQueue::resetStats() {
+	memset(&_stats, 0, sizeof(_stats));
+	_decodedFrames.store(0, std::memory_order_relaxed);
+}
+
+} // End of namespace Video
@@ -0,0 +1,258 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef VIDEO_DECODE_AHEAD_QUEUE_H
+#define VIDEO_DECODE_AHEAD_QUEUE_H
+
+#include "common/array.h"
+#include "common/noncopyable.h"
+#include "common/threadpool.h"
+#include "graphics/surface.h"
+
+#include <atomic>
+
+namespace Video {
+
+class VideoDecoder;
+
+/**
+ * Frame pacing statistics of a DecodeAheadQueue.
+ */
+struct DecodeAheadStats {
+	uint32 decodedFrames;   ///< Frames decoded by the worker
+	uint32 shownFrames;     ///< Frames returned by DecodeAheadQueue::getNextFrame()
+	uint32 droppedFrames;   ///< Frames skipped because a later frame was due as well
+	uint32 lateFrames;      ///< Frames returned more than kLateFrameMillis after their start time
+	uint32 underruns;       ///< Frames which were due before they were decoded
+	uint32 maxLateness;     ///< Largest delay of a returned frame, in milliseconds
+};
+
+/**
+ * Decodes the frames of a video ahead of time on a background thread.
+ *
+ * The frames are copied into a ring of surfaces which are allocated once,
+ * and handed out when the decoder's clock reaches their start time. This
+ * replaces the usual needsUpdate()/decodeNextFrame() calls on the decoder:
+ *
+ * @code
+ * Video::DecodeAheadQueue queue(decoder);
+ * decoder->start();
+ * queue.start();
+ *
+ * while (!queue.endOfVideo()) {
+ *     if (queue.needsUpdate()) {
+ *         const Graphics::Surface *frame = queue.getNextFrame();
+ *         if (queue.hasDirtyPalette())
+ *             g_system->getPaletteManager()->setPalette(queue.getPalette(), 0, 256);
+ *         if (frame)
+ *             g_system->copyRectToScreen(frame->getPixels(), frame->pitch, x, y, frame->w, frame->h);
+ *     }
+ *     g_system->updateScreen();
+ *     g_system->delayMillis(queue.getTimeToNextFrame());
+ * }
+ * @endcode
+ *
+ * While the queue is running, the worker owns the decoder, which must not
+ * be used directly, not even getTime(): the queue's getTime() and
+ * pauseVideo() replace the decoder's ones. Anything else, like seeking,
+ * rewinding or closing the video, requires stop() first. Reversed playback
+ * is not supported.
+ *
+ * If the backend does not support threads, the ring is refilled from
+ * start() and getNextFrame() instead.
+ */
+class DecodeAheadQueue : Common::NonCopyable {
+public:
+	enum {
+		/** Default number of decoded frames held by the queue */
+		kDefaultQueueSize = 4,
+		/** Frames shown later than this after their start time count as late */
+		kLateFrameMillis = 20
+	};
+
+	/**
+	 * @param decoder    The video to decode. It stays owned by the caller.
+	 * @param queueSize  How many frames to keep decoded, including the one
+	 *                   last returned by getNextFrame(). At least two.
+	 */
+	DecodeAheadQueue(VideoDecoder *decoder, uint queueSize = kDefaultQueueSize);
+	~DecodeAheadQueue();
+
+	/**
+	 * Start decoding ahead from the decoder's current position. The video
+	 * has to be loaded, and should be started.
+	 */
+	void start();
+
+	/**
+	 * Wait for the worker and drop the queued frames. The decoder is
+	 * positioned after the last decoded frame, not the last shown one,
+	 * so seek or rewind it before starting again.
+	 */
+	void stop();
+
+	/** Return true between start() and stop(). */
+	bool isRunning() const { return _running; }
+
+	/**
+	 * Return the time of the video, in milliseconds.
+	 *
+	 * The decoder's clock is only read while the worker is idle, or by the
+	 * worker after each frame. In between, it is extrapolated from the last
+	 * reading with the system clock.
+	 */
+	uint32 getTime() const;
+
+	/**
+	 * Pause or resume the video, like VideoDecoder::pauseVideo(). This waits
+	 * for the frame being decoded, if any.
+	 */
+	void pauseVideo(bool pause);
+
+	/** Return true if a queued frame has reached its start time. */
+	bool needsUpdate() const;
+
+	/**
+	 * Return the time (in ms) until the next frame is due, 0 if it is
+	 * due already or if there are no frames left.
+	 */
+	uint32 getTimeToNextFrame() const;
+
+	/**
+	 * Return the most recent frame which is due, dropping the older ones.
+	 *
+	 * The surface stays valid until the next call to this function or
+	 * stop(). Like VideoDecoder::decodeNextFrame(), this may return 0,
+	 * in which case the last frame should be kept on screen.
+	 */
+	const Graphics::Surface *getNextFrame();
+
+	/** Return the number of the frame last returned by getNextFrame(). */
+	int getCurFrame() const { return _curFrame; }
+
+	/**
+	 * Return true if the palette changed with the frames returned by
+	 * getNextFrame(). The flag is cleared by getPalette().
+	 */
+	bool hasDirtyPalette() const { return _dirtyPalette; }
+
+	/** Return the palette of the last returned frame, as interleaved RGB values. */
+	const byte *getPalette();
+
+	/**
+	 * Return true once all frames have been returned and the decoder
+	 * reached the end of the video, including its audio.
+	 */
+	bool endOfVideo() const;
+
+	/** Return the number of frames currently decoded ahead. */
+	uint getQueuedFrames() const;
+
+	/** Return the frame pacing statistics since the last resetStats(). */
+	DecodeAheadStats getStats() const;
+
+	/** Reset all frame pacing statistics. */
+	void resetStats();
+
+private:
+	struct Slot {
+		Graphics::Surface surface;
+		bool hasSurface;
+		int frameNum;
+		uint32 startTime;
+		bool hasPalette;
+		byte palette[256 * 3];
+	};
+
+	/**
+	 * Fills the ring and returns. The reader submits it again once it
+	 * released a slot.
+	 */
+	class DecodeTask : public Common::Task {
+	public:
+		explicit DecodeTask(DecodeAheadQueue *queue) : _queue(queue) {}
+		void run() override { _queue->decode(); }
+
+	private:
+		DecodeAheadQueue *_queue;
+	};
+
+	/** Decode into the ring until it is full. Called on the worker thread. */
+	void decode();
+
+	/** Submit the decoding task if there is space in the ring. */
+	void requestDecode();
+
+	/** Return true if the worker does not use the decoder. */
+	bool isWorkerIdle() const;
+
+	/** Read the decoder's clock, and keep it for getTime(). */
+	uint32 sampleClock() const;
+
+	/**
+	 * Get the start time of the next frame, whether it is decoded yet or
+	 * not. Return false if there are no frames left.
+	 */
+	bool getNextStartTime(uint32 &startTime) const;
+
+	/** Take over the palette of a frame which is shown or dropped. */
+	void applyPalette(const Slot &slot);
+
+	VideoDecoder *_decoder;
+	Common::Array<Slot> _slots;
+	bool _running;
+
+	/**
+	 * Ring positions, counting frames since start(). The worker writes
+	 * slot _decoded, the reader takes slot _taken, and the slots before
+	 * _released may be reused.
+	 */
+	std::atomic<uint32> _decoded;
+	uint32 _taken;
+	std::atomic<uint32> _released;
+
+	/** Start time of the frame the worker decodes next */
+	std::atomic<uint32> _pendingStartTime;
+	std::atomic<bool> _decoderEnded;
+	std::atomic<bool> _quit;
+	/** Set by the worker when it finds the ring full, see decode() */
+	std::atomic<bool> _workerLeaving;
+
+	/** Last reading of the decoder's clock, and system time it was made at */
+	mutable std::atomic<uint64> _clockSample;
+
+	int _curFrame;
+	bool _dirtyPalette;
+	byte _palette[256 * 3];
+
+	std::atomic<uint32> _decodedFrames;
+	DecodeAheadStats _stats;
+	/** Frame counted in the last underrun, to count each frame once */
+	uint32 _underrunFrame;
+
+	Common::ThreadPool _pool;
+	DecodeTask _task;
+	bool _taskSubmitted;
+};
+
+} // End of namespace Video
+
+#endif
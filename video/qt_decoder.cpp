@@ -501,6 +501,15 @@ bool QuickTimeDecoder::VideoTrackHandler::setOutputPixelFormat(const Graphics::P
 	return success;
 }
 
+void QuickTimeDecoder::VideoTrackHandler::setThreadPool(Common::ThreadPool *pool) {
+	for (uint i = 0; i < _parent->sampleDescs.size(); i++) {
+		VideoSampleDesc *desc = (VideoSampleDesc *)_parent->sampleDescs[i];
+
+		if (desc->_videoCodec)
+			desc->_videoCodec->setThreadPool(pool);
+	}
+}
+
 int QuickTimeDecoder::VideoTrackHandler::getFrameCount() const {
 	return _parent->frameCount;
 }
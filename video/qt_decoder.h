@@ -340,6 +340,7 @@ private:
 		uint16 getHeight() const override;
 		Graphics::PixelFormat getPixelFormat() const override;
 		bool setOutputPixelFormat(const Graphics::PixelFormat &format) override;
+		void setThreadPool(Common::ThreadPool *pool) override;
 		int getCurFrame() const override { return _curFrame; }
 		void setCurFrame(int32 curFrame) { _curFrame = curFrame; }
 		int getFrameCount() const override;
@@ -27,9 +27,16 @@
 #include "common/rational.h"
 #include "common/file.h"
 #include "common/system.h"
+#include "common/threadpool.h"
 
 namespace Video {
 
+enum {
+	// Number of worker threads used for parallel decoding. Codecs split
+	// frames into a few large parts at most, so more would rarely help.
+	kDecodeThreads = 4
+};
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -48,6 +55,12 @@ VideoDecoder::VideoDecoder() {
 	_canSetDither = true;
 	_canSetDefaultFormat = true;
 	_videoCodecAccuracy = Image::CodecAccuracy::Default;
+	_decodePool = nullptr;
+}
+
+VideoDecoder::~VideoDecoder() {
+	// Subclasses close() their tracks before this runs
+	delete _decodePool;
 }
 
 void VideoDecoder::close() {
@@ -594,6 +607,27 @@ void VideoDecoder::setVideoCodecAccuracy(Image::CodecAccuracy accuracy) {
 	}
 }
 
+void VideoDecoder::setParallelDecoding(bool enable) {
+	if (enable == isParallelDecoding())
+		return;
+
+	Common::ThreadPool *pool = enable ? new Common::ThreadPool(kDecodeThreads) : nullptr;
+
+	// Without threads, the codecs are better off decoding directly
+	if (pool && !pool->isAsync()) {
+		delete pool;
+		return;
+	}
+
+	for (Track *track : _tracks) {
+		if (track->getTrackType() == Track::kTrackTypeVideo)
+			static_cast<VideoTrack *>(track)->setThreadPool(pool);
+	}
+
+	delete _decodePool;
+	_decodePool = pool;
+}
+
 VideoDecoder::Track::Track() {
 	_paused = false;
 }
@@ -840,6 +874,9 @@ void VideoDecoder::addTrack(Track *track, bool isExternal) {
 			}
 		}
 	} else if (track->getTrackType() == Track::kTrackTypeVideo) {
+		if (_decodePool)
+			((VideoTrack *)track)->setThreadPool(_decodePool);
+
 		// If this track has a better time, update _nextVideoTrack
 		if (!_nextVideoTrack || ((VideoTrack *)track)->getNextFrameStartTime() < _nextVideoTrack->getNextFrameStartTime())
 			_nextVideoTrack = (VideoTrack *)track;
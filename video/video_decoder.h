@@ -39,6 +39,7 @@ class SeekableAudioStream;
 
 namespace Common {
 class SeekableReadStream;
+class ThreadPool;
 }
 
 namespace Graphics {
@@ -51,9 +52,11 @@ namespace Video {
  * Generic interface for video decoder classes.
  */
 class VideoDecoder {
+	friend class DecodeAheadQueue;
+
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -430,6 +433,29 @@ public:
 	 */
 	virtual void setVideoCodecAccuracy(Image::CodecAccuracy accuracy);
 
+	/**
+	 * Decode independent parts of each frame, such as the strips of Cinepak
+	 * frames, on worker threads. This only helps with codecs which support
+	 * it, and has no effect on the others. The decoded frames are the same.
+	 *
+	 * This may be called at any time, and stays in effect when another
+	 * video is loaded.
+	 *
+	 * @param enable true to decode in parallel, false to decode on the
+	 *               calling thread
+	 */
+	void setParallelDecoding(bool enable);
+
+	/**
+	 * Return true if parallel decoding is enabled. This stays false if
+	 * the backend does not support threads.
+	 *
+	 * @see setParallelDecoding()
+	 */
+	bool isParallelDecoding() const { return _decodePool != nullptr; }
+
+	// To decode ahead on a background thread, see DecodeAheadQueue
+
 	/////////////////////////////////////////
 	// Audio Control
 	/////////////////////////////////////////
@@ -625,6 +651,14 @@ protected:
 		 */
 		virtual void setCodecAccuracy(Image::CodecAccuracy accuracy) {}
 
+		/**
+		 * Set the thread pool used to decode parts of a frame in parallel,
+		 * or nullptr to decode on the calling thread.
+		 *
+		 * @see VideoDecoder::setParallelDecoding()
+		 */
+		virtual void setThreadPool(Common::ThreadPool *pool) {}
+
 		/**
 		 * Get the current frame of this track
 		 *
@@ -1045,6 +1079,9 @@ protected:
 
 	Image::CodecAccuracy _videoCodecAccuracy;
 
+	/** Worker threads for parallel decoding, if enabled */
+	Common::ThreadPool *_decodePool;
+
 private:
 	uint32 _pauseLevel;
 	uint32 _pauseStartTime;